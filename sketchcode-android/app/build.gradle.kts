@@ -3,6 +3,77 @@ plugins {
     id("org.jetbrains.kotlin.android")
 }
 
+val onnxruntimeVersion = "1.24.1"
+// The AAR's C headers and libonnxruntime.so, unpacked for the native decoder loop
+val onnxruntimeAar: Configuration by configurations.creating
+val onnxruntimeDir = layout.buildDirectory.dir("onnxruntime")
+
+/**
+ * Packs the tokenizer's vocab.json into vocab.bin, the table vocabulary.cpp maps in
+ * place (layout documented in vocabulary.h): a header, per-token byte offsets, an
+ * FNV-1a hash of 16-bit token ids keyed by their bytes, and the token bytes themselves,
+ * already mapped back through GPT-2's bytes_to_unicode().
+ */
+abstract class PackVocab : DefaultTask() {
+    @get:InputFile
+    abstract val vocabJson: RegularFileProperty
+
+    @get:OutputDirectory
+    abstract val outputDir: DirectoryProperty
+
+    @TaskAction
+    fun pack() {
+        @Suppress("UNCHECKED_CAST")
+        val vocab = groovy.json.JsonSlurper().parse(vocabJson.get().asFile, "UTF-8") as Map<String, Number>
+
+        // Reverse of bytes_to_unicode(): printable bytes stand for themselves, the rest
+        // were shifted to 256 + n in byte order
+        val byteOf = HashMap<Int, Byte>()
+        var shifted = 0
+        for (b in 0..255) {
+            val printable = b in '!'.code..'~'.code || b in 0xA1..0xAC || b in 0xAE..0xFF
+            byteOf[if (printable) b else 256 + shifted++] = b.toByte()
+        }
+
+        val count = vocab.values.maxOf { it.toInt() } + 1
+        val tokens = Array(count) { ByteArray(0) }
+        for ((text, id) in vocab) {
+            tokens[id.toInt()] = text.codePoints().toArray().map { byteOf.getValue(it) }.toByteArray()
+        }
+
+        var hashSize = 1
+        while (hashSize < 2 * count) hashSize *= 2
+        val hash = ShortArray(hashSize) { -1 }   // 0xFFFF = free
+        for ((id, bytes) in tokens.withIndex()) {
+            var h = 0x811C9DC5.toInt()
+            for (b in bytes) h = (h xor (b.toInt() and 0xFF)) * 0x01000193
+            var slot = h and (hashSize - 1)
+            while (hash[slot] != (-1).toShort()) slot = (slot + 1) and (hashSize - 1)
+            hash[slot] = id.toShort()
+        }
+
+        val blobSize = tokens.sumOf { it.size }
+        val out = java.nio.ByteBuffer.allocate(20 + 4 * (count + 1) + 2 * hashSize + blobSize)
+            .order(java.nio.ByteOrder.LITTLE_ENDIAN)
+        out.put("WVOC".toByteArray(Charsets.US_ASCII)).putInt(1).putInt(count).putInt(hashSize).putInt(blobSize)
+        var offset = 0
+        for (bytes in tokens) {
+            out.putInt(offset)
+            offset += bytes.size
+        }
+        out.putInt(offset)
+        hash.forEach { out.putShort(it) }
+        tokens.forEach { out.put(it) }
+        outputDir.get().file("vocab.bin").asFile.writeBytes(out.array())
+        logger.lifecycle("vocab.bin: $count tokens, $blobSize blob bytes, hash $hashSize")
+    }
+}
+
+val packVocab by tasks.registering(PackVocab::class) {
+    vocabJson.set(layout.projectDirectory.file("src/main/tokenizer/vocab.json"))
+    outputDir.set(layout.buildDirectory.dir("generated/vocab"))
+}
+
 android {
     namespace = "com.sketchcode.app"
     compileSdk = 35
@@ -16,6 +87,11 @@ android {
         ndk {
             abiFilters += "arm64-v8a"
         }
+        externalNativeBuild {
+            cmake {
+                arguments += "-DONNXRUNTIME_ROOT=${onnxruntimeDir.get().asFile.absolutePath}"
+            }
+        }
     }
 
     externalNativeBuild {
@@ -25,6 +101,17 @@ android {
         }
     }
 
+    sourceSets {
+        getByName("main") {
+            assets.srcDir(packVocab.flatMap { it.outputDir })
+        }
+    }
+
+    // vocab.bin is memory-mapped straight out of the APK
+    androidResources {
+        noCompress += "bin"
+    }
+
     buildFeatures {
         compose = true
     }
@@ -87,8 +174,24 @@ dependencies {
     implementation("com.google.code.gson:gson:2.10.1")
 
     // ONNX Runtime with Qualcomm QNN Execution Provider (includes HTP/NPU libs)
-    implementation("com.microsoft.onnxruntime:onnxruntime-android-qnn:1.24.1")
+    implementation("com.microsoft.onnxruntime:onnxruntime-android-qnn:$onnxruntimeVersion")
+    onnxruntimeAar("com.microsoft.onnxruntime:onnxruntime-android-qnn:$onnxruntimeVersion@aar")
 
     // Core
     implementation("androidx.core:core-ktx:1.13.1")
 }
+
+val extractOnnxRuntime by tasks.registering(Copy::class) {
+    from({ zipTree(onnxruntimeAar.singleFile) }) {
+        include("headers/**", "jni/**")
+    }
+    into(onnxruntimeDir)
+}
+
+tasks.matching { it.name.startsWith("configureCMake") }.configureEach {
+    dependsOn(extractOnnxRuntime)
+}
+
+tasks.matching { it.name == "preBuild" }.configureEach {
+    dependsOn(packVocab)
+}
@@ -0,0 +1,97 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+// Smallest block taken from the heap; one 30 s utterance needs a few MB
+static constexpr size_t MIN_BLOCK_BYTES = 256 * 1024;
+
+static inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Offset of the first byte at or after offset in data that is aligned to alignment.
+// Aligned on the address, not the offset: blocks are only ALIGNMENT-aligned.
+static inline size_t alignedOffset(const char* data, size_t offset, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(data);
+    return alignUp(base + offset, alignment) - base;
+}
+
+Arena::Arena(size_t initialBytes) {
+    if (initialBytes > 0) addBlock(initialBytes);
+}
+
+Arena::~Arena() {
+    for (const Block& block : blocks_) ::operator delete(block.data, std::align_val_t(ALIGNMENT));
+}
+
+void Arena::addBlock(size_t minBytes) {
+    size_t size = alignUp(std::max(minBytes, MIN_BLOCK_BYTES), ALIGNMENT);
+    char* data = static_cast<char*>(::operator new(size, std::align_val_t(ALIGNMENT)));
+    // Room for the blocks of a doubling warm-up, so after it the list never regrows
+    if (blocks_.capacity() == 0) blocks_.reserve(16);
+    blocks_.push_back({ data, size });
+    heapBlocks_++;
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    alignment = std::max(alignment, (size_t)1);
+    while (current_ < blocks_.size()) {
+        size_t start = alignedOffset(blocks_[current_].data, offset_, alignment);
+        if (start + bytes <= blocks_[current_].size) {
+            offset_ = start + bytes;
+            highWater_ = std::max(highWater_, used());
+            return blocks_[current_].data + start;
+        }
+        // Later blocks are left over from a rewind: try them before the heap
+        current_++;
+        offset_ = 0;
+    }
+    // Out of blocks: at least double the capacity, so a growing utterance takes few blocks
+    size_t capacity = 0;
+    for (const Block& block : blocks_) capacity += block.size;
+    addBlock(std::max(bytes + alignment, capacity));
+    current_ = blocks_.size() - 1;
+    size_t start = alignedOffset(blocks_[current_].data, 0, alignment);
+    offset_ = start + bytes;
+    highWater_ = std::max(highWater_, used());
+    return blocks_[current_].data + start;
+}
+
+void Arena::rewind(const Marker& mark) {
+    if (mark.block > current_ || (mark.block == current_ && mark.offset > offset_)) return;
+    current_ = mark.block;
+    offset_ = mark.offset;
+}
+
+void Arena::reset() {
+    resets_++;
+    current_ = 0;
+    offset_ = 0;
+    if (blocks_.size() <= 1) return;
+
+    // The utterance spilled into more blocks: replace them with one that holds it all
+    size_t size = std::max(highWater_, blocks_.front().size);
+    for (const Block& block : blocks_) ::operator delete(block.data, std::align_val_t(ALIGNMENT));
+    blocks_.clear();
+    // Alignment padding at block ends can make the spilled layout need a little more
+    addBlock(size + size / 16);
+}
+
+size_t Arena::used() const {
+    size_t bytes = offset_;
+    for (size_t i = 0; i < current_ && i < blocks_.size(); i++) bytes += blocks_[i].size;
+    return bytes;
+}
+
+Arena::Stats Arena::stats() const {
+    Stats stats;
+    stats.used = used();
+    stats.highWater = highWater_;
+    for (const Block& block : blocks_) stats.capacity += block.size;
+    stats.blocks = (int)blocks_.size();
+    stats.heapBlocks = heapBlocks_;
+    stats.resets = resets_;
+    return stats;
+}
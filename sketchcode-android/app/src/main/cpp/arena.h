@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Bump-pointer arena for the transient buffers of one utterance: padded audio, power
+ * spectra, beamformer channels, the mel itself before it is copied out.
+ *
+ * allocate() hands out aligned memory from the current block and only takes a new block
+ * from the heap when that one is full. Nothing is freed individually; reset() releases
+ * everything at once at the end of the utterance. If the utterance needed more than one
+ * block, reset() merges them into a single block of the high-water size, so after the
+ * first (warm-up) utterance of a given size, utterances allocate nothing from the heap.
+ *
+ * Marker / rewind() release the scratch of one stage while the utterance goes on.
+ * Not thread-safe: one arena per thread of work.
+ */
+class Arena {
+public:
+    // Cache-line alignment, enough for NEON / SSE loads
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct Stats {
+        size_t used = 0;          // bytes handed out since the last reset
+        size_t highWater = 0;     // largest `used` seen since creation
+        size_t capacity = 0;      // bytes held in blocks
+        int blocks = 0;
+        uint64_t heapBlocks = 0;  // blocks ever taken from the heap
+        uint64_t resets = 0;
+    };
+
+    struct Marker {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+
+    explicit Arena(size_t initialBytes = 0);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** bytes aligned to alignment, which may exceed the blocks' own ALIGNMENT. */
+    void* allocate(size_t bytes, size_t alignment = ALIGNMENT);
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T) > ALIGNMENT ? alignof(T) : ALIGNMENT));
+    }
+
+    Marker mark() const { return { current_, offset_ }; }
+    /** Release everything allocated after mark was taken. */
+    void rewind(const Marker& mark);
+
+    /** Release everything; keeps (and merges) the blocks for the next utterance. */
+    void reset();
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void addBlock(size_t minBytes);
+    size_t used() const;
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;         // block allocate() bumps in
+    size_t offset_ = 0;          // first free byte of blocks_[current_]
+    size_t highWater_ = 0;
+    uint64_t heapBlocks_ = 0;
+    uint64_t resets_ = 0;
+};
+
+/** Rewinds the arena to where it was on construction: scratch of one stage or call. */
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena_;
+    Arena::Marker mark_;
+};
@@ -0,0 +1,44 @@
+#include <jni.h>
+
+#include "arena.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin NativeArena owns a native Arena through an opaque jlong handle; the handle
+// is passed to the native stages (MelSpectrogram) that take their scratch from it.
+// Calls on one arena must not overlap: it belongs to one worker thread.
+
+static inline Arena* fromHandle(jlong handle) {
+    return reinterpret_cast<Arena*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_NativeArena_nativeCreate(JNIEnv * /* env */, jobject /* this */, jlong initialBytes) {
+    return reinterpret_cast<jlong>(new Arena(initialBytes > 0 ? (size_t)initialBytes : 0));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_NativeArena_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_NativeArena_nativeReset(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->reset();
+}
+
+// [used, highWater, capacity, blocks, heapBlocks, resets]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_sketchcode_app_whisper_NativeArena_nativeStats(JNIEnv *env, jobject /* this */, jlong handle) {
+    Arena::Stats stats = fromHandle(handle)->stats();
+    jlong values[6] = {
+        (jlong)stats.used, (jlong)stats.highWater, (jlong)stats.capacity,
+        (jlong)stats.blocks, (jlong)stats.heapBlocks, (jlong)stats.resets,
+    };
+    jlongArray result = env->NewLongArray(6);
+    if (result != nullptr) env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
@@ -0,0 +1,178 @@
+#include "beam_search.h"
+#include "logits.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "WhisperBeamSearch"
+#include "native_log.h"
+
+BeamSearch::BeamSearch(const BeamSearchConfig& config) : config_(config) {
+    config_.beamSize = std::clamp(config_.beamSize, 1, MAX_BEAM);
+    config_.patience = std::max(config_.patience, 1.0f / config_.beamSize);
+    beams_.reserve(config_.beamSize);
+    next_.reserve(config_.beamSize);
+    outSlots_.reserve(config_.beamSize);
+    candidates_.reserve(config_.beamSize * (config_.beamSize + 1));
+    LOGI("Beam search: width %d, length penalty %.2f, patience %.2f",
+         config_.beamSize, config_.lengthPenalty, config_.patience);
+}
+
+int BeamSearch::start(int32_t lastPromptToken, int maxTokens) {
+    std::fill(std::begin(refCounts_), std::end(refCounts_), 0);
+    beams_.clear();
+    finished_.clear();
+    candidates_.clear();
+    outSlots_.assign(1, -1);
+    maxTokens_ = std::clamp(maxTokens, 1, config_.maxTokens);
+    maxFinished_ = std::max(1, (int)lroundf(config_.beamSize * config_.patience));
+    length_ = 0;
+    done_ = false;
+
+    int slot = acquireSlot();
+    beams_.push_back({ {}, lastPromptToken, 0.0f, slot });
+    return slot;
+}
+
+int BeamSearch::tokens(int beam, int32_t* out, int maxCount) const {
+    if (beam < 0 || beam >= beamCount()) return 0;
+    const std::vector<int32_t>& seq = beams_[beam].tokens;
+    int n = std::min((int)seq.size(), maxCount);
+    std::copy(seq.begin(), seq.begin() + n, out);
+    return n;
+}
+
+int BeamSearch::scoreFp16(int beam, const uint16_t* logits) {
+    return score(beam, logSumExpFp16(logits, config_.vocabSize),
+                 [&](int k, int32_t* indices, float* values) {
+                     return topKFp16(logits, config_.vocabSize, k, indices, values);
+                 });
+}
+
+int BeamSearch::scoreFp32(int beam, const float* logits) {
+    return score(beam, logSumExpFp32(logits, config_.vocabSize),
+                 [&](int k, int32_t* indices, float* values) {
+                     return topKFp32(logits, config_.vocabSize, k, indices, values);
+                 });
+}
+
+template <typename TopK>
+int BeamSearch::score(int beam, float logSumExp, TopK topK) {
+    if (done_ || beam < 0 || beam >= beamCount() || outSlots_[beam] >= 0) return -1;
+
+    // beamSize + 1 candidates per beam: enough to refill every beam even if one is EOT
+    int32_t indices[MAX_BEAM + 1];
+    float values[MAX_BEAM + 1];
+    int n = topK(config_.beamSize + 1, indices, values);
+    float base = beams_[beam].logProb - logSumExp;
+    for (int i = 0; i < n; i++) {
+        if (std::isinf(values[i])) break; // suppressed; sorted, so the rest are too
+        candidates_.push_back({ beam, indices[i], base + values[i] });
+    }
+
+    int slot = acquireSlot();
+    outSlots_[beam] = slot;
+    return slot;
+}
+
+int BeamSearch::advance(int32_t* freedSlots) {
+    if (done_) return 0;
+
+    // Best first; ties by parent then token so the order is deterministic
+    std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.logProb != b.logProb) return a.logProb > b.logProb;
+        return a.parent != b.parent ? a.parent < b.parent : a.token < b.token;
+    });
+
+    next_.clear();
+    for (const Candidate& c : candidates_) {
+        const Hypothesis& parent = beams_[c.parent];
+        if (c.token == config_.eot) {
+            if ((int)finished_.size() < maxFinished_) finish(parent.tokens, c.logProb);
+            continue;
+        }
+        int slot = outSlots_[c.parent];
+        if (slot < 0) continue; // parent was not scored this step
+        Hypothesis child { parent.tokens, c.token, c.logProb, slot };
+        child.tokens.push_back(c.token);
+        next_.push_back(std::move(child));
+        refCounts_[slot]++;
+        if ((int)next_.size() >= config_.beamSize) break;
+    }
+    candidates_.clear();
+    length_++;
+
+    // Drop the parents' input slots and this step's own hold on the output slots;
+    // a slot stays alive only while some child still reads it.
+    int numFreed = 0;
+    for (size_t b = 0; b < beams_.size(); b++) {
+        releaseSlot(beams_[b].slot, freedSlots, &numFreed);
+        if (outSlots_[b] >= 0) releaseSlot(outSlots_[b], freedSlots, &numFreed);
+    }
+    beams_.swap(next_);
+    outSlots_.assign(beams_.size(), -1);
+
+    done_ = beams_.empty() || (int)finished_.size() >= maxFinished_ || length_ >= maxTokens_;
+    if (done_) {
+        // Out of length budget: unfinished beams compete with the finished ones
+        for (Hypothesis& h : beams_) {
+            if ((int)finished_.size() < maxFinished_) finish(std::move(h.tokens), h.logProb);
+            releaseSlot(h.slot, freedSlots, &numFreed);
+        }
+        beams_.clear();
+        outSlots_.clear();
+        LOGI("Beam search finished after %d tokens with %d candidates", length_, (int)finished_.size());
+    }
+    return numFreed;
+}
+
+int BeamSearch::best(int32_t* out, int maxCount) const {
+    const Finished* best = top();
+    if (!best) return 0;
+    int n = std::min((int)best->tokens.size(), maxCount);
+    std::copy(best->tokens.begin(), best->tokens.begin() + n, out);
+    return n;
+}
+
+float BeamSearch::bestLogProb() const {
+    const Finished* best = top();
+    return best ? best->logProb : 0.0f;
+}
+
+const BeamSearch::Finished* BeamSearch::top() const {
+    const Finished* best = nullptr;
+    for (const Finished& f : finished_) {
+        if (!best || f.score > best->score) best = &f;
+    }
+    return best;
+}
+
+int BeamSearch::acquireSlot() {
+    for (int slot = 0; slot < MAX_SLOTS; slot++) {
+        if (refCounts_[slot] == 0) {
+            refCounts_[slot] = 1;
+            return slot;
+        }
+    }
+    LOGE("No free KV-cache slot");
+    return -1;
+}
+
+void BeamSearch::releaseSlot(int slot, int32_t* freed, int* numFreed) {
+    if (slot < 0 || refCounts_[slot] <= 0) return;
+    if (--refCounts_[slot] == 0) freed[(*numFreed)++] = slot;
+}
+
+void BeamSearch::finish(std::vector<int32_t> tokens, float logProb) {
+    float score = rank(logProb, (int)tokens.size());
+    finished_.push_back({ std::move(tokens), logProb, score });
+}
+
+// Whisper's MaximumLikelihoodRanker
+float BeamSearch::rank(float logProb, int length) const {
+    if (length <= 0) return logProb;
+    float penalty = config_.lengthPenalty > 0.0f
+            ? powf((5.0f + length) / 6.0f, config_.lengthPenalty)
+            : (float)length;
+    return logProb / penalty;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Beam-search controller for the step-at-a-time Whisper decoder.
+ *
+ * The caller owns the decoder and its self-attention KV tensors; this class owns
+ * the hypotheses (tokens, cumulative log-probs), ranks finished sequences with
+ * Whisper's length penalty, and decides which KV-cache slot each beam reads.
+ *
+ * KV-cache slots are reference counted. A filled slot is never written again, so
+ * when a beam forks its children share the parent's slot instead of copying it
+ * (copy-on-write where the "write" is the decoder's next step, which always lands
+ * in a fresh slot). advance() reports the slots no beam references any more so the
+ * caller can release their tensors.
+ *
+ * Per step, for every beam b in [0, beamCount()):
+ *   run the decoder on lastToken(b) with the caches in beamSlot(b),
+ *   filter its logits, then outSlot = scoreFp16(b, logits) and store the decoder's
+ *   output caches in outSlot.
+ * Then advance(freed) and release the freed slots, until done().
+ */
+struct BeamSearchConfig {
+    int beamSize = 5;
+    int eot = 50257;
+    int vocabSize = 51866;
+    int maxTokens = 200;          // sampled tokens per hypothesis, EOT excluded
+    float lengthPenalty = 0.0f;   // 0: divide by length; > 0: Google NMT ((5 + len) / 6)^alpha
+    float patience = 1.0f;        // finished candidates to collect = beamSize * patience
+};
+
+class BeamSearch {
+public:
+    static constexpr int MAX_BEAM = 8;
+    static constexpr int MAX_SLOTS = 2 * MAX_BEAM;
+
+    explicit BeamSearch(const BeamSearchConfig& config);
+
+    /**
+     * Start a new utterance from a prompt ending in lastPromptToken.
+     * @param maxTokens per-utterance cap (clamped to the config's maxTokens)
+     * @return the slot the caller fills with the caches after the prompt prefix
+     */
+    int start(int32_t lastPromptToken, int maxTokens);
+
+    int beamCount() const { return (int)beams_.size(); }
+    int beamSlot(int beam) const { return beams_[beam].slot; }
+    int32_t lastToken(int beam) const { return beams_[beam].lastToken; }
+
+    /** Sampled tokens of a live beam (what the logit filters need); returns the count. */
+    int tokens(int beam, int32_t* out, int maxCount) const;
+
+    /**
+     * Record the candidates of one beam from its filtered logits.
+     * @return the slot where the caller stores this step's output caches, or -1 on error
+     */
+    int scoreFp16(int beam, const uint16_t* logits);
+    int scoreFp32(int beam, const float* logits);
+
+    /**
+     * Select the next beams from this step's candidates.
+     * @param freedSlots receives the slots that became unreferenced (at most MAX_SLOTS)
+     * @return number of freed slots
+     */
+    int advance(int32_t* freedSlots);
+
+    bool done() const { return done_; }
+    const BeamSearchConfig& config() const { return config_; }
+
+    /** Best finished sequence by length-penalized score (EOT excluded); returns the count. */
+    int best(int32_t* out, int maxCount) const;
+
+    /** Cumulative log-probability of that sequence (for the fallback's confidence check). */
+    float bestLogProb() const;
+
+private:
+    struct Hypothesis {
+        std::vector<int32_t> tokens;
+        int32_t lastToken;
+        float logProb;
+        int slot;
+    };
+    struct Candidate {
+        int parent;
+        int32_t token;
+        float logProb;
+    };
+    struct Finished {
+        std::vector<int32_t> tokens;
+        float logProb;
+        float score;
+    };
+
+    template <typename TopK>
+    int score(int beam, float logSumExp, TopK topK);
+    const Finished* top() const;
+    int acquireSlot();
+    void releaseSlot(int slot, int32_t* freed, int* numFreed);
+    void finish(std::vector<int32_t> tokens, float logProb);
+    float rank(float logProb, int length) const;
+
+    BeamSearchConfig config_;
+    std::vector<Hypothesis> beams_;
+    std::vector<Hypothesis> next_;
+    std::vector<int> outSlots_;          // per beam: slot holding this step's output caches
+    std::vector<Candidate> candidates_;
+    std::vector<Finished> finished_;
+    int refCounts_[MAX_SLOTS] = {};
+    int maxTokens_ = 0;
+    int maxFinished_ = 0;
+    int length_ = 0;
+    bool done_ = true;
+};
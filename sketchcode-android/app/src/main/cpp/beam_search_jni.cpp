@@ -0,0 +1,128 @@
+#include <jni.h>
+#include <algorithm>
+
+#include "beam_search.h"
+
+#define LOG_TAG "WhisperBeamSearch"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin BeamSearch owns a native BeamSearch through an opaque jlong handle.
+// Logits are read in place from the decoder's pinned direct buffer.
+
+static inline BeamSearch* fromHandle(jlong handle) {
+    return reinterpret_cast<BeamSearch*>(handle);
+}
+
+// Copies native ints into a caller-preallocated array; returns the number written.
+static jint fillIntArray(JNIEnv* env, jintArray array, const int32_t* values, int count) {
+    count = std::min(count, (int)env->GetArrayLength(array));
+    env->SetIntArrayRegion(array, 0, count, values);
+    return count;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jint beamSize, jint eot, jint vocabSize,
+        jint maxTokens, jfloat lengthPenalty, jfloat patience) {
+    BeamSearchConfig config;
+    config.beamSize = beamSize;
+    config.eot = eot;
+    config.vocabSize = vocabSize;
+    config.maxTokens = maxTokens;
+    config.lengthPenalty = lengthPenalty;
+    config.patience = patience;
+    return reinterpret_cast<jlong>(new BeamSearch(config));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeStart(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint lastPromptToken, jint maxTokens) {
+    return fromHandle(handle)->start(lastPromptToken, maxTokens);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeBeamCount(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->beamCount();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeBeamSlot(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint beam) {
+    return fromHandle(handle)->beamSlot(beam);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeLastToken(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint beam) {
+    return fromHandle(handle)->lastToken(beam);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeTokens(
+        JNIEnv *env, jobject /* this */, jlong handle, jint beam, jintArray outTokens) {
+    jint capacity = env->GetArrayLength(outTokens);
+    auto* tokens = static_cast<int32_t*>(env->GetPrimitiveArrayCritical(outTokens, nullptr));
+    int n = fromHandle(handle)->tokens(beam, tokens, capacity);
+    env->ReleasePrimitiveArrayCritical(outTokens, tokens, 0);
+    return n;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeScore(
+        JNIEnv *env, jobject /* this */, jlong handle, jint beam, jobject logitsBuffer, jboolean fp16) {
+    BeamSearch* search = fromHandle(handle);
+    void* logits = env->GetDirectBufferAddress(logitsBuffer);
+    jlong needed = (jlong)search->config().vocabSize * (fp16 ? 2 : 4);
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < needed) {
+        LOGE("BeamSearch: expected a direct logits buffer of %lld bytes", (long long)needed);
+        return -1;
+    }
+    return fp16 ? search->scoreFp16(beam, static_cast<const uint16_t*>(logits))
+                : search->scoreFp32(beam, static_cast<const float*>(logits));
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeAdvance(
+        JNIEnv *env, jobject /* this */, jlong handle, jintArray outFreedSlots) {
+    int32_t freed[BeamSearch::MAX_SLOTS];
+    int n = fromHandle(handle)->advance(freed);
+    return fillIntArray(env, outFreedSlots, freed, n);
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeBestLogProb(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->bestLogProb();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeDone(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->done() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BeamSearch_nativeBest(
+        JNIEnv *env, jobject /* this */, jlong handle, jintArray outTokens) {
+    jint capacity = env->GetArrayLength(outTokens);
+    auto* tokens = static_cast<int32_t*>(env->GetPrimitiveArrayCritical(outTokens, nullptr));
+    int n = fromHandle(handle)->best(tokens, capacity);
+    env->ReleasePrimitiveArrayCritical(outTokens, tokens, 0);
+    return n;
+}
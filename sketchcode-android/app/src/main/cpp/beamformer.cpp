@@ -0,0 +1,100 @@
+#include "beamformer.h"
+#include "mel_engine.h"
+#include "arena.h"
+
+#include <cmath>
+#include <algorithm>
+
+#define LOG_TAG "WhisperBeamformer"
+#include "native_log.h"
+
+// Frames quieter than this (sum of both channels' power) carry no usable phase
+static constexpr float MIN_FRAME_POWER = 1e-8f;
+
+BeamformResult estimateInterMicDelay(const float* left, const float* right, int numSamples, int maxDelay) {
+    BeamformResult result;
+    maxDelay = std::min(maxDelay, (FFT_SIZE - N_FFT) / 2);
+    if (numSamples < N_FFT) return result;
+
+    float window[N_FFT];
+    computeHannWindow(window, N_FFT);
+
+    float lRe[FFT_SIZE], lIm[FFT_SIZE];
+    float rRe[FFT_SIZE], rIm[FFT_SIZE];
+    float accRe[FFT_SIZE] = {}, accIm[FFT_SIZE] = {};
+
+    int numFrames = (numSamples - N_FFT) / HOP_LENGTH + 1;
+    for (int frame = 0; frame < numFrames; frame++) {
+        int start = frame * HOP_LENGTH;
+        frameSpectrum(left, start, window, lRe, lIm);
+        frameSpectrum(right, start, window, rRe, rIm);
+
+        float framePower = 0.0f;
+        for (int k = 0; k < FFT_OUT; k++) {
+            framePower += lRe[k] * lRe[k] + lIm[k] * lIm[k] + rRe[k] * rRe[k] + rIm[k] * rIm[k];
+        }
+        if (framePower < MIN_FRAME_POWER) continue;
+
+        // PHAT-weighted cross-spectrum: L * conj(R) / |L * conj(R)|
+        for (int k = 0; k < FFT_SIZE; k++) {
+            float cRe = lRe[k] * rRe[k] + lIm[k] * rIm[k];
+            float cIm = lIm[k] * rRe[k] - lRe[k] * rIm[k];
+            float mag = sqrtf(cRe * cRe + cIm * cIm);
+            if (mag > 1e-12f) {
+                accRe[k] += cRe / mag;
+                accIm[k] += cIm / mag;
+            }
+        }
+        result.framesUsed++;
+    }
+    if (result.framesUsed == 0) return result;
+
+    // Inverse FFT via conjugation: ifft(x) = conj(fft(conj(x))) / n
+    for (int k = 0; k < FFT_SIZE; k++) accIm[k] = -accIm[k];
+    fft(accRe, accIm, FFT_SIZE);
+
+    // Correlation at lag tau lives at index tau (tau >= 0) or FFT_SIZE + tau (tau < 0).
+    // A peak at tau means left[n] ~ right[n - tau], i.e. the right channel leads by tau.
+    int bestLag = 0;
+    float bestVal = -INFINITY;
+    for (int lag = -maxDelay; lag <= maxDelay; lag++) {
+        float v = accRe[(lag + FFT_SIZE) % FFT_SIZE];
+        if (v > bestVal) {
+            bestVal = v;
+            bestLag = lag;
+        }
+    }
+
+    result.delaySamples = -bestLag;
+    result.confidence = std::clamp(bestVal / ((float)FFT_SIZE * result.framesUsed), 0.0f, 1.0f);
+    return result;
+}
+
+BeamformResult beamformStereo(const float* interleaved, int numFrames, std::vector<float>& mono) {
+    Arena arena;
+    mono.resize(numFrames);
+    return beamformStereo(interleaved, numFrames, mono.data(), arena);
+}
+
+BeamformResult beamformStereo(const float* interleaved, int numFrames, float* mono, Arena& arena) {
+    ArenaScope scratch(arena);
+    float* left = arena.allocate<float>(numFrames);
+    float* right = arena.allocate<float>(numFrames);
+    for (int i = 0; i < numFrames; i++) {
+        left[i] = interleaved[2 * i];
+        right[i] = interleaved[2 * i + 1];
+    }
+
+    BeamformResult result = estimateInterMicDelay(left, right, numFrames, MAX_MIC_DELAY);
+    int d = result.delaySamples;
+
+    // Delay-and-sum: align right onto left, average where both channels exist
+    for (int i = 0; i < numFrames; i++) {
+        int j = i + d;
+        mono[i] = (j >= 0 && j < numFrames) ? 0.5f * (left[i] + right[j]) : left[i];
+    }
+
+    LOGI("Beamformed %d stereo frames: delay=%d samples, confidence=%.3f (%d STFT frames)",
+         numFrames, d, result.confidence, result.framesUsed);
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+class Arena;
+
+/**
+ * Two-microphone delay-and-sum beamformer.
+ *
+ * The inter-mic delay is estimated with GCC-PHAT: for each STFT frame (same
+ * Hann window / FFT size as the mel engine) the cross-spectrum X_L * conj(X_R)
+ * is whitened to unit magnitude and accumulated; the inverse FFT of the sum
+ * peaks at the lag between the channels. The right channel is then shifted by
+ * that lag and averaged with the left one, so the talker adds coherently while
+ * diffuse noise does not.
+ */
+
+// Largest delay searched, in samples. 16 samples at 16 kHz is ~34 cm of path
+// difference, well beyond the spacing of phone microphones.
+static constexpr int MAX_MIC_DELAY = 16;
+
+struct BeamformResult {
+    int delaySamples = 0;  // > 0: right channel lags the left channel
+    float confidence = 0;  // normalized GCC-PHAT peak in [0, 1]
+    int framesUsed = 0;    // STFT frames that contributed to the estimate
+};
+
+/**
+ * Estimate the delay of the right channel relative to the left.
+ * @param left,right  per-channel PCM, numSamples each
+ */
+BeamformResult estimateInterMicDelay(const float* left, const float* right, int numSamples, int maxDelay);
+
+/**
+ * Beamform interleaved stereo PCM ([L0, R0, L1, R1, ...], numFrames pairs) into mono.
+ * @param mono receives numFrames samples
+ */
+BeamformResult beamformStereo(const float* interleaved, int numFrames, std::vector<float>& mono);
+
+/** beamformStereo into mono (numFrames floats), with the per-channel copies taken from arena. */
+BeamformResult beamformStereo(const float* interleaved, int numFrames, float* mono, Arena& arena);
@@ -0,0 +1,188 @@
+#include "bpe_encoder.h"
+#include "vocabulary.h"
+
+#include <algorithm>
+
+// ---- Pre-tokenizer ----
+
+namespace {
+
+enum CharClass { CLASS_SPACE, CLASS_LETTER, CLASS_NUMBER, CLASS_OTHER };
+
+// Length of the UTF-8 sequence starting with lead byte b (1 for stray continuations)
+inline size_t utf8Length(uint8_t b) {
+    if (b < 0xC0) return 1;
+    if (b < 0xE0) return 2;
+    if (b < 0xF0) return 3;
+    return 4;
+}
+
+inline CharClass classOf(uint8_t b) {
+    if (b >= 0x80) return CLASS_LETTER;
+    if (b == ' ' || b == '\t' || b == '\n' || b == '\r' || b == '\f' || b == '\v') return CLASS_SPACE;
+    if ((b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z')) return CLASS_LETTER;
+    if (b >= '0' && b <= '9') return CLASS_NUMBER;
+    return CLASS_OTHER;
+}
+
+// End of the run of characters of class cls starting at i
+inline size_t runEnd(const uint8_t* text, size_t length, size_t i, CharClass cls) {
+    while (i < length && classOf(text[i]) == cls) {
+        i += cls == CLASS_LETTER ? utf8Length(text[i]) : 1;
+    }
+    return std::min(i, length);
+}
+
+// 's 't 're 've 'm 'll 'd at i; returns its length or 0
+inline size_t contraction(const uint8_t* text, size_t length, size_t i) {
+    if (text[i] != '\'' || i + 1 >= length) return 0;
+    uint8_t c = text[i + 1];
+    if (c == 's' || c == 't' || c == 'm' || c == 'd') return 2;
+    if (i + 2 < length) {
+        uint8_t d = text[i + 2];
+        if ((c == 'r' && d == 'e') || (c == 'v' && d == 'e') || (c == 'l' && d == 'l')) return 3;
+    }
+    return 0;
+}
+
+} // namespace
+
+void bpePretokenize(const uint8_t* text, size_t length, void (*emit)(void* ctx, size_t begin, size_t end), void* ctx) {
+    size_t i = 0;
+    while (i < length) {
+        if (size_t n = contraction(text, length, i)) {
+            emit(ctx, i, i + n);
+            i += n;
+            continue;
+        }
+        CharClass cls = classOf(text[i]);
+        if (cls == CLASS_SPACE) {
+            size_t end = runEnd(text, length, i, CLASS_SPACE);
+            if (end == length) {
+                emit(ctx, i, end);               // trailing whitespace
+                break;
+            }
+            // \s+(?!\S): the run minus the character that touches the next piece
+            if (end - i > 1) {
+                emit(ctx, i, end - 1);
+                i = end - 1;
+            }
+            if (text[i] != ' ') {                // only a plain space prefixes a piece
+                emit(ctx, i, i + 1);
+                i++;
+                continue;
+            }
+            // ' ?X': the space joins the piece that follows
+            CharClass next = classOf(text[i + 1]);
+            size_t pieceEnd = runEnd(text, length, i + 1, next);
+            emit(ctx, i, pieceEnd);
+            i = pieceEnd;
+            continue;
+        }
+        size_t end = runEnd(text, length, i, cls);
+        if (cls == CLASS_OTHER) {
+            // [^\s\p{L}\p{N}]+ also swallows apostrophes that are not contractions here
+            end = std::max(end, i + 1);
+        }
+        emit(ctx, i, end);
+        i = end;
+    }
+}
+
+// ---- BPE merges ----
+
+BpeEncoder::BpeEncoder(const Vocabulary* vocab, size_t cacheCapacity)
+    : vocab_(vocab), cacheCapacity_(cacheCapacity) {
+    cache_.reserve(cacheCapacity);
+}
+
+namespace {
+
+// Min-heap on (rank, left position): the lowest rank merges first, leftmost on ties
+struct CandidateOrder {
+    template <typename C>
+    bool operator()(const C& a, const C& b) const {
+        return a.rank != b.rank ? a.rank > b.rank : a.left > b.left;
+    }
+};
+
+} // namespace
+
+void BpeEncoder::merge(const uint8_t* bytes, size_t length, std::vector<int32_t>& out) {
+    out.clear();
+    int whole = vocab_->lookup(bytes, length);
+    if (whole >= 0) {                            // common case: the piece is one token
+        out.push_back(whole);
+        return;
+    }
+
+    // One part per byte; every single byte is a token in a byte-level vocabulary
+    parts_.resize(length);
+    for (size_t i = 0; i < length; i++) {
+        parts_[i] = { (uint32_t)i, 1, (int32_t)i - 1, i + 1 < length ? (int32_t)i + 1 : -1 };
+    }
+    heap_.clear();
+    auto push = [&](int32_t left) {
+        if (left < 0) return;
+        int32_t right = parts_[left].next;
+        if (right < 0) return;
+        int rank = vocab_->lookup(bytes + parts_[left].start, parts_[left].length + parts_[right].length);
+        if (rank < 0) return;
+        heap_.push_back({ rank, left, parts_[left].length, parts_[right].length });
+        std::push_heap(heap_.begin(), heap_.end(), CandidateOrder());
+    };
+    for (size_t i = 0; i + 1 < length; i++) push((int32_t)i);
+
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), CandidateOrder());
+        Candidate c = heap_.back();
+        heap_.pop_back();
+        // Stale if either side has merged with something else since it was queued
+        Part& left = parts_[c.left];
+        if (left.length != c.leftLength || left.next < 0 || parts_[left.next].length != c.rightLength) continue;
+
+        Part& right = parts_[left.next];
+        left.length += right.length;
+        right.length = 0;                        // dead; lengths of live parts are never 0
+        left.next = right.next;
+        if (right.next >= 0) parts_[right.next].prev = c.left;
+        push(left.prev);
+        push(c.left);
+    }
+
+    for (int32_t p = 0; p >= 0; p = parts_[p].next) {
+        out.push_back(vocab_->lookup(bytes + parts_[p].start, parts_[p].length));
+    }
+}
+
+const std::vector<int32_t>& BpeEncoder::encodePiece(const uint8_t* bytes, size_t length) {
+    std::string key(reinterpret_cast<const char*>(bytes), length);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        cacheHits_++;
+        return it->second;
+    }
+    if (cache_.size() >= cacheCapacity_) cache_.clear();
+    std::vector<int32_t>& tokens = cache_[std::move(key)];
+    merge(bytes, length, tokens);
+    return tokens;
+}
+
+int BpeEncoder::encode(const char* text, size_t length, int32_t* out, int capacity) {
+    struct Context {
+        BpeEncoder* encoder;
+        const uint8_t* text;
+        int32_t* out;
+        int capacity;
+        int count;
+    } ctx = { this, reinterpret_cast<const uint8_t*>(text), out, capacity, 0 };
+
+    bpePretokenize(ctx.text, length, [](void* p, size_t begin, size_t end) {
+        auto* c = static_cast<Context*>(p);
+        for (int32_t token : c->encoder->encodePiece(c->text + begin, end - begin)) {
+            if (c->count < c->capacity) c->out[c->count] = token;
+            c->count++;
+        }
+    }, &ctx);
+    return ctx.count;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Vocabulary;
+
+/**
+ * Byte-level BPE encoder for Whisper's tiktoken vocabulary, for prompt conditioning.
+ *
+ * Text is split with GPT-2's pre-tokenizer pattern
+ *   's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+ * (every non-ASCII code point counts as a letter), and each piece is merged
+ * separately. In a tiktoken vocabulary a token's id is its merge rank, so the
+ * merge-rank table is the vocabulary's own bytes → id hash: no merges file. Each
+ * merge pass pops the lowest-ranked adjacent pair (leftmost on ties) from a
+ * priority queue and requeues only the two pairs it changed.
+ *
+ * Results are cached per piece; identifiers repeat across a file and across
+ * utterances, so most pieces are hash hits after the first prompt.
+ */
+class BpeEncoder {
+public:
+    /** The vocabulary must outlive the encoder. */
+    explicit BpeEncoder(const Vocabulary* vocab, size_t cacheCapacity = 4096);
+
+    /**
+     * Encode UTF-8 text. Writes at most capacity ids to out; returns the full count.
+     */
+    int encode(const char* text, size_t length, int32_t* out, int capacity);
+
+    /** Tokens of one pre-tokenized piece (cached). */
+    const std::vector<int32_t>& encodePiece(const uint8_t* bytes, size_t length);
+
+    size_t cacheSize() const { return cache_.size(); }
+    uint64_t cacheHits() const { return cacheHits_; }
+
+private:
+    void merge(const uint8_t* bytes, size_t length, std::vector<int32_t>& out);
+
+    const Vocabulary* vocab_;
+    size_t cacheCapacity_;
+    std::unordered_map<std::string, std::vector<int32_t>> cache_;
+    uint64_t cacheHits_ = 0;
+
+    // Merge scratch, reused across pieces
+    struct Part {
+        uint32_t start;
+        uint32_t length;
+        int32_t prev;
+        int32_t next;
+    };
+    struct Candidate {
+        int32_t rank;
+        int32_t left;
+        uint32_t leftLength;
+        uint32_t rightLength;
+    };
+    std::vector<Part> parts_;
+    std::vector<Candidate> heap_;
+};
+
+/**
+ * Split UTF-8 text into GPT-2 pre-tokenizer pieces; calls emit(begin, end) in order.
+ * Exposed for the host check tool.
+ */
+void bpePretokenize(const uint8_t* text, size_t length, void (*emit)(void* ctx, size_t begin, size_t end), void* ctx);
@@ -0,0 +1,55 @@
+#include <jni.h>
+
+#include <vector>
+
+#include "bpe_encoder.h"
+#include "vocabulary.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin BpeEncoder owns a native encoder through an opaque jlong handle. It reads
+// the mapped vocabulary of the Kotlin Vocabulary it was created from, which must stay
+// open for as long as the encoder does. Text arrives as UTF-8 bytes (not a jstring,
+// whose modified UTF-8 differs for NUL and supplementary characters).
+
+static inline BpeEncoder* fromHandle(jlong handle) {
+    return reinterpret_cast<BpeEncoder*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_BpeEncoder_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jlong vocabHandle, jint cacheCapacity) {
+    if (vocabHandle == 0) return 0;
+    auto* encoder = new BpeEncoder(reinterpret_cast<const Vocabulary*>(vocabHandle), (size_t)cacheCapacity);
+    return reinterpret_cast<jlong>(encoder);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_BpeEncoder_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_sketchcode_app_whisper_BpeEncoder_nativeEncode(
+        JNIEnv *env, jobject /* this */, jlong handle, jbyteArray text) {
+    BpeEncoder* encoder = fromHandle(handle);
+    jsize length = env->GetArrayLength(text);
+    // Never more tokens than bytes: every byte is a token before merging
+    std::vector<int32_t> tokens((size_t)length);
+    auto* bytes = static_cast<const char*>(env->GetPrimitiveArrayCritical(text, nullptr));
+    if (bytes == nullptr) return nullptr;
+    int count = encoder->encode(bytes, (size_t)length, tokens.data(), (int)tokens.size());
+    env->ReleasePrimitiveArrayCritical(text, const_cast<char*>(bytes), JNI_ABORT);
+
+    jintArray out = env->NewIntArray(count);
+    if (out != nullptr) env->SetIntArrayRegion(out, 0, count, tokens.data());
+    return out;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_BpeEncoder_nativeCacheSize(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return (jint)fromHandle(handle)->cacheSize();
+}
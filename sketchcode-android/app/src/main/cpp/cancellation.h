@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * Cooperative cancellation for one transcription.
+ *
+ * The owner calls cancel() from any thread; the native loops doing the work poll it
+ * once per unit (a mel frame, a decoder step) and return early, leaving their output
+ * incomplete. Callers that pass a token check cancelled() after the call rather than
+ * trusting a partial result. Nothing blocks and no work is interrupted mid-unit, so
+ * every buffer is released by the loop's normal exit path.
+ */
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{ false };
+};
+
+/** True if token is set and cancelled; loops take an optional token. */
+static inline bool isCancelled(const CancellationToken* token) {
+    return token != nullptr && token->cancelled();
+}
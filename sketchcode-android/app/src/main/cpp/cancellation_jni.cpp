@@ -0,0 +1,43 @@
+#include <jni.h>
+
+#include "cancellation.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin CancellationToken owns a native token through an opaque jlong handle; the
+// handle is also passed to the mel spectrogram and the native decoder, which poll it
+// once per frame / step. cancel() may be called from any thread while they run.
+
+static inline CancellationToken* fromHandle(jlong handle) {
+    return reinterpret_cast<CancellationToken*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_CancellationToken_nativeCreate(JNIEnv * /* env */, jobject /* this */) {
+    return reinterpret_cast<jlong>(new CancellationToken());
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_CancellationToken_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_CancellationToken_nativeCancel(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->cancel();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_CancellationToken_nativeReset(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->reset();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_CancellationToken_nativeIsCancelled(
+        JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->cancelled() ? JNI_TRUE : JNI_FALSE;
+}
@@ -0,0 +1,163 @@
+#include "capture_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define LOG_TAG "WhisperCapture"
+#include "native_log.h"
+
+static inline uint64_t alignTo16(uint64_t n) {
+    return (n + 15) & ~(uint64_t)15;
+}
+
+bool appendCaptureRecord(const std::string& path, const CaptureRecordHeader& header,
+                         const float* samples, uint64_t maxFileBytes) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("Cannot open capture file %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Appenders take turns: the size check below decides whether this write also
+    // creates the file header, so it must not race another appender's first write
+    if (flock(fd, LOCK_EX) != 0) {
+        LOGE("Cannot lock capture file %s: %s", path.c_str(), strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        LOGE("Cannot stat capture file %s: %s", path.c_str(), strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    CaptureRecordHeader record = header;
+    memcpy(record.magic, CAPTURE_RECORD_MAGIC, sizeof(record.magic));
+    record.headerBytes = sizeof(CaptureRecordHeader);
+    uint64_t pcmBytes = (uint64_t)record.numSamples * sizeof(float);
+    record.payloadBytes = alignTo16(pcmBytes);
+
+    uint64_t recordBytes = sizeof(record) + record.payloadBytes;
+    uint64_t fileHeaderBytes = st.st_size == 0 ? sizeof(CaptureFileHeader) : 0;
+    if (maxFileBytes > 0 && (uint64_t)st.st_size + fileHeaderBytes + recordBytes > maxFileBytes) {
+        LOGW("Capture file %s is full (%lld bytes), dropping record", path.c_str(), (long long)st.st_size);
+        ::close(fd);
+        return false;
+    }
+
+    CaptureFileHeader fileHeader {};
+    memcpy(fileHeader.magic, CAPTURE_FILE_MAGIC, sizeof(fileHeader.magic));
+    fileHeader.version = CAPTURE_VERSION;
+
+    static const uint8_t zeros[16] = {};
+    struct iovec iov[4];
+    int iovCount = 0;
+    if (fileHeaderBytes > 0) {
+        iov[iovCount++] = { &fileHeader, sizeof(fileHeader) };
+    }
+    iov[iovCount++] = { &record, sizeof(record) };
+    iov[iovCount++] = { const_cast<float*>(samples), (size_t)pcmBytes };
+    iov[iovCount++] = { const_cast<uint8_t*>(zeros), (size_t)(record.payloadBytes - pcmBytes) };
+
+    // One gathered write keeps the record contiguous; closing releases the lock
+    ssize_t expected = (ssize_t)(fileHeaderBytes + recordBytes);
+    ssize_t written = writev(fd, iov, iovCount);
+    ::close(fd);
+    if (written != expected) {
+        LOGE("Short write to capture file %s (%zd of %zd bytes)", path.c_str(), written, expected);
+        return false;
+    }
+    LOGI("Captured %u samples (%u ch) to %s", record.numSamples, record.channels, path.c_str());
+    return true;
+}
+
+// ---- Reader ----
+
+CaptureLogReader::~CaptureLogReader() {
+    close();
+}
+
+void CaptureLogReader::close() {
+    if (map_ != nullptr) {
+        munmap(map_, mapSize_);
+    }
+    map_ = nullptr;
+    mapSize_ = 0;
+    pos_ = 0;
+    truncated_ = false;
+}
+
+bool CaptureLogReader::open(const std::string& path) {
+    close();
+    error_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "cannot open: " + std::string(strerror(errno));
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CaptureFileHeader)) {
+        error_ = "file too small for a capture header";
+        ::close(fd);
+        return false;
+    }
+    mapSize_ = (size_t)st.st_size;
+    map_ = mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        error_ = "mmap failed: " + std::string(strerror(errno));
+        return false;
+    }
+
+    const auto* fileHeader = static_cast<const CaptureFileHeader*>(map_);
+    if (memcmp(fileHeader->magic, CAPTURE_FILE_MAGIC, sizeof(CAPTURE_FILE_MAGIC)) != 0) {
+        error_ = "not a capture file";
+        close();
+        return false;
+    }
+    if (fileHeader->version != CAPTURE_VERSION) {
+        error_ = "unsupported capture version " + std::to_string(fileHeader->version);
+        close();
+        return false;
+    }
+    pos_ = sizeof(CaptureFileHeader);
+    return true;
+}
+
+bool CaptureLogReader::next(const CaptureRecordHeader** header, const float** samples) {
+    if (map_ == nullptr || pos_ >= mapSize_) return false;
+
+    const uint8_t* base = static_cast<const uint8_t*>(map_);
+    size_t remaining = mapSize_ - pos_;
+    const auto* record = reinterpret_cast<const CaptureRecordHeader*>(base + pos_);
+
+    if (remaining < sizeof(CaptureRecordHeader) ||
+        memcmp(record->magic, CAPTURE_RECORD_MAGIC, sizeof(CAPTURE_RECORD_MAGIC)) != 0 ||
+        record->headerBytes < CAPTURE_RECORD_MIN_HEADER_BYTES ||
+        record->headerBytes > remaining ||
+        record->payloadBytes > remaining - record->headerBytes ||
+        (uint64_t)record->numSamples * sizeof(float) > record->payloadBytes) {
+        truncated_ = true;
+        pos_ = mapSize_;
+        return false;
+    }
+
+    if (record->headerBytes < sizeof(CaptureRecordHeader)) {
+        shortHeader_ = CaptureRecordHeader {};
+        memcpy(&shortHeader_, record, record->headerBytes);
+        record = &shortHeader_;
+    }
+    *header = record;
+    *samples = reinterpret_cast<const float*>(base + pos_ + record->headerBytes);
+    pos_ += record->headerBytes + record->payloadBytes;
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Capture-and-replay corpus: an append-only file of recorded utterances.
+ *
+ * Layout (little-endian, every block 16-byte aligned so a mapping can be read in place):
+ *
+ *   CaptureFileHeader                         once, at offset 0
+ *   { CaptureRecordHeader, float32 PCM[] }    repeated, one per transcription
+ *
+ * Each record holds the exact samples fed to the mel engine (interleaved when
+ * channels == 2) plus the per-stage timings measured on device. Records are
+ * written with a single O_APPEND write under an exclusive flock (which also makes
+ * creating the file header atomic with the first record), so a crash can at worst
+ * leave a truncated tail record, which readers detect and ignore.
+ */
+
+static constexpr char CAPTURE_FILE_MAGIC[8] = { 'W', 'M', 'C', 'A', 'P', 'T', 'R', 'E' };
+static constexpr char CAPTURE_RECORD_MAGIC[4] = { 'U', 'T', 'T', 'R' };
+static constexpr uint32_t CAPTURE_VERSION = 1;
+
+enum CaptureStage {
+    CAPTURE_STAGE_MEL = 0,
+    CAPTURE_STAGE_ENCODER,
+    CAPTURE_STAGE_DECODER,
+    CAPTURE_STAGE_TOTAL,
+    CAPTURE_STAGE_COUNT_MAX = 8 // reserved slots in the record header
+};
+
+enum CaptureFlags : uint32_t {
+    CAPTURE_FLAG_DENOISE = 1u << 0,
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+static_assert(sizeof(CaptureFileHeader) == 16, "header must stay 16 bytes");
+
+struct CaptureRecordHeader {
+    char magic[4];
+    uint32_t headerBytes;      // sizeof(CaptureRecordHeader), lets newer readers skip added fields
+    uint64_t timestampMs;      // wall-clock capture time (Unix epoch)
+    uint64_t payloadBytes;     // PCM bytes following the header, padded to 16
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t numSamples;       // float32 samples in the payload (frames * channels)
+    uint32_t flags;            // CaptureFlags
+    uint32_t decodedTokens;
+    uint32_t reserved;
+    uint32_t stageMicros[CAPTURE_STAGE_COUNT_MAX]; // indexed by CaptureStage, 0 = not measured
+    // Mel front end as run on device (absent from records written before them: read as 0)
+    uint32_t melBucketFrames;  // melFramesForAudio() bucket, 0 = full N_FRAMES mel
+    uint32_t melQuantType;     // MelQuantType of the encoder input, 0 = fp32 only
+    float melQuantScale;
+    int32_t melQuantZeroPoint;
+};
+static_assert(sizeof(CaptureRecordHeader) % 16 == 0, "records must stay 16-byte aligned");
+
+// Header size of the first records, before the mel front-end fields
+static constexpr uint32_t CAPTURE_RECORD_MIN_HEADER_BYTES = 80;
+static_assert(offsetof(CaptureRecordHeader, melBucketFrames) == CAPTURE_RECORD_MIN_HEADER_BYTES,
+              "fields may only be added at the end");
+
+/**
+ * Append one utterance to the corpus at path, creating the file if needed.
+ * Refuses to grow the file past maxFileBytes (0 = unlimited).
+ * @return true if the record was written
+ */
+bool appendCaptureRecord(const std::string& path, const CaptureRecordHeader& header,
+                         const float* samples, uint64_t maxFileBytes);
+
+/**
+ * Read-only mapping of a capture corpus. Iterate with next() until it returns false.
+ */
+class CaptureLogReader {
+public:
+    CaptureLogReader() = default;
+    ~CaptureLogReader();
+    CaptureLogReader(const CaptureLogReader&) = delete;
+    CaptureLogReader& operator=(const CaptureLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const std::string& error() const { return error_; }
+
+    /**
+     * Advance to the next complete record. Pointers stay valid until close(); a header
+     * shorter than today's is returned as a copy, with the missing fields zeroed, that
+     * stays valid until the next call.
+     */
+    bool next(const CaptureRecordHeader** header, const float** samples);
+
+    /** True if the file ended in a partially written record. */
+    bool truncated() const { return truncated_; }
+
+private:
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+    size_t pos_ = 0;
+    bool truncated_ = false;
+    CaptureRecordHeader shortHeader_ {};
+    std::string error_;
+};
@@ -0,0 +1,41 @@
+#include <jni.h>
+#include <cstring>
+
+#include "capture_log.h"
+
+#define LOG_TAG "WhisperCapture"
+#include "native_log.h"
+
+// ---- JNI Entry Point ----
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_CaptureRecorder_nativeAppend(
+        JNIEnv *env, jobject /* this */, jstring pathString, jfloatArray audioArray,
+        jint sampleRate, jint channels, jint flags, jintArray stageMicrosArray,
+        jint decodedTokens, jlong timestampMs, jlong maxFileBytes, jint melBucketFrames, jint melQuantType,
+        jfloat melQuantScale, jint melQuantZeroPoint) {
+
+    CaptureRecordHeader header {};
+    header.timestampMs = (uint64_t)timestampMs;
+    header.sampleRate = (uint32_t)sampleRate;
+    header.channels = (uint32_t)channels;
+    header.numSamples = (uint32_t)env->GetArrayLength(audioArray);
+    header.flags = (uint32_t)flags;
+    header.decodedTokens = (uint32_t)decodedTokens;
+    header.melBucketFrames = melBucketFrames > 0 ? (uint32_t)melBucketFrames : 0;
+    header.melQuantType = (uint32_t)melQuantType;
+    header.melQuantScale = melQuantScale;
+    header.melQuantZeroPoint = melQuantZeroPoint;
+
+    jsize stageCount = env->GetArrayLength(stageMicrosArray);
+    if (stageCount > CAPTURE_STAGE_COUNT_MAX) stageCount = CAPTURE_STAGE_COUNT_MAX;
+    env->GetIntArrayRegion(stageMicrosArray, 0, stageCount, reinterpret_cast<jint*>(header.stageMicros));
+
+    const char* path = env->GetStringUTFChars(pathString, nullptr);
+    float* audio = env->GetFloatArrayElements(audioArray, nullptr);
+    bool ok = appendCaptureRecord(path, header, audio, (uint64_t)maxFileBytes);
+    env->ReleaseFloatArrayElements(audioArray, audio, JNI_ABORT);
+    env->ReleaseStringUTFChars(pathString, path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
@@ -0,0 +1,130 @@
+#include "context_bias.h"
+
+#include <algorithm>
+
+ContextBias::ContextBias(float boost, float startBoost) : boost_(boost), startBoost_(startBoost) {
+    clear();
+}
+
+void ContextBias::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_.clear();
+    nodes_.push_back({ -1, -1, 0, {} });
+    freeNodes_.clear();
+    edges_.clear();
+    maxDepth_ = 0;
+    words_ = 0;
+}
+
+int32_t ContextBias::child(int32_t node, int32_t token) const {
+    auto it = edges_.find(edgeKey(node, token));
+    if (it == edges_.end() || nodes_[it->second].refs == 0) return -1;
+    return it->second;
+}
+
+int32_t ContextBias::newNode(int32_t parent, int32_t token) {
+    int32_t id;
+    if (!freeNodes_.empty()) {
+        id = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[id].token = token;
+        nodes_[id].parent = parent;
+        nodes_[id].refs = 0;
+        nodes_[id].children.clear();
+    } else {
+        id = (int32_t)nodes_.size();
+        nodes_.push_back({ token, parent, 0, {} });
+    }
+    nodes_[parent].children.push_back(id);
+    edges_[edgeKey(parent, token)] = id;
+    return id;
+}
+
+void ContextBias::add(const int32_t* tokens, int length) {
+    if (length <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    int32_t node = 0;
+    nodes_[0].refs++;
+    for (int i = 0; i < length; i++) {
+        auto it = edges_.find(edgeKey(node, tokens[i]));
+        int32_t next = it != edges_.end() ? it->second : newNode(node, tokens[i]);
+        nodes_[next].refs++;
+        node = next;
+    }
+    maxDepth_ = std::max(maxDepth_, length);
+    words_++;
+}
+
+void ContextBias::remove(const int32_t* tokens, int length) {
+    if (length <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Only remove a word that is actually present, so counts never go negative
+    int32_t node = 0;
+    for (int i = 0; i < length; i++) {
+        node = child(node, tokens[i]);
+        if (node < 0) return;
+    }
+    nodes_[0].refs--;
+    // Back up to the root through the parent links (kept by dead nodes too)
+    while (node > 0) {
+        Node& n = nodes_[node];
+        int32_t parent = n.parent;
+        if (--n.refs == 0) {
+            // Unlink the dead node so it can be reused
+            edges_.erase(edgeKey(parent, n.token));
+            auto& siblings = nodes_[parent].children;
+            siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+            freeNodes_.push_back(node);
+        }
+        node = parent;
+    }
+    words_--;
+}
+
+int ContextBias::collect(const int32_t* tokens, int numTokens, int32_t* out, float* boostOut, int capacity) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (words_ == 0 || capacity <= 0) return 0;
+    int count = 0;
+    auto emitChildren = [&](int32_t node, float boost) {
+        for (int32_t c : nodes_[node].children) {
+            if (count == capacity) return;
+            out[count] = nodes_[c].token;
+            boostOut[count++] = boost;
+        }
+    };
+
+    // Every suffix of the last maxDepth - 1 tokens that spells a proper prefix of a word
+    int first = std::max(0, numTokens - (maxDepth_ - 1));
+    for (int start = first; start < numTokens; start++) {
+        int32_t node = 0;
+        for (int i = start; i < numTokens && node >= 0; i++) node = child(node, tokens[i]);
+        if (node > 0) emitChildren(node, boost_);
+    }
+    if (startBoost_ != 0.0f) emitChildren(0, startBoost_);
+    if (count <= 1) return count;
+
+    // A token continuing several prefixes is boosted once, by the largest boost
+    auto& unique = scratch_;
+    unique.resize(count);
+    for (int i = 0; i < count; i++) unique[i] = { out[i], boostOut[i] };
+    std::sort(unique.begin(), unique.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : a.second > b.second;
+    });
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (n > 0 && out[n - 1] == unique[i].first) continue;
+        out[n] = unique[i].first;
+        boostOut[n++] = unique[i].second;
+    }
+    return n;
+}
+
+int ContextBias::wordCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return words_;
+}
+
+int ContextBias::liveNodes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)(nodes_.size() - freeNodes_.size()) - 1;
+}
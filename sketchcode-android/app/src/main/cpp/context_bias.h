@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Identifier-aware contextual biasing: a token trie over the identifiers of the file
+ * on screen, each tokenized the way Whisper would write it (" getPendingAnnotation").
+ *
+ * Greedy decoding prefers common English continuations ("get pending annotation")
+ * over the file's own names. Once the decoded tokens end in a proper prefix of an
+ * identifier, every token that continues that identifier gets a logit boost, so
+ * " get" + "P" + "ending" + "Ann"... wins over " get" + " pending". Tokens that would
+ * start an identifier get the (usually smaller or zero) startBoost.
+ *
+ * Active prefixes are found from the last maxDepth tokens alone (no per-hypothesis
+ * state), so the same trie serves greedy decoding and every beam. A step costs one
+ * short walk per suffix, most of which fail at the first token, plus one boost per
+ * continuation of each active prefix.
+ *
+ * Words are reference counted: add()/remove() update the trie in place when the code
+ * snapshot changes, and nodes no word passes through any more are skipped and reused.
+ * All calls are thread-safe (updates arrive while a decode is running).
+ */
+class ContextBias {
+public:
+    explicit ContextBias(float boost = 2.0f, float startBoost = 0.0f);
+
+    void add(const int32_t* tokens, int length);
+    void remove(const int32_t* tokens, int length);
+    void clear();
+
+    /**
+     * Tokens to boost after the decoded history tokens[0, numTokens): continuations of
+     * every active prefix (deduplicated), written to out. boostOut receives the boost
+     * of each. Returns the count written (at most capacity).
+     */
+    int collect(const int32_t* tokens, int numTokens, int32_t* out, float* boostOut, int capacity) const;
+
+    int wordCount() const;
+    int liveNodes() const;
+    float boost() const { return boost_; }
+
+private:
+    struct Node {
+        int32_t token;
+        int32_t parent;
+        uint32_t refs;                    // words passing through; 0 = dead
+        std::vector<int32_t> children;
+    };
+
+    static uint64_t edgeKey(int32_t node, int32_t token) {
+        return ((uint64_t)(uint32_t)node << 32) | (uint32_t)token;
+    }
+    int32_t child(int32_t node, int32_t token) const;  // live child or -1
+    int32_t newNode(int32_t parent, int32_t token);
+
+    float boost_;
+    float startBoost_;
+    mutable std::mutex mutex_;
+    std::vector<Node> nodes_;                        // nodes_[0] is the root
+    std::vector<int32_t> freeNodes_;
+    std::unordered_map<uint64_t, int32_t> edges_;    // (node, token) → child
+    int maxDepth_ = 0;                               // longest word added (upper bound)
+    int words_ = 0;
+    mutable std::vector<std::pair<int32_t, float>> scratch_;   // collect() dedup, reused
+};
@@ -0,0 +1,56 @@
+#include <jni.h>
+
+#include "context_bias.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin ContextBias owns the native trie through an opaque jlong handle; the
+// handle is also attached to the LogitProcessor, which queries it every step.
+
+static inline ContextBias* fromHandle(jlong handle) {
+    return reinterpret_cast<ContextBias*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jfloat boost, jfloat startBoost) {
+    return reinterpret_cast<jlong>(new ContextBias(boost, startBoost));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeAdd(JNIEnv *env, jobject /* this */, jlong handle, jintArray tokens) {
+    jsize length = env->GetArrayLength(tokens);
+    auto* ids = static_cast<int32_t*>(env->GetPrimitiveArrayCritical(tokens, nullptr));
+    if (ids == nullptr) return;
+    fromHandle(handle)->add(ids, length);
+    env->ReleasePrimitiveArrayCritical(tokens, ids, JNI_ABORT);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeRemove(JNIEnv *env, jobject /* this */, jlong handle, jintArray tokens) {
+    jsize length = env->GetArrayLength(tokens);
+    auto* ids = static_cast<int32_t*>(env->GetPrimitiveArrayCritical(tokens, nullptr));
+    if (ids == nullptr) return;
+    fromHandle(handle)->remove(ids, length);
+    env->ReleasePrimitiveArrayCritical(tokens, ids, JNI_ABORT);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeClear(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->clear();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_ContextBias_nativeWordCount(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->wordCount();
+}
@@ -0,0 +1,53 @@
+#include "decode_guard.h"
+#include "mel_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "WhisperDecodeGuard"
+#include "native_log.h"
+
+DecodeGuard::DecodeGuard(const DecodeGuardConfig& config) : config_(config) {
+    tokens_.reserve(config_.maxTokens + 1);
+    reset(0.0f);
+}
+
+void DecodeGuard::reset(float speechSeconds) {
+    tokens_.clear();
+    std::fill(std::begin(runs_), std::end(runs_), 0);
+    keep_ = 0;
+    int estimate = (int)ceilf(speechSeconds * config_.tokensPerSecond) + config_.budgetSlack;
+    budget_ = std::clamp(estimate, config_.budgetSlack, config_.maxTokens);
+}
+
+DecodeStopReason DecodeGuard::accept(int32_t token) {
+    int i = (int)tokens_.size();
+    tokens_.push_back(token);
+    keep_ = i + 1;
+
+    // runs_[p]: how many consecutive trailing tokens equal the token p positions earlier.
+    // A period-p pattern repeated k times leaves a run of (k - 1) * p.
+    for (int p = 1; p <= MAX_PERIOD && p <= i; p++) {
+        runs_[p] = tokens_[i - p] == token ? runs_[p] + 1 : 0;
+    }
+    for (int p = 1; p <= MAX_PERIOD && p <= i; p++) {
+        int repeats = p == 1 ? config_.minRepeatsSingle : config_.minRepeats;
+        if (runs_[p] >= (repeats - 1) * p) {
+            keep_ = i + 1 - runs_[p];
+            LOGI("Repetition loop: period %d repeated %d times at token %d, keeping %d tokens",
+                 p, runs_[p] / p + 1, i, keep_);
+            return DECODE_STOP_REPETITION;
+        }
+    }
+
+    if ((int)tokens_.size() >= budget_) {
+        LOGI("Token budget of %d reached", budget_);
+        return DECODE_STOP_TOKEN_BUDGET;
+    }
+    return DECODE_CONTINUE;
+}
+
+float speechSecondsFromMel(const float* melSpec, int melStride, int numFrames) {
+    int speechFrames = detectSpeechFrames(melSpec, melStride, numFrames, nullptr);
+    return (float)speechFrames * HOP_LENGTH / SAMPLE_RATE;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Early-termination guard for the autoregressive decoder.
+ *
+ * Two independent stop conditions, checked once per generated token:
+ *  - Repetition: the tail of the sequence is a period-p pattern (p <= MAX_PERIOD)
+ *    repeated minRepeats times (minRepeatsSingle for p = 1). Tracked with one run
+ *    counter per period, so each token costs O(MAX_PERIOD).
+ *  - Token budget: derived from the clip's speech duration (speech frames of the
+ *    mel spectrogram), so silence or a short utterance cannot run to MAX_TOKENS.
+ *
+ * On a repetition stop, keepTokens() is the sequence length with only the first
+ * occurrence of the looping pattern kept.
+ */
+
+enum DecodeStopReason {
+    DECODE_CONTINUE = 0,
+    DECODE_STOP_REPETITION = 1,
+    DECODE_STOP_TOKEN_BUDGET = 2,
+    DECODE_STOP_CANCELLED = 3,      // set by the decoder loops, not by the guard
+};
+
+struct DecodeGuardConfig {
+    int maxTokens = 200;
+    float tokensPerSecond = 8.0f;   // generous for dictated code (identifiers split into many tokens)
+    int budgetSlack = 10;           // tokens allowed on top of the duration estimate
+    int minRepeats = 3;             // period >= 2
+    int minRepeatsSingle = 6;       // period 1 (the same token over and over)
+};
+
+class DecodeGuard {
+public:
+    static constexpr int MAX_PERIOD = 16;
+
+    explicit DecodeGuard(const DecodeGuardConfig& config = DecodeGuardConfig());
+
+    /** Start a new utterance with a token budget for speechSeconds of speech. */
+    void reset(float speechSeconds);
+
+    /** Feed the next generated token. */
+    DecodeStopReason accept(int32_t token);
+
+    int budget() const { return budget_; }
+    int keepTokens() const { return keep_; }
+    int tokenCount() const { return (int)tokens_.size(); }
+
+private:
+    DecodeGuardConfig config_;
+    std::vector<int32_t> tokens_;
+    int runs_[MAX_PERIOD + 1] = {};
+    int budget_ = 0;
+    int keep_ = 0;
+};
+
+/** Seconds of speech in a normalized [N_MELS x melStride] log-mel spectrogram. */
+float speechSecondsFromMel(const float* melSpec, int melStride, int numFrames);
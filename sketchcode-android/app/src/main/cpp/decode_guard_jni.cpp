@@ -0,0 +1,55 @@
+#include <jni.h>
+
+#include "decode_guard.h"
+#include "mel_engine.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin DecodeGuard owns a native DecodeGuard through an opaque jlong handle.
+
+static inline DecodeGuard* fromHandle(jlong handle) {
+    return reinterpret_cast<DecodeGuard*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_DecodeGuard_nativeCreate(JNIEnv * /* env */, jobject /* this */, jint maxTokens) {
+    DecodeGuardConfig config;
+    config.maxTokens = maxTokens;
+    return reinterpret_cast<jlong>(new DecodeGuard(config));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeGuard_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_DecodeGuard_nativeReset(
+        JNIEnv *env, jobject /* this */, jlong handle, jfloatArray melArray) {
+    float speechSeconds = (float)N_SAMPLES / SAMPLE_RATE;
+    // Full or trimmed (see melFramesForAudio) spectrograms
+    int frames = melFramesOf(env->GetArrayLength(melArray));
+    if (frames > 0) {
+        float* mel = env->GetFloatArrayElements(melArray, nullptr);
+        speechSeconds = speechSecondsFromMel(mel, frames, frames);
+        env->ReleaseFloatArrayElements(melArray, mel, JNI_ABORT);
+    }
+    DecodeGuard* guard = fromHandle(handle);
+    guard->reset(speechSeconds);
+    return guard->budget();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_DecodeGuard_nativeAccept(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint token) {
+    return fromHandle(handle)->accept(token);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_DecodeGuard_nativeKeepTokens(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->keepTokens();
+}
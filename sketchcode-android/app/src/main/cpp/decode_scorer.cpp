@@ -0,0 +1,96 @@
+#include "decode_scorer.h"
+#include "fp16.h"
+#include "logits.h"
+
+#include <cmath>
+#include <vector>
+#include <zlib.h>
+
+#define LOG_TAG "WhisperDecodeScorer"
+#include "native_log.h"
+
+DecodeScorer::DecodeScorer(const DecodeScorerConfig& config, uint64_t seed)
+        : config_(config), rng_(seed ? seed : 1) {
+}
+
+void DecodeScorer::reset() {
+    sumLogProb_ = 0.0f;
+    noSpeechProb_ = 0.0f;
+    avgLogProb_ = 0.0f;
+    compressionRatio_ = 0.0f;
+}
+
+void DecodeScorer::noSpeechFp16(const uint16_t* logits) {
+    float lse = logSumExpFp16(logits, config_.vocabSize);
+    noSpeechProb_ = expf(fp16ToFloat(logits[config_.noSpeechToken]) - lse);
+}
+
+void DecodeScorer::noSpeechFp32(const float* logits) {
+    float lse = logSumExpFp32(logits, config_.vocabSize);
+    noSpeechProb_ = expf(logits[config_.noSpeechToken] - lse);
+}
+
+int DecodeScorer::sampleFp16(const uint16_t* logits, float temperature) {
+    if (temperature <= 0.0f) return argmaxFp16(logits, config_.vocabSize);
+    return ::sampleFp16(logits, config_.vocabSize, temperature, nextUniform());
+}
+
+int DecodeScorer::sampleFp32(const float* logits, float temperature) {
+    if (temperature <= 0.0f) return argmaxFp32(logits, config_.vocabSize);
+    return ::sampleFp32(logits, config_.vocabSize, temperature, nextUniform());
+}
+
+// Log-softmax at one index: logit - logsumexp, with the max subtracted inside logsumexp
+void DecodeScorer::acceptFp16(const uint16_t* logits, int32_t token) {
+    if (token < 0 || token >= config_.vocabSize) return;
+    sumLogProb_ += fp16ToFloat(logits[token]) - logSumExpFp16(logits, config_.vocabSize);
+}
+
+void DecodeScorer::acceptFp32(const float* logits, int32_t token) {
+    if (token < 0 || token >= config_.vocabSize) return;
+    sumLogProb_ += logits[token] - logSumExpFp32(logits, config_.vocabSize);
+}
+
+DecodeVerdict DecodeScorer::verdict(const char* text, size_t textBytes, int numTokens) {
+    avgLogProb_ = sumLogProb_ / (float)(numTokens + 1);
+    compressionRatio_ = compressionRatio(text, textBytes);
+
+    bool lowConfidence = avgLogProb_ < config_.logProbThreshold;
+    DecodeVerdict verdict = DECODE_ACCEPT;
+    if (lowConfidence && noSpeechProb_ > config_.noSpeechThreshold) {
+        verdict = DECODE_NO_SPEECH;
+    } else if (compressionRatio_ > config_.compressionRatioThreshold || lowConfidence) {
+        verdict = DECODE_FALLBACK;
+    }
+    LOGI("avg logprob %.3f, compression ratio %.2f, no-speech %.3f -> %d",
+         avgLogProb_, compressionRatio_, noSpeechProb_, (int)verdict);
+    return verdict;
+}
+
+// xorshift64*: the top 24 bits give a uniform float in [0, 1)
+float DecodeScorer::nextUniform() {
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    uint64_t bits = rng_ * 0x2545F4914F6CDD1Dull;
+    return (float)(bits >> 40) * (1.0f / 16777216.0f);
+}
+
+float compressionRatio(const char* text, size_t textBytes) {
+    if (textBytes == 0) return 0.0f;
+
+    // Transcripts are at most a few hundred bytes: compress from a stack buffer when it fits
+    uint8_t stackBuffer[2048];
+    uLongf compressedBytes = compressBound((uLong)textBytes);
+    std::vector<uint8_t> heapBuffer;
+    uint8_t* out = stackBuffer;
+    if (compressedBytes > sizeof(stackBuffer)) {
+        heapBuffer.resize(compressedBytes);
+        out = heapBuffer.data();
+    }
+    if (compress2(out, &compressedBytes, reinterpret_cast<const Bytef*>(text), (uLong)textBytes,
+                  Z_DEFAULT_COMPRESSION) != Z_OK || compressedBytes == 0) {
+        return 0.0f;
+    }
+    return (float)textBytes / (float)compressedBytes;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Quality scoring for Whisper's temperature fallback (openai/whisper transcribe.py).
+ *
+ * One decode attempt accumulates the log-probability of every sampled token (log-softmax
+ * of the filtered logits, evaluated at the chosen token) and the no-speech probability
+ * from the first decoder step. verdict() then applies the reference rules:
+ *  - compression ratio of the text above compressionRatioThreshold (repetitive output), or
+ *  - average log-probability below logProbThreshold (low confidence)
+ * asks for a re-decode at the next temperature, unless the no-speech probability is
+ * above noSpeechThreshold while confidence is low, in which case the clip is silence.
+ *
+ * Sampling for temperature > 0 also lives here so the attempt's RNG state and scores
+ * stay together. Nothing allocates per step.
+ */
+struct DecodeScorerConfig {
+    int vocabSize = 51866;
+    int noSpeechToken = 50363;
+    float compressionRatioThreshold = 2.4f;
+    float logProbThreshold = -1.0f;
+    float noSpeechThreshold = 0.6f;
+};
+
+enum DecodeVerdict {
+    DECODE_ACCEPT = 0,
+    DECODE_FALLBACK = 1,
+    DECODE_NO_SPEECH = 2,
+};
+
+class DecodeScorer {
+public:
+    explicit DecodeScorer(const DecodeScorerConfig& config, uint64_t seed = 0x9E3779B97F4A7C15ull);
+
+    /** Start a new attempt. */
+    void reset();
+
+    /** Record P(no-speech) from the logits after the SOT token (unfiltered). */
+    void noSpeechFp16(const uint16_t* logits);
+    void noSpeechFp32(const float* logits);
+
+    /** Pick the next token: argmax at temperature 0, otherwise a softmax(logits / T) draw. */
+    int sampleFp16(const uint16_t* logits, float temperature);
+    int sampleFp32(const float* logits, float temperature);
+
+    /** Add log P(token) under the filtered logits to the running sum. */
+    void acceptFp16(const uint16_t* logits, int32_t token);
+    void acceptFp32(const float* logits, int32_t token);
+
+    /** Add an externally accumulated log-probability (e.g. a beam-search hypothesis). */
+    void addLogProb(float logProb) { sumLogProb_ += logProb; }
+
+    /**
+     * Judge the finished attempt.
+     * @param text,textBytes decoded UTF-8 text
+     * @param numTokens sampled tokens (Whisper averages over numTokens + 1, counting EOT)
+     */
+    DecodeVerdict verdict(const char* text, size_t textBytes, int numTokens);
+
+    float sumLogProb() const { return sumLogProb_; }
+    float noSpeechProb() const { return noSpeechProb_; }
+    float lastAvgLogProb() const { return avgLogProb_; }
+    float lastCompressionRatio() const { return compressionRatio_; }
+    const DecodeScorerConfig& config() const { return config_; }
+
+private:
+    float nextUniform();
+
+    DecodeScorerConfig config_;
+    uint64_t rng_;
+    float sumLogProb_ = 0.0f;
+    float noSpeechProb_ = 0.0f;
+    float avgLogProb_ = 0.0f;
+    float compressionRatio_ = 0.0f;
+};
+
+/** zlib compression ratio (raw bytes / compressed bytes) as Whisper computes it; 0 for empty text. */
+float compressionRatio(const char* text, size_t textBytes);
@@ -0,0 +1,122 @@
+#include <jni.h>
+
+#include "decode_scorer.h"
+
+#define LOG_TAG "WhisperDecodeScorer"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin DecodeScorer owns a native DecodeScorer through an opaque jlong handle.
+// Logits are read in place from the decoder's pinned direct buffer.
+
+static inline DecodeScorer* fromHandle(jlong handle) {
+    return reinterpret_cast<DecodeScorer*>(handle);
+}
+
+// Address of the pinned logits, or nullptr if the buffer is too small for the vocabulary.
+static const void* logitsAddress(JNIEnv* env, DecodeScorer* scorer, jobject logitsBuffer, jboolean fp16) {
+    const void* logits = env->GetDirectBufferAddress(logitsBuffer);
+    jlong needed = (jlong)scorer->config().vocabSize * (fp16 ? 2 : 4);
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < needed) {
+        LOGE("DecodeScorer: expected a direct logits buffer of %lld bytes", (long long)needed);
+        return nullptr;
+    }
+    return logits;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jint vocabSize, jint noSpeechToken, jlong seed) {
+    DecodeScorerConfig config;
+    config.vocabSize = vocabSize;
+    config.noSpeechToken = noSpeechToken;
+    return reinterpret_cast<jlong>(new DecodeScorer(config, (uint64_t)seed));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeReset(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->reset();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeNoSpeech(
+        JNIEnv *env, jobject /* this */, jlong handle, jobject logitsBuffer, jboolean fp16) {
+    DecodeScorer* scorer = fromHandle(handle);
+    const void* logits = logitsAddress(env, scorer, logitsBuffer, fp16);
+    if (logits == nullptr) return;
+    if (fp16) {
+        scorer->noSpeechFp16(static_cast<const uint16_t*>(logits));
+    } else {
+        scorer->noSpeechFp32(static_cast<const float*>(logits));
+    }
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeSample(
+        JNIEnv *env, jobject /* this */, jlong handle, jobject logitsBuffer, jboolean fp16, jfloat temperature) {
+    DecodeScorer* scorer = fromHandle(handle);
+    const void* logits = logitsAddress(env, scorer, logitsBuffer, fp16);
+    if (logits == nullptr) return -1;
+    return fp16 ? scorer->sampleFp16(static_cast<const uint16_t*>(logits), temperature)
+                : scorer->sampleFp32(static_cast<const float*>(logits), temperature);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeAccept(
+        JNIEnv *env, jobject /* this */, jlong handle, jobject logitsBuffer, jboolean fp16, jint token) {
+    DecodeScorer* scorer = fromHandle(handle);
+    const void* logits = logitsAddress(env, scorer, logitsBuffer, fp16);
+    if (logits == nullptr) return;
+    if (fp16) {
+        scorer->acceptFp16(static_cast<const uint16_t*>(logits), token);
+    } else {
+        scorer->acceptFp32(static_cast<const float*>(logits), token);
+    }
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeAddLogProb(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jfloat logProb) {
+    fromHandle(handle)->addLogProb(logProb);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeVerdict(
+        JNIEnv *env, jobject /* this */, jlong handle, jbyteArray textUtf8, jint numTokens) {
+    jsize length = env->GetArrayLength(textUtf8);
+    auto* text = static_cast<const char*>(env->GetPrimitiveArrayCritical(textUtf8, nullptr));
+    DecodeVerdict verdict = fromHandle(handle)->verdict(text, (size_t)length, numTokens);
+    env->ReleasePrimitiveArrayCritical(textUtf8, const_cast<char*>(text), JNI_ABORT);
+    return verdict;
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeAvgLogProb(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->lastAvgLogProb();
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeCompressionRatio(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->lastCompressionRatio();
+}
+
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_sketchcode_app_whisper_DecodeScorer_nativeNoSpeechProb(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->noSpeechProb();
+}
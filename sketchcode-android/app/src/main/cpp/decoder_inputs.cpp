@@ -0,0 +1,49 @@
+#include "decoder_inputs.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#define LOG_TAG "WhisperDecoderInputs"
+#include "native_log.h"
+
+static constexpr size_t ALIGNMENT = 64;
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+DecoderInputPool::DecoderInputPool(int maskSize, int numMasks, uint16_t maskValue, size_t zeroCacheElements)
+        : maskSize_(maskSize), numMasks_(numMasks), zeroCacheElements_(zeroCacheElements) {
+    if (maskSize <= 0 || numMasks <= 0) return;
+
+    // Layout: [masks][input_ids][position_ids][zero cache], each section cache-line aligned
+    size_t masksBytes = alignUp(maskBytes());
+    size_t scalarBytes = alignUp(sizeof(int32_t));
+    size_t total = masksBytes + 2 * scalarBytes + alignUp(zeroCacheBytes());
+    base_ = aligned_alloc(ALIGNMENT, total);
+    if (base_ == nullptr) {
+        LOGE("Failed to allocate %zu bytes for decoder inputs", total);
+        return;
+    }
+    memset(base_, 0, total);
+
+    auto* bytes = static_cast<uint8_t*>(base_);
+    masks_ = reinterpret_cast<uint16_t*>(bytes);
+    inputIds_ = reinterpret_cast<int32_t*>(bytes + masksBytes);
+    positionIds_ = reinterpret_cast<int32_t*>(bytes + masksBytes + scalarBytes);
+    zeroCache_ = reinterpret_cast<uint16_t*>(bytes + masksBytes + 2 * scalarBytes);
+
+    // Mask n: [maskValue x (maskSize - n - 1), 0.0 x (n + 1)] (0.0 is all-zero bits)
+    for (int n = 0; n < numMasks; n++) {
+        uint16_t* mask = masks_ + (size_t)n * maskSize;
+        int firstUnmasked = std::max(0, maskSize - n - 1);
+        std::fill(mask, mask + firstUnmasked, maskValue);
+    }
+    LOGI("Decoder input pool: %d masks x %d, %zu-value zero cache, %zu bytes",
+         numMasks, maskSize, zeroCacheElements, total);
+}
+
+DecoderInputPool::~DecoderInputPool() {
+    free(base_);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Preallocated, pinned inputs for the step-at-a-time decoder.
+ *
+ * One 64-byte-aligned allocation holds everything the decoder loop used to allocate
+ * per step or per transcription:
+ *  - numMasks fp16 attention masks of maskSize values, precomputed once. Mask n
+ *    unmasks the n + 1 rightmost positions (the sliding-window KV layout), the rest
+ *    hold maskValue.
+ *  - int32 input_ids and position_ids scalars, rewritten in place before each run.
+ *  - A zero-filled fp16 block used as the initial self-attention cache for every
+ *    layer (the decoder only reads it, so all layers share it).
+ *
+ * The memory is exposed to Kotlin as direct ByteBuffers, which ORT tensors wrap
+ * without copying; after construction the decoder loop allocates nothing.
+ */
+class DecoderInputPool {
+public:
+    DecoderInputPool(int maskSize, int numMasks, uint16_t maskValue, size_t zeroCacheElements);
+    ~DecoderInputPool();
+
+    DecoderInputPool(const DecoderInputPool&) = delete;
+    DecoderInputPool& operator=(const DecoderInputPool&) = delete;
+
+    bool valid() const { return base_ != nullptr; }
+
+    uint16_t* masks() const { return masks_; }
+    size_t maskBytes() const { return (size_t)maskSize_ * numMasks_ * sizeof(uint16_t); }
+    int32_t* inputIds() const { return inputIds_; }
+    int32_t* positionIds() const { return positionIds_; }
+    uint16_t* zeroCache() const { return zeroCache_; }
+    size_t zeroCacheBytes() const { return zeroCacheElements_ * sizeof(uint16_t); }
+
+private:
+    int maskSize_;
+    int numMasks_;
+    size_t zeroCacheElements_;
+    void* base_ = nullptr;
+    uint16_t* masks_ = nullptr;
+    int32_t* inputIds_ = nullptr;
+    int32_t* positionIds_ = nullptr;
+    uint16_t* zeroCache_ = nullptr;
+};
@@ -0,0 +1,56 @@
+#include <jni.h>
+
+#include "decoder_inputs.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin DecoderInputPool owns a native pool through an opaque jlong handle and
+// wraps its sections as direct ByteBuffers (valid until nativeDestroy).
+
+static inline DecoderInputPool* fromHandle(jlong handle) {
+    return reinterpret_cast<DecoderInputPool*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jint maskSize, jint numMasks, jshort maskValue,
+        jint zeroCacheElements) {
+    auto* pool = new DecoderInputPool(maskSize, numMasks, (uint16_t)maskValue, (size_t)zeroCacheElements);
+    if (!pool->valid()) {
+        delete pool;
+        return 0;
+    }
+    return reinterpret_cast<jlong>(pool);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativeMasks(JNIEnv *env, jobject /* this */, jlong handle) {
+    DecoderInputPool* pool = fromHandle(handle);
+    return env->NewDirectByteBuffer(pool->masks(), (jlong)pool->maskBytes());
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativeInputIds(JNIEnv *env, jobject /* this */, jlong handle) {
+    return env->NewDirectByteBuffer(fromHandle(handle)->inputIds(), sizeof(int32_t));
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativePositionIds(JNIEnv *env, jobject /* this */, jlong handle) {
+    return env->NewDirectByteBuffer(fromHandle(handle)->positionIds(), sizeof(int32_t));
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_sketchcode_app_whisper_DecoderInputPool_nativeZeroCache(JNIEnv *env, jobject /* this */, jlong handle) {
+    DecoderInputPool* pool = fromHandle(handle);
+    return env->NewDirectByteBuffer(pool->zeroCache(), (jlong)pool->zeroCacheBytes());
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// ---- IEEE 754 binary16 helpers (scalar) ----
+
+/** Exact fp16 → fp32 widening (handles subnormals, inf and NaN). */
+static inline float fp16ToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+    uint32_t bits;
+    if (exp == 0x1F) {
+        bits = sign | 0x7F800000 | (mant << 13);             // inf / NaN
+    } else if (exp != 0) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);     // normal: rebias 15 → 127
+    } else if (mant == 0) {
+        bits = sign;                                          // ±0
+    } else {
+        // Subnormal: normalize the mantissa
+        int shift = 0;
+        while ((mant & 0x400) == 0) {
+            mant <<= 1;
+            shift++;
+        }
+        bits = sign | ((uint32_t)(113 - shift) << 23) | ((mant & 0x3FF) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/** fp32 → fp16 with round-to-nearest-even; overflow saturates to ±inf, NaN stays NaN. */
+static inline uint16_t floatToFp16(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t absBits = bits & 0x7FFFFFFF;
+
+    if (absBits >= 0x7F800000) {
+        return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 : 0); // inf / quiet NaN
+    }
+    if (absBits >= 0x477FF000) {
+        return sign | 0x7C00;                                         // rounds past 65504
+    }
+    if (absBits < 0x38800000) {
+        // Result is subnormal (or zero): shift the implicit-one mantissa into place
+        if (absBits < 0x33000000) return sign;                        // below half the smallest subnormal
+        uint32_t exp = absBits >> 23;
+        uint32_t mant = (absBits & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - exp;                                   // 14..24
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1))) half++;
+        return sign | (uint16_t)half;
+    }
+    // Normal: rebias 127 → 15 and round the 13 dropped mantissa bits
+    uint32_t h = ((absBits - 0x38000000) >> 13);
+    uint32_t rem = absBits & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+    return sign | (uint16_t)h;
+}
+
+/**
+ * Map fp16 bits to a signed 16-bit key with the same ordering as the float values
+ * (for non-NaN inputs), so comparisons and max reductions can run on integer lanes
+ * without widening to fp32. -0 orders just below +0.
+ */
+static inline int16_t fp16OrderKey(uint16_t h) {
+    int16_t s = (int16_t)h;
+    return (int16_t)(s ^ ((s >> 15) & 0x7FFF));
+}
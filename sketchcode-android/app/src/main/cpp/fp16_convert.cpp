@@ -0,0 +1,95 @@
+#include "fp16_convert.h"
+#include "fp16.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FP16_CONVERT_NEON 1
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FP16_CONVERT_F16C 1
+#endif
+
+static void fp16ToFloatScalar(const uint16_t* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = fp16ToFloat(src[i]);
+}
+
+static void floatToFp16Scalar(const float* src, uint16_t* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) dst[i] = floatToFp16(src[i]);
+}
+
+#if defined(FP16_CONVERT_NEON)
+
+void fp16ToFloatArray(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(src + i));
+        vst1q_f32(dst + i, vcvt_f32_f16(vget_low_f16(h)));      // fcvtl
+        vst1q_f32(dst + i + 4, vcvt_high_f32_f16(h));           // fcvtl2
+    }
+    fp16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+void floatToFp16Array(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float16x4_t lo = vcvt_f16_f32(vld1q_f32(src + i));      // fcvtn
+        float16x8_t h = vcvt_high_f16_f32(lo, vld1q_f32(src + i + 4));  // fcvtn2
+        vst1q_u16(dst + i, vreinterpretq_u16_f16(h));
+    }
+    floatToFp16Scalar(src + i, dst + i, count - i);
+}
+
+const char* fp16ConvertBackend() { return "neon"; }
+
+#elif defined(FP16_CONVERT_F16C)
+
+__attribute__((target("avx,f16c")))
+static void fp16ToFloatF16c(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    fp16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx,f16c")))
+static void floatToFp16F16c(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    floatToFp16Scalar(src + i, dst + i, count - i);
+}
+
+static bool hasF16c() {
+    static const bool supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return supported;
+}
+
+void fp16ToFloatArray(const uint16_t* src, float* dst, size_t count) {
+    if (hasF16c()) fp16ToFloatF16c(src, dst, count);
+    else fp16ToFloatScalar(src, dst, count);
+}
+
+void floatToFp16Array(const float* src, uint16_t* dst, size_t count) {
+    if (hasF16c()) floatToFp16F16c(src, dst, count);
+    else floatToFp16Scalar(src, dst, count);
+}
+
+const char* fp16ConvertBackend() { return hasF16c() ? "f16c" : "scalar"; }
+
+#else
+
+void fp16ToFloatArray(const uint16_t* src, float* dst, size_t count) {
+    fp16ToFloatScalar(src, dst, count);
+}
+
+void floatToFp16Array(const float* src, uint16_t* dst, size_t count) {
+    floatToFp16Scalar(src, dst, count);
+}
+
+const char* fp16ConvertBackend() { return "scalar"; }
+
+#endif
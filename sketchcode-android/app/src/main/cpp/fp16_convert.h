@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bulk IEEE binary16 <-> binary32 conversion for tensor boundaries (the mel input,
+ * logits, cache dumps).
+ *
+ * arm64 uses NEON fcvtl / fcvtn, x86 hosts use F16C when the CPU has it (checked once
+ * at runtime), and everything else falls back to the scalar helpers in fp16.h. All
+ * paths round to nearest even, keep subnormals and saturate overflow to ±inf, so they
+ * agree bit for bit on every non-NaN input; NaN stays NaN (payload bits may differ).
+ */
+
+/** Widen count fp16 values to fp32. */
+void fp16ToFloatArray(const uint16_t* src, float* dst, size_t count);
+
+/** Narrow count fp32 values to fp16. */
+void floatToFp16Array(const float* src, uint16_t* dst, size_t count);
+
+/** Which implementation the calls above use on this CPU: "neon", "f16c" or "scalar". */
+const char* fp16ConvertBackend();
@@ -0,0 +1,74 @@
+#include <jni.h>
+
+#include "fp16_convert.h"
+
+#define LOG_TAG "WhisperFp16"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// fp16 sides are always direct ByteBuffers in native order (tensor memory pinned for
+// ORT); fp32 sides are either a FloatArray or another direct buffer.
+
+// Address of a direct buffer holding at least `bytes`, or nullptr (and a log line).
+static void* directAddress(JNIEnv* env, jobject buffer, jlong bytes, const char* what) {
+    void* data = env->GetDirectBufferAddress(buffer);
+    if (data == nullptr || env->GetDirectBufferCapacity(buffer) < bytes) {
+        LOGE("%s: expected a direct buffer of %lld bytes", what, (long long)bytes);
+        return nullptr;
+    }
+    return data;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_NativeFp16_nativeFloatsToFp16(
+        JNIEnv *env, jobject /* this */, jfloatArray src, jint offset, jobject dst, jint count) {
+    auto* out = static_cast<uint16_t*>(directAddress(env, dst, (jlong)count * 2, "floatsToFp16"));
+    if (out == nullptr || offset < 0 || offset + count > env->GetArrayLength(src)) return JNI_FALSE;
+    auto* in = static_cast<float*>(env->GetPrimitiveArrayCritical(src, nullptr));
+    if (in == nullptr) return JNI_FALSE;
+    floatToFp16Array(in + offset, out, (size_t)count);
+    env->ReleasePrimitiveArrayCritical(src, in, JNI_ABORT);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_NativeFp16_nativeFp16ToFloats(
+        JNIEnv *env, jobject /* this */, jobject src, jfloatArray dst, jint offset, jint count) {
+    auto* in = static_cast<const uint16_t*>(directAddress(env, src, (jlong)count * 2, "fp16ToFloats"));
+    if (in == nullptr || offset < 0 || offset + count > env->GetArrayLength(dst)) return JNI_FALSE;
+    auto* out = static_cast<float*>(env->GetPrimitiveArrayCritical(dst, nullptr));
+    if (out == nullptr) return JNI_FALSE;
+    fp16ToFloatArray(in, out + offset, (size_t)count);
+    env->ReleasePrimitiveArrayCritical(dst, out, 0);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_NativeFp16_nativeBufferToFp16(
+        JNIEnv *env, jobject /* this */, jobject src, jobject dst, jint count) {
+    auto* in = static_cast<const float*>(directAddress(env, src, (jlong)count * 4, "bufferToFp16"));
+    auto* out = static_cast<uint16_t*>(directAddress(env, dst, (jlong)count * 2, "bufferToFp16"));
+    if (in == nullptr || out == nullptr) return JNI_FALSE;
+    floatToFp16Array(in, out, (size_t)count);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_NativeFp16_nativeBufferToFloat(
+        JNIEnv *env, jobject /* this */, jobject src, jobject dst, jint count) {
+    auto* in = static_cast<const uint16_t*>(directAddress(env, src, (jlong)count * 2, "bufferToFloat"));
+    auto* out = static_cast<float*>(directAddress(env, dst, (jlong)count * 4, "bufferToFloat"));
+    if (in == nullptr || out == nullptr) return JNI_FALSE;
+    fp16ToFloatArray(in, out, (size_t)count);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_sketchcode_app_whisper_NativeFp16_nativeBackend(JNIEnv *env, jobject /* this */) {
+    return env->NewStringUTF(fp16ConvertBackend());
+}
@@ -0,0 +1,244 @@
+#include "keyword_spotter.h"
+#include "mel_engine.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#define LOG_TAG "WhisperKWS"
+#include "native_log.h"
+
+static constexpr char KWS_FILE_MAGIC[4] = { 'W', 'K', 'W', 'S' };
+static constexpr int KWS_FILE_VERSION = 1;
+
+// Frames kept around the detected speech region
+static constexpr int SPEECH_MARGIN_FRAMES = 5;
+// DTW rejects pairs whose lengths differ by more than this factor
+static constexpr float MAX_LENGTH_RATIO = 2.0f;
+
+// ---- MFCC ----
+
+// Orthonormal DCT-II basis [N_MFCC x N_MELS], computed once
+static const float* dctBasis() {
+    static float basis[N_MFCC * N_MELS];
+    static bool initialized = [] {
+        for (int i = 0; i < N_MFCC; i++) {
+            float scale = i == 0 ? sqrtf(1.0f / N_MELS) : sqrtf(2.0f / N_MELS);
+            for (int m = 0; m < N_MELS; m++) {
+                basis[i * N_MELS + m] = scale * cosf((float)M_PI * i * (m + 0.5f) / N_MELS);
+            }
+        }
+        return true;
+    }();
+    (void)initialized;
+    return basis;
+}
+
+void melToMfcc(const float* melSpec, int melStride, int frameBegin, int frameEnd, std::vector<float>& mfcc) {
+    const float* basis = dctBasis();
+    int frames = frameEnd - frameBegin;
+    mfcc.assign((size_t)frames * N_MFCC, 0.0f);
+
+    float column[N_MELS];
+    for (int f = 0; f < frames; f++) {
+        for (int m = 0; m < N_MELS; m++) {
+            column[m] = melSpec[m * melStride + frameBegin + f];
+        }
+        float* out = mfcc.data() + (size_t)f * N_MFCC;
+        for (int i = 0; i < N_MFCC; i++) {
+            float sum = 0.0f;
+            for (int m = 0; m < N_MELS; m++) {
+                sum += basis[i * N_MELS + m] * column[m];
+            }
+            out[i] = sum;
+        }
+    }
+
+    // Cepstral mean normalization removes the channel / microphone response
+    for (int i = 0; i < N_MFCC; i++) {
+        float mean = 0.0f;
+        for (int f = 0; f < frames; f++) mean += mfcc[(size_t)f * N_MFCC + i];
+        mean /= std::max(frames, 1);
+        for (int f = 0; f < frames; f++) mfcc[(size_t)f * N_MFCC + i] -= mean;
+    }
+}
+
+bool findSpeechRegion(const float* melSpec, int melStride, int numFrames, int* begin, int* end) {
+    numFrames = std::min(numFrames, melStride);
+    if (numFrames <= 0) return false;
+
+    std::vector<uint8_t> isSpeech(numFrames);
+    if (detectSpeechFrames(melSpec, melStride, numFrames, isSpeech.data()) == 0) return false;
+
+    int first = -1, last = -1;
+    for (int f = 0; f < numFrames; f++) {
+        if (isSpeech[f]) {
+            if (first < 0) first = f;
+            last = f;
+        }
+    }
+    if (first < 0) return false;
+
+    *begin = std::max(0, first - SPEECH_MARGIN_FRAMES);
+    *end = std::min(numFrames, last + 1 + SPEECH_MARGIN_FRAMES);
+    return true;
+}
+
+// ---- DTW ----
+
+static inline float frameDistance(const float* a, const float* b) {
+    float sum = 0.0f;
+    for (int i = 0; i < N_MFCC; i++) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sqrtf(sum);
+}
+
+// Sakoe-Chiba band DTW, normalized by the combined sequence length
+static float dtwDistance(const float* a, int n, const float* b, int m) {
+    if (n == 0 || m == 0) return INFINITY;
+    if ((float)std::max(n, m) / std::min(n, m) > MAX_LENGTH_RATIO) return INFINITY;
+
+    int band = std::max(std::abs(n - m), std::max(n, m) / 4) + 1;
+    std::vector<float> prev(m + 1, INFINITY), cur(m + 1, INFINITY);
+    prev[0] = 0.0f;
+
+    for (int i = 1; i <= n; i++) {
+        std::fill(cur.begin(), cur.end(), INFINITY);
+        // Band around the diagonal scaled to the length ratio
+        int center = (int)((long)i * m / n);
+        int jLo = std::max(1, center - band), jHi = std::min(m, center + band);
+        for (int j = jLo; j <= jHi; j++) {
+            float cost = frameDistance(a + (size_t)(i - 1) * N_MFCC, b + (size_t)(j - 1) * N_MFCC);
+            float best = std::min(prev[j - 1] + 2.0f * cost,  // diagonal steps count twice
+                                  std::min(prev[j], cur[j - 1]) + cost);
+            cur[j] = best;
+        }
+        std::swap(prev, cur);
+    }
+    return prev[m] / (float)(n + m);
+}
+
+// ---- KeywordSpotter ----
+
+bool KeywordSpotter::enroll(int commandId, const float* melSpec, int melStride, int numFrames) {
+    int begin, end;
+    if (!findSpeechRegion(melSpec, melStride, numFrames, &begin, &end)) {
+        LOGW("Enroll command %d: no speech found", commandId);
+        return false;
+    }
+    if (end - begin > MAX_COMMAND_FRAMES) {
+        LOGW("Enroll command %d: speech too long (%d frames)", commandId, end - begin);
+        return false;
+    }
+
+    Template t;
+    t.commandId = commandId;
+    t.frames = end - begin;
+    melToMfcc(melSpec, melStride, begin, end, t.mfcc);
+    templates_.push_back(std::move(t));
+    LOGI("Enrolled command %d: %d frames [%d, %d), %d templates total",
+         commandId, end - begin, begin, end, (int)templates_.size());
+    return true;
+}
+
+KeywordSpotter::Match KeywordSpotter::match(const float* melSpec, int melStride, int numFrames,
+                                            float maxDistance, float minMargin) const {
+    Match result;
+    if (templates_.empty()) return result;
+
+    int begin, end;
+    if (!findSpeechRegion(melSpec, melStride, numFrames, &begin, &end) || end - begin > MAX_COMMAND_FRAMES) {
+        return result;
+    }
+
+    std::vector<float> mfcc;
+    melToMfcc(melSpec, melStride, begin, end, mfcc);
+
+    // Best distance per command, then compare the winner against the runner-up command
+    int bestCommand = -1;
+    float best = INFINITY, runnerUp = INFINITY;
+    std::vector<std::pair<int, float>> perCommand;
+    for (const Template& t : templates_) {
+        float d = dtwDistance(mfcc.data(), end - begin, t.mfcc.data(), t.frames);
+        auto it = std::find_if(perCommand.begin(), perCommand.end(),
+                               [&](const std::pair<int, float>& p) { return p.first == t.commandId; });
+        if (it == perCommand.end()) {
+            perCommand.emplace_back(t.commandId, d);
+        } else {
+            it->second = std::min(it->second, d);
+        }
+    }
+    for (const auto& [command, d] : perCommand) {
+        if (d < best) {
+            runnerUp = best;
+            best = d;
+            bestCommand = command;
+        } else if (d < runnerUp) {
+            runnerUp = d;
+        }
+    }
+
+    result.distance = best;
+    result.margin = best > 0.0f ? runnerUp / best : INFINITY;
+    if (bestCommand >= 0 && best <= maxDistance && result.margin >= minMargin) {
+        result.commandId = bestCommand;
+    }
+    LOGI("KWS: %d speech frames, best command %d (distance %.3f, margin %.2f) → %d",
+         end - begin, bestCommand, best, result.margin, result.commandId);
+    return result;
+}
+
+void KeywordSpotter::removeCommand(int commandId) {
+    templates_.erase(std::remove_if(templates_.begin(), templates_.end(),
+                                    [&](const Template& t) { return t.commandId == commandId; }),
+                     templates_.end());
+}
+
+bool KeywordSpotter::save(const std::string& path) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+
+    int header[3] = { KWS_FILE_VERSION, N_MFCC, (int)templates_.size() };
+    bool ok = fwrite(KWS_FILE_MAGIC, 1, 4, f) == 4 && fwrite(header, sizeof(int), 3, f) == 3;
+    for (const Template& t : templates_) {
+        int meta[2] = { t.commandId, t.frames };
+        ok = ok && fwrite(meta, sizeof(int), 2, f) == 2 &&
+             fwrite(t.mfcc.data(), sizeof(float), t.mfcc.size(), f) == t.mfcc.size();
+    }
+    return fclose(f) == 0 && ok;
+}
+
+bool KeywordSpotter::load(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) return false;
+
+    char magic[4];
+    int header[3];
+    std::vector<Template> loaded;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, KWS_FILE_MAGIC, 4) == 0 &&
+              fread(header, sizeof(int), 3, f) == 3 &&
+              header[0] == KWS_FILE_VERSION && header[1] == N_MFCC && header[2] >= 0;
+    for (int i = 0; ok && i < header[2]; i++) {
+        int meta[2];
+        ok = fread(meta, sizeof(int), 2, f) == 2 && meta[1] > 0 && meta[1] <= MAX_COMMAND_FRAMES;
+        if (!ok) break;
+        Template t;
+        t.commandId = meta[0];
+        t.frames = meta[1];
+        t.mfcc.resize((size_t)t.frames * N_MFCC);
+        ok = fread(t.mfcc.data(), sizeof(float), t.mfcc.size(), f) == t.mfcc.size();
+        loaded.push_back(std::move(t));
+    }
+    fclose(f);
+
+    if (!ok) {
+        LOGW("Ignoring unreadable keyword templates in %s", path.c_str());
+        return false;
+    }
+    templates_ = std::move(loaded);
+    LOGI("Loaded %d keyword templates from %s", (int)templates_.size(), path.c_str());
+    return true;
+}
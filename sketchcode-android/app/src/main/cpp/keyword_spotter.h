@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Template-matching keyword spotter for short voice commands ("send", "undo", ...).
+ *
+ * Features are MFCCs derived from the normalized log-mel frames the mel engine
+ * already produced (orthonormal DCT-II over the 128 mel bins, cepstral mean
+ * normalized), trimmed to the speech region. Utterances are matched against
+ * enrolled templates with band-limited DTW; a command is only returned when the
+ * best template is close enough and clearly better than every other command.
+ */
+
+static constexpr int N_MFCC = 13;
+
+// Longest speech segment treated as a command (2.5 s); longer clips go to Whisper.
+static constexpr int MAX_COMMAND_FRAMES = 250;
+
+/**
+ * MFCCs of frames [frameBegin, frameEnd) of a [N_MELS x melStride] log-mel spectrogram.
+ * @param mfcc receives (frameEnd - frameBegin) * N_MFCC values, frame-major
+ */
+void melToMfcc(const float* melSpec, int melStride, int frameBegin, int frameEnd, std::vector<float>& mfcc);
+
+/**
+ * Locate the speech region in the first numFrames frames by per-frame log-mel energy.
+ * @return false if no frame rises above the noise floor
+ */
+bool findSpeechRegion(const float* melSpec, int melStride, int numFrames, int* begin, int* end);
+
+class KeywordSpotter {
+public:
+    struct Match {
+        int commandId = -1;     // -1: no confident match
+        float distance = 0.0f;  // normalized DTW distance of the best template
+        float margin = 0.0f;    // best distance of the runner-up command / distance
+    };
+
+    /**
+     * Add a template for commandId from a [N_MELS x melStride] log-mel spectrogram
+     * whose first numFrames frames contain the spoken command.
+     */
+    bool enroll(int commandId, const float* melSpec, int melStride, int numFrames);
+
+    /**
+     * Match an utterance. A command is accepted if its best distance is below
+     * maxDistance and every other command is at least minMargin times further away.
+     */
+    Match match(const float* melSpec, int melStride, int numFrames, float maxDistance, float minMargin) const;
+
+    void removeCommand(int commandId);
+    void clear() { templates_.clear(); }
+    int templateCount() const { return (int)templates_.size(); }
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    struct Template {
+        int commandId;
+        int frames;
+        std::vector<float> mfcc;
+    };
+
+    std::vector<Template> templates_;
+};
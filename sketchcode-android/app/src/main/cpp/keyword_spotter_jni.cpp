@@ -0,0 +1,87 @@
+#include <jni.h>
+#include <algorithm>
+
+#include "keyword_spotter.h"
+#include "mel_engine.h"
+
+#define LOG_TAG "WhisperKWS"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin KeywordSpotter owns a native KeywordSpotter through an opaque jlong handle.
+
+static inline KeywordSpotter* fromHandle(jlong handle) {
+    return reinterpret_cast<KeywordSpotter*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeCreate(JNIEnv * /* env */, jobject /* this */) {
+    return reinterpret_cast<jlong>(new KeywordSpotter());
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeEnroll(
+        JNIEnv *env, jobject /* this */, jlong handle, jint commandId, jfloatArray melArray, jint numFrames) {
+    int stride = melFramesOf(env->GetArrayLength(melArray));
+    if (stride == 0) return JNI_FALSE;
+    float* mel = env->GetFloatArrayElements(melArray, nullptr);
+    bool ok = fromHandle(handle)->enroll(commandId, mel, stride, std::min((int)numFrames, stride));
+    env->ReleaseFloatArrayElements(melArray, mel, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeMatch(
+        JNIEnv *env, jobject /* this */, jlong handle, jfloatArray melArray, jint numFrames,
+        jfloat maxDistance, jfloat minMargin) {
+    int stride = melFramesOf(env->GetArrayLength(melArray));
+    if (stride == 0) return -1;
+    float* mel = env->GetFloatArrayElements(melArray, nullptr);
+    KeywordSpotter::Match match = fromHandle(handle)->match(mel, stride, std::min((int)numFrames, stride),
+                                                            maxDistance, minMargin);
+    env->ReleaseFloatArrayElements(melArray, mel, JNI_ABORT);
+    return match.commandId;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeRemoveCommand(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint commandId) {
+    fromHandle(handle)->removeCommand(commandId);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeTemplateCount(
+        JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->templateCount();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeSave(
+        JNIEnv *env, jobject /* this */, jlong handle, jstring pathString) {
+    const char* path = env->GetStringUTFChars(pathString, nullptr);
+    bool ok = fromHandle(handle)->save(path);
+    env->ReleaseStringUTFChars(pathString, path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_KeywordSpotter_nativeLoad(
+        JNIEnv *env, jobject /* this */, jlong handle, jstring pathString) {
+    const char* path = env->GetStringUTFChars(pathString, nullptr);
+    bool ok = fromHandle(handle)->load(path);
+    env->ReleaseStringUTFChars(pathString, path);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
@@ -0,0 +1,172 @@
+#include "logit_processor.h"
+#include "context_bias.h"
+#include "fp16.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "WhisperLogitProc"
+#include "native_log.h"
+
+static constexpr uint16_t FP16_NEG_INF = 0xFC00;
+
+// ---- Element access for fp16 / fp32 logits ----
+
+namespace {
+
+struct Fp16Logits {
+    uint16_t* data;
+
+    float get(int i) const { return fp16ToFloat(data[i]); }
+    void set(int i, float v) const { data[i] = floatToFp16(v); }
+    void suppress(int i) const { data[i] = FP16_NEG_INF; }
+    void suppressRange(int begin, int end) const {
+        std::fill(data + begin, data + end, FP16_NEG_INF);
+    }
+    // Max over [begin, end) on order keys (no widening), returned as fp32
+    float maxInRange(int begin, int end) const {
+        if (begin >= end) return -INFINITY;
+        int16_t best = INT16_MIN;
+        for (int i = begin; i < end; i++) {
+            best = std::max(best, fp16OrderKey(data[i]));
+        }
+        // The key transform is its own inverse
+        return fp16ToFloat((uint16_t)fp16OrderKey((uint16_t)best));
+    }
+};
+
+struct Fp32Logits {
+    float* data;
+
+    float get(int i) const { return data[i]; }
+    void set(int i, float v) const { data[i] = v; }
+    void suppress(int i) const { data[i] = -INFINITY; }
+    void suppressRange(int begin, int end) const {
+        std::fill(data + begin, data + end, -INFINITY);
+    }
+    float maxInRange(int begin, int end) const {
+        float best = -INFINITY;
+        for (int i = begin; i < end; i++) {
+            best = std::max(best, data[i]);
+        }
+        return best;
+    }
+};
+
+} // namespace
+
+// ---- LogitProcessor ----
+
+LogitProcessor::LogitProcessor(const LogitProcessorConfig& config) : config_(config) {
+    // Drop out-of-range IDs once so apply() needs no bounds checks
+    auto& suppress = config_.suppressTokens;
+    suppress.erase(std::remove_if(suppress.begin(), suppress.end(),
+                                  [&](int32_t t) { return t < 0 || t >= config_.vocabSize; }),
+                   suppress.end());
+    std::sort(suppress.begin(), suppress.end());
+    suppress.erase(std::unique(suppress.begin(), suppress.end()), suppress.end());
+    config_.timestampBegin = std::min(config_.timestampBegin, config_.vocabSize);
+    penalized_.assign(config_.vocabSize, 0);
+    biasTokens_.resize(256);
+    biasBoosts_.resize(256);
+
+    LOGI("Logit processor: %d suppressed tokens, timestamps=%d, repetition penalty=%.2f",
+         (int)suppress.size(), config_.timestamps ? 1 : 0, config_.repetitionPenalty);
+}
+
+void LogitProcessor::applyFp16(uint16_t* logits, const int32_t* tokens, int numTokens) {
+    apply(Fp16Logits { logits }, tokens, numTokens);
+}
+
+void LogitProcessor::applyFp32(float* logits, const int32_t* tokens, int numTokens) {
+    apply(Fp32Logits { logits }, tokens, numTokens);
+}
+
+template <typename Logits>
+void LogitProcessor::apply(Logits logits, const int32_t* tokens, int numTokens) {
+    const LogitProcessorConfig& c = config_;
+    const int tsBegin = c.timestampBegin;
+
+    // Repetition penalty first, so suppression below always wins
+    if (c.repetitionPenalty != 1.0f && numTokens > 0) {
+        for (int i = 0; i < numTokens; i++) {
+            int t = tokens[i];
+            if (t < 0 || t >= tsBegin || penalized_[t]) continue; // text and specials only
+            penalized_[t] = 1;
+            float v = logits.get(t);
+            logits.set(t, v > 0.0f ? v / c.repetitionPenalty : v * c.repetitionPenalty);
+        }
+        for (int i = 0; i < numTokens; i++) {
+            int t = tokens[i];
+            if (t >= 0 && t < tsBegin) penalized_[t] = 0;
+        }
+    }
+
+    // Contextual biasing, also before suppression (-inf stays -inf)
+    if (bias_ != nullptr) {
+        int n = bias_->collect(tokens, numTokens, biasTokens_.data(), biasBoosts_.data(), (int)biasTokens_.size());
+        for (int i = 0; i < n; i++) {
+            int t = biasTokens_[i];
+            if (t >= 0 && t < tsBegin) logits.set(t, logits.get(t) + biasBoosts_[i]);
+        }
+    }
+
+    // SuppressTokens
+    for (int32_t t : c.suppressTokens) {
+        logits.suppress(t);
+    }
+
+    // SuppressBlank: don't start with a space or end immediately
+    if (numTokens == 0) {
+        if (c.blankToken >= 0 && c.blankToken < c.vocabSize) logits.suppress(c.blankToken);
+        logits.suppress(c.eot);
+    }
+
+    if (!c.timestamps) {
+        logits.suppressRange(tsBegin, c.vocabSize);
+        return;
+    }
+
+    // ---- ApplyTimestampRules ----
+    logits.suppress(c.noTimestamps);
+
+    // Timestamps come in pairs, except directly before EOT
+    bool lastWasTimestamp = numTokens >= 1 && tokens[numTokens - 1] >= tsBegin;
+    bool penultimateWasTimestamp = numTokens < 2 || tokens[numTokens - 2] >= tsBegin;
+    if (lastWasTimestamp) {
+        if (penultimateWasTimestamp) {
+            logits.suppressRange(tsBegin, c.vocabSize); // must be text or EOT
+        } else {
+            logits.suppressRange(0, c.eot);             // must be a timestamp or EOT
+        }
+    }
+
+    // Timestamps never go backwards (and only repeat to close a pair)
+    for (int i = numTokens - 1; i >= 0; i--) {
+        if (tokens[i] < tsBegin) continue;
+        int timestampLast = (lastWasTimestamp && !penultimateWasTimestamp) ? tokens[i] : tokens[i] + 1;
+        logits.suppressRange(tsBegin, std::min(timestampLast, c.vocabSize));
+        break;
+    }
+
+    if (numTokens == 0) {
+        // The first token has to be a timestamp, no later than maxInitialTimestampIndex
+        logits.suppressRange(0, tsBegin);
+        int lastAllowed = tsBegin + c.maxInitialTimestampIndex;
+        if (lastAllowed + 1 < c.vocabSize) logits.suppressRange(lastAllowed + 1, c.vocabSize);
+    }
+
+    // If the total probability of timestamps beats any single text token, force a timestamp.
+    // Softmax normalization cancels out, so compare logsumexp(timestamps) with max(text).
+    float maxText = logits.maxInRange(0, tsBegin);
+    float maxTs = logits.maxInRange(tsBegin, c.vocabSize);
+    if (std::isfinite(maxTs)) {
+        float sum = 0.0f;
+        for (int i = tsBegin; i < c.vocabSize; i++) {
+            sum += expf(logits.get(i) - maxTs);
+        }
+        if (maxTs + logf(sum) > maxText) {
+            logits.suppressRange(0, tsBegin);
+        }
+    }
+}
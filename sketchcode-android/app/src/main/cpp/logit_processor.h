@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ContextBias;
+
+/**
+ * Whisper's logit filters, applied in place to the decoder's logits before the
+ * greedy/top-k pick (see openai/whisper decoding.py for the reference rules):
+ *
+ *  - SuppressTokens: a fixed set (non-speech symbols, task/SOT specials) is set to -inf.
+ *  - SuppressBlank: at the first sampled step, " " and <|endoftext|> are set to -inf.
+ *  - Timestamps: with timestamps off, every timestamp token is suppressed; with them on,
+ *    pairs, monotonicity, the initial-timestamp limit and the "timestamp mass beats
+ *    the best text token" rule are enforced.
+ *  - Repetition penalty (CTRL-style) on tokens already generated.
+ *  - Contextual biasing (optional ContextBias): continuations of identifiers from the
+ *    file on screen are boosted.
+ *
+ * Configure once per session; apply() is one call per decoder step. Range fills and
+ * vocab-wide reductions are vectorized, the static suppress list is a short scatter.
+ * apply() reuses per-step scratch held by the processor: one processor per decode.
+ */
+struct LogitProcessorConfig {
+    int vocabSize = 51866;
+    int eot = 50257;
+    int noTimestamps = 50364;
+    int timestampBegin = 50365;
+    int blankToken = 220;                 // " "
+    std::vector<int32_t> suppressTokens;  // suppressed at every step
+    bool timestamps = false;
+    int maxInitialTimestampIndex = 50;    // first timestamp at most 1.0 s
+    float repetitionPenalty = 1.0f;       // 1 = disabled
+};
+
+class LogitProcessor {
+public:
+    explicit LogitProcessor(const LogitProcessorConfig& config);
+
+    /**
+     * Filter one step's logits in place.
+     * @param tokens  tokens sampled so far (after the prompt), numTokens entries
+     */
+    void applyFp16(uint16_t* logits, const int32_t* tokens, int numTokens);
+    void applyFp32(float* logits, const int32_t* tokens, int numTokens);
+
+    const LogitProcessorConfig& config() const { return config_; }
+
+    /** Boost identifier continuations from bias (not owned; nullptr to stop). */
+    void setContextBias(const ContextBias* bias) { bias_ = bias; }
+
+private:
+    template <typename Logits>
+    void apply(Logits logits, const int32_t* tokens, int numTokens);
+
+    LogitProcessorConfig config_;
+    const ContextBias* bias_ = nullptr;
+    // Per-step scratch for deduplicating penalized tokens (sized once, never reallocated)
+    std::vector<uint8_t> penalized_;
+    // Per-step scratch for the bias's boosted tokens
+    std::vector<int32_t> biasTokens_;
+    std::vector<float> biasBoosts_;
+};
@@ -0,0 +1,341 @@
+#include "logits.h"
+#include "fp16.h"
+#include "fp16_convert.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ---- Argmax ----
+// Two passes: a SIMD max reduction, then a scan for the first lane equal to the max.
+// Both passes stream the 100 KB logits buffer from L2, which beats tracking indices
+// per lane in a single pass.
+
+static int16_t maxKeyFp16(const uint16_t* logits, int count, int* tail) {
+    int i = 0;
+    int16_t best = INT16_MIN;
+#if defined(__ARM_NEON)
+    if (count >= 8) {
+        int16x8_t vmax = vdupq_n_s16(INT16_MIN);
+        int16x8_t mask = vdupq_n_s16(0x7FFF);
+        for (; i + 8 <= count; i += 8) {
+            int16x8_t s = vreinterpretq_s16_u16(vld1q_u16(logits + i));
+            int16x8_t key = veorq_s16(s, vandq_s16(vshrq_n_s16(s, 15), mask));
+            vmax = vmaxq_s16(vmax, key);
+        }
+        best = vmaxvq_s16(vmax);
+    }
+#elif defined(__SSE2__)
+    if (count >= 8) {
+        __m128i vmax = _mm_set1_epi16(INT16_MIN);
+        __m128i mask = _mm_set1_epi16(0x7FFF);
+        for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(logits + i));
+            __m128i key = _mm_xor_si128(s, _mm_and_si128(_mm_srai_epi16(s, 15), mask));
+            vmax = _mm_max_epi16(vmax, key);
+        }
+        alignas(16) int16_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vmax);
+        for (int16_t lane : lanes) {
+            if (lane > best) best = lane;
+        }
+    }
+#endif
+    *tail = i;
+    return best;
+}
+
+int argmaxFp16(const uint16_t* logits, int count) {
+    if (count <= 0) return -1;
+
+    int tail;
+    int16_t best = maxKeyFp16(logits, count, &tail);
+    for (int i = tail; i < count; i++) {
+        int16_t key = fp16OrderKey(logits[i]);
+        if (key > best) best = key;
+    }
+
+    // First index holding the max key
+    int i = 0;
+#if defined(__ARM_NEON)
+    int16x8_t target = vdupq_n_s16(best);
+    int16x8_t mask = vdupq_n_s16(0x7FFF);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s = vreinterpretq_s16_u16(vld1q_u16(logits + i));
+        int16x8_t key = veorq_s16(s, vandq_s16(vshrq_n_s16(s, 15), mask));
+        if (vmaxvq_u16(vceqq_s16(key, target)) != 0) break;
+    }
+#elif defined(__SSE2__)
+    __m128i target = _mm_set1_epi16(best);
+    __m128i mask = _mm_set1_epi16(0x7FFF);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(logits + i));
+        __m128i key = _mm_xor_si128(s, _mm_and_si128(_mm_srai_epi16(s, 15), mask));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(key, target)) != 0) break;
+    }
+#endif
+    for (; i < count; i++) {
+        if (fp16OrderKey(logits[i]) == best) return i;
+    }
+    return 0; // unreachable for non-empty input
+}
+
+int argmaxFp32(const float* logits, int count) {
+    if (count <= 0) return -1;
+
+    int i = 0;
+    float best = logits[0];
+#if defined(__ARM_NEON)
+    if (count >= 4) {
+        float32x4_t vmax = vld1q_f32(logits);
+        for (i = 4; i + 4 <= count; i += 4) {
+            vmax = vmaxq_f32(vmax, vld1q_f32(logits + i));
+        }
+        best = vmaxvq_f32(vmax);
+    }
+#elif defined(__SSE2__)
+    if (count >= 4) {
+        __m128 vmax = _mm_loadu_ps(logits);
+        for (i = 4; i + 4 <= count; i += 4) {
+            vmax = _mm_max_ps(vmax, _mm_loadu_ps(logits + i));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, vmax);
+        best = lanes[0];
+        for (float lane : lanes) {
+            if (lane > best) best = lane;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        if (logits[i] > best) best = logits[i];
+    }
+
+    for (i = 0; i < count; i++) {
+        if (logits[i] == best) return i;
+    }
+    return 0;
+}
+
+// ---- Top-k ----
+// Min-heap of the best k candidates seen so far; its root is the admission threshold.
+// Candidates compare by (key, -index) so that equal values keep the earlier index.
+
+namespace {
+
+template <typename Key>
+struct Candidate {
+    Key key;
+    int32_t index;
+};
+
+template <typename Key>
+struct WorseFirst {
+    // std::push_heap builds a max-heap of the comparator; "greater" puts the worst on top
+    bool operator()(const Candidate<Key>& a, const Candidate<Key>& b) const {
+        return a.key != b.key ? a.key > b.key : a.index < b.index;
+    }
+};
+
+template <typename Key>
+class TopKHeap {
+public:
+    explicit TopKHeap(int k) : k_(k) {}
+
+    Key threshold() const { return heap_[0].key; }
+
+    void offer(Key key, int32_t index) {
+        if (size_ < k_) {
+            heap_[size_++] = { key, index };
+            std::push_heap(heap_, heap_ + size_, WorseFirst<Key>());
+        } else if (key > heap_[0].key) {
+            std::pop_heap(heap_, heap_ + size_, WorseFirst<Key>());
+            heap_[size_ - 1] = { key, index };
+            std::push_heap(heap_, heap_ + size_, WorseFirst<Key>());
+        }
+    }
+
+    /** Best first. */
+    int sorted(Candidate<Key>* out) {
+        std::copy(heap_, heap_ + size_, out);
+        std::sort(out, out + size_, WorseFirst<Key>());
+        return size_;
+    }
+
+private:
+    Candidate<Key> heap_[MAX_TOP_K];
+    int size_ = 0;
+    int k_;
+};
+
+} // namespace
+
+int topKFp16(const uint16_t* logits, int count, int k, int32_t* outIndices, float* outValues) {
+    k = std::min({ k, count, MAX_TOP_K });
+    if (k <= 0) return 0;
+
+    TopKHeap<int16_t> heap(k);
+    int i = 0;
+    for (; i < k; i++) {
+        heap.offer(fp16OrderKey(logits[i]), i);
+    }
+
+#if defined(__ARM_NEON)
+    int16x8_t mask = vdupq_n_s16(0x7FFF);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s = vreinterpretq_s16_u16(vld1q_u16(logits + i));
+        int16x8_t key = veorq_s16(s, vandq_s16(vshrq_n_s16(s, 15), mask));
+        if (vmaxvq_u16(vcgtq_s16(key, vdupq_n_s16(heap.threshold()))) == 0) continue;
+        for (int j = i; j < i + 8; j++) {
+            heap.offer(fp16OrderKey(logits[j]), j);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i mask = _mm_set1_epi16(0x7FFF);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(logits + i));
+        __m128i key = _mm_xor_si128(s, _mm_and_si128(_mm_srai_epi16(s, 15), mask));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi16(key, _mm_set1_epi16(heap.threshold()))) == 0) continue;
+        for (int j = i; j < i + 8; j++) {
+            heap.offer(fp16OrderKey(logits[j]), j);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        heap.offer(fp16OrderKey(logits[i]), i);
+    }
+
+    Candidate<int16_t> best[MAX_TOP_K];
+    int n = heap.sorted(best);
+    for (int j = 0; j < n; j++) {
+        outIndices[j] = best[j].index;
+        outValues[j] = fp16ToFloat(logits[best[j].index]);
+    }
+    return n;
+}
+
+int topKFp32(const float* logits, int count, int k, int32_t* outIndices, float* outValues) {
+    k = std::min({ k, count, MAX_TOP_K });
+    if (k <= 0) return 0;
+
+    TopKHeap<float> heap(k);
+    int i = 0;
+    for (; i < k; i++) {
+        heap.offer(logits[i], i);
+    }
+
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t threshold = vdupq_n_f32(heap.threshold());
+        uint32x4_t above = vorrq_u32(vcgtq_f32(vld1q_f32(logits + i), threshold),
+                                     vcgtq_f32(vld1q_f32(logits + i + 4), threshold));
+        if (vmaxvq_u32(above) == 0) continue;
+        for (int j = i; j < i + 8; j++) {
+            heap.offer(logits[j], j);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128 threshold = _mm_set1_ps(heap.threshold());
+        __m128 above = _mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(logits + i), threshold),
+                                 _mm_cmpgt_ps(_mm_loadu_ps(logits + i + 4), threshold));
+        if (_mm_movemask_ps(above) == 0) continue;
+        for (int j = i; j < i + 8; j++) {
+            heap.offer(logits[j], j);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        heap.offer(logits[i], i);
+    }
+
+    Candidate<float> best[MAX_TOP_K];
+    int n = heap.sorted(best);
+    for (int j = 0; j < n; j++) {
+        outIndices[j] = best[j].index;
+        outValues[j] = best[j].key;
+    }
+    return n;
+}
+
+// ---- Log-sum-exp ----
+// The vectorized argmax finds the max; the exp pass is a plain loop over fp32
+// (fp16 logits are widened a block at a time with the bulk converter).
+
+float logSumExpFp16(const uint16_t* logits, int count) {
+    if (count <= 0) return -INFINITY;
+    float maxValue = fp16ToFloat(logits[argmaxFp16(logits, count)]);
+    if (std::isinf(maxValue)) return maxValue;
+
+    constexpr int BLOCK = 256;
+    float widened[BLOCK];
+    float sum = 0.0f;
+    for (int start = 0; start < count; start += BLOCK) {
+        int n = std::min(BLOCK, count - start);
+        fp16ToFloatArray(logits + start, widened, (size_t)n);
+        for (int i = 0; i < n; i++) {
+            sum += expf(widened[i] - maxValue);
+        }
+    }
+    return maxValue + logf(sum);
+}
+
+float logSumExpFp32(const float* logits, int count) {
+    if (count <= 0) return -INFINITY;
+    float maxValue = logits[argmaxFp32(logits, count)];
+    if (std::isinf(maxValue)) return maxValue;
+
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sum += expf(logits[i] - maxValue);
+    }
+    return maxValue + logf(sum);
+}
+
+// ---- Sampling ----
+
+namespace {
+
+template <typename Get>
+int sampleScaled(Get get, int count, float maxValue, float temperature, float uniform) {
+    float invT = 1.0f / temperature;
+    float total = 0.0f;
+    for (int i = 0; i < count; i++) {
+        total += expf((get(i) - maxValue) * invT);
+    }
+
+    float target = uniform * total;
+    float cumulative = 0.0f;
+    int last = -1;
+    for (int i = 0; i < count; i++) {
+        float w = expf((get(i) - maxValue) * invT);
+        if (w <= 0.0f) continue;
+        cumulative += w;
+        last = i;
+        if (cumulative > target) return i;
+    }
+    return last; // rounding left target at the very top of the CDF
+}
+
+} // namespace
+
+int sampleFp16(const uint16_t* logits, int count, float temperature, float uniform) {
+    if (count <= 0) return -1;
+    int best = argmaxFp16(logits, count);
+    float maxValue = fp16ToFloat(logits[best]);
+    if (temperature <= 0.0f || std::isinf(maxValue)) return best;
+    return sampleScaled([&](int i) { return fp16ToFloat(logits[i]); }, count, maxValue, temperature, uniform);
+}
+
+int sampleFp32(const float* logits, int count, float temperature, float uniform) {
+    if (count <= 0) return -1;
+    int best = argmaxFp32(logits, count);
+    float maxValue = logits[best];
+    if (temperature <= 0.0f || std::isinf(maxValue)) return best;
+    return sampleScaled([&](int i) { return logits[i]; }, count, maxValue, temperature, uniform);
+}
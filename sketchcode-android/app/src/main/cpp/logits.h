@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Vectorized reductions over the decoder's logits ([1, 51866, 1, 1], vocab on dim 1).
+ *
+ * The fp16 variants work on the raw half-precision bits: values are mapped to an
+ * order-preserving int16 key (see fp16OrderKey), so the reduction runs on integer
+ * SIMD lanes (NEON on arm64, SSE2 on x86 hosts) without converting to fp32.
+ * Ties resolve to the lowest index, matching a scalar "strictly greater" scan.
+ * NaN logits are not expected and are not handled specially.
+ */
+
+/** Index of the largest fp16 value in logits[0, count). */
+int argmaxFp16(const uint16_t* logits, int count);
+
+/** Index of the largest fp32 value in logits[0, count). */
+int argmaxFp32(const float* logits, int count);
+
+// Largest k supported by the top-k kernels (the heap lives on the stack)
+static constexpr int MAX_TOP_K = 64;
+
+/**
+ * Partial top-k: the k largest logits, sorted by value descending (ties by index).
+ * A SIMD pre-filter skips 8-lane blocks that cannot beat the current k-th best, so
+ * the small heap is only touched for a few hundred candidates per step.
+ * @param outIndices,outValues receive min(k, count, MAX_TOP_K) entries (values as fp32)
+ * @return number of entries written
+ */
+int topKFp16(const uint16_t* logits, int count, int k, int32_t* outIndices, float* outValues);
+
+/** fp32 variant of topKFp16. */
+int topKFp32(const float* logits, int count, int k, int32_t* outIndices, float* outValues);
+
+// ---- Log-softmax normalizer ----
+
+/**
+ * log(sum(exp(logits))) over [0, count), stabilized by the max; a logit's
+ * log-probability is logit - logSumExp. Suppressed (-inf) entries contribute 0;
+ * returns -inf if every entry is suppressed.
+ */
+float logSumExpFp16(const uint16_t* logits, int count);
+
+/** fp32 variant of logSumExpFp16. */
+float logSumExpFp32(const float* logits, int count);
+
+// ---- Temperature sampling ----
+
+/**
+ * Draw an index from softmax(logits / temperature) by inverting the CDF at
+ * uniform * total (uniform in [0, 1)). Two passes over the logits, no scratch
+ * memory. Suppressed (-inf) entries are never drawn.
+ */
+int sampleFp16(const uint16_t* logits, int count, float temperature, float uniform);
+
+/** fp32 variant of sampleFp16. */
+int sampleFp32(const float* logits, int count, float temperature, float uniform);
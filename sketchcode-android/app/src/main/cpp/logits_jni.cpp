@@ -0,0 +1,140 @@
+#include <jni.h>
+#include <algorithm>
+
+#include "context_bias.h"
+#include "logits.h"
+#include "logit_processor.h"
+
+#define LOG_TAG "WhisperLogits"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// Logits arrive as direct ByteBuffers (the decoder's pinned output tensor), so the
+// native side reads them in place: no copy into a Java array and no fp16 widening.
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeLogits_nativeArgmaxFp16(
+        JNIEnv *env, jobject /* this */, jobject logitsBuffer, jint count) {
+    auto* logits = static_cast<const uint16_t*>(env->GetDirectBufferAddress(logitsBuffer));
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < (jlong)count * 2) {
+        LOGE("argmaxFp16: expected a direct buffer of %d fp16 values", (int)count);
+        return -1;
+    }
+    return argmaxFp16(logits, count);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeLogits_nativeArgmaxFp32(
+        JNIEnv *env, jobject /* this */, jobject logitsBuffer, jint count) {
+    auto* logits = static_cast<const float*>(env->GetDirectBufferAddress(logitsBuffer));
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < (jlong)count * 4) {
+        LOGE("argmaxFp32: expected a direct buffer of %d fp32 values", (int)count);
+        return -1;
+    }
+    return argmaxFp32(logits, count);
+}
+
+// Writes the top-k into caller-preallocated arrays; returns the number of entries.
+static jint copyTopK(JNIEnv* env, jint n, const int32_t* indices, const float* values,
+                     jintArray outIndices, jfloatArray outValues) {
+    env->SetIntArrayRegion(outIndices, 0, n, reinterpret_cast<const jint*>(indices));
+    env->SetFloatArrayRegion(outValues, 0, n, values);
+    return n;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeLogits_nativeTopKFp16(
+        JNIEnv *env, jobject /* this */, jobject logitsBuffer, jint count, jint k,
+        jintArray outIndices, jfloatArray outValues) {
+    auto* logits = static_cast<const uint16_t*>(env->GetDirectBufferAddress(logitsBuffer));
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < (jlong)count * 2) {
+        LOGE("topKFp16: expected a direct buffer of %d fp16 values", (int)count);
+        return 0;
+    }
+    k = std::min({ (int)k, (int)env->GetArrayLength(outIndices), (int)env->GetArrayLength(outValues) });
+    int32_t indices[MAX_TOP_K];
+    float values[MAX_TOP_K];
+    int n = topKFp16(logits, count, k, indices, values);
+    return copyTopK(env, n, indices, values, outIndices, outValues);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeLogits_nativeTopKFp32(
+        JNIEnv *env, jobject /* this */, jobject logitsBuffer, jint count, jint k,
+        jintArray outIndices, jfloatArray outValues) {
+    auto* logits = static_cast<const float*>(env->GetDirectBufferAddress(logitsBuffer));
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < (jlong)count * 4) {
+        LOGE("topKFp32: expected a direct buffer of %d fp32 values", (int)count);
+        return 0;
+    }
+    k = std::min({ (int)k, (int)env->GetArrayLength(outIndices), (int)env->GetArrayLength(outValues) });
+    int32_t indices[MAX_TOP_K];
+    float values[MAX_TOP_K];
+    int n = topKFp32(logits, count, k, indices, values);
+    return copyTopK(env, n, indices, values, outIndices, outValues);
+}
+
+// ---- Logit processor ----
+// The Kotlin LogitProcessor owns a native LogitProcessor through an opaque jlong handle.
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_LogitProcessor_nativeCreate(
+        JNIEnv *env, jobject /* this */, jint vocabSize, jint eot, jint noTimestamps, jint timestampBegin,
+        jint blankToken, jintArray suppressTokens, jboolean timestamps, jint maxInitialTimestampIndex,
+        jfloat repetitionPenalty) {
+    LogitProcessorConfig config;
+    config.vocabSize = vocabSize;
+    config.eot = eot;
+    config.noTimestamps = noTimestamps;
+    config.timestampBegin = timestampBegin;
+    config.blankToken = blankToken;
+    config.suppressTokens.resize(env->GetArrayLength(suppressTokens));
+    env->GetIntArrayRegion(suppressTokens, 0, (jsize)config.suppressTokens.size(),
+                           reinterpret_cast<jint*>(config.suppressTokens.data()));
+    config.timestamps = timestamps == JNI_TRUE;
+    config.maxInitialTimestampIndex = maxInitialTimestampIndex;
+    config.repetitionPenalty = repetitionPenalty;
+    return reinterpret_cast<jlong>(new LogitProcessor(config));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_LogitProcessor_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete reinterpret_cast<LogitProcessor*>(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_LogitProcessor_nativeSetContextBias(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jlong biasHandle) {
+    reinterpret_cast<LogitProcessor*>(handle)->setContextBias(reinterpret_cast<const ContextBias*>(biasHandle));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_LogitProcessor_nativeApply(
+        JNIEnv *env, jobject /* this */, jlong handle, jobject logitsBuffer, jboolean fp16,
+        jintArray tokensArray, jint numTokens) {
+    auto* processor = reinterpret_cast<LogitProcessor*>(handle);
+    void* logits = env->GetDirectBufferAddress(logitsBuffer);
+    jlong needed = (jlong)processor->config().vocabSize * (fp16 ? 2 : 4);
+    if (logits == nullptr || env->GetDirectBufferCapacity(logitsBuffer) < needed) {
+        LOGE("LogitProcessor: expected a direct logits buffer of %lld bytes", (long long)needed);
+        return;
+    }
+    numTokens = std::min(numTokens, env->GetArrayLength(tokensArray));
+
+    // Short critical section: the token array is read, nothing calls back into the JVM
+    auto* tokens = static_cast<const int32_t*>(env->GetPrimitiveArrayCritical(tokensArray, nullptr));
+    if (fp16) {
+        processor->applyFp16(static_cast<uint16_t*>(logits), tokens, numTokens);
+    } else {
+        processor->applyFp32(static_cast<float*>(logits), tokens, numTokens);
+    }
+    env->ReleasePrimitiveArrayCritical(tokensArray, const_cast<int32_t*>(tokens), JNI_ABORT);
+}
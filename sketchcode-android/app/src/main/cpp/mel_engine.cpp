@@ -0,0 +1,354 @@
+#include "mel_engine.h"
+#include "arena.h"
+#include "cancellation.h"
+#include "noise_suppression.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#define LOG_TAG "WhisperMel"
+#include "native_log.h"
+
+// ---- FFT ----
+
+void fft(float* re, float* im, int n) {
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    // Cooley-Tukey
+    for (int len = 2; len <= n; len <<= 1) {
+        float ang = -2.0f * M_PI / len;
+        float wRe = cosf(ang), wIm = sinf(ang);
+        for (int i = 0; i < n; i += len) {
+            float curRe = 1.0f, curIm = 0.0f;
+            for (int j = 0; j < len / 2; j++) {
+                float tRe = curRe * re[i + j + len/2] - curIm * im[i + j + len/2];
+                float tIm = curRe * im[i + j + len/2] + curIm * re[i + j + len/2];
+                re[i + j + len/2] = re[i + j] - tRe;
+                im[i + j + len/2] = im[i + j] - tIm;
+                re[i + j] += tRe;
+                im[i + j] += tIm;
+                float newCurRe = curRe * wRe - curIm * wIm;
+                curIm = curRe * wIm + curIm * wRe;
+                curRe = newCurRe;
+            }
+        }
+    }
+}
+
+// ---- Mel Filterbank (computed analytically) ----
+
+static inline float hzToMel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static inline float melToHz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+void computeMelFilterbank(float* filters, int nMels, int nFft, int sampleRate) {
+    int nFreqs = nFft / 2 + 1; // 201
+    float fMin = 0.0f;
+    float fMax = (float)sampleRate / 2.0f; // 8000 Hz
+    float melMin = hzToMel(fMin);
+    float melMax = hzToMel(fMax);
+
+    // nMels + 2 evenly spaced points in mel space
+    std::vector<float> melPoints(nMels + 2);
+    for (int i = 0; i < nMels + 2; i++) {
+        melPoints[i] = melMin + (melMax - melMin) * i / (nMels + 1);
+    }
+
+    // Convert to Hz and then to FFT bin indices
+    std::vector<float> binFreqs(nMels + 2);
+    for (int i = 0; i < nMels + 2; i++) {
+        float hz = melToHz(melPoints[i]);
+        binFreqs[i] = hz * nFft / sampleRate;
+    }
+
+    // Create triangular filters
+    memset(filters, 0, nMels * nFreqs * sizeof(float));
+    for (int m = 0; m < nMels; m++) {
+        float left = binFreqs[m];
+        float center = binFreqs[m + 1];
+        float right = binFreqs[m + 2];
+
+        for (int k = 0; k < nFreqs; k++) {
+            float fk = (float)k;
+            if (fk >= left && fk <= center && center > left) {
+                filters[m * nFreqs + k] = (fk - left) / (center - left);
+            } else if (fk > center && fk <= right && right > center) {
+                filters[m * nFreqs + k] = (right - fk) / (right - center);
+            }
+        }
+    }
+
+    // Slaney-style normalization: each filter scaled by 2.0 / (right - left) in Hz
+    for (int m = 0; m < nMels; m++) {
+        float leftHz = melToHz(melPoints[m]);
+        float rightHz = melToHz(melPoints[m + 2]);
+        float enorm = 2.0f / (rightHz - leftHz);
+        for (int k = 0; k < nFreqs; k++) {
+            filters[m * nFreqs + k] *= enorm;
+        }
+    }
+}
+
+// ---- Hann window (periodic, matching PyTorch default) ----
+
+void computeHannWindow(float* window, int length) {
+    // Periodic Hann: window[i] = 0.5 * (1 - cos(2*pi*i / N))
+    // This matches torch.hann_window(N, periodic=True)
+    for (int i = 0; i < length; i++) {
+        window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / length));
+    }
+}
+
+// ---- STFT framing ----
+
+void padAudioForStft(const float* audio, int audioLen, float* padded) {
+    // Step 1: Pad or truncate to N_SAMPLES, in place after the left padding
+    int copyLen = std::clamp(audioLen, 0, N_SAMPLES);
+    float* raw = padded + PAD;
+    memcpy(raw, audio, copyLen * sizeof(float));
+    memset(raw + copyLen, 0, (N_SAMPLES - copyLen) * sizeof(float));
+
+    // Step 2: Apply center padding with reflection (matching torch.stft center=True)
+    // Pad PAD (=200) samples on each side using reflection
+    // Left reflection padding: reflect raw[1..PAD] → padded[PAD-1..0]
+    for (int i = 0; i < PAD; i++) {
+        padded[PAD - 1 - i] = raw[i + 1];
+    }
+    // Right reflection padding: reflect raw[N_SAMPLES-2..N_SAMPLES-PAD-1] → padded[N_SAMPLES+PAD..end]
+    for (int i = 0; i < PAD; i++) {
+        padded[N_SAMPLES + PAD + i] = raw[N_SAMPLES - 2 - i];
+    }
+}
+
+void padAudioForStft(const float* audio, int audioLen, std::vector<float>& padded) {
+    padded.resize(N_SAMPLES + 2 * PAD); // 480400
+    padAudioForStft(audio, audioLen, padded.data());
+}
+
+void frameSpectrum(const float* signal, int start, const float* window, float* fftRe, float* fftIm) {
+    // Zero-pad FFT buffer
+    memset(fftRe, 0, FFT_SIZE * sizeof(float));
+    memset(fftIm, 0, FFT_SIZE * sizeof(float));
+
+    // Apply Hann window to frame from padded signal
+    for (int i = 0; i < N_FFT; i++) {
+        fftRe[i] = signal[start + i] * window[i];
+    }
+
+    // FFT
+    fft(fftRe, fftIm, FFT_SIZE);
+}
+
+void framePowerSpectrum(const float* padded, int start, const float* window,
+                        float* fftRe, float* fftIm, float* power) {
+    frameSpectrum(padded, start, window, fftRe, fftIm);
+
+    // Magnitude squared (power spectrogram)
+    for (int k = 0; k < FFT_OUT; k++) {
+        power[k] = fftRe[k] * fftRe[k] + fftIm[k] * fftIm[k];
+    }
+}
+
+void logMelFrame(const float* melFilters, const float* power, float* out, int stride) {
+    for (int m = 0; m < N_MELS; m++) {
+        float sum = 0.0f;
+        for (int k = 0; k < FFT_OUT; k++) {
+            sum += melFilters[m * FFT_OUT + k] * power[k];
+        }
+        // Log10 mel spectrogram (clamp to avoid log(0))
+        out[m * stride] = log10f(fmaxf(sum, 1e-10f));
+    }
+}
+
+// ---- Speech activity ----
+
+// Speech frames are those above min + SPEECH_THRESHOLD * (max - min) of the frame energy range
+static constexpr float SPEECH_THRESHOLD = 0.3f;
+// Normalized log-mel energy range below which a clip is treated as silence (0.25 = 10 dB)
+static constexpr float MIN_DYNAMIC_RANGE = 0.25f;
+
+int detectSpeechFrames(const float* melSpec, int melStride, int numFrames, uint8_t* isSpeech) {
+    numFrames = std::min({ numFrames, melStride, N_FRAMES });
+    if (numFrames <= 0) return 0;
+    if (isSpeech != nullptr) memset(isSpeech, 0, numFrames);
+
+    float energy[N_FRAMES] = {};
+    for (int m = 0; m < N_MELS; m++) {
+        const float* row = melSpec + m * melStride;
+        for (int f = 0; f < numFrames; f++) {
+            energy[f] += row[f];
+        }
+    }
+    auto [minIt, maxIt] = std::minmax_element(energy, energy + numFrames);
+    float minE = *minIt / N_MELS, maxE = *maxIt / N_MELS;
+    if (maxE - minE < MIN_DYNAMIC_RANGE) return 0;
+
+    float threshold = (minE + SPEECH_THRESHOLD * (maxE - minE)) * N_MELS;
+    int count = 0;
+    for (int f = 0; f < numFrames; f++) {
+        bool speech = energy[f] > threshold;
+        if (isSpeech != nullptr) isSpeech[f] = speech ? 1 : 0;
+        count += speech ? 1 : 0;
+    }
+    return count;
+}
+
+// ---- Log-mel pipeline ----
+
+// log10 of the filterbank floor: the value of every frame that sees only padding
+static const float SILENCE_LOG_MEL = log10f(1e-10f);
+
+int melFramesForAudio(int audioLen, int bucketFrames) {
+    if (bucketFrames <= 0) return N_FRAMES;
+    // Frame f reads samples [f * HOP - PAD, f * HOP + PAD): the first silent one
+    // starts at or past the end of the audio
+    int64_t firstSilent = ((int64_t)std::max(audioLen, 0) + PAD + HOP_LENGTH - 1) / HOP_LENGTH;
+    int64_t frames = (firstSilent + 1 + bucketFrames - 1) / bucketFrames * bucketFrames;
+    return (int)std::min<int64_t>(frames, N_FRAMES);
+}
+
+// ---- Quantized output ----
+
+template <typename T>
+static inline T quantizeValue(float value, float scale, float zeroPoint) {
+    // nearbyintf rounds half to even in the default rounding mode, as QuantizeLinear does
+    float q = nearbyintf(value / scale) + zeroPoint;
+    q = fminf(fmaxf(q, (float)std::numeric_limits<T>::min()), (float)std::numeric_limits<T>::max());
+    return (T)q;
+}
+
+template <typename T>
+static void quantizeValues(const float* mel, int count, const MelQuantization& quant, T* out) {
+    const float zeroPoint = (float)quant.zeroPoint;
+    for (int i = 0; i < count; i++) out[i] = quantizeValue<T>(mel[i], quant.scale, zeroPoint);
+}
+
+// Whisper's normalization, clamp to clampAt then (x + 4) / 4, in place, also writing
+// the quantized values in the same pass
+template <typename T>
+static void normalizeQuantized(float* mel, int count, float clampAt, const MelQuantization& quant, T* out) {
+    const float zeroPoint = (float)quant.zeroPoint;
+    for (int i = 0; i < count; i++) {
+        float value = (fmaxf(mel[i], clampAt) + 4.0f) / 4.0f;
+        mel[i] = value;
+        out[i] = quantizeValue<T>(value, quant.scale, zeroPoint);
+    }
+}
+
+void quantizeMel(const float* mel, int count, const MelQuantization& quant, void* out) {
+    if (quant.type == MEL_QUANT_INT8) {
+        quantizeValues(mel, count, quant, static_cast<int8_t*>(out));
+    } else if (quant.type == MEL_QUANT_UINT8) {
+        quantizeValues(mel, count, quant, static_cast<uint8_t*>(out));
+    }
+}
+
+// The filterbank depends only on the constants: computed on first use, then shared
+static const float* melFilterbank() {
+    static const std::vector<float> filters = [] {
+        std::vector<float> f(N_MELS * FFT_OUT);
+        computeMelFilterbank(f.data(), N_MELS, N_FFT, SAMPLE_RATE);
+        return f;
+    }();
+    return filters.data();
+}
+
+float computeLogMelSpectrogram(const float* audio, int audioLen, const MelOptions& options, float* melSpec) {
+    if (isCancelled(options.cancel)) return 0.0f;
+    Arena temporary;
+    Arena& arena = options.arena != nullptr ? *options.arena : temporary;
+    ArenaScope scratch(arena);
+
+    const int paddedLen = N_SAMPLES + 2 * PAD; // 480400
+    float* padded = arena.allocate<float>(paddedLen);
+    padAudioForStft(audio, audioLen, padded);
+
+    // Total frames from padded signal: (paddedLen - N_FFT) / HOP_LENGTH + 1
+    // = (480400 - 400) / 160 + 1 = 480000/160 + 1 = 3001
+    // Whisper drops the last frame: stft[..., :-1] → 3000 frames
+    int totalFrames = (paddedLen - N_FFT) / HOP_LENGTH + 1; // 3001
+    int outputFrames = std::min(totalFrames - 1, N_FRAMES);  // 3000 (drop last)
+    // Trimmed output: the frames after it are only padding, skip their STFTs
+    const int stride = std::clamp(options.outputFrames, 1, outputFrames);
+    outputFrames = stride;
+
+    LOGI("Padded length: %d, total STFT frames: %d, output frames: %d", paddedLen, totalFrames, outputFrames);
+
+    // Pre-compute Hann window (periodic)
+    float hannWindow[N_FFT];
+    computeHannWindow(hannWindow, N_FFT);
+
+    const float* melFilters = melFilterbank();
+
+    // Output: N_MELS x stride
+    memset(melSpec, 0, (size_t)N_MELS * stride * sizeof(float));
+
+    // FFT buffers
+    float fftRe[FFT_SIZE];
+    float fftIm[FFT_SIZE];
+
+    if (!options.suppressNoise) {
+        // Process each frame (from center-padded signal)
+        float magnitudes[FFT_OUT];
+        for (int frame = 0; frame < outputFrames; frame++) {
+            if (isCancelled(options.cancel)) return 0.0f;
+            framePowerSpectrum(padded, frame * HOP_LENGTH, hannWindow, fftRe, fftIm, magnitudes);
+            logMelFrame(melFilters, magnitudes, melSpec + frame, stride);
+        }
+    } else {
+        // Keep every frame's power spectrum so the noise floor can be estimated
+        // across the whole clip, then attenuate in place before the filterbank.
+        float* power = arena.allocate<float>((size_t)outputFrames * FFT_OUT);
+        for (int frame = 0; frame < outputFrames; frame++) {
+            if (isCancelled(options.cancel)) return 0.0f;
+            framePowerSpectrum(padded, frame * HOP_LENGTH, hannWindow, fftRe, fftIm,
+                               power + (size_t)frame * FFT_OUT);
+        }
+
+        // Frames past the end of the recording are zero padding — exclude them from
+        // the noise estimate, otherwise the floor collapses to zero on short clips.
+        int speechFrames = std::min(outputFrames, (std::min(audioLen, N_SAMPLES) + HOP_LENGTH - 1) / HOP_LENGTH);
+        suppressNoise(power, speechFrames, FFT_OUT, NoiseSuppressionParams(), &arena);
+
+        for (int frame = 0; frame < outputFrames; frame++) {
+            if (isCancelled(options.cancel)) return 0.0f;
+            logMelFrame(melFilters, power + (size_t)frame * FFT_OUT, melSpec + frame, stride);
+        }
+    }
+
+    // Normalize: clamp to (max - 8.0), then (x + 4.0) / 4.0
+    // This matches WhisperFeatureExtractor exactly
+    // (the dropped padding frames of a trimmed output still count towards the maximum)
+    float maxVal = *std::max_element(melSpec, melSpec + N_MELS * stride);
+    if (stride < N_FRAMES) maxVal = std::max(maxVal, SILENCE_LOG_MEL);
+    const MelQuantization& quant = options.quantization;
+    if (options.quantizedOut != nullptr && quant.type == MEL_QUANT_INT8) {
+        normalizeQuantized(melSpec, N_MELS * stride, maxVal - 8.0f, quant, static_cast<int8_t*>(options.quantizedOut));
+        return maxVal;
+    }
+    if (options.quantizedOut != nullptr && quant.type == MEL_QUANT_UINT8) {
+        normalizeQuantized(melSpec, N_MELS * stride, maxVal - 8.0f, quant, static_cast<uint8_t*>(options.quantizedOut));
+        return maxVal;
+    }
+    for (int i = 0; i < N_MELS * stride; i++) {
+        melSpec[i] = fmaxf(melSpec[i], maxVal - 8.0f);
+        melSpec[i] = (melSpec[i] + 4.0f) / 4.0f;
+    }
+    return maxVal;
+}
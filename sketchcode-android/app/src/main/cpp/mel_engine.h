@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class Arena;
+class CancellationToken;
+
+// Whisper-Large-V3-Turbo parameters
+static constexpr int SAMPLE_RATE = 16000;
+static constexpr int N_FFT = 400;
+static constexpr int HOP_LENGTH = 160;
+static constexpr int N_MELS = 128;
+static constexpr int CHUNK_LENGTH = 30; // seconds
+static constexpr int N_SAMPLES = SAMPLE_RATE * CHUNK_LENGTH; // 480000
+static constexpr int N_FRAMES = N_SAMPLES / HOP_LENGTH;      // 3000
+static constexpr int FFT_SIZE = 512; // next power of 2 >= N_FFT
+static constexpr int FFT_OUT = N_FFT / 2 + 1; // 201
+static constexpr int PAD = N_FFT / 2; // 200 — center padding for STFT
+
+/** Element type of a quantized log-mel (MelQuantization). */
+enum MelQuantType {
+    MEL_QUANT_NONE = 0,
+    MEL_QUANT_INT8 = 1,
+    MEL_QUANT_UINT8 = 2,
+};
+
+/**
+ * Affine quantization of the normalized log-mel for int8/uint8 encoder inputs, as ONNX
+ * QuantizeLinear: q = saturate(round_half_even(x / scale) + zeroPoint). Dequantized
+ * values are within scale / 2 of the fp32 mel inside the representable range.
+ */
+struct MelQuantization {
+    MelQuantType type = MEL_QUANT_NONE;
+    float scale = 1.0f;
+    int zeroPoint = 0;
+};
+
+// Range the default quantization covers: a silent clip normalizes to -1.5 everywhere,
+// and the loudest mel bins of full-scale speech stay below 2
+static constexpr float MEL_QUANT_MIN = -1.5f;
+static constexpr float MEL_QUANT_MAX = 2.0f;
+
+/** [MEL_QUANT_MIN, MEL_QUANT_MAX] over the 256 levels of type, for models that do not carry their own. */
+static inline MelQuantization defaultMelQuantization(MelQuantType type) {
+    MelQuantization quant;
+    quant.type = type;
+    quant.scale = (MEL_QUANT_MAX - MEL_QUANT_MIN) / 255.0f;
+    int lowest = type == MEL_QUANT_INT8 ? -128 : 0;
+    // Rounded so that MEL_QUANT_MIN, the value of silence, stays representable
+    quant.zeroPoint = lowest + (int)std::ceil(-MEL_QUANT_MIN / quant.scale);
+    return quant;
+}
+
+/**
+ * Per-call switches for the log-mel pipeline.
+ */
+struct MelOptions {
+    // Spectral-subtraction noise suppression on the STFT power spectra (see noise_suppression.h)
+    bool suppressNoise = false;
+    // Polled once per STFT frame; when cancelled the call returns early with the
+    // output incomplete (see cancellation.h)
+    const CancellationToken* cancel = nullptr;
+    // Frames emitted from the start of the clip: out is [N_MELS x outputFrames]. With at
+    // least melFramesForAudio(audioLen, 1) frames, the dropped ones are only padding and
+    // every emitted value is the same as in the full N_FRAMES spectrogram.
+    int outputFrames = N_FRAMES;
+    // With a quantization type set, the normalization pass also writes the quantized
+    // mel into quantizedOut (N_MELS * outputFrames int8/uint8 values, same layout)
+    MelQuantization quantization;
+    void* quantizedOut = nullptr;
+    // Scratch (padded audio, power spectra) comes from here and is released on return;
+    // with none, a temporary arena is used (see arena.h)
+    Arena* arena = nullptr;
+};
+
+// ---- STFT building blocks (shared with the other native DSP stages) ----
+
+/** In-place radix-2 complex FFT. n must be a power of two. */
+void fft(float* re, float* im, int n);
+
+/** Slaney-normalized triangular mel filterbank, [nMels x (nFft/2 + 1)] row-major. */
+void computeMelFilterbank(float* filters, int nMels, int nFft, int sampleRate);
+
+/** Periodic Hann window, matching torch.hann_window(N, periodic=True). */
+void computeHannWindow(float* window, int length);
+
+/**
+ * Pad or truncate audio to N_SAMPLES, then reflect-pad PAD samples on each side
+ * (torch.stft center=True). Output has N_SAMPLES + 2 * PAD samples.
+ */
+void padAudioForStft(const float* audio, int audioLen, std::vector<float>& padded);
+
+/** padAudioForStft into padded, N_SAMPLES + 2 * PAD floats. */
+void padAudioForStft(const float* audio, int audioLen, float* padded);
+
+/**
+ * Complex spectrum of the Hann-windowed frame signal[start .. start + N_FFT), zero-padded
+ * to FFT_SIZE. fftRe/fftIm are FFT_SIZE buffers that receive the full spectrum.
+ */
+void frameSpectrum(const float* signal, int start, const float* window, float* fftRe, float* fftIm);
+
+/**
+ * Power spectrum |X[k]|^2 (k < FFT_OUT) of the Hann-windowed frame starting at padded[start].
+ * fftRe/fftIm are FFT_SIZE scratch buffers; on return they hold the full complex spectrum.
+ */
+void framePowerSpectrum(const float* padded, int start, const float* window,
+                        float* fftRe, float* fftIm, float* power);
+
+/**
+ * Log10 mel energies of one power spectrum (FFT_OUT bins) through the filterbank,
+ * floored at 1e-10 before the log. Writes out[m * stride] for m < N_MELS.
+ */
+void logMelFrame(const float* melFilters, const float* power, float* out, int stride);
+
+// ---- Log-mel ----
+
+/**
+ * Energy-based speech activity over the first numFrames (at most N_FRAMES) frames of a normalized
+ * [N_MELS x melStride] log-mel spectrogram. A frame is speech if its mean log-mel
+ * lies above min + 0.3 * (max - min) of the clip; clips with less than 10 dB of
+ * dynamic range are treated as silence.
+ * @param isSpeech receives one 0/1 flag per frame (may be null)
+ * @return number of speech frames
+ */
+int detectSpeechFrames(const float* melSpec, int melStride, int numFrames, uint8_t* isSpeech);
+
+/**
+ * Frames of a trimmed log-mel for audioLen samples, for encoders that take less than
+ * 30 s: every frame that overlaps the audio plus one of silence, rounded up to a
+ * multiple of bucketFrames and capped at N_FRAMES (bucketFrames <= 0 keeps N_FRAMES).
+ * Unless all N_FRAMES are kept, the last frame is silence, so a consumer can pad to a
+ * longer encoder input by repeating it.
+ */
+int melFramesForAudio(int audioLen, int bucketFrames);
+
+/** Frames of a [N_MELS x frames] spectrogram of `values` floats, 0 if no such shape. */
+static inline int melFramesOf(int64_t values) {
+    if (values <= 0 || values % N_MELS != 0 || values / N_MELS > N_FRAMES) return 0;
+    return (int)(values / N_MELS);
+}
+
+/**
+ * Quantize count values of an already normalized log-mel into out (int8/uint8 per
+ * quant.type); for spectrograms that did not come out of computeLogMelSpectrogram
+ * quantized. No-op for MEL_QUANT_NONE.
+ */
+void quantizeMel(const float* mel, int count, const MelQuantization& quant, void* out);
+
+/**
+ * Compute the normalized Whisper log-mel spectrogram.
+ * @param audio 16kHz mono PCM (padded/truncated to 30s)
+ * @param out   N_MELS * options.outputFrames floats, row-major [mel][frame]
+ * @return the pre-normalization log10 maximum (for logging); 0 if options.cancel fired
+ */
+float computeLogMelSpectrogram(const float* audio, int audioLen, const MelOptions& options, float* out);
@@ -0,0 +1,126 @@
+#include "mel_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Incomplete frames that still overlap the audio: a 400-sample window spans 2.5 hops
+static constexpr int TAIL_FRAMES = 3;
+
+MelStream::MelStream(const MelStreamConfig& config)
+    : config_(config), filters_(N_MELS * FFT_OUT), ring_((size_t)N_FRAMES * N_MELS),
+      frameMax_(N_FRAMES), maxQueue_(N_FRAMES + TAIL_FRAMES) {
+    computeHannWindow(window_, N_FFT);
+    computeMelFilterbank(filters_.data(), N_MELS, N_FFT, SAMPLE_RATE);
+    memset(power_, 0, sizeof(power_));
+    logMelFrame(filters_.data(), power_, tail_, 1);
+    silence_ = tail_[0];
+    history_.reserve(N_FFT + 16 * 1024);
+}
+
+void MelStream::reset() {
+    history_.clear();
+    histBase_ = 0;
+    total_ = 0;
+    nextFrame_ = 0;
+    lastSnapshot_ = 0;
+    maxHead_ = 0;
+    maxCount_ = 0;
+}
+
+// Sample of the recording, reflected at its start (torch.stft center=True) and zero
+// past the end, as padAudioForStft lays it out
+float MelStream::sampleAt(int64_t index) const {
+    if (index < 0) index = -index;
+    if (index >= total_) return 0.0f;
+    return history_[(size_t)(index - histBase_)];
+}
+
+bool MelStream::frameReady(int64_t frame) const {
+    // The first frame also reflects sample PAD
+    return total_ >= frame * HOP_LENGTH + PAD + (frame == 0 ? 1 : 0);
+}
+
+float MelStream::computeFrame(int64_t frame, float* out) {
+    int64_t start = frame * HOP_LENGTH - PAD;
+    for (int i = 0; i < N_FFT; i++) signal_[i] = sampleAt(start + i);
+    framePowerSpectrum(signal_, 0, window_, fftRe_, fftIm_, power_);
+    logMelFrame(filters_.data(), power_, out, 1);
+    return *std::max_element(out, out + N_MELS);
+}
+
+void MelStream::pushMax(int64_t frame, float value) {
+    const int capacity = (int)maxQueue_.size();
+    while (maxCount_ > 0) {
+        int64_t back = maxQueue_[(maxHead_ + maxCount_ - 1) % capacity];
+        if (frameMax_[back % N_FRAMES] > value) break;
+        maxCount_--;
+    }
+    maxQueue_[(maxHead_ + maxCount_) % capacity] = frame;
+    maxCount_++;
+}
+
+bool MelStream::push(const float* samples, int count) {
+    if (count <= 0) return false;
+
+    // Drop samples no future frame reads; the first two frames still reflect the start
+    int64_t keepFrom = std::max<int64_t>(0, nextFrame_ * HOP_LENGTH - PAD);
+    if (nextFrame_ >= 2 && keepFrom - histBase_ >= (int64_t)history_.size() / 2) {
+        history_.erase(history_.begin(), history_.begin() + (keepFrom - histBase_));
+        histBase_ = keepFrom;
+    }
+    history_.insert(history_.end(), samples, samples + count);
+    total_ += count;
+
+    while (frameReady(nextFrame_)) {
+        int slot = (int)(nextFrame_ % N_FRAMES);
+        float* out = ring_.data() + (size_t)slot * N_MELS;
+        // The slot's previous frame is out of every window by now
+        if (maxCount_ > 0 && maxQueue_[maxHead_] == nextFrame_ - N_FRAMES) {
+            maxHead_ = (maxHead_ + 1) % (int)maxQueue_.size();
+            maxCount_--;
+        }
+        frameMax_[slot] = computeFrame(nextFrame_, out);
+        pushMax(nextFrame_, frameMax_[slot]);
+        nextFrame_++;
+    }
+    return nextFrame_ - lastSnapshot_ >= config_.snapshotIntervalFrames;
+}
+
+int MelStream::snapshot(float* out) {
+    lastSnapshot_ = nextFrame_;
+
+    // The window ends at the newest sample and starts on a frame boundary
+    int64_t first = total_ > N_SAMPLES ? (total_ - N_SAMPLES + HOP_LENGTH - 1) / HOP_LENGTH : 0;
+    const int capacity = (int)maxQueue_.size();
+    while (maxCount_ > 0 && maxQueue_[maxHead_] < first) {
+        maxHead_ = (maxHead_ + 1) % capacity;
+        maxCount_--;
+    }
+    float maxVal = maxCount_ > 0 ? frameMax_[maxQueue_[maxHead_] % N_FRAMES] : -INFINITY;
+
+    // Frames after the stored ones that still overlap the audio
+    int64_t end = first + N_FRAMES;
+    int64_t tailEnd = nextFrame_;
+    while (tailEnd < end && tailEnd - nextFrame_ < TAIL_FRAMES && tailEnd * HOP_LENGTH - PAD < total_) {
+        maxVal = std::max(maxVal, computeFrame(tailEnd, tail_ + (tailEnd - nextFrame_) * N_MELS));
+        tailEnd++;
+    }
+    if (tailEnd < end || maxVal == -INFINITY) maxVal = std::max(maxVal, silence_);
+
+    // Same normalization as computeLogMelSpectrogram, fused with the transpose
+    const float clampAt = maxVal - 8.0f;
+    for (int f = 0; f < N_FRAMES; f++) {
+        int64_t frame = first + f;
+        const float* src = frame < nextFrame_ ? ring_.data() + (size_t)(frame % N_FRAMES) * N_MELS
+                         : frame < tailEnd ? tail_ + (frame - nextFrame_) * N_MELS
+                         : nullptr;
+        if (src == nullptr) {
+            float value = (fmaxf(silence_, clampAt) + 4.0f) / 4.0f;
+            for (int m = 0; m < N_MELS; m++) out[m * N_FRAMES + f] = value;
+            continue;
+        }
+        for (int m = 0; m < N_MELS; m++) out[m * N_FRAMES + f] = (fmaxf(src[m], clampAt) + 4.0f) / 4.0f;
+    }
+    return (int)std::min<int64_t>(N_FRAMES, tailEnd - first);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mel_engine.h"
+
+struct MelStreamConfig {
+    // push() reports a snapshot as due once this many new frames arrived (2 s)
+    int snapshotIntervalFrames = 2 * SAMPLE_RATE / HOP_LENGTH;
+};
+
+/**
+ * Rolling 30 s log-mel window for live transcription while audio is still arriving.
+ *
+ * push() runs the STFT and filterbank only on frames whose 400-sample window is now
+ * complete and stores their log10 mel energies in a ring of N_FRAMES frames; frames
+ * are never recomputed. The window maximum, which Whisper's normalization clamps
+ * against, comes from a monotonic deque of per-frame maxima, so it stays exact as
+ * old frames fall out of the window.
+ *
+ * snapshot() writes an encoder-ready [N_MELS x N_FRAMES] spectrogram of the last 30 s:
+ * the stored frames, the up to three newest frames computed with the missing samples
+ * zeroed, and silence after that. Until 30 s have been pushed this is exactly what
+ * computeLogMelSpectrogram() gives for the same audio. After that, the window's first
+ * two frames and its last one see the neighbouring audio, or zeros, where the batch
+ * pipeline reflects at the clip edges.
+ *
+ * Noise suppression needs the whole clip and is not applied. Not thread-safe.
+ */
+class MelStream {
+public:
+    explicit MelStream(const MelStreamConfig& config = MelStreamConfig());
+
+    /** Start a new recording. Keeps every buffer's capacity. */
+    void reset();
+
+    /** Append 16 kHz mono samples; true if a snapshot is due. */
+    bool push(const float* samples, int count);
+
+    /**
+     * Normalized [N_MELS x N_FRAMES] log-mel of the last 30 s, row-major [mel][frame].
+     * @return frames in the window that cover audio (the rest is padding)
+     */
+    int snapshot(float* out);
+
+    int64_t samples() const { return total_; }
+    /** Frames computed and stored so far. */
+    int64_t frames() const { return nextFrame_; }
+
+private:
+    float sampleAt(int64_t index) const;
+    float computeFrame(int64_t frame, float* out);
+    bool frameReady(int64_t frame) const;
+    void pushMax(int64_t frame, float value);
+
+    MelStreamConfig config_;
+    float window_[N_FFT];
+    std::vector<float> filters_;
+    float fftRe_[FFT_SIZE];
+    float fftIm_[FFT_SIZE];
+    float power_[FFT_OUT];
+    float signal_[N_FFT];
+    float silence_;                     // log-mel of an all-zero frame
+
+    // Samples from histBase_ on; older ones are no longer part of any frame
+    std::vector<float> history_;
+    int64_t histBase_ = 0;
+    int64_t total_ = 0;
+
+    // Frame f at ring_[(f % N_FRAMES) * N_MELS], frame-major
+    std::vector<float> ring_;
+    std::vector<float> frameMax_;       // per ring slot
+    int64_t nextFrame_ = 0;
+    int64_t lastSnapshot_ = 0;
+
+    // Monotonic deque of frame indices, decreasing maxima: the front is the window max
+    std::vector<int64_t> maxQueue_;
+    int maxHead_ = 0;
+    int maxCount_ = 0;
+
+    float tail_[3 * N_MELS];            // newest frames, computed with zeros for missing samples
+};
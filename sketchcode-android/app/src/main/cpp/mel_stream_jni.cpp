@@ -0,0 +1,65 @@
+#include <jni.h>
+#include <algorithm>
+
+#include "mel_stream.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin MelStream owns the native rolling window through an opaque jlong handle.
+// Audio chunks come in from the capture thread as they are read; snapshots go out
+// into a caller-owned FloatArray that is reused between snapshots.
+
+static inline MelStream* fromHandle(jlong handle) {
+    return reinterpret_cast<MelStream*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jint snapshotIntervalFrames) {
+    MelStreamConfig config;
+    if (snapshotIntervalFrames > 0) config.snapshotIntervalFrames = snapshotIntervalFrames;
+    return reinterpret_cast<jlong>(new MelStream(config));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativeReset(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->reset();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativePush(
+        JNIEnv *env, jobject /* this */, jlong handle, jfloatArray samples, jint count) {
+    count = std::min(count, (jint)env->GetArrayLength(samples));
+    if (count <= 0) return JNI_FALSE;
+    auto* data = static_cast<float*>(env->GetPrimitiveArrayCritical(samples, nullptr));
+    if (data == nullptr) return JNI_FALSE;
+    bool due = fromHandle(handle)->push(data, count);
+    env->ReleasePrimitiveArrayCritical(samples, data, JNI_ABORT);
+    return due ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativeSnapshot(
+        JNIEnv *env, jobject /* this */, jlong handle, jfloatArray out) {
+    if (env->GetArrayLength(out) < N_MELS * N_FRAMES) return -1;
+    auto* data = static_cast<float*>(env->GetPrimitiveArrayCritical(out, nullptr));
+    if (data == nullptr) return -1;
+    int frames = fromHandle(handle)->snapshot(data);
+    env->ReleasePrimitiveArrayCritical(out, data, 0);
+    return frames;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_MelStream_nativeSamples(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->samples();
+}
@@ -0,0 +1,352 @@
+#include "native_decoder.h"
+#include "cancellation.h"
+#include "decode_guard.h"
+#include "decode_scorer.h"
+#include "logit_processor.h"
+#include "stream_detokenizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#define LOG_TAG "WhisperNativeDecoder"
+#include "native_log.h"
+
+static constexpr uint16_t MASK_NEG_FP16 = 0xD640; // -100.0, Qualcomm's reference mask value
+
+std::unique_ptr<NativeDecoder> NativeDecoder::create(const NativeDecoderOptions& options) {
+    std::unique_ptr<NativeDecoder> decoder(new NativeDecoder());
+    if (!decoder->init(options)) return nullptr;
+    return decoder;
+}
+
+NativeDecoder::~NativeDecoder() {
+    if (api_ == nullptr) return;
+    for (int set = 0; set < 2; set++) {
+        for (OrtValue* v : kSelf_[set]) api_->ReleaseValue(v);
+        for (OrtValue* v : vSelf_[set]) api_->ReleaseValue(v);
+    }
+    for (OrtValue* v : masks_) api_->ReleaseValue(v);
+    for (OrtValue* v : { inputIds_, positionIds_, logitsValue_, zeroK_, zeroV_ }) {
+        if (v != nullptr) api_->ReleaseValue(v);
+    }
+    if (binding_ != nullptr) api_->ReleaseIoBinding(binding_);
+    if (runOptions_ != nullptr) api_->ReleaseRunOptions(runOptions_);
+    if (memoryInfo_ != nullptr) api_->ReleaseMemoryInfo(memoryInfo_);
+    if (session_ != nullptr) api_->ReleaseSession(session_);
+    if (env_ != nullptr) api_->ReleaseEnv(env_);
+}
+
+bool NativeDecoder::check(OrtStatus* status, const char* what) {
+    if (status == nullptr) return true;
+    LOGE("%s failed: %s", what, api_->GetErrorMessage(status));
+    api_->ReleaseStatus(status);
+    return false;
+}
+
+OrtValue* NativeDecoder::wrap(void* data, size_t bytes, const std::vector<int64_t>& shape,
+                              ONNXTensorElementDataType type) {
+    OrtValue* value = nullptr;
+    if (!check(api_->CreateTensorWithDataAsOrtValue(memoryInfo_, data, bytes, shape.data(), shape.size(),
+                                                    type, &value), "CreateTensorWithDataAsOrtValue")) {
+        return nullptr;
+    }
+    return value;
+}
+
+// ---- Model introspection ----
+
+namespace {
+
+struct TensorSpec {
+    std::vector<int64_t> shape;
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+};
+
+size_t elementCount(const std::vector<int64_t>& shape) {
+    size_t n = 1;
+    for (int64_t d : shape) n *= (size_t)d;
+    return n;
+}
+
+} // namespace
+
+bool NativeDecoder::init(const NativeDecoderOptions& options) {
+    api_ = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+    if (api_ == nullptr) {
+        LOGE("ONNX Runtime API version %d unavailable", ORT_API_VERSION);
+        return false;
+    }
+    if (!check(api_->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "whisper_decoder", &env_), "CreateEnv")) return false;
+
+    OrtSessionOptions* sessionOptions = nullptr;
+    if (!check(api_->CreateSessionOptions(&sessionOptions), "CreateSessionOptions")) return false;
+    bool ok = true;
+    for (const auto& [key, value] : options.configEntries) {
+        ok = ok && check(api_->AddSessionConfigEntry(sessionOptions, key.c_str(), value.c_str()),
+                         "AddSessionConfigEntry");
+    }
+    if (ok && options.qnn) {
+        std::vector<const char*> keys, values;
+        for (const auto& [key, value] : options.qnnOptions) {
+            keys.push_back(key.c_str());
+            values.push_back(value.c_str());
+        }
+        ok = check(api_->SessionOptionsAppendExecutionProvider(sessionOptions, "QNN", keys.data(), values.data(),
+                                                               keys.size()), "Append QNN provider");
+    }
+    ok = ok && check(api_->CreateSession(env_, options.modelPath.c_str(), sessionOptions, &session_), "CreateSession");
+    api_->ReleaseSessionOptions(sessionOptions);
+    if (!ok) return false;
+
+    // Read every input/output shape so no model constant is hard-coded here
+    OrtAllocator* allocator = nullptr;
+    if (!check(api_->GetAllocatorWithDefaultOptions(&allocator), "GetAllocatorWithDefaultOptions")) return false;
+    auto readSpecs = [&](bool inputs, std::vector<std::pair<std::string, TensorSpec>>& out) {
+        size_t count = 0;
+        if (!check(inputs ? api_->SessionGetInputCount(session_, &count)
+                          : api_->SessionGetOutputCount(session_, &count), "SessionGet*Count")) return false;
+        for (size_t i = 0; i < count; i++) {
+            char* name = nullptr;
+            OrtTypeInfo* typeInfo = nullptr;
+            if (!check(inputs ? api_->SessionGetInputName(session_, i, allocator, &name)
+                              : api_->SessionGetOutputName(session_, i, allocator, &name), "SessionGet*Name")) {
+                return false;
+            }
+            TensorSpec spec;
+            const OrtTensorTypeAndShapeInfo* tensorInfo = nullptr;
+            size_t dims = 0;
+            bool specOk = check(inputs ? api_->SessionGetInputTypeInfo(session_, i, &typeInfo)
+                                       : api_->SessionGetOutputTypeInfo(session_, i, &typeInfo), "SessionGet*TypeInfo")
+                    && check(api_->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo), "CastTypeInfoToTensorInfo")
+                    && tensorInfo != nullptr
+                    && check(api_->GetTensorElementType(tensorInfo, &spec.type), "GetTensorElementType")
+                    && check(api_->GetDimensionsCount(tensorInfo, &dims), "GetDimensionsCount");
+            if (specOk) {
+                spec.shape.resize(dims);
+                specOk = check(api_->GetDimensions(tensorInfo, spec.shape.data(), dims), "GetDimensions");
+            }
+            out.emplace_back(name, spec);
+            if (typeInfo != nullptr) api_->ReleaseTypeInfo(typeInfo);
+            api_->AllocatorFree(allocator, name);
+            if (!specOk) return false;
+        }
+        return true;
+    };
+    std::vector<std::pair<std::string, TensorSpec>> inputSpecs, outputSpecs;
+    if (!readSpecs(true, inputSpecs) || !readSpecs(false, outputSpecs)) return false;
+
+    auto find = [](const std::vector<std::pair<std::string, TensorSpec>>& specs, const std::string& name) {
+        for (const auto& spec : specs) {
+            if (spec.first == name) return &spec.second;
+        }
+        return static_cast<const TensorSpec*>(nullptr);
+    };
+    while (find(inputSpecs, "k_cache_self_" + std::to_string(numLayers_) + "_in") != nullptr) numLayers_++;
+    const TensorSpec* mask = find(inputSpecs, "attention_mask");
+    const TensorSpec* logits = find(outputSpecs, "logits");
+    const TensorSpec* kSelf = find(inputSpecs, "k_cache_self_0_in");
+    const TensorSpec* vSelf = find(inputSpecs, "v_cache_self_0_in");
+    const TensorSpec* kCross = find(inputSpecs, "k_cache_cross_0");
+    const TensorSpec* vCross = find(inputSpecs, "v_cache_cross_0");
+    if (numLayers_ == 0 || !mask || !logits || !kSelf || !vSelf || !kCross || !vCross) {
+        LOGE("%s does not have the Whisper decoder inputs/outputs", options.modelPath.c_str());
+        return false;
+    }
+    for (const TensorSpec* spec : { mask, logits, kSelf, vSelf, kCross, vCross }) {
+        if (std::any_of(spec->shape.begin(), spec->shape.end(), [](int64_t d) { return d <= 0; })) {
+            LOGE("Decoder model has dynamic dimensions; a fixed-shape export is required");
+            return false;
+        }
+    }
+    if (kSelf->type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 || kCross->type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16
+            || mask->type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16) {
+        LOGE("Decoder caches and mask must be fp16");
+        return false;
+    }
+
+    kSelfShape_ = kSelf->shape;
+    vSelfShape_ = vSelf->shape;
+    kCrossShape_ = kCross->shape;
+    vCrossShape_ = vCross->shape;
+    maskShape_ = mask->shape;
+    logitsShape_ = logits->shape;
+    maskSize_ = (int)mask->shape.back();
+    selfElements_ = elementCount(kSelfShape_);
+    crossElements_ = elementCount(kCrossShape_);
+    logitsFp16_ = logits->type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    vocabSize_ = (int)elementCount(logitsShape_);
+    if (elementCount(vSelfShape_) != selfElements_ || elementCount(vCrossShape_) != crossElements_) {
+        LOGE("K and V cache sizes differ");
+        return false;
+    }
+    for (int layer = 0; layer < numLayers_; layer++) {
+        std::string l = std::to_string(layer);
+        kSelfIn_.push_back("k_cache_self_" + l + "_in");
+        vSelfIn_.push_back("v_cache_self_" + l + "_in");
+        kSelfOut_.push_back("k_cache_self_" + l + "_out");
+        vSelfOut_.push_back("v_cache_self_" + l + "_out");
+        kCross_.push_back("k_cache_cross_" + l);
+        vCross_.push_back("v_cache_cross_" + l);
+    }
+
+    // ---- Buffers and their OrtValues, created once ----
+    if (!check(api_->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memoryInfo_), "CreateCpuMemoryInfo")
+            || !check(api_->CreateIoBinding(session_, &binding_), "CreateIoBinding")
+            || !check(api_->CreateRunOptions(&runOptions_), "CreateRunOptions")) {
+        return false;
+    }
+
+    pool_ = std::make_unique<DecoderInputPool>(maskSize_, maskSize_, MASK_NEG_FP16, selfElements_);
+    if (!pool_->valid()) return false;
+    inputIds_ = wrap(pool_->inputIds(), sizeof(int32_t), { 1, 1 }, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32);
+    positionIds_ = wrap(pool_->positionIds(), sizeof(int32_t), { 1 }, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32);
+    zeroK_ = wrap(pool_->zeroCache(), pool_->zeroCacheBytes(), kSelfShape_, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+    zeroV_ = wrap(pool_->zeroCache(), pool_->zeroCacheBytes(), vSelfShape_, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+    for (int n = 0; n < maskSize_; n++) {
+        masks_.push_back(wrap(pool_->masks() + (size_t)n * maskSize_, maskSize_ * sizeof(uint16_t), maskShape_,
+                              ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16));
+        if (masks_.back() == nullptr) return false;
+    }
+
+    logits_.resize((size_t)vocabSize_ * (logitsFp16_ ? 2 : 4));
+    logitsValue_ = wrap(logits_.data(), logits_.size(), logitsShape_,
+                        logitsFp16_ ? ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 : ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+
+    size_t layerBytes = selfElements_ * sizeof(uint16_t);
+    for (int set = 0; set < 2; set++) {
+        selfCaches_[set].assign(2 * numLayers_ * selfElements_, 0);
+        for (int layer = 0; layer < numLayers_; layer++) {
+            uint16_t* k = selfCaches_[set].data() + (size_t)layer * selfElements_;
+            uint16_t* v = selfCaches_[set].data() + (size_t)(numLayers_ + layer) * selfElements_;
+            kSelf_[set].push_back(wrap(k, layerBytes, kSelfShape_, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16));
+            vSelf_[set].push_back(wrap(v, layerBytes, vSelfShape_, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16));
+            if (!kSelf_[set].back() || !vSelf_[set].back()) return false;
+        }
+    }
+    if (!inputIds_ || !positionIds_ || !zeroK_ || !zeroV_ || !logitsValue_) return false;
+
+    // Bindings that never change
+    if (!check(api_->BindInput(binding_, "input_ids", inputIds_), "BindInput(input_ids)")
+            || !check(api_->BindInput(binding_, "position_ids", positionIds_), "BindInput(position_ids)")
+            || !check(api_->BindOutput(binding_, "logits", logitsValue_), "BindOutput(logits)")) {
+        return false;
+    }
+
+    LOGI("Native decoder: %d layers, vocab %d (%s logits), mask %d, %.1f MB of ping-pong caches",
+         numLayers_, vocabSize_, logitsFp16_ ? "fp16" : "fp32", maskSize_,
+         2.0 * selfCaches_[0].size() * sizeof(uint16_t) / (1024.0 * 1024.0));
+    return true;
+}
+
+// ---- Decode loop ----
+
+// Ping-pong: step n reads set n % 2 (the zero block at step 0) and writes set (n + 1) % 2
+bool NativeDecoder::bindStep(int step, int position) {
+    if (!check(api_->BindInput(binding_, "attention_mask", masks_[std::min(position, maskSize_ - 1)]),
+               "BindInput(attention_mask)")) {
+        return false;
+    }
+    int in = step & 1;
+    int out = in ^ 1;
+    for (int layer = 0; layer < numLayers_; layer++) {
+        const OrtValue* kIn = step == 0 ? zeroK_ : kSelf_[in][layer];
+        const OrtValue* vIn = step == 0 ? zeroV_ : vSelf_[in][layer];
+        if (!check(api_->BindInput(binding_, kSelfIn_[layer].c_str(), kIn), "BindInput(k_cache_self)")
+                || !check(api_->BindInput(binding_, vSelfIn_[layer].c_str(), vIn), "BindInput(v_cache_self)")
+                || !check(api_->BindOutput(binding_, kSelfOut_[layer].c_str(), kSelf_[out][layer]),
+                          "BindOutput(k_cache_self)")
+                || !check(api_->BindOutput(binding_, vSelfOut_[layer].c_str(), vSelf_[out][layer]),
+                          "BindOutput(v_cache_self)")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+NativeDecodeResult NativeDecoder::decode(const uint16_t* const* crossK, const uint16_t* const* crossV,
+                                         const NativeDecodeParams& params, int32_t* outTokens, int maxTokens) {
+    NativeDecodeResult result;
+    if (params.scorer == nullptr || params.promptLength <= 0) return result;
+    auto start = std::chrono::steady_clock::now();
+
+    // The encoder outputs are wrapped, not copied; they only need to outlive this call
+    size_t crossBytes = crossElements_ * sizeof(uint16_t);
+    std::vector<OrtValue*> cross;
+    bool ok = true;
+    for (int layer = 0; layer < numLayers_ && ok; layer++) {
+        OrtValue* k = wrap(const_cast<uint16_t*>(crossK[layer]), crossBytes, kCrossShape_,
+                           ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        OrtValue* v = wrap(const_cast<uint16_t*>(crossV[layer]), crossBytes, vCrossShape_,
+                           ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        if (k) cross.push_back(k);
+        if (v) cross.push_back(v);
+        ok = k && v && check(api_->BindInput(binding_, kCross_[layer].c_str(), k), "BindInput(k_cache_cross)")
+                && check(api_->BindInput(binding_, vCross_[layer].c_str(), v), "BindInput(v_cache_cross)");
+    }
+
+    // Same bookkeeping as the Kotlin loop: all tokens fed so far, and the sampled ones
+    std::vector<int32_t> tokens(params.prompt, params.prompt + params.promptLength);
+    std::vector<int32_t> sampled;
+    tokens.reserve(params.promptLength + maxTokens + 1);
+    sampled.reserve(maxTokens + 1);
+    const int sampleFrom = params.promptLength - 1;
+
+    for (int step = 0; ok && step < (int)tokens.size() && step < maxTokens + params.promptLength; step++) {
+        if (isCancelled(params.cancel)) {
+            result.stopReason = DECODE_STOP_CANCELLED;
+            break;
+        }
+        *pool_->inputIds() = tokens[step];
+        *pool_->positionIds() = step;
+        if (!bindStep(step, step) || !check(api_->RunWithBinding(session_, runOptions_, binding_), "RunWithBinding")) {
+            break;
+        }
+        result.steps++;
+
+        // No-speech probability from the raw logits after SOT
+        if (step == params.sotIndex) {
+            if (logitsFp16_) params.scorer->noSpeechFp16(reinterpret_cast<const uint16_t*>(logits_.data()));
+            else params.scorer->noSpeechFp32(reinterpret_cast<const float*>(logits_.data()));
+        }
+        if (step < sampleFrom) continue;
+
+        int32_t next;
+        if (logitsFp16_) {
+            auto* logits = reinterpret_cast<uint16_t*>(logits_.data());
+            if (params.processor) params.processor->applyFp16(logits, sampled.data(), (int)sampled.size());
+            next = params.scorer->sampleFp16(logits, params.temperature);
+            params.scorer->acceptFp16(logits, next);
+        } else {
+            auto* logits = reinterpret_cast<float*>(logits_.data());
+            if (params.processor) params.processor->applyFp32(logits, sampled.data(), (int)sampled.size());
+            next = params.scorer->sampleFp32(logits, params.temperature);
+            params.scorer->acceptFp32(logits, next);
+        }
+
+        if (next == params.eot || next < 0) break;
+        tokens.push_back(next);
+        sampled.push_back(next);
+        if (next >= params.timestampBegin) continue;   // timestamps are fed back, not emitted
+
+        if (result.numTokens < maxTokens) outTokens[result.numTokens++] = next;
+        if (params.guard) {
+            DecodeStopReason reason = params.guard->accept(next);
+            if (reason != DECODE_CONTINUE) {
+                result.stopReason = reason;
+                result.numTokens = std::min(result.numTokens, params.guard->keepTokens());
+                break;
+            }
+        }
+        if (params.stream && params.stream->push(next) && params.onText) {
+            params.onText(params.textContext, *params.stream);
+        }
+    }
+
+    for (OrtValue* v : cross) api_->ReleaseValue(v);
+    result.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOGI("Native decode: %d tokens in %d steps, %.1f ms (%.2f ms/step)", result.numTokens, result.steps,
+         result.decodeMs, result.steps ? result.decodeMs / result.steps : 0.0);
+    lastResult_ = result;
+    return result;
+}
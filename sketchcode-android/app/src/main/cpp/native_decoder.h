@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <onnxruntime_c_api.h>
+
+#include "decoder_inputs.h"
+
+class LogitProcessor;
+class DecodeGuard;
+class DecodeScorer;
+class StreamDetokenizer;
+class CancellationToken;
+
+/**
+ * The autoregressive decoder loop on the ONNX Runtime C API.
+ *
+ * Replaces the per-step Kotlin loop (input map, JNI crossing, output OnnxTensors)
+ * with one native call per decode attempt. Every tensor is created once and bound
+ * through an OrtIoBinding:
+ *  - input_ids / position_ids / attention_mask come from a DecoderInputPool,
+ *  - logits are written into one preallocated buffer,
+ *  - the self-attention caches ping-pong between two preallocated sets: step n
+ *    reads set n % 2 and writes set (n + 1) % 2 (step 0 reads the pool's zeros),
+ *  - the cross-attention caches wrap the caller's encoder output buffers.
+ *
+ * Shapes, layer count and vocabulary size are read from the model, so the same loop
+ * runs the Whisper decoder on QNN and a small test model on the CPU provider.
+ * Requires ONNX Runtime at build time (WHISPER_HAS_ORT).
+ */
+struct NativeDecoderOptions {
+    std::string modelPath;
+    bool qnn = false;                                         // CPU provider otherwise
+    std::vector<std::pair<std::string, std::string>> qnnOptions;
+    std::vector<std::pair<std::string, std::string>> configEntries;  // session config
+};
+
+struct NativeDecodeParams {
+    const int32_t* prompt = nullptr;
+    int promptLength = 0;
+    int sotIndex = 0;                      // prompt position of SOT: no-speech is read there
+    float temperature = 0.0f;
+    int eot = 50257;
+    int timestampBegin = 50365;
+    LogitProcessor* processor = nullptr;   // optional
+    DecodeGuard* guard = nullptr;          // optional; reset by the caller
+    DecodeScorer* scorer = nullptr;        // required: token choice and scoring
+    // Optional streaming: every kept text token is pushed into stream (reset by the
+    // caller), and onText runs whenever that completes characters.
+    StreamDetokenizer* stream = nullptr;
+    void (*onText)(void* context, const StreamDetokenizer& stream) = nullptr;
+    void* textContext = nullptr;
+    // Optional: polled before every decoder run; stops with DECODE_STOP_CANCELLED
+    const CancellationToken* cancel = nullptr;
+};
+
+struct NativeDecodeResult {
+    int numTokens = 0;        // text tokens written to the output
+    int steps = 0;            // decoder runs, prompt included
+    int stopReason = 0;       // DecodeStopReason of the guard, 0 if none
+    double decodeMs = 0.0;
+};
+
+class NativeDecoder {
+public:
+    /** Load the decoder model; nullptr (and a log line) on failure. */
+    static std::unique_ptr<NativeDecoder> create(const NativeDecoderOptions& options);
+    ~NativeDecoder();
+
+    NativeDecoder(const NativeDecoder&) = delete;
+    NativeDecoder& operator=(const NativeDecoder&) = delete;
+
+    int numLayers() const { return numLayers_; }
+    int vocabSize() const { return vocabSize_; }
+    bool logitsFp16() const { return logitsFp16_; }
+    /** fp16 values per cross-attention cache tensor (K and V have the same count). */
+    size_t crossElements() const { return crossElements_; }
+
+    /**
+     * Run one decode attempt.
+     * @param crossK,crossV numLayers() fp16 encoder outputs each, crossElements() values
+     * @param outTokens receives up to maxTokens text tokens (no EOT, no timestamps)
+     */
+    NativeDecodeResult decode(const uint16_t* const* crossK, const uint16_t* const* crossV,
+                              const NativeDecodeParams& params, int32_t* outTokens, int maxTokens);
+    const NativeDecodeResult& lastResult() const { return lastResult_; }
+
+private:
+    NativeDecoder() = default;
+    bool init(const NativeDecoderOptions& options);
+    bool check(OrtStatus* status, const char* what);
+    OrtValue* wrap(void* data, size_t bytes, const std::vector<int64_t>& shape,
+                   ONNXTensorElementDataType type);
+    bool bindStep(int step, int position);
+
+    const OrtApi* api_ = nullptr;
+    OrtEnv* env_ = nullptr;
+    OrtSession* session_ = nullptr;
+    OrtMemoryInfo* memoryInfo_ = nullptr;
+    OrtIoBinding* binding_ = nullptr;
+    OrtRunOptions* runOptions_ = nullptr;
+
+    int numLayers_ = 0;
+    int vocabSize_ = 0;
+    int maskSize_ = 0;
+    bool logitsFp16_ = true;
+    size_t selfElements_ = 0;
+    size_t crossElements_ = 0;
+    std::vector<int64_t> kSelfShape_, vSelfShape_, kCrossShape_, vCrossShape_, maskShape_, logitsShape_;
+    std::vector<std::string> kSelfIn_, vSelfIn_, kSelfOut_, vSelfOut_, kCross_, vCross_;
+
+    std::unique_ptr<DecoderInputPool> pool_;
+    std::vector<uint16_t> selfCaches_[2];   // ping-pong sets: numLayers K blocks, then numLayers V blocks
+    std::vector<uint8_t> logits_;
+
+    // OrtValues over the buffers above, created once
+    OrtValue* inputIds_ = nullptr;
+    OrtValue* positionIds_ = nullptr;
+    OrtValue* logitsValue_ = nullptr;
+    OrtValue* zeroK_ = nullptr;
+    OrtValue* zeroV_ = nullptr;
+    std::vector<OrtValue*> masks_;
+    std::vector<OrtValue*> kSelf_[2], vSelf_[2];
+
+    NativeDecodeResult lastResult_;
+};
@@ -0,0 +1,208 @@
+#include <jni.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define LOG_TAG "WhisperNativeDecoder"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin NativeDecoder owns a native decoder session through an opaque jlong handle.
+// One nativeDecode call runs a whole decode attempt: the encoder's pinned cross-attention
+// buffers go in, token IDs come out. The logit processor, guard and scorer are passed as
+// the handles of their own Kotlin wrappers.
+//
+// Without ONNX Runtime at build time (WHISPER_HAS_ORT unset) nativeCreate returns 0 and
+// the app keeps decoding in Kotlin.
+
+#ifdef WHISPER_HAS_ORT
+
+#include "native_decoder.h"
+#include "cancellation.h"
+#include "decode_guard.h"
+#include "decode_scorer.h"
+#include "logit_processor.h"
+#include "stream_detokenizer.h"
+
+static inline NativeDecoder* fromHandle(jlong handle) {
+    return reinterpret_cast<NativeDecoder*>(handle);
+}
+
+static std::vector<std::pair<std::string, std::string>> stringPairs(JNIEnv* env, jobjectArray keys,
+                                                                     jobjectArray values) {
+    std::vector<std::pair<std::string, std::string>> pairs;
+    if (keys == nullptr || values == nullptr) return pairs;
+    jsize count = std::min(env->GetArrayLength(keys), env->GetArrayLength(values));
+    for (jsize i = 0; i < count; i++) {
+        auto key = static_cast<jstring>(env->GetObjectArrayElement(keys, i));
+        auto value = static_cast<jstring>(env->GetObjectArrayElement(values, i));
+        const char* k = env->GetStringUTFChars(key, nullptr);
+        const char* v = env->GetStringUTFChars(value, nullptr);
+        pairs.emplace_back(k, v);
+        env->ReleaseStringUTFChars(key, k);
+        env->ReleaseStringUTFChars(value, v);
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(value);
+    }
+    return pairs;
+}
+
+// Partial-text upcall: NativeDecoder.onStreamedText() reads the stream and notifies its
+// listener. An exception thrown there stops the upcalls for the rest of the attempt
+// rather than leaving it pending across ONNX Runtime calls.
+struct TextUpcall {
+    JNIEnv* env;
+    jobject decoder;
+    jmethodID method;
+};
+
+static void onStreamedText(void* context, const StreamDetokenizer& /* stream */) {
+    auto* upcall = static_cast<TextUpcall*>(context);
+    if (upcall->method == nullptr) return;
+    upcall->env->CallVoidMethod(upcall->decoder, upcall->method);
+    if (upcall->env->ExceptionCheck()) {
+        upcall->env->ExceptionClear();
+        LOGW("onStreamedText threw; partial text disabled for this attempt");
+        upcall->method = nullptr;
+    }
+}
+
+// Addresses of one direct buffer per layer, or false if any is missing or too small.
+static bool crossAddresses(JNIEnv* env, jobjectArray buffers, const NativeDecoder* decoder,
+                           std::vector<const uint16_t*>& out) {
+    if (buffers == nullptr || env->GetArrayLength(buffers) != decoder->numLayers()) return false;
+    jlong needed = (jlong)(decoder->crossElements() * sizeof(uint16_t));
+    for (int layer = 0; layer < decoder->numLayers(); layer++) {
+        jobject buffer = env->GetObjectArrayElement(buffers, layer);
+        auto* data = static_cast<const uint16_t*>(env->GetDirectBufferAddress(buffer));
+        bool ok = data != nullptr && env->GetDirectBufferCapacity(buffer) >= needed;
+        env->DeleteLocalRef(buffer);
+        if (!ok) return false;
+        out.push_back(data);
+    }
+    return true;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeCreate(
+        JNIEnv *env, jobject /* this */, jstring modelPath, jboolean qnn,
+        jobjectArray qnnKeys, jobjectArray qnnValues, jobjectArray configKeys, jobjectArray configValues) {
+    NativeDecoderOptions options;
+    const char* path = env->GetStringUTFChars(modelPath, nullptr);
+    options.modelPath = path;
+    env->ReleaseStringUTFChars(modelPath, path);
+    options.qnn = qnn;
+    options.qnnOptions = stringPairs(env, qnnKeys, qnnValues);
+    options.configEntries = stringPairs(env, configKeys, configValues);
+    return reinterpret_cast<jlong>(NativeDecoder::create(options).release());
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeDecode(
+        JNIEnv *env, jobject thiz, jlong handle, jobjectArray crossKBuffers, jobjectArray crossVBuffers,
+        jintArray prompt, jint sotIndex, jlong processorHandle, jlong guardHandle, jlong scorerHandle, jlong streamHandle,
+        jlong cancelHandle, jfloat temperature, jint eot, jint timestampBegin, jintArray outTokens) {
+    NativeDecoder* decoder = fromHandle(handle);
+    std::vector<const uint16_t*> crossK, crossV;
+    if (!crossAddresses(env, crossKBuffers, decoder, crossK) || !crossAddresses(env, crossVBuffers, decoder, crossV)) {
+        LOGE("nativeDecode: expected %d direct cross-attention buffers of %zu fp16 values each",
+             decoder->numLayers(), decoder->crossElements());
+        return 0;
+    }
+    if (scorerHandle == 0) return 0;
+
+    jsize promptLength = env->GetArrayLength(prompt);
+    std::vector<int32_t> promptTokens(promptLength);
+    env->GetIntArrayRegion(prompt, 0, promptLength, promptTokens.data());
+    jsize maxTokens = env->GetArrayLength(outTokens);
+    std::vector<int32_t> tokens(maxTokens);
+
+    NativeDecodeParams params;
+    params.prompt = promptTokens.data();
+    params.promptLength = promptLength;
+    params.sotIndex = sotIndex;
+    params.temperature = temperature;
+    params.eot = eot;
+    params.timestampBegin = timestampBegin;
+    params.processor = reinterpret_cast<LogitProcessor*>(processorHandle);
+    params.guard = reinterpret_cast<DecodeGuard*>(guardHandle);
+    params.scorer = reinterpret_cast<DecodeScorer*>(scorerHandle);
+    params.cancel = reinterpret_cast<const CancellationToken*>(cancelHandle);
+    TextUpcall upcall = { env, thiz, nullptr };
+    if (streamHandle != 0) {
+        jclass cls = env->GetObjectClass(thiz);
+        upcall.method = env->GetMethodID(cls, "onStreamedText", "()V");
+        env->DeleteLocalRef(cls);
+        if (upcall.method == nullptr) env->ExceptionClear();
+        params.stream = reinterpret_cast<StreamDetokenizer*>(streamHandle);
+        params.onText = onStreamedText;
+        params.textContext = &upcall;
+    }
+    NativeDecodeResult result = decoder->decode(crossK.data(), crossV.data(), params, tokens.data(), maxTokens);
+
+    env->SetIntArrayRegion(outTokens, 0, result.numTokens, tokens.data());
+    return result.numTokens;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeLastStopReason(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->lastResult().stopReason;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeLastSteps(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->lastResult().steps;
+}
+
+#else
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jstring /* modelPath */, jboolean /* qnn */,
+        jobjectArray /* qnnKeys */, jobjectArray /* qnnValues */, jobjectArray /* configKeys */,
+        jobjectArray /* configValues */) {
+    LOGW("Built without ONNX Runtime headers; native decoding unavailable");
+    return 0;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong /* handle */) {
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeDecode(
+        JNIEnv * /* env */, jobject /* this */, jlong /* handle */, jobjectArray /* crossKBuffers */,
+        jobjectArray /* crossVBuffers */, jintArray /* prompt */, jint /* sotIndex */, jlong /* processorHandle */,
+        jlong /* guardHandle */, jlong /* scorerHandle */, jlong /* streamHandle */, jlong /* cancelHandle */,
+        jfloat /* temperature */, jint /* eot */, jint /* timestampBegin */, jintArray /* outTokens */) {
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeLastStopReason(JNIEnv * /* env */, jobject /* this */, jlong /* handle */) {
+    return 0;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_NativeDecoder_nativeLastSteps(JNIEnv * /* env */, jobject /* this */, jlong /* handle */) {
+    return 0;
+}
+
+#endif
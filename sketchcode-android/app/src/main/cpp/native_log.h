@@ -0,0 +1,23 @@
+#pragma once
+
+// Logging shim shared by the native sources. On device this goes to logcat;
+// host builds (tools, fixtures) print to stderr so the same code runs off-device.
+// Each translation unit defines LOG_TAG before including this header.
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+
+#define NATIVE_LOG_(level, ...) do { \
+        fprintf(stderr, level "/" LOG_TAG ": " __VA_ARGS__); \
+        fputc('\n', stderr); \
+    } while (0)
+#define LOGI(...) NATIVE_LOG_("I", __VA_ARGS__)
+#define LOGW(...) NATIVE_LOG_("W", __VA_ARGS__)
+#define LOGE(...) NATIVE_LOG_("E", __VA_ARGS__)
+#endif
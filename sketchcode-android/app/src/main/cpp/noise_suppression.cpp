@@ -0,0 +1,64 @@
+#include "noise_suppression.h"
+#include "arena.h"
+
+#include <cmath>
+#include <algorithm>
+
+#define LOG_TAG "WhisperNoise"
+#include "native_log.h"
+
+void suppressNoise(float* power, int nFrames, int nBins, const NoiseSuppressionParams& params, Arena* arena) {
+    if (nFrames <= 0 || nBins <= 0) return;
+    Arena temporary;
+    if (arena == nullptr) arena = &temporary;
+    ArenaScope scratch(*arena);
+
+    // Rank frames by total energy
+    float* energy = arena->allocate<float>(nFrames);
+    for (int f = 0; f < nFrames; f++) {
+        const float* frame = power + (size_t)f * nBins;
+        float sum = 0.0f;
+        for (int k = 0; k < nBins; k++) {
+            sum += frame[k];
+        }
+        energy[f] = sum;
+    }
+
+    int nNoise = std::max(1, (int)(nFrames * params.noiseFrameFraction));
+    int* order = arena->allocate<int>(nFrames);
+    for (int f = 0; f < nFrames; f++) order[f] = f;
+    std::nth_element(order, order + (nNoise - 1), order + nFrames,
+                     [&](int a, int b) { return energy[a] < energy[b]; });
+
+    // Noise floor: mean power per bin over the quietest frames
+    float* noise = arena->allocate<float>(nBins);
+    std::fill(noise, noise + nBins, 0.0f);
+    for (int i = 0; i < nNoise; i++) {
+        const float* frame = power + (size_t)order[i] * nBins;
+        for (int k = 0; k < nBins; k++) {
+            noise[k] += frame[k];
+        }
+    }
+    float noiseEnergy = 0.0f;
+    for (int k = 0; k < nBins; k++) {
+        noise[k] = noise[k] / nNoise * params.overSubtraction;
+        noiseEnergy += noise[k];
+    }
+    if (noiseEnergy <= 0.0f) {
+        LOGI("Noise floor is zero over %d frames, skipping suppression", nNoise);
+        return;
+    }
+
+    // Wiener-style gain per bin, applied in place
+    for (int f = 0; f < nFrames; f++) {
+        float* frame = power + (size_t)f * nBins;
+        for (int k = 0; k < nBins; k++) {
+            float p = frame[k];
+            float gain = p > 0.0f ? 1.0f - noise[k] / p : 0.0f;
+            frame[k] = p * fmaxf(gain, params.gainFloor);
+        }
+    }
+
+    LOGI("Noise suppression: floor from %d/%d frames, mean noise energy %.4g",
+         nNoise, nFrames, noiseEnergy / params.overSubtraction);
+}
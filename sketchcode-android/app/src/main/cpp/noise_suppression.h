@@ -0,0 +1,27 @@
+#pragma once
+
+class Arena;
+
+/**
+ * Spectral-subtraction noise suppression on STFT power spectra.
+ *
+ * The noise floor is estimated per frequency bin as the mean power of the
+ * lowest-energy frames in the clip (pauses between words), and every frame is
+ * then attenuated in place with a Wiener-style gain
+ *   G = max(1 - alpha * N / P, beta)
+ * before the mel filterbank is applied. It reuses the spectra the mel engine
+ * already computed, so it costs no extra FFTs.
+ */
+struct NoiseSuppressionParams {
+    float noiseFrameFraction = 0.1f; // fraction of lowest-energy frames used for the noise estimate
+    float overSubtraction = 1.5f;    // alpha: > 1 removes residual "musical" noise more aggressively
+    float gainFloor = 0.05f;         // beta: minimum gain, keeps some noise to avoid artifacts
+};
+
+/**
+ * Attenuate the noise floor of a power spectrogram in place.
+ * @param power  [nFrames x nBins] row-major power spectra
+ * @param arena  scratch for the frame ranking, released on return (null: a temporary one)
+ */
+void suppressNoise(float* power, int nFrames, int nBins, const NoiseSuppressionParams& params,
+                   Arena* arena = nullptr);
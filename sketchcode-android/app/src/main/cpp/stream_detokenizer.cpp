@@ -0,0 +1,73 @@
+#include "stream_detokenizer.h"
+#include "vocabulary.h"
+
+namespace {
+
+const char REPLACEMENT[] = "\xEF\xBF\xBD";   // U+FFFD
+
+inline bool isContinuation(uint8_t b) { return (b & 0xC0) == 0x80; }
+
+// Length of the sequence a lead byte starts, 0 if it cannot start one
+inline size_t sequenceLength(uint8_t b) {
+    if (b < 0x80) return 1;
+    if (b >= 0xC2 && b <= 0xDF) return 2;
+    if (b >= 0xE0 && b <= 0xEF) return 3;
+    if (b >= 0xF0 && b <= 0xF4) return 4;
+    return 0;                                  // continuation, overlong C0/C1, F5+
+}
+
+// Second-byte ranges that rule out overlong forms, surrogates and > U+10FFFF
+inline bool validSecond(uint8_t lead, uint8_t b) {
+    if (lead == 0xE0) return b >= 0xA0 && b <= 0xBF;
+    if (lead == 0xED) return b >= 0x80 && b <= 0x9F;
+    if (lead == 0xF0) return b >= 0x90 && b <= 0xBF;
+    if (lead == 0xF4) return b >= 0x80 && b <= 0x8F;
+    return isContinuation(b);
+}
+
+} // namespace
+
+StreamDetokenizer::StreamDetokenizer(const Vocabulary* vocab) : vocab_(vocab) {
+    text_.reserve(1024);
+}
+
+void StreamDetokenizer::reset() {
+    text_.clear();
+    pendingLength_ = 0;
+    pendingNeed_ = 0;
+}
+
+void StreamDetokenizer::feed(uint8_t byte) {
+    if (pendingLength_ > 0) {
+        bool fits = pendingLength_ == 1 ? validSecond(pending_[0], byte) : isContinuation(byte);
+        if (fits) {
+            pending_[pendingLength_++] = byte;
+            if (pendingLength_ == pendingNeed_) {
+                text_.append(reinterpret_cast<const char*>(pending_), pendingLength_);
+                pendingLength_ = 0;
+            }
+            return;
+        }
+        // Truncated sequence: one replacement for it, then this byte starts afresh
+        text_.append(REPLACEMENT);
+        pendingLength_ = 0;
+    }
+    size_t need = sequenceLength(byte);
+    if (need == 1) {
+        text_.push_back((char)byte);
+    } else if (need == 0) {
+        text_.append(REPLACEMENT);
+    } else {
+        pending_[0] = byte;
+        pendingLength_ = 1;
+        pendingNeed_ = need;
+    }
+}
+
+bool StreamDetokenizer::push(int32_t token) {
+    size_t length = 0;
+    const uint8_t* bytes = vocab_->tokenBytes(token, &length);
+    size_t before = text_.size();
+    for (size_t i = 0; i < length; i++) feed(bytes[i]);
+    return text_.size() > before;
+}
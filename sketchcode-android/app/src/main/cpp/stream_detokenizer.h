@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Vocabulary;
+
+/**
+ * Incremental detokenizer for streaming partial transcripts.
+ *
+ * Byte-level BPE tokens are UTF-8 fragments: one character (an accented letter, a
+ * CJK ideograph, an emoji) can be split over two or three tokens. push() appends a
+ * token's bytes and moves every character that is now complete into text(); an
+ * unfinished sequence waits in a small pending buffer for the next token. Invalid
+ * bytes become U+FFFD, as Whisper's decode(errors="replace") does, so text() is
+ * always valid UTF-8 and a prefix of the final transcript.
+ *
+ * Special tokens (>= the vocabulary count) contribute nothing.
+ */
+class StreamDetokenizer {
+public:
+    /** The vocabulary must outlive the detokenizer. */
+    explicit StreamDetokenizer(const Vocabulary* vocab);
+
+    /** Start a new transcript. Keeps the text buffer's capacity. */
+    void reset();
+
+    /** Append one token; true if text() grew. */
+    bool push(int32_t token);
+
+    /** Complete characters so far (not NUL-terminated). */
+    const char* text() const { return text_.data(); }
+    size_t length() const { return text_.size(); }
+
+    /** Bytes held back as the start of an unfinished character. */
+    size_t pendingBytes() const { return pendingLength_; }
+
+private:
+    void feed(uint8_t byte);
+
+    const Vocabulary* vocab_;
+    std::string text_;
+    uint8_t pending_[4] = {};
+    size_t pendingLength_ = 0;
+    size_t pendingNeed_ = 0;      // full length of the pending sequence
+};
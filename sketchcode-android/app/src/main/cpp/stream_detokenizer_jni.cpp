@@ -0,0 +1,51 @@
+#include <jni.h>
+
+#include "stream_detokenizer.h"
+#include "vocabulary.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin StreamingDetokenizer owns a native detokenizer through an opaque jlong
+// handle; the handle is also passed to the native decoder, which pushes tokens into it
+// directly. Text goes back as UTF-8 bytes: JNI's modified UTF-8 cannot carry emoji.
+
+static inline StreamDetokenizer* fromHandle(jlong handle) {
+    return reinterpret_cast<StreamDetokenizer*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_StreamingDetokenizer_nativeCreate(
+        JNIEnv * /* env */, jobject /* this */, jlong vocabHandle) {
+    if (vocabHandle == 0) return 0;
+    return reinterpret_cast<jlong>(new StreamDetokenizer(reinterpret_cast<const Vocabulary*>(vocabHandle)));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_StreamingDetokenizer_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_StreamingDetokenizer_nativeReset(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->reset();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_StreamingDetokenizer_nativePush(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jint token) {
+    return fromHandle(handle)->push(token) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_sketchcode_app_whisper_StreamingDetokenizer_nativeText(JNIEnv *env, jobject /* this */, jlong handle) {
+    StreamDetokenizer* stream = fromHandle(handle);
+    jbyteArray out = env->NewByteArray((jsize)stream->length());
+    if (out != nullptr) {
+        env->SetByteArrayRegion(out, 0, (jsize)stream->length(), reinterpret_cast<const jbyte*>(stream->text()));
+    }
+    return out;
+}
@@ -0,0 +1,291 @@
+// Checks that the native front end of an utterance runs out of a warmed-up Arena
+// (arena.h) without touching the heap.
+//
+//   whisper_arena_check [-r rounds]
+//
+// An utterance pass is what the mel JNI entry points and the front-end thread do:
+// beamform stereo into mono, the log-mel (trimmed or full, with and without noise
+// suppression, fp32 or quantized), speech detection, then Arena::reset() at the end of
+// the transcription. Every malloc-family call of the process is counted. Checks that:
+//  - each pass gives the same mel, bit for bit, as the same call without an arena,
+//  - after one warm-up round over all utterance kinds, `rounds` more rounds make zero
+//    heap allocations, and the arena takes no new blocks,
+//  - a pass leaves the arena empty (scratch released by the stages that took it),
+//  - allocations are aligned as asked, also above the blocks' own 64-byte alignment,
+// and reports the high-water mark and the cost of a pass with and without the arena.
+// Exits non-zero on any failure.
+
+#include "arena.h"
+#include "beamformer.h"
+#include "mel_engine.h"
+#include "test_signals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// ---- Allocation accounting ----
+// glibc's malloc family, wrapped: operator new, aligned new and the C library all end
+// up here. Only calls made while `counting` is set are counted.
+
+static std::atomic<bool> counting{ false };
+static std::atomic<long long> heapCalls{ 0 };
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) heapCalls++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (counting.load(std::memory_order_relaxed)) heapCalls++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+    if (counting.load(std::memory_order_relaxed)) heapCalls++;
+    return __libc_realloc(p, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    if (counting.load(std::memory_order_relaxed)) heapCalls++;
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* p = memalign(alignment, size);
+    if (p == nullptr) return ENOMEM;
+    *out = p;
+    return 0;
+}
+}
+
+static std::vector<float> syntheticStereo(int frames, int delay, uint32_t seed) {
+    // A talker reaching the right mic `delay` samples late
+    SyntheticSpeechOptions speech;
+    speech.seed = seed;
+    std::vector<float> mono = syntheticSpeech(frames + delay, speech);
+    std::vector<float> interleaved(2 * (size_t)frames);
+    for (int i = 0; i < frames; i++) {
+        interleaved[2 * i] = mono[i + delay];
+        interleaved[2 * i + 1] = mono[i];
+    }
+    return interleaved;
+}
+
+struct Utterance {
+    const char* name;
+    std::vector<float> interleaved;  // stereo, or mono when channels == 1
+    int channels;
+    bool suppressNoise;
+    int bucketFrames;
+    MelQuantType quantType;
+};
+
+struct PassResult {
+    int frames = 0;
+    int speechFrames = 0;
+};
+
+// One front-end pass as the JNI entry points run it; mel receives the spectrogram.
+// Without an arena, the buffers are vectors and the stages use their own scratch.
+static PassResult frontEnd(const Utterance& u, Arena* arena, std::vector<float>& mel, std::vector<uint8_t>& quantized) {
+    int samples = (int)u.interleaved.size() / u.channels;
+    int frames = melFramesForAudio(samples, u.bucketFrames);
+    std::vector<float> heapMono, heapMel;
+    float* melSpec;
+    const float* audio = u.interleaved.data();
+    if (arena != nullptr) {
+        if (u.channels == 2) {
+            float* mono = arena->allocate<float>(std::max(samples, 1));
+            beamformStereo(u.interleaved.data(), samples, mono, *arena);
+            audio = mono;
+        }
+        melSpec = arena->allocate<float>((size_t)N_MELS * frames);
+    } else {
+        if (u.channels == 2) {
+            beamformStereo(u.interleaved.data(), samples, heapMono);
+            audio = heapMono.data();
+        }
+        heapMel.resize((size_t)N_MELS * frames);
+        melSpec = heapMel.data();
+    }
+
+    MelOptions options;
+    options.suppressNoise = u.suppressNoise;
+    options.outputFrames = frames;
+    options.arena = arena;
+    if (u.quantType != MEL_QUANT_NONE) {
+        options.quantization = defaultMelQuantization(u.quantType);
+        options.quantizedOut = quantized.data();
+    }
+    computeLogMelSpectrogram(audio, samples, options, melSpec);
+
+    PassResult result;
+    result.frames = frames;
+    result.speechFrames = detectSpeechFrames(melSpec, frames, frames, nullptr);
+    // The JNI layer copies the spectrogram out into a Java array
+    memcpy(mel.data(), melSpec, (size_t)N_MELS * frames * sizeof(float));
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int rounds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            rounds = std::max(1, atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "usage: %s [-r rounds]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Utterance> utterances;
+    auto add = [&](const char* name, float seconds, int channels, bool denoise, int bucket, MelQuantType quant) {
+        std::vector<float> stereo = syntheticStereo((int)(seconds * SAMPLE_RATE), 3, 99u + (uint32_t)utterances.size());
+        Utterance u{ name, {}, channels, denoise, bucket, quant };
+        if (channels == 2) {
+            u.interleaved = std::move(stereo);
+        } else {
+            for (size_t s = 0; s < stereo.size(); s += 2) u.interleaved.push_back(stereo[s]);
+        }
+        utterances.push_back(std::move(u));
+    };
+    add("mono 1.5 s trimmed", 1.5f, 1, false, 500, MEL_QUANT_NONE);
+    add("mono 4 s trimmed denoise", 4.0f, 1, true, 500, MEL_QUANT_NONE);
+    add("mono 12 s full int8", 12.0f, 1, false, 0, MEL_QUANT_INT8);
+    add("stereo 6 s trimmed uint8", 6.0f, 2, true, 500, MEL_QUANT_UINT8);
+    add("stereo 30 s full denoise", 30.0f, 2, true, 0, MEL_QUANT_NONE);
+    add("mono 45 s full denoise", 45.0f, 1, true, 0, MEL_QUANT_INT8);
+
+    const size_t count = (size_t)N_MELS * N_FRAMES;
+    std::vector<float> mel(count), reference(count);
+    std::vector<uint8_t> quantized(count), referenceQuantized(count);
+    int failures = 0;
+
+    // Reference mels without an arena
+    std::vector<std::vector<float>> golden;
+    std::vector<std::vector<uint8_t>> goldenQuantized;
+    double heapMs = 0.0;
+    for (const Utterance& u : utterances) {
+        auto start = Clock::now();
+        PassResult r = frontEnd(u, nullptr, reference, referenceQuantized);
+        heapMs += msSince(start);
+        golden.emplace_back(reference.begin(), reference.begin() + (size_t)N_MELS * r.frames);
+        goldenQuantized.emplace_back(referenceQuantized.begin(), referenceQuantized.begin() + (size_t)N_MELS * r.frames);
+    }
+
+    Arena arena;
+    auto pass = [&](size_t index) {
+        const Utterance& u = utterances[index];
+        PassResult r;
+        {
+            ArenaScope call(arena);
+            r = frontEnd(u, &arena, mel, quantized);
+        }
+        size_t values = (size_t)N_MELS * r.frames;
+        if (values != golden[index].size() || memcmp(mel.data(), golden[index].data(), values * sizeof(float)) != 0) {
+            fprintf(stderr, "FAIL: %s: mel differs from the one computed without an arena\n", u.name);
+            failures++;
+        }
+        if (u.quantType != MEL_QUANT_NONE && memcmp(quantized.data(), goldenQuantized[index].data(), values) != 0) {
+            fprintf(stderr, "FAIL: %s: quantized mel differs from the one computed without an arena\n", u.name);
+            failures++;
+        }
+        if (arena.stats().used != 0) {
+            fprintf(stderr, "FAIL: %s: %zu bytes still allocated after the pass\n", u.name, arena.stats().used);
+            failures++;
+        }
+        // End of the transcription
+        arena.reset();
+    };
+
+    // Alignments above the block alignment, in the first block and in a spilled one
+    {
+        Arena aligned(4096);
+        size_t allocations = 0;
+        for (size_t alignment : { 8, 64, 256, 4096, 16384 }) {
+            for (size_t bytes : { (size_t)1, (size_t)100, (size_t)300000 }) {
+                void* p = aligned.allocate(bytes, alignment);
+                allocations++;
+                if (reinterpret_cast<uintptr_t>(p) % alignment != 0) {
+                    fprintf(stderr, "FAIL: %zu bytes at %p are not %zu-aligned\n", bytes, p, alignment);
+                    failures++;
+                }
+            }
+        }
+        if (aligned.stats().blocks < 2 || allocations == 0) {
+            fprintf(stderr, "FAIL: the alignment check never spilled into a second block\n");
+            failures++;
+        }
+    }
+
+    // The accounting must see the heap, or zero below proves nothing
+    counting = true;
+    std::vector<float>* probe = new std::vector<float>(N_FFT);
+    counting = false;
+    delete probe;
+    if (heapCalls.load() < 2) {
+        fprintf(stderr, "FAIL: allocation counting does not see operator new\n");
+        failures++;
+    }
+
+    // Warm-up: grows the arena to the largest utterance, the reset after it merges the blocks
+    for (size_t i = 0; i < utterances.size(); i++) pass(i);
+    Arena::Stats warm = arena.stats();
+
+    long long heapTotal = 0;
+    double arenaMs = 0.0;
+    printf("%-28s %10s\n", "utterance", "heap_calls");
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < utterances.size(); i++) {
+            // Longest first on odd rounds, so no order of utterances is special
+            size_t index = round % 2 == 0 ? i : utterances.size() - 1 - i;
+            heapCalls = 0;
+            auto start = Clock::now();
+            counting = true;
+            pass(index);
+            counting = false;
+            arenaMs += msSince(start);
+            long long calls = heapCalls.load();
+            heapTotal += calls;
+            if (round == 0) printf("%-28s %10lld\n", utterances[index].name, calls);
+            if (calls != 0) {
+                fprintf(stderr, "FAIL: %s: %lld heap allocations after warm-up\n", utterances[index].name, calls);
+                failures++;
+            }
+        }
+    }
+    Arena::Stats stats = arena.stats();
+    if (stats.heapBlocks != warm.heapBlocks || stats.blocks != 1) {
+        fprintf(stderr, "FAIL: arena took %llu new blocks after warm-up (%d held)\n",
+                (unsigned long long)(stats.heapBlocks - warm.heapBlocks), stats.blocks);
+        failures++;
+    }
+
+    printf("%d rounds of %zu utterances: %lld heap allocations after warm-up\n",
+           rounds, utterances.size(), heapTotal);
+    printf("arena: high-water %.2f MB, capacity %.2f MB in %d block(s), %llu heap blocks, %llu resets\n",
+           stats.highWater / 1048576.0, stats.capacity / 1048576.0, stats.blocks,
+           (unsigned long long)stats.heapBlocks, (unsigned long long)stats.resets);
+    printf("front end per round: arena %.2f ms, heap %.2f ms\n", arenaMs / rounds, heapMs);
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include "audio_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint16_t WAVE_FORMAT_PCM = 1;
+static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+static constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+static inline uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+MappedAudioFile::~MappedAudioFile() {
+    close();
+}
+
+void MappedAudioFile::close() {
+    if (map_ != nullptr) {
+        munmap(map_, mapSize_);
+    }
+    map_ = nullptr;
+    mapSize_ = 0;
+    data_ = nullptr;
+    numFrames_ = 0;
+}
+
+bool MappedAudioFile::open(const std::string& path) {
+    close();
+    error_.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open: " + std::string(strerror(errno));
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        error_ = "empty or unreadable file";
+        ::close(fd);
+        return false;
+    }
+    mapSize_ = (size_t)st.st_size;
+    map_ = mmap(nullptr, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        error_ = "mmap failed: " + std::string(strerror(errno));
+        return false;
+    }
+    madvise(map_, mapSize_, MADV_SEQUENTIAL);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(map_);
+    if (mapSize_ >= 12 && memcmp(bytes, "RIFF", 4) == 0 && memcmp(bytes + 8, "WAVE", 4) == 0) {
+        if (!parseWav()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Headerless PCM: 16 kHz, mono, s16le
+    data_ = bytes;
+    sampleRate_ = 16000;
+    channels_ = 1;
+    bitsPerSample_ = 16;
+    isFloat_ = false;
+    numFrames_ = mapSize_ / 2;
+    return true;
+}
+
+bool MappedAudioFile::parseWav() {
+    const uint8_t* bytes = static_cast<const uint8_t*>(map_);
+    size_t pos = 12;
+    bool haveFormat = false;
+    uint16_t format = 0;
+
+    while (pos + 8 <= mapSize_) {
+        const uint8_t* chunk = bytes + pos;
+        uint32_t chunkSize = readU32(chunk + 4);
+        size_t body = pos + 8;
+        size_t available = mapSize_ - body;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && available >= 16) {
+            format = readU16(bytes + body);
+            channels_ = readU16(bytes + body + 2);
+            sampleRate_ = (int)readU32(bytes + body + 4);
+            bitsPerSample_ = readU16(bytes + body + 14);
+            if (format == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26 && available >= 26) {
+                format = readU16(bytes + body + 24); // first two bytes of the subformat GUID
+            }
+            haveFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                error_ = "data chunk before fmt chunk";
+                return false;
+            }
+            if (format == WAVE_FORMAT_PCM && bitsPerSample_ == 16) {
+                isFloat_ = false;
+            } else if (format == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample_ == 32) {
+                isFloat_ = true;
+            } else {
+                error_ = "unsupported WAV encoding (format " + std::to_string(format) +
+                         ", " + std::to_string(bitsPerSample_) + " bit)";
+                return false;
+            }
+            if (channels_ < 1) {
+                error_ = "invalid channel count";
+                return false;
+            }
+            // Streams written by a killed recorder often have a bogus data size
+            size_t dataBytes = chunkSize <= available ? chunkSize : available;
+            data_ = bytes + body;
+            numFrames_ = dataBytes / ((size_t)channels_ * (bitsPerSample_ / 8));
+            return true;
+        }
+        pos = body + chunkSize + (chunkSize & 1); // chunks are word aligned
+    }
+    error_ = "no data chunk";
+    return false;
+}
+
+const float* MappedAudioFile::floatSamples() const {
+    if (!isFloat_ || reinterpret_cast<uintptr_t>(data_) % alignof(float) != 0) return nullptr;
+    return reinterpret_cast<const float*>(data_);
+}
+
+void MappedAudioFile::toFloat(size_t firstFrame, size_t frames, float* out) const {
+    firstFrame = std::min(firstFrame, numFrames_);
+    frames = std::min(frames, numFrames_ - firstFrame);
+    size_t first = firstFrame * channels_;
+    size_t n = frames * channels_;
+    if (isFloat_) {
+        memcpy(out, data_ + first * sizeof(float), n * sizeof(float));
+    } else {
+        const uint8_t* src = data_ + 2 * first;
+        for (size_t i = 0; i < n; i++) {
+            int16_t s;
+            memcpy(&s, src + 2 * i, sizeof(s));
+            out[i] = s / 32768.0f;
+        }
+    }
+}
+
+void MappedAudioFile::toFloat(std::vector<float>& out, size_t maxFrames) const {
+    size_t frames = std::min(maxFrames, numFrames_);
+    out.resize(frames * channels_);
+    toFloat(0, frames, out.data());
+}
+
+bool writeNpy(const std::string& path, const float* data, const std::vector<size_t>& shape) {
+    std::string dims;
+    size_t count = 1;
+    for (size_t d : shape) {
+        dims += std::to_string(d) + ", ";
+        count *= d;
+    }
+    // "(a, b)" for N-D, but "(a,)" for 1-D
+    if (shape.size() > 1) {
+        dims.resize(dims.size() - 2);
+    } else if (!shape.empty()) {
+        dims.resize(dims.size() - 1);
+    }
+    std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + dims + "), }";
+
+    // Magic (6) + version (2) + header length (2) + header, padded to 64 bytes with '\n' last
+    size_t total = 10 + header.size() + 1;
+    header.append((64 - total % 64) % 64, ' ');
+    header.push_back('\n');
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+    const char magic[] = "\x93NUMPY\x01\x00";
+    uint16_t headerLen = (uint16_t)header.size();
+    uint8_t lenBytes[2] = { (uint8_t)(headerLen & 0xFF), (uint8_t)(headerLen >> 8) };
+    bool ok = fwrite(magic, 1, 8, f) == 8 &&
+              fwrite(lenBytes, 1, 2, f) == 2 &&
+              fwrite(header.data(), 1, header.size(), f) == header.size() &&
+              fwrite(data, sizeof(float), count, f) == count;
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only memory-mapped audio file (host tools only).
+ *
+ * Supports RIFF/WAVE with PCM16 or IEEE float32 samples, and headerless .pcm
+ * files (16-bit little-endian mono). Sample data is used straight from the
+ * mapping: floatSamples() hands out aligned float32 data as is, and toFloat()
+ * converts a range of frames into a caller-owned buffer, so a long recording can
+ * be read block by block instead of copied whole.
+ */
+class MappedAudioFile {
+public:
+    MappedAudioFile() = default;
+    ~MappedAudioFile();
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+
+    /** Map and parse the file. On failure returns false and sets error(). */
+    bool open(const std::string& path);
+    void close();
+
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return channels_; }
+    /** Sample frames (one sample per channel each). */
+    size_t numFrames() const { return numFrames_; }
+    double durationSeconds() const { return sampleRate_ > 0 ? (double)numFrames_ / sampleRate_ : 0.0; }
+    const std::string& error() const { return error_; }
+
+    /**
+     * Interleaved float32 samples straight from the mapping, or nullptr when the file
+     * is PCM16 or its data chunk is not 4-byte aligned (then use toFloat()).
+     */
+    const float* floatSamples() const;
+
+    /** Convert frames [firstFrame, firstFrame + frames) to interleaved float32 in [-1, 1]. */
+    void toFloat(size_t firstFrame, size_t frames, float* out) const;
+    /** Convert the first maxFrames frames (all by default) into out, resized to fit. */
+    void toFloat(std::vector<float>& out, size_t maxFrames = SIZE_MAX) const;
+
+private:
+    bool parseWav();
+
+    void* map_ = nullptr;
+    size_t mapSize_ = 0;
+    const uint8_t* data_ = nullptr; // first sample
+    size_t numFrames_ = 0;
+    int sampleRate_ = 0;
+    int channels_ = 0;
+    int bitsPerSample_ = 0;
+    bool isFloat_ = false;
+    std::string error_;
+};
+
+/** Write a C-order float32 .npy array (NumPy format version 1.0). */
+bool writeNpy(const std::string& path, const float* data, const std::vector<size_t>& shape);
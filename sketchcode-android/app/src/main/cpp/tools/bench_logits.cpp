@@ -0,0 +1,123 @@
+// Microbenchmark for the per-step logits kernels used by the decoder loop.
+//
+//   whisper_logits_bench [-n steps]
+//
+// Compares the native kernels against models of the previous Kotlin paths
+// (allocate a FloatArray(VOCAB_SIZE), widen fp16 one value at a time, then a
+// scalar argmax or a full sortedByDescending for top-k) on synthetic logits,
+// and reports the per-step cost of each.
+
+#include "fp16.h"
+#include "logits.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+static constexpr int VOCAB_SIZE = 51866;
+
+template <typename F>
+static double perStepMicros(int steps, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) body(s);
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / steps;
+}
+
+static volatile int sink;
+
+int main(int argc, char** argv) {
+    int steps = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) steps = atoi(argv[++i]);
+    }
+
+    // A handful of distinct logit vectors so the winner moves between steps
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist(0.0f, 4.0f);
+    constexpr int VARIANTS = 8;
+    std::vector<std::vector<uint16_t>> fp16Logits(VARIANTS, std::vector<uint16_t>(VOCAB_SIZE));
+    std::vector<std::vector<float>> fp32Logits(VARIANTS, std::vector<float>(VOCAB_SIZE));
+    for (int v = 0; v < VARIANTS; v++) {
+        for (int i = 0; i < VOCAB_SIZE; i++) {
+            fp16Logits[v][i] = floatToFp16(dist(rng));
+            fp32Logits[v][i] = fp16ToFloat(fp16Logits[v][i]);
+        }
+    }
+
+    // Baseline: fresh float array per step, per-element widening, scalar argmax
+    double baseline = perStepMicros(steps, [&](int s) {
+        const uint16_t* src = fp16Logits[s % VARIANTS].data();
+        std::unique_ptr<float[]> logits(new float[VOCAB_SIZE]);
+        for (int i = 0; i < VOCAB_SIZE; i++) logits[i] = fp16ToFloat(src[i]);
+        int best = 0;
+        for (int i = 1; i < VOCAB_SIZE; i++) {
+            if (logits[i] > logits[best]) best = i;
+        }
+        sink = best;
+    });
+
+    double nativeFp16 = perStepMicros(steps, [&](int s) {
+        sink = argmaxFp16(fp16Logits[s % VARIANTS].data(), VOCAB_SIZE);
+    });
+    double nativeFp32 = perStepMicros(steps, [&](int s) {
+        sink = argmaxFp32(fp32Logits[s % VARIANTS].data(), VOCAB_SIZE);
+    });
+
+    constexpr int TOP_K = 5;
+    std::vector<int> order(VOCAB_SIZE);
+    double sortBaseline = perStepMicros(std::max(steps / 20, 1), [&](int s) {
+        const std::vector<float>& logits = fp32Logits[s % VARIANTS];
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return logits[a] > logits[b]; });
+        sink = order[TOP_K - 1];
+    });
+
+    int32_t topIndices[TOP_K];
+    float topValues[TOP_K];
+    double topKNativeFp16 = perStepMicros(steps, [&](int s) {
+        topKFp16(fp16Logits[s % VARIANTS].data(), VOCAB_SIZE, TOP_K, topIndices, topValues);
+        sink = topIndices[0];
+    });
+    double topKNativeFp32 = perStepMicros(steps, [&](int s) {
+        topKFp32(fp32Logits[s % VARIANTS].data(), VOCAB_SIZE, TOP_K, topIndices, topValues);
+        sink = topIndices[0];
+    });
+
+    // Cross-check the kernels against the scalar reference
+    int mismatches = 0;
+    for (int v = 0; v < VARIANTS; v++) {
+        int ref = 0;
+        for (int i = 1; i < VOCAB_SIZE; i++) {
+            if (fp32Logits[v][i] > fp32Logits[v][ref]) ref = i;
+        }
+        if (argmaxFp16(fp16Logits[v].data(), VOCAB_SIZE) != ref) mismatches++;
+        if (argmaxFp32(fp32Logits[v].data(), VOCAB_SIZE) != ref) mismatches++;
+
+        const std::vector<float>& logits = fp32Logits[v];
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return logits[a] > logits[b]; });
+        topKFp16(fp16Logits[v].data(), VOCAB_SIZE, TOP_K, topIndices, topValues);
+        if (!std::equal(topIndices, topIndices + TOP_K, order.begin())) mismatches++;
+        topKFp32(logits.data(), VOCAB_SIZE, TOP_K, topIndices, topValues);
+        if (!std::equal(topIndices, topIndices + TOP_K, order.begin())) mismatches++;
+    }
+
+    printf("argmax over %d logits, %d steps\n", VOCAB_SIZE, steps);
+    printf("  baseline (alloc + widen + scalar): %8.2f us/step, %zu bytes allocated/step\n",
+           baseline, VOCAB_SIZE * sizeof(float));
+    printf("  native fp16 in place:              %8.2f us/step (%.1fx)\n", nativeFp16, baseline / nativeFp16);
+    printf("  native fp32 in place:              %8.2f us/step (%.1fx)\n", nativeFp32, baseline / nativeFp32);
+    printf("top-%d over %d logits\n", TOP_K, VOCAB_SIZE);
+    printf("  baseline (full sort):              %8.2f us/step\n", sortBaseline);
+    printf("  native fp16 partial top-k:         %8.2f us/step (%.1fx)\n", topKNativeFp16, sortBaseline / topKNativeFp16);
+    printf("  native fp32 partial top-k:         %8.2f us/step (%.1fx)\n", topKNativeFp32, sortBaseline / topKNativeFp32);
+    printf("mismatches vs reference: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
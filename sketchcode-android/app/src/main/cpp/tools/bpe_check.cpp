@@ -0,0 +1,249 @@
+// Checks the native BPE encoder (bpe_encoder.cpp) against reference tokenizations,
+// the streaming detokenizer (stream_detokenizer.cpp) against whole-list decoding, and
+// the identifier trie (context_bias.cpp) built from encoded identifiers.
+//
+//   whisper_bpe_check vocab.bin [reference.tsv] [-n benchRuns]
+//
+// reference.tsv holds lines of "text<TAB>id id id" produced by tiktoken with Whisper's
+// pattern and ranks (tools/export_bpe_reference.py; \t and \n escaped in the text),
+// and defaults to the checked-in tools/testdata/bpe_reference.tsv. Every line is
+// compared token for token, every string of the built-in corpus of code identifiers
+// and prose must have a line, and decoding must give the input back. Each corpus
+// string is then streamed back one token at a time: every partial text must be a
+// prefix of the decoded string, and the last one the whole of it. Identifiers added to a ContextBias must have each next token
+// boosted after each of their proper prefixes, and nothing once removed. Then times
+// encoding an identifier prompt cold (empty cache) and warm, and one bias lookup.
+// Exits non-zero on any mismatch.
+
+#include "bpe_encoder.h"
+#include "context_bias.h"
+#include "stream_detokenizer.h"
+#include "vocabulary.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char* kCorpus[] = {
+    "getUserById fetchRecords parseJsonResponse HttpClient onCreateView",
+    "snake_case_name MAX_BUFFER_SIZE __init__ self.assertEqual(x, 42)",
+    "val interimText = state.copy(interimText = \"\")",
+    "for (int i = 0; i < n; i++) { total += values[i]; }",
+    "It's what they'll say, isn't it? We've been here before; I'd go.",
+    "  leading spaces,\ttabs\tand\n\nnewlines   trailing   ",
+    "numbers 3.14159 and 1,000,000 and v2alpha3",
+    "naïve café résumé — 東京 über straße",
+    "emoji 🎤 done!!! ???",
+    "",
+};
+
+static std::vector<int32_t> encode(BpeEncoder& encoder, const std::string& text) {
+    std::vector<int32_t> ids(text.size() + 1);
+    int n = encoder.encode(text.data(), text.size(), ids.data(), (int)ids.size());
+    ids.resize(n);
+    return ids;
+}
+
+static std::string decode(const Vocabulary& vocab, const std::vector<int32_t>& ids) {
+    std::string out(vocab.decode(ids.data(), ids.size(), nullptr, 0), '\0');
+    vocab.decode(ids.data(), ids.size(), reinterpret_cast<uint8_t*>(&out[0]), out.size());
+    return out;
+}
+
+static void printIds(const char* label, const std::vector<int32_t>& ids) {
+    printf("  %s:", label);
+    for (int32_t id : ids) printf(" %d", id);
+    printf("\n");
+}
+
+static std::string unescape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '\\' && i + 1 < s.size()) {
+            char c = s[++i];
+            out += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+#ifndef WHISPER_BPE_REFERENCE
+#define WHISPER_BPE_REFERENCE "tools/testdata/bpe_reference.tsv"
+#endif
+
+// text -> expected ids; false if the file cannot be read
+static bool loadReference(const char* path, std::map<std::string, std::vector<int32_t>>& reference) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[8192];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        std::string s(line);
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) s.pop_back();
+        size_t tab = s.rfind('\t');
+        if (tab == std::string::npos) continue;
+        std::vector<int32_t>& expected = reference[unescape(s.substr(0, tab))];
+        for (char* p = &s[tab + 1]; *p != '\0';) {
+            char* end;
+            long id = strtol(p, &end, 10);
+            if (end == p) break;
+            expected.push_back((int32_t)id);
+            p = end;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* vocabPath = nullptr;
+    const char* referencePath = WHISPER_BPE_REFERENCE;
+    int benchRuns = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) benchRuns = atoi(argv[++i]);
+        else if (vocabPath == nullptr) vocabPath = argv[i];
+        else referencePath = argv[i];
+    }
+    if (vocabPath == nullptr) {
+        fprintf(stderr, "usage: %s vocab.bin [reference.tsv] [-n benchRuns]\n", argv[0]);
+        return 2;
+    }
+    std::unique_ptr<Vocabulary> vocab(Vocabulary::open(vocabPath));
+    if (!vocab) return 1;
+
+    std::map<std::string, std::vector<int32_t>> reference;
+    if (!loadReference(referencePath, reference)) return 1;
+
+    int failures = 0;
+    BpeEncoder encoder(vocab.get());
+    size_t totalTokens = 0;
+    for (const char* text : kCorpus) {
+        if (reference.count(text) == 0) {
+            if (failures++ < 10) printf("no reference for \"%s\"\n", text);
+        }
+    }
+    for (const auto& [text, expected] : reference) {
+        std::vector<int32_t> actual = encode(encoder, text);
+        totalTokens += actual.size();
+        if (actual != expected || decode(*vocab, actual) != text) {
+            if (failures++ < 10) {
+                printf("mismatch: \"%s\"\n", text.c_str());
+                printIds("reference", expected);
+                printIds("encoder  ", actual);
+            }
+        }
+    }
+    printf("reference: %zu strings, %zu tokens, %d mismatches\n", reference.size(), totalTokens, failures);
+
+    // Streaming: multi-byte characters span tokens, so partial texts must hold them back.
+    // Special tokens mixed in must not show up.
+    StreamDetokenizer stream(vocab.get());
+    int streamFailures = 0, heldBack = 0;
+    for (const char* text : kCorpus) {
+        stream.reset();
+        std::vector<int32_t> ids = encode(encoder, text);
+        for (int32_t id : ids) {
+            stream.push(id);
+            stream.push(vocab->count() + 1);
+            std::string partial(stream.text(), stream.length());
+            if (stream.pendingBytes() > 0) heldBack++;
+            if (strncmp(text, partial.c_str(), partial.size()) != 0 || partial.size() > strlen(text)) {
+                if (streamFailures++ < 10) printf("stream: \"%s\" is not a prefix of \"%s\"\n", partial.c_str(), text);
+                break;
+            }
+        }
+        if (stream.length() != strlen(text) || stream.pendingBytes() != 0) {
+            if (streamFailures++ < 10) printf("stream: incomplete \"%.*s\" for \"%s\"\n", (int)stream.length(), stream.text(), text);
+        }
+    }
+    // A truncated sequence and a stray continuation byte each become U+FFFD
+    stream.reset();
+    for (const char* bytes : { "\xE6\x9D", "a", "\x80" }) {
+        stream.push(vocab->lookup(reinterpret_cast<const uint8_t*>(bytes), strlen(bytes)));
+    }
+    if (std::string(stream.text(), stream.length()) != "\xEF\xBF\xBD" "a" "\xEF\xBF\xBD") {
+        if (streamFailures++ < 10) printf("stream: invalid bytes not replaced\n");
+    }
+    printf("stream: %d partial texts held back a split character, %d mismatches\n", heldBack, streamFailures);
+    failures += streamFailures;
+
+    // Contextual bias: each identifier, after some unrelated speech, is boosted token by token
+    const char* identifiers[] = { " getPendingAnnotation", " fetchPending", " getPendingCount", " KvCachePingPong" };
+    ContextBias bias(2.0f);
+    std::vector<std::vector<int32_t>> words;
+    for (const char* id : identifiers) {
+        words.push_back(encode(encoder, id));
+        bias.add(words.back().data(), (int)words.back().size());
+    }
+    int biasFailures = 0;
+    int32_t boosted[256];
+    float boosts[256];
+    std::vector<int32_t> history = encode(encoder, " rename");
+    for (const auto& word : words) {
+        for (size_t k = 1; k < word.size(); k++) {
+            std::vector<int32_t> h = history;
+            h.insert(h.end(), word.begin(), word.begin() + k);
+            int n = bias.collect(h.data(), (int)h.size(), boosted, boosts, 256);
+            if (std::find(boosted, boosted + n, word[k]) == boosted + n) {
+                if (biasFailures++ < 10) printf("bias: token %zu of word %zu not boosted\n", k, (size_t)(&word - &words[0]));
+            }
+        }
+    }
+    int unrelated = bias.collect(history.data(), (int)history.size(), boosted, boosts, 256);
+    if (unrelated != 0) biasFailures++;
+    // Removing a word drops only what no other word shares
+    int nodesBefore = bias.liveNodes();
+    bias.remove(words[2].data(), (int)words[2].size());
+    bias.remove(words[2].data(), (int)words[2].size());   // a second removal is a no-op
+    std::vector<int32_t> prefix(words[0].begin(), words[0].end() - 1);
+    int kept = bias.collect(prefix.data(), (int)prefix.size(), boosted, boosts, 256);
+    if (std::find(boosted, boosted + kept, words[0].back()) == boosted + kept || bias.wordCount() != 3) biasFailures++;
+    // A phrase of any length comes out as cleanly as it went in
+    std::vector<int32_t> longPhrase;
+    while (longPhrase.size() < 200) longPhrase.insert(longPhrase.end(), words[1].begin(), words[1].end());
+    int nodesKept = bias.liveNodes();
+    bias.add(longPhrase.data(), (int)longPhrase.size());
+    bias.remove(longPhrase.data(), (int)longPhrase.size());
+    if (bias.liveNodes() != nodesKept || bias.wordCount() != 3) {
+        printf("bias: a %zu-token phrase was not removed\n", longPhrase.size());
+        biasFailures++;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int run = 0; run < benchRuns; run++) {
+        bias.collect(prefix.data(), (int)prefix.size(), boosted, boosts, 256);
+    }
+    double collectUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t1).count() / benchRuns;
+    printf("bias: %d words, %d -> %d nodes after a removal, %.2f us per step, %d mismatches\n",
+           bias.wordCount(), nodesBefore, bias.liveNodes(), collectUs, biasFailures);
+    failures += biasFailures;
+
+    // An identifier prompt like the one built from the open file
+    const std::string prompt = kCorpus[0] + std::string(" ") + kCorpus[1] + " interimText transcribeStreaming "
+            "VoiceRecorderService WhisperInference decodeGreedy melSpectrogram KvCachePingPong";
+    std::vector<int32_t> ids(prompt.size());
+    double coldUs = 0;
+    for (int run = 0; run < 20; run++) {
+        BpeEncoder cold(vocab.get());
+        auto t0 = std::chrono::steady_clock::now();
+        cold.encode(prompt.data(), prompt.size(), ids.data(), (int)ids.size());
+        coldUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    int n = 0;
+    for (int run = 0; run < benchRuns; run++) n = encoder.encode(prompt.data(), prompt.size(), ids.data(), (int)ids.size());
+    double warmUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / benchRuns;
+    printf("prompt: %zu bytes -> %d tokens, cold %.1f us, warm %.1f us\n", prompt.size(), n, coldUs / 20, warmUs);
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
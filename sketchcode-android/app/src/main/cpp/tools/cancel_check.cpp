@@ -0,0 +1,222 @@
+// Checks cooperative cancellation (cancellation.h) of the mel pipeline and of a
+// queued transcription.
+//
+//   whisper_cancel_check [-r repeats] [-s stepMs]
+//
+// The mel front end is the real one on 30 s of synthetic audio; the decoder stage is a
+// stand-in that sleeps stepMs per step and polls the token between steps, as the
+// decoder loops do. Checks that:
+//  - a cancel mid-spectrogram returns within a couple of frames (median of the repeats),
+//    with or without noise suppression,
+//  - a cancelled call frees everything it allocated (global operator new/delete count),
+//  - a reset token computes the same spectrogram as no token at all,
+//  - a job cancelled mid-decode stops within one step, completes once as cancelled,
+//    returns its slot, and the next job runs normally.
+// Exits non-zero on any failure.
+
+#include "cancellation.h"
+#include "mel_engine.h"
+#include "test_signals.h"
+#include "transcription_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// ---- Allocation accounting ----
+// Every operator new in the process goes through here; only the net byte count
+// matters, so sized and unsized deletes both read the size from a header.
+
+static std::atomic<long long> liveBytes{ 0 };
+
+static constexpr size_t HEADER = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+    auto* block = static_cast<unsigned char*>(malloc(size + HEADER));
+    if (block == nullptr) throw std::bad_alloc();
+    memcpy(block, &size, sizeof(size));
+    liveBytes += (long long)size;
+    return block + HEADER;
+}
+
+void operator delete(void* p) noexcept {
+    if (p == nullptr) return;
+    auto* block = static_cast<unsigned char*>(p) - HEADER;
+    size_t size;
+    memcpy(&size, block, sizeof(size));
+    liveBytes -= (long long)size;
+    free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+/** Median cancel-to-return latency of computeLogMelSpectrogram, cancelled at a third. */
+static double melCancelLatency(const std::vector<float>& audio, bool denoise, double fullMs, int repeats,
+                               float* out, int& leaks) {
+    std::vector<double> latencies;
+    for (int r = 0; r < repeats; r++) {
+        CancellationToken token;
+        MelOptions options;
+        options.suppressNoise = denoise;
+        options.cancel = &token;
+
+        long long before = liveBytes.load();
+        std::atomic<bool> returned{ false };
+        Clock::time_point returnedAt;
+        std::thread worker([&] {
+            computeLogMelSpectrogram(audio.data(), (int)audio.size(), options, out);
+            returnedAt = Clock::now();
+            returned = true;
+        });
+        std::this_thread::sleep_for(std::chrono::microseconds((long)(fullMs * 1000.0 / 3.0)));
+        Clock::time_point cancelledAt = Clock::now();
+        token.cancel();
+        worker.join();
+        if (!returned) continue;
+        // The thread object itself is freed by join; anything else is the pipeline's
+        if (liveBytes.load() != before) leaks++;
+        latencies.push_back(std::max(0.0, std::chrono::duration<double, std::milli>(returnedAt - cancelledAt).count()));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies.empty() ? 1e9 : latencies[latencies.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int repeats = 7, stepMs = 5;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-r") == 0) repeats = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "-s") == 0) stepMs = std::max(1, atoi(argv[i + 1]));
+    }
+    int failures = 0;
+
+    // ---- Mel frame loop ----
+    SyntheticSpeechOptions speech;
+    speech.pitchHz = 180.0;
+    speech.glideHz = 60.0;
+    speech.glideRateHz = 0.3;
+    speech.syllableRateHz = 4.0;
+    speech.seed = 12345;
+    std::vector<float> audio = syntheticSpeech(N_SAMPLES, speech);
+    std::vector<float> reference(N_MELS * N_FRAMES), mel(N_MELS * N_FRAMES);
+    for (bool denoise : { false, true }) {
+        MelOptions plain;
+        plain.suppressNoise = denoise;
+        computeLogMelSpectrogram(audio.data(), (int)audio.size(), plain, reference.data());   // warm-up
+        auto start = Clock::now();
+        computeLogMelSpectrogram(audio.data(), (int)audio.size(), plain, reference.data());
+        double fullMs = msSince(start);
+        double frameMs = fullMs / N_FRAMES;
+
+        CancellationToken early;
+        early.cancel();
+        MelOptions cancelled = plain;
+        cancelled.cancel = &early;
+        start = Clock::now();
+        computeLogMelSpectrogram(audio.data(), (int)audio.size(), cancelled, mel.data());
+        double earlyMs = msSince(start);
+
+        int leaks = 0;
+        double latency = melCancelLatency(audio, denoise, fullMs, repeats, mel.data(), leaks);
+        // Two frames plus slack: the thread has to notice, return and be timed, and the
+        // denoiser's whole-clip floor estimate (about a millisecond) runs unpolled
+        double bound = 2.0 * frameMs + 1.5;
+        printf("mel%s: %.1f ms full (%.1f us/frame), pre-cancelled %.2f ms, cancel latency %.3f ms (bound %.3f)\n",
+               denoise ? " (denoise)" : "", fullMs, frameMs * 1000.0, earlyMs, latency, bound);
+        if (latency > bound) {
+            fprintf(stderr, "FAIL: mel cancel took %.3f ms\n", latency);
+            failures++;
+        }
+        if (leaks) {
+            fprintf(stderr, "FAIL: %d cancelled mel runs left memory allocated\n", leaks);
+            failures++;
+        }
+
+        early.reset();
+        computeLogMelSpectrogram(audio.data(), (int)audio.size(), cancelled, mel.data());
+        if (memcmp(mel.data(), reference.data(), mel.size() * sizeof(float)) != 0) {
+            fprintf(stderr, "FAIL: reset token changed the spectrogram\n");
+            failures++;
+        }
+    }
+
+    // ---- Queued job cancelled mid-decode ----
+    // One token per job, as VoiceRecorderService keeps one per utterance
+    const int steps = 200;
+    CancellationToken tokens[2];
+    std::mutex mutex;
+    std::vector<std::pair<int64_t, int>> completions;
+    int stepsRun[2] = { 0, 0 };
+    std::atomic<bool> decoding{ false };
+    Clock::time_point stoppedAt;
+
+    TranscriptionQueueCallbacks callbacks;
+    callbacks.frontEnd = [&](int64_t job, int /* slot */) {
+        MelOptions options;
+        options.cancel = &tokens[job];
+        std::vector<float> out(N_MELS * N_FRAMES);
+        computeLogMelSpectrogram(audio.data(), (int)audio.size(), options, out.data());
+        return tokens[job].cancelled() ? JOB_CANCELLED : JOB_CONTINUE;
+    };
+    callbacks.decode = [&](int64_t job, int /* slot */) {
+        decoding = true;
+        for (int step = 0; step < steps; step++) {
+            if (tokens[job].cancelled()) {
+                stoppedAt = Clock::now();
+                return JOB_CANCELLED;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(stepMs));
+            stepsRun[job]++;
+        }
+        return JOB_DONE;
+    };
+    callbacks.complete = [&](int64_t job, int status) {
+        std::lock_guard<std::mutex> lock(mutex);
+        completions.emplace_back(job, status);
+    };
+
+    double decodeLatency;
+    int pendingAfter;
+    {
+        TranscriptionQueue queue(2, 1, callbacks);
+        queue.submit(0);
+        while (!decoding) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10 * stepMs));
+        Clock::time_point cancelledAt = Clock::now();
+        tokens[0].cancel();
+        queue.cancel(0);
+        // One slot: the second job only gets its front end once the cancelled one frees it
+        if (!queue.submit(1)) failures++;
+        while (queue.pending() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        decodeLatency = std::chrono::duration<double, std::milli>(stoppedAt - cancelledAt).count();
+        pendingAfter = queue.pending();
+    }
+    printf("decode: cancelled after %d of %d steps, stopped %.2f ms after cancel (step %d ms); next job ran %d steps\n",
+           stepsRun[0], steps, decodeLatency, stepMs, stepsRun[1]);
+    if (decodeLatency > stepMs + 2.0) {
+        fprintf(stderr, "FAIL: decode cancel took %.2f ms\n", decodeLatency);
+        failures++;
+    }
+    bool completedOnce = completions.size() == 2 && completions[0] == std::make_pair((int64_t)0, (int)JOB_CANCELLED)
+            && completions[1] == std::make_pair((int64_t)1, (int)JOB_DONE);
+    if (!completedOnce || stepsRun[1] != steps || pendingAfter != 0) {
+        fprintf(stderr, "FAIL: expected job 0 cancelled and job 1 done once each (%zu completions)\n",
+                completions.size());
+        failures++;
+    }
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
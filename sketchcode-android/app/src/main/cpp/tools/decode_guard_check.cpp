@@ -0,0 +1,172 @@
+// Replays fixed token streams through DecodeGuard (decode_guard.cpp).
+//
+//   whisper_decode_guard_check [recording.wav|recording.pcm ...]
+//
+// Each stream is fed token by token, as the decoder loops do, and checked for the step
+// the guard stops at, the stop reason and keepTokens():
+//  - a period-1 run (the same token over and over) after one real token,
+//  - a period-4 loop from the first token,
+//  - a period-3 loop that starts after real text (the text and one occurrence are kept),
+//  - a clean stream with short legitimate repeats, which must not trip,
+//  - a clean stream past the budget of a silent clip.
+// Then the budget reset() derives from speechSecondsFromMel(): the floor for a silent
+// mel, the duration estimate for a clip with 2 s of speech, and the maxTokens clamp.
+// Each 16 kHz recording given (real speech, with its pauses) must measure some speech
+// and no more than its length; its speech time and budget are printed.
+// Exits non-zero on any mismatch.
+
+#include "decode_guard.h"
+#include "mel_engine.h"
+#include "test_signals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Replay {
+    const char* name;
+    std::vector<int32_t> tokens;
+    float speechSeconds;
+    int stopAt;                 // index of the token that stops, -1 if none may
+    DecodeStopReason reason;
+    int keep;                   // keepTokens() at the stop
+};
+
+static const char* reasonName(DecodeStopReason reason) {
+    switch (reason) {
+        case DECODE_CONTINUE: return "continue";
+        case DECODE_STOP_REPETITION: return "repetition";
+        case DECODE_STOP_TOKEN_BUDGET: return "budget";
+        case DECODE_STOP_CANCELLED: return "cancelled";
+    }
+    return "?";
+}
+
+static std::vector<int32_t> cleanTokens(int count) {
+    // Distinct tokens with a few short repeats real text has ("a a", "x y x y")
+    std::vector<int32_t> tokens = { 50364, 400, 400, 281, 309, 281, 309, 11 };
+    for (int i = 0; (int)tokens.size() < count; i++) tokens.push_back(1000 + (i * 37) % 101);
+    tokens.resize(count);
+    return tokens;
+}
+
+static int replay(const Replay& r) {
+    DecodeGuard guard;
+    guard.reset(r.speechSeconds);
+    int stoppedAt = -1;
+    DecodeStopReason reason = DECODE_CONTINUE;
+    for (size_t i = 0; i < r.tokens.size(); i++) {
+        reason = guard.accept(r.tokens[i]);
+        if (reason != DECODE_CONTINUE) {
+            stoppedAt = (int)i;
+            break;
+        }
+    }
+    int failures = 0;
+    if (stoppedAt != r.stopAt || reason != r.reason) {
+        fprintf(stderr, "FAIL: %s: stopped at %d (%s), expected %d (%s)\n", r.name, stoppedAt,
+                reasonName(reason), r.stopAt, reasonName(r.reason));
+        failures++;
+    } else if (stoppedAt >= 0 && guard.keepTokens() != r.keep) {
+        fprintf(stderr, "FAIL: %s: keeps %d tokens, expected %d\n", r.name, guard.keepTokens(), r.keep);
+        failures++;
+    }
+    printf("%-32s %6d %-10s %5d\n", r.name, stoppedAt, reasonName(reason), stoppedAt >= 0 ? guard.keepTokens() : -1);
+    return failures;
+}
+
+static int expectBudget(const char* name, const DecodeGuardConfig& config, float speechSeconds, int expected) {
+    DecodeGuard guard(config);
+    guard.reset(speechSeconds);
+    printf("%-32s %6.2f s -> budget %d\n", name, speechSeconds, guard.budget());
+    if (guard.budget() != expected) {
+        fprintf(stderr, "FAIL: %s: budget %d, expected %d\n", name, guard.budget(), expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const DecodeGuardConfig defaults;
+    int failures = 0;
+
+    std::vector<Replay> replays;
+    // minRepeatsSingle (6) sevens: the sixth stops, keeping [50364, 7]
+    replays.push_back({ "period-1 run", { 50364, 7, 7, 7, 7, 7, 7, 7, 7 }, 30.0f, 6, DECODE_STOP_REPETITION, 2 });
+    // Three occurrences of a period-4 pattern stop on the twelfth token, keeping one
+    replays.push_back({ "period-4 loop", { 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1, 2 }, 30.0f, 11,
+                        DECODE_STOP_REPETITION, 4 });
+    // Five tokens of text, then three occurrences of a period-3 pattern
+    replays.push_back({ "loop after text", { 10, 11, 12, 13, 14, 20, 21, 22, 20, 21, 22, 20, 21, 22, 20 }, 30.0f, 13,
+                        DECODE_STOP_REPETITION, 8 });
+    // A budget of 10 * 8 + 10 = 90 tokens is never reached by 80 clean ones
+    replays.push_back({ "clean stream", cleanTokens(80), 10.0f, -1, DECODE_CONTINUE, 0 });
+    // Silence: only the slack, so the tenth token stops
+    replays.push_back({ "clean stream, silent clip", cleanTokens(40), 0.0f, defaults.budgetSlack - 1,
+                        DECODE_STOP_TOKEN_BUDGET, defaults.budgetSlack });
+
+    printf("%-32s %6s %-10s %5s\n", "stream", "stop", "reason", "keep");
+    for (const Replay& r : replays) failures += replay(r);
+
+    // Budgets from mels
+    std::vector<float> mel(N_MELS * N_FRAMES);
+    std::vector<float> silence(N_SAMPLES, 0.0f);
+    computeLogMelSpectrogram(silence.data(), (int)silence.size(), MelOptions(), mel.data());
+    float silentSeconds = speechSecondsFromMel(mel.data(), N_FRAMES, N_FRAMES);
+    if (silentSeconds != 0.0f) {
+        fprintf(stderr, "FAIL: silent mel has %.2f s of speech\n", silentSeconds);
+        failures++;
+    }
+    failures += expectBudget("silent mel", defaults, silentSeconds, defaults.budgetSlack);
+
+    // 5 s: silence, 2 s of a voiced tone, silence, over a faint noise floor
+    SyntheticSpeechOptions voiced;
+    voiced.noise = 0.001f;
+    voiced.pitchHz = 180.0;
+    voiced.glideHz = 0.0;
+    voiced.syllableRateHz = 0.0;
+    voiced.harmonics = 2;
+    voiced.voicedFrom = 1.5;
+    voiced.voicedTo = 3.5;
+    voiced.seed = 3;
+    std::vector<float> clip = syntheticSpeech(5 * SAMPLE_RATE, voiced);
+    computeLogMelSpectrogram(clip.data(), (int)clip.size(), MelOptions(), mel.data());
+    float speechSeconds = speechSecondsFromMel(mel.data(), N_FRAMES, N_FRAMES);
+    if (speechSeconds < 1.5f || speechSeconds > 2.5f) {
+        fprintf(stderr, "FAIL: clip with 2 s of speech measures %.2f s\n", speechSeconds);
+        failures++;
+    }
+    int estimate = (int)ceilf(speechSeconds * defaults.tokensPerSecond) + defaults.budgetSlack;
+    failures += expectBudget("speech mel", defaults, speechSeconds, std::min(estimate, defaults.maxTokens));
+
+    DecodeGuardConfig small;
+    small.maxTokens = 20;
+    failures += expectBudget("speech mel, maxTokens 20", small, speechSeconds, small.maxTokens);
+
+    for (int i = 1; i < argc; i++) {
+        std::vector<float> recording;
+        std::string error;
+        if (!loadRecording(argv[i], recording, error)) {
+            fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+            return 1;
+        }
+        // The first 30 s, as the encoder sees them
+        int samples = std::min((int)recording.size(), N_SAMPLES);
+        computeLogMelSpectrogram(recording.data(), samples, MelOptions(), mel.data());
+        float seconds = speechSecondsFromMel(mel.data(), N_FRAMES, N_FRAMES);
+        float length = (float)samples / SAMPLE_RATE;
+        DecodeGuard guard(defaults);
+        guard.reset(seconds);
+        printf("%-32s %6.2f s of %.2f s -> budget %d\n", argv[i], seconds, length, guard.budget());
+        if (seconds <= 0.0f || seconds > length + (float)HOP_LENGTH / SAMPLE_RATE) {
+            fprintf(stderr, "FAIL: %s: %.2f s of speech in %.2f s of audio\n", argv[i], seconds, length);
+            failures++;
+        }
+    }
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
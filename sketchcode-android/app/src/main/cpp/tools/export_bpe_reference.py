@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Tokenize the BPE check corpus with tiktoken, as the reference for whisper_bpe_check.
+
+    export_bpe_reference.py [vocab.json] [OUT_TSV]
+
+Builds a tiktoken Encoding from the app's tokenizer/vocab.json (token bytes -> id,
+which in Whisper's vocabulary is the merge rank) and Whisper's pre-tokenizer
+pattern, and writes one "text<TAB>id id id" line per corpus string, with \\, \\t,
+\\n and \\r escaped in the text. The result is checked in as
+tools/testdata/bpe_reference.tsv; whisper_bpe_check compares BpeEncoder against
+it token for token. The reference shares nothing with the native code: not the
+pre-tokenizer, not the merge loop, not the packed vocab.bin.
+Needs tiktoken.
+"""
+
+import json
+import os
+import sys
+
+import tiktoken
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_VOCAB = os.path.join(HERE, "..", "..", "tokenizer", "vocab.json")
+DEFAULT_OUT = os.path.join(HERE, "testdata", "bpe_reference.tsv")
+
+# Whisper's pattern (whisper/tokenizer.py, tiktoken's gpt2)
+PATTERN = r"""'s|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+"""
+
+# kCorpus in bpe_check.cpp comes first; the check requires a line for each of them
+CORPUS = [
+    "getUserById fetchRecords parseJsonResponse HttpClient onCreateView",
+    "snake_case_name MAX_BUFFER_SIZE __init__ self.assertEqual(x, 42)",
+    "val interimText = state.copy(interimText = \"\")",
+    "for (int i = 0; i < n; i++) { total += values[i]; }",
+    "It's what they'll say, isn't it? We've been here before; I'd go.",
+    "  leading spaces,\ttabs\tand\n\nnewlines   trailing   ",
+    "numbers 3.14159 and 1,000,000 and v2alpha3",
+    "naïve café résumé — 東京 über straße",
+    "emoji 🎤 done!!! ???",
+    "",
+    # Code as it is dictated and as it appears in prompts
+    "fun onAudio(buffer: FloatArray) { if (!_state.value.isRecording) return }",
+    "#include <vector>\nint main() { return 0; }",
+    "x->next = nullptr; a[i] += b[j] * 2.5f; // TODO(user): fix",
+    "def __repr__(self): return f\"<Node {self.id!r}>\"",
+    "SELECT id, name FROM users WHERE age >= 18 ORDER BY name;",
+    "https://example.com/path?query=1&other=two#anchor",
+    "camelCaseHTTPServer XMLHttpRequest iOS10 utf8ToUtf16",
+    # Apostrophes and contractions in and out of words
+    "don't won't y'all rock'n'roll 'quoted' ''double'' O'Neil's",
+    "THEY'RE WE'VE I'M YOU'LL HE'D IT'S",
+    "x's 3's !!'s 's 'd",
+    # Whitespace runs before every kind of piece
+    "a  b   c\t\td \n e\r\nf",
+    "  'tis   42   !!  ",
+    "\n\n\n",
+    " ",
+    # Unicode letters, numbers, marks, punctuation and spaces
+    "Ελληνικά русский язык עברית العربية हिन्दी",
+    "日本語のテキスト、句読点。한국어 텍스트",
+    "Arabic-Indic ٣٤٥ Devanagari ४२ Roman Ⅻ fractions ½ ¾ superscript x² subscript H₂O",
+    "combining e\u0301 n\u0303 a\u030a vs precomposed é ñ å",
+    "no\u00a0break\u00a0space ideographic\u3000space thin\u2009space",
+    "quotes «guillemets» „low“ ‘single’ “double” … ellipsis – en — em",
+    "symbols © ® ™ € £ ¥ ° ± × ÷ → ⇒ ∀ ∑ √ ∞",
+    "emoji 👍🏽 👨‍👩‍👧 🇯🇵 ❤️ zero\u200bwidth",
+    "mixed café123 123café 東京2024 ２０２４年",
+    "it’s the user’s file — don’t say “word—next” 1½ x²2 café…",
+]
+
+
+def byte_decoder():
+    # GPT-2's bytes_to_unicode(), inverted
+    printable = (list(range(ord("!"), ord("~") + 1)) + list(range(0xA1, 0xAC + 1))
+                 + list(range(0xAE, 0xFF + 1)))
+    chars, shifted = {}, 0
+    for b in range(256):
+        if b in printable:
+            chars[chr(b)] = b
+        else:
+            chars[chr(256 + shifted)] = b
+            shifted += 1
+    return chars
+
+
+def escape(text):
+    return text.replace("\\", "\\\\").replace("\t", "\\t").replace("\n", "\\n").replace("\r", "\\r")
+
+
+def main():
+    vocab_path = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_VOCAB
+    out_path = sys.argv[2] if len(sys.argv) > 2 else DEFAULT_OUT
+    decoder = byte_decoder()
+    with open(vocab_path, encoding="utf-8") as f:
+        vocab = json.load(f)
+    ranks = {bytes(decoder[c] for c in text): rank for text, rank in vocab.items() if text}
+    encoding = tiktoken.Encoding("whisper_vocab", pat_str=PATTERN, mergeable_ranks=ranks, special_tokens={})
+
+    os.makedirs(os.path.dirname(out_path), exist_ok=True)
+    with open(out_path, "w", encoding="utf-8", newline="\n") as f:
+        for text in CORPUS:
+            ids = encoding.encode_ordinary(text)
+            assert encoding.decode_bytes(ids) == text.encode("utf-8"), text
+            f.write(escape(text) + "\t" + " ".join(map(str, ids)) + "\n")
+    print(f"{out_path}: {len(CORPUS)} lines, tiktoken {tiktoken.__version__}, {len(ranks)} ranks")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""Export a tiny fixed-shape decoder for the native decoder loop, with a greedy reference.
+
+    export_test_decoder.py OUT_DIR [--layers 2] [--vocab 64] [--dim 16] [--window 16]
+                           [--cross 6] [--prompt 4] [--tokens 24] [--seed 1]
+
+Writes into OUT_DIR:
+  decoder.onnx   same input/output names, dtypes and cache layout as the Whisper
+                 decoder export the app runs (k/v_cache_self_<i>_in/_out sliding
+                 windows, k/v_cache_cross_<i>, fp16 attention_mask and logits), with
+                 random weights, `layers` single-head layers and a `vocab`-token vocabulary
+  cross.bin      fp16 cross-attention caches: every layer's K, then every layer's V
+  reference.txt  "prompt ..." and "tokens ...": the greedy decode of the prompt,
+                 run step by step through onnxruntime's plain Session.run, feeding the
+                 cache outputs back as inputs (what the Kotlin loop does)
+
+Check the native loop against it with
+    whisper_native_decode OUT_DIR/decoder.onnx --check OUT_DIR
+
+Weights are redrawn (seed + 1, ...) until every greedy step wins by at least
+MIN_MARGIN, so fp16 rounding differences between runtimes cannot flip a token.
+Needs numpy, onnx and onnxruntime.
+"""
+
+import argparse
+import os
+import sys
+
+import numpy as np
+import onnx
+import onnxruntime as ort
+from onnx import TensorProto, helper, numpy_helper
+
+MASK_NEG = -100.0          # MASK_NEG_FP16 in native_decoder.cpp
+MAX_POSITIONS = 256
+MIN_MARGIN = 0.05
+MAX_SEEDS = 50
+
+
+def build_model(args, rng):
+    L, D, C, V = args.window, args.dim, args.cross, args.vocab
+    nodes, inits = [], []
+
+    def const(name, array):
+        inits.append(numpy_helper.from_array(np.asarray(array), name))
+        return name
+
+    def node(op, inputs, output, **attrs):
+        nodes.append(helper.make_node(op, inputs, [output], name=output, **attrs))
+        return output
+
+    def weight(name, rows, cols, scale):
+        return const(name, (rng.standard_normal((rows, cols)) * scale).astype(np.float32))
+
+    def as_float(name, shape):
+        cast = node("Cast", [name], name + "_f32", to=TensorProto.FLOAT)
+        return node("Reshape", [cast, const(name + "_shape", np.array(shape, np.int64))], name + "_2d")
+
+    inputs = [
+        helper.make_tensor_value_info("input_ids", TensorProto.INT32, [1, 1]),
+        helper.make_tensor_value_info("attention_mask", TensorProto.FLOAT16, [1, 1, 1, L]),
+        helper.make_tensor_value_info("position_ids", TensorProto.INT32, [1]),
+    ]
+    outputs = [helper.make_tensor_value_info("logits", TensorProto.FLOAT16, [1, 1, V])]
+
+    embed = weight("embed", V, D, 1.0)
+    positions = weight("positions", MAX_POSITIONS, D, 0.3)
+    tok = node("Gather", [embed, "input_ids"], "tok_embed")
+    tok = node("Reshape", [tok, const("row_shape", np.array([1, D], np.int64))], "tok_row")
+    pos = node("Gather", [positions, "position_ids"], "pos_row")
+    x = node("Add", [tok, pos], "x0")
+    mask = as_float("attention_mask", [1, L])
+    scale = const("scale", np.array(1.0 / np.sqrt(D), np.float32))
+
+    def attend(prefix, query, keys, values, extra_mask):
+        scores = node("MatMul", [query, keys], prefix + "_scores")
+        scores = node("Mul", [scores, scale], prefix + "_scaled")
+        if extra_mask is not None:
+            scores = node("Add", [scores, extra_mask], prefix + "_masked")
+        probs = node("Softmax", [scores], prefix + "_probs", axis=-1)
+        return node("MatMul", [probs, values], prefix + "_context")
+
+    for i in range(args.layers):
+        p = f"l{i}"
+        inputs += [
+            helper.make_tensor_value_info(f"k_cache_self_{i}_in", TensorProto.FLOAT16, [1, 1, D, L - 1]),
+            helper.make_tensor_value_info(f"v_cache_self_{i}_in", TensorProto.FLOAT16, [1, 1, L - 1, D]),
+            helper.make_tensor_value_info(f"k_cache_cross_{i}", TensorProto.FLOAT16, [1, 1, D, C]),
+            helper.make_tensor_value_info(f"v_cache_cross_{i}", TensorProto.FLOAT16, [1, 1, C, D]),
+        ]
+        outputs += [
+            helper.make_tensor_value_info(f"k_cache_self_{i}_out", TensorProto.FLOAT16, [1, 1, D, L - 1]),
+            helper.make_tensor_value_info(f"v_cache_self_{i}_out", TensorProto.FLOAT16, [1, 1, L - 1, D]),
+        ]
+        k_in = as_float(f"k_cache_self_{i}_in", [D, L - 1])
+        v_in = as_float(f"v_cache_self_{i}_in", [L - 1, D])
+        k_cross = as_float(f"k_cache_cross_{i}", [D, C])
+        v_cross = as_float(f"v_cache_cross_{i}", [C, D])
+
+        # Self-attention over the window: the new key/value enter on the right
+        q = node("MatMul", [x, weight(p + "_wq", D, D, 0.5)], p + "_q")
+        k = node("MatMul", [x, weight(p + "_wk", D, D, 0.5)], p + "_k")
+        v = node("MatMul", [x, weight(p + "_wv", D, D, 0.5)], p + "_v")
+        k_col = node("Transpose", [k], p + "_k_col", perm=[1, 0])
+        keys = node("Concat", [k_in, k_col], p + "_keys", axis=1)
+        values = node("Concat", [v_in, v], p + "_values", axis=0)
+        context = attend(p + "_self", q, keys, values, mask)
+        x = node("Add", [x, node("MatMul", [context, weight(p + "_wo", D, D, 0.5)], p + "_self_out")], p + "_x1")
+
+        # Cross-attention
+        cq = node("MatMul", [x, weight(p + "_wcq", D, D, 0.5)], p + "_cq")
+        context = attend(p + "_cross", cq, k_cross, v_cross, None)
+        x = node("Add", [x, node("MatMul", [context, weight(p + "_wco", D, D, 0.5)], p + "_cross_out")], p + "_x2")
+
+        # MLP
+        hidden = node("Tanh", [node("MatMul", [x, weight(p + "_w1", D, 2 * D, 0.5)], p + "_h")], p + "_act")
+        x = node("Add", [x, node("MatMul", [hidden, weight(p + "_w2", 2 * D, D, 0.5)], p + "_mlp")], p + "_x3")
+
+        # The window slides: the oldest position falls out
+        one = const(p + "_one", np.array([1], np.int64))
+        k_next = node("Slice", [keys, one, const(p + "_kend", np.array([L], np.int64)), one], p + "_k_next")
+        v_next = node("Slice", [values, one, const(p + "_vend", np.array([L], np.int64)),
+                                const(p + "_zero", np.array([0], np.int64))], p + "_v_next")
+        for src, out, shape in ((k_next, f"k_cache_self_{i}_out", [1, 1, D, L - 1]),
+                                (v_next, f"v_cache_self_{i}_out", [1, 1, L - 1, D])):
+            shaped = node("Reshape", [src, const(out + "_shape", np.array(shape, np.int64))], out + "_f32")
+            nodes.append(helper.make_node("Cast", [shaped], [out], name=out, to=TensorProto.FLOAT16))
+
+    logits = node("MatMul", [x, weight("unembed", D, V, 1.0)], "logits_2d")
+    logits = node("Reshape", [logits, const("logits_shape", np.array([1, 1, V], np.int64))], "logits_f32")
+    nodes.append(helper.make_node("Cast", [logits], ["logits"], name="logits", to=TensorProto.FLOAT16))
+
+    graph = helper.make_graph(nodes, "tiny_whisper_decoder", inputs, outputs, inits)
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 17)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    return model
+
+
+def masks(L):
+    # Mask n unmasks the n + 1 rightmost positions, as DecoderInputPool lays them out
+    out = np.full((L, 1, 1, 1, L), MASK_NEG, np.float16)
+    for n in range(L):
+        out[n, ..., L - 1 - n:] = 0.0
+    return out
+
+
+def greedy(session, args, cross_k, cross_v, prompt):
+    L, D = args.window, args.dim
+    mask_table = masks(L)
+    k_self = [np.zeros((1, 1, D, L - 1), np.float16) for _ in range(args.layers)]
+    v_self = [np.zeros((1, 1, L - 1, D), np.float16) for _ in range(args.layers)]
+    tokens, sampled, margin = list(prompt), [], float("inf")
+    step = 0
+    while len(sampled) < args.tokens:
+        feeds = {
+            "input_ids": np.array([[tokens[step]]], np.int32),
+            "position_ids": np.array([step], np.int32),
+            "attention_mask": mask_table[min(step, L - 1)],
+        }
+        for i in range(args.layers):
+            feeds[f"k_cache_self_{i}_in"] = k_self[i]
+            feeds[f"v_cache_self_{i}_in"] = v_self[i]
+            feeds[f"k_cache_cross_{i}"] = cross_k[i]
+            feeds[f"v_cache_cross_{i}"] = cross_v[i]
+        names = ["logits"] + [f"{kv}_cache_self_{i}_out" for i in range(args.layers) for kv in ("k", "v")]
+        results = dict(zip(names, session.run(names, feeds)))
+        for i in range(args.layers):
+            k_self[i] = results[f"k_cache_self_{i}_out"]
+            v_self[i] = results[f"v_cache_self_{i}_out"]
+        if step >= len(prompt) - 1:
+            logits = results["logits"].astype(np.float32).reshape(-1)
+            top2 = np.sort(logits)[-2:]
+            margin = min(margin, float(top2[1] - top2[0]))
+            token = int(np.argmax(logits))
+            tokens.append(token)
+            sampled.append(token)
+        step += 1
+    return sampled, margin
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("out_dir")
+    parser.add_argument("--layers", type=int, default=2)
+    parser.add_argument("--vocab", type=int, default=64)
+    parser.add_argument("--dim", type=int, default=16)
+    parser.add_argument("--window", type=int, default=16, help="attention_mask length (self cache + 1)")
+    parser.add_argument("--cross", type=int, default=6, help="encoder positions")
+    parser.add_argument("--prompt", type=int, default=4)
+    parser.add_argument("--tokens", type=int, default=24, help="greedy tokens in the reference")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if args.prompt + args.tokens > MAX_POSITIONS:
+        sys.exit(f"prompt + tokens must stay within {MAX_POSITIONS} positions")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for seed in range(args.seed, args.seed + MAX_SEEDS):
+        rng = np.random.default_rng(seed)
+        model = build_model(args, rng)
+        cross_k = [(rng.standard_normal((1, 1, args.dim, args.cross)) * 0.5).astype(np.float16)
+                   for _ in range(args.layers)]
+        cross_v = [(rng.standard_normal((1, 1, args.cross, args.dim)) * 0.5).astype(np.float16)
+                   for _ in range(args.layers)]
+        prompt = [int(t) for t in rng.integers(0, args.vocab, args.prompt)]
+        session = ort.InferenceSession(model.SerializeToString(), providers=["CPUExecutionProvider"])
+        tokens, margin = greedy(session, args, cross_k, cross_v, prompt)
+        if margin >= MIN_MARGIN:
+            break
+        print(f"seed {seed}: greedy margin {margin:.4f} below {MIN_MARGIN}, redrawing", file=sys.stderr)
+    else:
+        sys.exit(f"no seed in {MAX_SEEDS} gave a greedy margin of {MIN_MARGIN}")
+
+    onnx.save(model, os.path.join(args.out_dir, "decoder.onnx"))
+    with open(os.path.join(args.out_dir, "cross.bin"), "wb") as f:
+        for cache in cross_k + cross_v:
+            f.write(cache.tobytes())
+    with open(os.path.join(args.out_dir, "reference.txt"), "w") as f:
+        f.write("prompt " + " ".join(map(str, prompt)) + "\n")
+        f.write("tokens " + " ".join(map(str, tokens)) + "\n")
+    print(f"seed {seed}: {args.layers} layers, vocab {args.vocab}, window {args.window}, "
+          f"greedy margin {margin:.3f}")
+    print("prompt", *prompt)
+    print("tokens", *tokens)
+
+
+if __name__ == "__main__":
+    main()
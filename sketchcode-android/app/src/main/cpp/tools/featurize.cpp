@@ -0,0 +1,160 @@
+// Batch log-mel featurization for offline evaluation.
+//
+//   whisper_mel_featurize [-j threads] [--denoise] -o OUT_DIR INPUT...
+//
+// INPUT may be .wav / .pcm files or directories (searched recursively). Each clip
+// is memory-mapped, run through the production mel engine (stereo WAVs go through
+// the beamformer first, exactly like the stereo JNI path) and written as a float32
+// [128, 3000] .npy file, mirroring the input directory layout under OUT_DIR.
+
+#include "audio_file.h"
+#include "beamformer.h"
+#include "mel_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Job {
+    fs::path input;
+    fs::path output;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [-j threads] [--denoise] -o OUT_DIR INPUT...\n", argv0);
+}
+
+static bool isAudioFile(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return ext == ".wav" || ext == ".pcm";
+}
+
+static void collectJobs(const fs::path& input, const fs::path& outDir, std::vector<Job>& jobs) {
+    if (fs::is_directory(input)) {
+        for (const auto& entry : fs::recursive_directory_iterator(input)) {
+            if (!entry.is_regular_file() || !isAudioFile(entry.path())) continue;
+            fs::path rel = fs::relative(entry.path(), input);
+            jobs.push_back({ entry.path(), (outDir / rel).replace_extension(".npy") });
+        }
+    } else {
+        jobs.push_back({ input, (outDir / input.filename()).replace_extension(".npy") });
+    }
+}
+
+int main(int argc, char** argv) {
+    int threads = (int)std::thread::hardware_concurrency();
+    MelOptions options;
+    fs::path outDir;
+    std::vector<fs::path> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        } else if (strcmp(argv[i], "--denoise") == 0) {
+            options.suppressNoise = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (outDir.empty() || inputs.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    threads = std::max(threads, 1);
+
+    std::vector<Job> jobs;
+    for (const auto& input : inputs) {
+        collectJobs(input, outDir, jobs);
+    }
+    if (jobs.empty()) {
+        fprintf(stderr, "no .wav/.pcm inputs found\n");
+        return 1;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> failures{0};
+    std::mutex statsLock;
+    double audioSeconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]() {
+        MappedAudioFile file;
+        std::vector<float> samples, mono;
+        std::vector<float> melSpec(N_MELS * N_FRAMES);
+
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const Job& job = jobs[i];
+            if (!file.open(job.input.string())) {
+                fprintf(stderr, "%s: %s\n", job.input.c_str(), file.error().c_str());
+                failures++;
+                continue;
+            }
+            if (file.sampleRate() != SAMPLE_RATE || file.channels() > 2) {
+                fprintf(stderr, "%s: need %d Hz mono/stereo, got %d Hz x%d\n",
+                        job.input.c_str(), SAMPLE_RATE, file.sampleRate(), file.channels());
+                failures++;
+                continue;
+            }
+
+            // The engine only reads the first 30 s: float WAVs are used from the mapping,
+            // PCM16 converts just that much
+            int numFrames = (int)std::min(file.numFrames(), (size_t)N_SAMPLES);
+            const float* audio = file.floatSamples();
+            if (audio == nullptr) {
+                file.toFloat(samples, numFrames);
+                audio = samples.data();
+            }
+            if (file.channels() == 2) {
+                beamformStereo(audio, numFrames, mono);
+                audio = mono.data();
+            }
+            computeLogMelSpectrogram(audio, numFrames, options, melSpec.data());
+
+            std::error_code ec;
+            fs::create_directories(job.output.parent_path(), ec);
+            if (!writeNpy(job.output.string(), melSpec.data(), { (size_t)N_MELS, (size_t)N_FRAMES })) {
+                fprintf(stderr, "%s: failed to write %s\n", job.input.c_str(), job.output.c_str());
+                failures++;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(statsLock);
+            // The engine only ever consumes the first 30 s of a clip
+            audioSeconds += std::min(file.durationSeconds(), (double)CHUNK_LENGTH);
+        }
+    };
+
+    int nWorkers = std::min<int>(threads, (int)jobs.size());
+    std::vector<std::thread> pool;
+    for (int t = 0; t < nWorkers; t++) {
+        pool.emplace_back(worker);
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int done = (int)jobs.size() - failures.load();
+    printf("featurized %d/%zu clips with %d threads in %.3f s\n", done, jobs.size(), nWorkers, wall);
+    printf("audio: %.3f h, throughput: %.4f audio-hours/s (%.1fx realtime)\n",
+           audioSeconds / 3600.0, audioSeconds / 3600.0 / wall, audioSeconds / wall);
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Checks the bulk fp16 conversions (fp16_convert.cpp) against the scalar reference.
+//
+//   whisper_fp16_check [-n benchRuns]
+//
+// Exhaustive over all 65,536 fp16 bit patterns: widening matches fp16ToFloat, and
+// narrowing the widened value gives the original bits back. Narrowing is also checked
+// at every rounding boundary (each midpoint between adjacent fp16 values and the fp32
+// neighbours on either side) and across the overflow / subnormal edges. Then times
+// one mel-sized conversion (128 x 3000) each way. Exits non-zero on any mismatch.
+
+#include "fp16.h"
+#include "fp16_convert.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static bool isNanFp16(uint16_t h) { return (h & 0x7C00) == 0x7C00 && (h & 0x3FF) != 0; }
+
+static uint32_t bitsOf(float f) {
+    uint32_t b;
+    memcpy(&b, &f, sizeof(b));
+    return b;
+}
+
+static float fromBits(uint32_t b) {
+    float f;
+    memcpy(&f, &b, sizeof(f));
+    return f;
+}
+
+int main(int argc, char** argv) {
+    int benchRuns = 50;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) benchRuns = atoi(argv[++i]);
+    }
+    printf("backend: %s\n", fp16ConvertBackend());
+    int failures = 0;
+
+    // Exhaustive widen + round trip (an odd length also exercises the scalar tail)
+    std::vector<uint16_t> all(65536 + 3);
+    for (size_t i = 0; i < all.size(); i++) all[i] = (uint16_t)i;
+    std::vector<float> widened(all.size());
+    std::vector<uint16_t> narrowed(all.size());
+    fp16ToFloatArray(all.data(), widened.data(), all.size());
+    floatToFp16Array(widened.data(), narrowed.data(), all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        uint16_t h = all[i];
+        float ref = fp16ToFloat(h);
+        if (isNanFp16(h)) {
+            if (!std::isnan(widened[i]) || !isNanFp16(narrowed[i])) {
+                if (failures++ < 10) printf("NaN 0x%04x: widened %08x, narrowed 0x%04x\n", h, bitsOf(widened[i]), narrowed[i]);
+            }
+            continue;
+        }
+        if (bitsOf(widened[i]) != bitsOf(ref) || narrowed[i] != h) {
+            if (failures++ < 10) {
+                printf("0x%04x: widened %08x (want %08x), round trip 0x%04x\n", h, bitsOf(widened[i]), bitsOf(ref), narrowed[i]);
+            }
+        }
+    }
+    printf("round trip: 65536 values checked\n");
+
+    // Narrowing at every rounding boundary: the exact midpoint between each pair of
+    // adjacent finite fp16 values (ties to even) and one fp32 ulp either side of it
+    std::vector<float> probes;
+    for (uint32_t h = 0; h < 0x7C00; h++) {
+        float lo = fp16ToFloat((uint16_t)h);
+        float hi = h + 1 < 0x7C00 ? fp16ToFloat((uint16_t)(h + 1)) : 65520.0f;  // 65520 rounds to inf
+        float mid = (lo + hi) * 0.5f;
+        for (float v : { mid, std::nextafter(mid, 0.0f), std::nextafter(mid, INFINITY), lo }) {
+            probes.push_back(v);
+            probes.push_back(-v);
+        }
+    }
+    for (float v : { 65504.0f, 65519.99f, 65520.0f, 1e6f, 1e-10f, 5.9604645e-8f, 2.9802322e-8f, 2.9802326e-8f,
+                     6.1035156e-5f, INFINITY, -INFINITY, 0.0f, -0.0f, fromBits(0x7F800001), fromBits(0x7FC00000) }) {
+        probes.push_back(v);
+    }
+    std::vector<uint16_t> out(probes.size());
+    floatToFp16Array(probes.data(), out.data(), probes.size());
+    for (size_t i = 0; i < probes.size(); i++) {
+        uint16_t ref = floatToFp16(probes[i]);
+        bool ok = std::isnan(probes[i]) ? isNanFp16(out[i]) : out[i] == ref;
+        if (!ok && failures++ < 20) printf("narrow %.9g (%08x): 0x%04x, want 0x%04x\n", probes[i], bitsOf(probes[i]), out[i], ref);
+    }
+    printf("narrowing: %zu boundary values checked\n", probes.size());
+
+    // Throughput on one mel spectrogram
+    constexpr size_t MEL = 128 * 3000;
+    std::vector<float> mel(MEL), back(MEL);
+    std::vector<uint16_t> melFp16(MEL);
+    for (size_t i = 0; i < MEL; i++) mel[i] = sinf((float)i * 0.001f) * 1.5f;
+    auto time = [&](auto&& body) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < benchRuns; r++) body();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / benchRuns;
+    };
+    double narrowUs = time([&] { floatToFp16Array(mel.data(), melFp16.data(), MEL); });
+    double widenUs = time([&] { fp16ToFloatArray(melFp16.data(), back.data(), MEL); });
+    double scalarUs = time([&] { for (size_t i = 0; i < MEL; i++) melFp16[i] = floatToFp16(mel[i]); });
+    printf("mel (%zu values): narrow %.0f us (scalar %.0f us), widen %.0f us\n", MEL, narrowUs, scalarUs, widenUs);
+
+    printf("%s: %d mismatches\n", failures ? "FAIL" : "OK", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+// Runs the native decoder loop (native_decoder.cpp) on the host with the CPU provider.
+//
+//   whisper_native_decode decoder.onnx [-n runs] [-t temperature] [-m maxTokens] [-c cancelMs]
+//   whisper_native_decode decoder.onnx --check DIR
+//
+// Any fixed-shape export with the Whisper decoder's input/output names works: the
+// real decoder in its ONNX (non-QNN) form, or a small test model with fewer layers
+// and a tiny vocabulary. Cross-attention caches are filled with random fp16 values,
+// since the point is the loop itself: bindings, ping-pong caches and per-step cost.
+// With -c, one more run is cancelled from another thread after cancelMs; it must stop
+// within one decoder step.
+//
+// With --check, DIR holds what tools/export_test_decoder.py writes next to the test
+// model: the cross-attention caches (cross.bin) and the greedy decode of a prompt
+// that onnxruntime's plain Session.run gives (reference.txt). Checks that:
+//  - greedy decodes give the reference tokens, twice in a row (the ping-pong caches
+//    and the clamped attention mask past the window carry no state between runs),
+//  - with a reference token as EOT, the decode stops right before its first occurrence,
+//  - with a DecodeGuard, it stops where the same guard replaying the reference stops,
+//    keeping keepTokens() tokens, for the repetition and the token budget stops.
+// Exits non-zero on any mismatch.
+
+#include "cancellation.h"
+#include "decode_guard.h"
+#include "decode_scorer.h"
+#include "fp16.h"
+#include "logit_processor.h"
+#include "native_decoder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// reference.txt: a "prompt" line and a "tokens" line of space-separated token ids
+static bool readReference(const std::string& path, std::vector<int32_t>& prompt, std::vector<int32_t>& expected) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        std::vector<int32_t>* target = key == "prompt" ? &prompt : key == "tokens" ? &expected : nullptr;
+        if (target == nullptr) continue;
+        for (int32_t token; fields >> token;) target->push_back(token);
+    }
+    return !prompt.empty() && !expected.empty();
+}
+
+// Runs one greedy decode of the test model and compares it with the expected outcome
+static int checkDecode(NativeDecoder& decoder, const char* name, const std::vector<const uint16_t*>& crossK,
+                       const std::vector<const uint16_t*>& crossV, const std::vector<int32_t>& prompt, int eot,
+                       DecodeGuard* guard, int maxTokens, const std::vector<int32_t>& expected, int expectedReason) {
+    DecodeScorerConfig scorerConfig;
+    scorerConfig.vocabSize = decoder.vocabSize();
+    scorerConfig.noSpeechToken = 0;
+    DecodeScorer scorer(scorerConfig);
+    NativeDecodeParams params;
+    params.prompt = prompt.data();
+    params.promptLength = (int)prompt.size();
+    params.eot = eot;
+    params.timestampBegin = decoder.vocabSize();
+    params.guard = guard;
+    params.scorer = &scorer;
+    std::vector<int32_t> tokens(maxTokens);
+    NativeDecodeResult result = decoder.decode(crossK.data(), crossV.data(), params, tokens.data(), maxTokens);
+    tokens.resize(result.numTokens);
+
+    printf("%-24s %6d %6d %6d\n", name, result.numTokens, result.steps, result.stopReason);
+    if (tokens != expected || result.stopReason != expectedReason) {
+        fprintf(stderr, "FAIL: %s: %d tokens (stop %d), expected %zu (stop %d)\n  got     ", name,
+                result.numTokens, result.stopReason, expected.size(), expectedReason);
+        for (int32_t t : tokens) fprintf(stderr, "%d ", t);
+        fprintf(stderr, "\n  expected ");
+        for (int32_t t : expected) fprintf(stderr, "%d ", t);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    return 0;
+}
+
+// The guard stops the native loop where it stops a replay of the reference
+static int checkGuard(NativeDecoder& decoder, const char* name, float speechSeconds,
+                      const std::vector<const uint16_t*>& crossK, const std::vector<const uint16_t*>& crossV,
+                      const std::vector<int32_t>& prompt, const std::vector<int32_t>& reference) {
+    DecodeGuard replay;
+    replay.reset(speechSeconds);
+    int reason = DECODE_CONTINUE;
+    size_t keep = reference.size();
+    for (int32_t token : reference) {
+        reason = replay.accept(token);
+        if (reason != DECODE_CONTINUE) {
+            keep = (size_t)replay.keepTokens();
+            break;
+        }
+    }
+    DecodeGuard guard;
+    guard.reset(speechSeconds);
+    std::vector<int32_t> expected(reference.begin(), reference.begin() + keep);
+    return checkDecode(decoder, name, crossK, crossV, prompt, -1, &guard, (int)reference.size(), expected, reason);
+}
+
+static int runCheck(NativeDecoder& decoder, const std::string& dir) {
+    std::vector<int32_t> prompt, reference;
+    if (!readReference(dir + "/reference.txt", prompt, reference)) {
+        fprintf(stderr, "cannot read %s/reference.txt\n", dir.c_str());
+        return 2;
+    }
+    // cross.bin: every layer's K cache, then every layer's V cache
+    int layers = decoder.numLayers();
+    std::vector<uint16_t> cross(2 * (size_t)layers * decoder.crossElements());
+    std::ifstream in(dir + "/cross.bin", std::ios::binary);
+    in.read(reinterpret_cast<char*>(cross.data()), (std::streamsize)(cross.size() * sizeof(uint16_t)));
+    if (!in || in.peek() != EOF) {
+        fprintf(stderr, "%s/cross.bin does not hold %zu fp16 values for %d layers\n", dir.c_str(), cross.size(), layers);
+        return 2;
+    }
+    std::vector<const uint16_t*> crossK, crossV;
+    for (int layer = 0; layer < layers; layer++) {
+        crossK.push_back(cross.data() + (size_t)layer * decoder.crossElements());
+        crossV.push_back(cross.data() + (size_t)(layers + layer) * decoder.crossElements());
+    }
+
+    int failures = 0;
+    const int maxTokens = (int)reference.size();
+    printf("%-24s %6s %6s %6s\n", "decode", "tokens", "steps", "stop");
+    failures += checkDecode(decoder, "greedy", crossK, crossV, prompt, -1, nullptr, maxTokens, reference, 0);
+    failures += checkDecode(decoder, "greedy, second run", crossK, crossV, prompt, -1, nullptr, maxTokens, reference, 0);
+
+    // EOT: the last reference token that does not occur before its index
+    size_t eotIndex = 0;
+    for (size_t i = 1; i < reference.size(); i++) {
+        if (std::find(reference.begin(), reference.begin() + i, reference[i]) == reference.begin() + i) eotIndex = i;
+    }
+    if (eotIndex > 0) {
+        std::vector<int32_t> expected(reference.begin(), reference.begin() + eotIndex);
+        failures += checkDecode(decoder, "eot", crossK, crossV, prompt, reference[eotIndex], nullptr, maxTokens,
+                                expected, 0);
+    }
+
+    // Plenty of speech: only a repetition in the reference can stop it; silence: the budget
+    failures += checkGuard(decoder, "guard, 30 s of speech", 30.0f, crossK, crossV, prompt, reference);
+    failures += checkGuard(decoder, "guard, silence", 0.0f, crossK, crossV, prompt, reference);
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s decoder.onnx [-n runs] [-t temperature] [-m maxTokens] [-c cancelMs]\n"
+                        "       %s decoder.onnx --check DIR\n", argv[0], argv[0]);
+        return 2;
+    }
+    int runs = 3;
+    float temperature = 0.0f;
+    int maxTokens = 200;
+    int cancelMs = -1;
+    const char* checkDir = nullptr;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) temperature = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) maxTokens = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) cancelMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) checkDir = argv[++i];
+    }
+
+    NativeDecoderOptions options;
+    options.modelPath = argv[1];
+    auto decoder = NativeDecoder::create(options);
+    if (!decoder) return 1;
+    if (checkDir) return runCheck(*decoder, checkDir);
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> dist(0.0f, 0.5f);
+    std::vector<std::vector<uint16_t>> cross(2 * decoder->numLayers(), std::vector<uint16_t>(decoder->crossElements()));
+    std::vector<const uint16_t*> crossK, crossV;
+    for (int layer = 0; layer < decoder->numLayers(); layer++) {
+        for (auto& v : cross[layer]) v = floatToFp16(dist(rng));
+        for (auto& v : cross[decoder->numLayers() + layer]) v = floatToFp16(dist(rng));
+        crossK.push_back(cross[layer].data());
+        crossV.push_back(cross[decoder->numLayers() + layer].data());
+    }
+
+    // A vocabulary smaller than Whisper's has no special tokens: prompt with 0s and
+    // let the budget end the decode.
+    bool whisperVocab = decoder->vocabSize() > 50365;
+    std::vector<int32_t> prompt = whisperVocab ? std::vector<int32_t>{ 50258, 50259, 50360, 50364 }
+                                               : std::vector<int32_t>{ 0, 0, 0, 0 };
+    DecodeScorerConfig scorerConfig;
+    scorerConfig.vocabSize = decoder->vocabSize();
+    scorerConfig.noSpeechToken = whisperVocab ? scorerConfig.noSpeechToken : 0;
+    DecodeScorer scorer(scorerConfig);
+    LogitProcessorConfig processorConfig;
+    processorConfig.vocabSize = decoder->vocabSize();
+    LogitProcessor processor(processorConfig);
+
+    std::vector<int32_t> tokens(maxTokens);
+    double msPerStep = 0.0;
+    for (int run = 0; run < runs; run++) {
+        scorer.reset();
+        NativeDecodeParams params;
+        params.prompt = prompt.data();
+        params.promptLength = (int)prompt.size();
+        params.temperature = temperature;
+        params.eot = whisperVocab ? params.eot : -1;
+        params.timestampBegin = whisperVocab ? params.timestampBegin : decoder->vocabSize();
+        params.processor = whisperVocab ? &processor : nullptr;
+        params.scorer = &scorer;
+        NativeDecodeResult result = decoder->decode(crossK.data(), crossV.data(), params, tokens.data(), maxTokens);
+
+        printf("run %d: %d tokens, %d steps, %.1f ms (%.2f ms/step), avg logprob %.3f\n  ",
+               run, result.numTokens, result.steps, result.decodeMs,
+               result.steps ? result.decodeMs / result.steps : 0.0, scorer.sumLogProb() / (result.numTokens + 1));
+        for (int i = 0; i < result.numTokens; i++) printf("%d ", tokens[i]);
+        printf("\n");
+        if (result.steps) msPerStep = result.decodeMs / result.steps;
+    }
+    if (cancelMs < 0) return 0;
+
+    // Cancel a full-length decode part way through: no EOT, so only the token stops it
+    CancellationToken token;
+    scorer.reset();
+    NativeDecodeParams params;
+    params.prompt = prompt.data();
+    params.promptLength = (int)prompt.size();
+    params.eot = -1;
+    params.timestampBegin = decoder->vocabSize();
+    params.scorer = &scorer;
+    params.cancel = &token;
+    auto cancelledAt = std::chrono::steady_clock::now();
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cancelMs));
+        cancelledAt = std::chrono::steady_clock::now();
+        token.cancel();
+    });
+    NativeDecodeResult result = decoder->decode(crossK.data(), crossV.data(), params, tokens.data(), maxTokens);
+    auto stoppedAt = std::chrono::steady_clock::now();
+    canceller.join();                            // cancelledAt is written on the canceller thread
+    double latency = std::chrono::duration<double, std::milli>(stoppedAt - cancelledAt).count();
+    printf("cancel after %d ms: stopped at step %d, %.2f ms after cancel (%.2f ms/step)\n",
+           cancelMs, result.steps, latency, msPerStep);
+    if (result.stopReason != DECODE_STOP_CANCELLED || latency > 2.0 * msPerStep + 1.0) {
+        fprintf(stderr, "FAIL: decode did not stop within one step of the cancel\n");
+        return 1;
+    }
+    return 0;
+}
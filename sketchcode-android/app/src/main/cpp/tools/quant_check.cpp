@@ -0,0 +1,174 @@
+// Measures the int8/uint8 log-mel output (MelOptions::quantization) against the fp32 mel.
+//
+//   whisper_quant_check [-s scale -z zeroPoint] [audio.wav|audio.pcm ...]
+//
+// Clips are 16 kHz recordings (channels averaged); without files, synthetic
+// clips from quiet to full scale are used. The default quantization is
+// defaultMelQuantization(); -s/-z override it. For int8 and uint8, with and without
+// noise suppression, checks that:
+//  - the fp32 mel written next to the quantized one equals the plain fp32 mel, bit for bit,
+//  - the fused quantized output equals quantizeMel() of the fp32 mel,
+//  - dequantized values within the representable range are off by at most scale / 2,
+// and reports the error of the dequantized mel against the fp32 one (max, RMS, SNR),
+// how many values saturate, and the cost of the fused pass against a separate one.
+// Exits non-zero on any failure.
+
+#include "mel_engine.h"
+#include "test_signals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static std::vector<float> syntheticClip(int samples, float level, uint32_t seed) {
+    // A few harmonics, like a voiced vowel, clipped at full scale
+    SyntheticSpeechOptions options;
+    options.level = level;
+    options.noise = 0.02f * level;
+    options.pitchHz = 140.0;
+    options.glideHz = 60.0;
+    options.glideRateHz = 0.5;
+    options.harmonics = 3;
+    options.seed = seed;
+    return syntheticSpeech(samples, options);
+}
+
+struct Clip {
+    std::string name;
+    std::vector<float> audio;
+};
+
+struct ErrorStats {
+    double maxError = 0.0;
+    double squaredError = 0.0;
+    double squaredSignal = 0.0;
+    long values = 0;
+    long saturated = 0;
+};
+
+static float dequantize(const void* data, int index, const MelQuantization& quant) {
+    int q = quant.type == MEL_QUANT_INT8 ? static_cast<const int8_t*>(data)[index]
+                                         : static_cast<const uint8_t*>(data)[index];
+    return (q - quant.zeroPoint) * quant.scale;
+}
+
+int main(int argc, char** argv) {
+    float scale = 0.0f;
+    int zeroPoint = 0;
+    bool custom = false;
+    std::vector<Clip> clips;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scale = (float)atof(argv[++i]);
+            custom = true;
+        } else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc) {
+            zeroPoint = atoi(argv[++i]);
+            custom = true;
+        } else {
+            Clip clip{ argv[i], {} };
+            std::string error;
+            if (!loadRecording(argv[i], clip.audio, error)) {
+                fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+                return 1;
+            }
+            clips.push_back(std::move(clip));
+        }
+    }
+    if (custom && scale <= 0.0f) {
+        fprintf(stderr, "usage: %s [-s scale -z zeroPoint] [audio.wav|audio.pcm ...]\n", argv[0]);
+        return 2;
+    }
+    if (clips.empty()) {
+        static const float LEVELS[] = { 0.0f, 0.003f, 0.05f, 0.3f, 1.0f };
+        static const float SECONDS[] = { 2.0f, 8.0f, 8.0f, 20.0f, 30.0f };
+        for (int i = 0; i < 5; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "level %.3f", LEVELS[i]);
+            clips.push_back({ name, syntheticClip((int)(SECONDS[i] * SAMPLE_RATE), LEVELS[i], 11u + i) });
+        }
+    }
+
+    const int count = N_MELS * N_FRAMES;
+    std::vector<float> golden(count), fused(count);
+    std::vector<uint8_t> quantized(count), reference(count);
+    int failures = 0;
+    double fusedMs = 0.0, separateMs = 0.0;
+    int timed = 0;
+
+    printf("%-8s %-24s %5s %9s %9s %8s %9s\n", "type", "clip", "noise", "max_err", "rms_err", "snr_db", "saturated");
+    for (MelQuantType type : { MEL_QUANT_INT8, MEL_QUANT_UINT8 }) {
+        MelQuantization quant = defaultMelQuantization(type);
+        if (custom) {
+            quant.scale = scale;
+            quant.zeroPoint = zeroPoint;
+        }
+        const int lowest = type == MEL_QUANT_INT8 ? -128 : 0;
+        const float representableMin = (lowest - quant.zeroPoint) * quant.scale;
+        const float representableMax = (lowest + 255 - quant.zeroPoint) * quant.scale;
+
+        for (const Clip& clip : clips) {
+            for (int denoise = 0; denoise < 2; denoise++) {
+                MelOptions options;
+                options.suppressNoise = denoise != 0;
+                auto start = Clock::now();
+                computeLogMelSpectrogram(clip.audio.data(), (int)clip.audio.size(), options, golden.data());
+                quantizeMel(golden.data(), count, quant, reference.data());
+                double separate = msSince(start);
+
+                options.quantization = quant;
+                options.quantizedOut = quantized.data();
+                start = Clock::now();
+                computeLogMelSpectrogram(clip.audio.data(), (int)clip.audio.size(), options, fused.data());
+                double fusedOnce = msSince(start);
+                if (denoise == 0) {
+                    fusedMs += fusedOnce;
+                    separateMs += separate;
+                    timed++;
+                }
+
+                if (memcmp(fused.data(), golden.data(), count * sizeof(float)) != 0) {
+                    fprintf(stderr, "FAIL: %s: fp32 mel changed when quantizing\n", clip.name.c_str());
+                    failures++;
+                }
+                if (memcmp(quantized.data(), reference.data(), count) != 0) {
+                    fprintf(stderr, "FAIL: %s: fused quantization differs from quantizeMel()\n", clip.name.c_str());
+                    failures++;
+                }
+
+                ErrorStats stats;
+                for (int i = 0; i < count; i++) {
+                    float x = golden[i];
+                    double error = fabs((double)dequantize(quantized.data(), i, quant) - x);
+                    bool inRange = x >= representableMin && x <= representableMax;
+                    if (!inRange) stats.saturated++;
+                    if (inRange && error > quant.scale * 0.5 * (1.0 + 1e-5)) {
+                        fprintf(stderr, "FAIL: %s: value %g dequantizes off by %g (scale %g)\n",
+                                clip.name.c_str(), x, error, quant.scale);
+                        failures++;
+                        break;
+                    }
+                    stats.maxError = std::max(stats.maxError, error);
+                    stats.squaredError += error * error;
+                    stats.squaredSignal += (double)x * x;
+                    stats.values++;
+                }
+                double rms = sqrt(stats.squaredError / std::max(1L, stats.values));
+                double snr = stats.squaredError > 0.0 ? 10.0 * log10(stats.squaredSignal / stats.squaredError) : INFINITY;
+                printf("%-8s %-24s %5d %9.5f %9.5f %8.1f %9ld\n", type == MEL_QUANT_INT8 ? "int8" : "uint8",
+                       clip.name.c_str(), denoise, stats.maxError, rms, snr, stats.saturated);
+            }
+        }
+        printf("%s: scale %g, zero point %d, range [%g, %g]\n", type == MEL_QUANT_INT8 ? "int8" : "uint8",
+               quant.scale, quant.zeroPoint, representableMin, representableMax);
+    }
+    printf("mel + quantization: fused %.2f ms, separate pass %.2f ms\n",
+           fusedMs / std::max(1, timed), separateMs / std::max(1, timed));
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Checks the two-stage transcription queue (transcription_queue.cpp) with stand-in stages.
+//
+//   whisper_queue_check [-f frontMs] [-d decodeMs] [-n jobs]
+//
+// The front end and decoder sleep instead of running models. Checks that:
+//  - jobs complete exactly once, in submission order,
+//  - the front end of job N+1 overlaps the decode of job N, so the batch takes about
+//    n * max(front, decode) rather than n * (front + decode),
+//  - no slot is held by two live jobs, and submit() refuses jobs beyond the depth,
+//  - a cancelled job skips the stages it has not started,
+//  - shutdown completes every job still queued as cancelled.
+// Exits non-zero on any failure.
+
+#include "test_signals.h"
+#include "transcription_queue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+struct Trace {
+    std::mutex mutex;
+    std::vector<int64_t> completed;
+    std::vector<int> statuses;
+    std::set<int64_t> decoded;
+    int slotOwner[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+    int slotConflicts = 0;
+    int overlaps = 0;
+    bool decoding = false;
+};
+
+int main(int argc, char** argv) {
+    int frontMs = 30, decodeMs = 50, jobs = 6;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-f") == 0) frontMs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-d") == 0) decodeMs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0) jobs = atoi(argv[i + 1]);
+    }
+    int failures = 0;
+    Trace trace;
+
+    TranscriptionQueueCallbacks callbacks;
+    callbacks.frontEnd = [&](int64_t job, int slot) {
+        {
+            std::lock_guard<std::mutex> lock(trace.mutex);
+            if (trace.slotOwner[slot] != -1) trace.slotConflicts++;
+            trace.slotOwner[slot] = (int)job;
+            if (trace.decoding) trace.overlaps++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(frontMs));
+        return JOB_CONTINUE;
+    };
+    callbacks.decode = [&](int64_t job, int slot) {
+        {
+            std::lock_guard<std::mutex> lock(trace.mutex);
+            trace.decoding = true;
+            trace.decoded.insert(job);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(decodeMs));
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.decoding = false;
+        trace.slotOwner[slot] = -1;
+        return JOB_DONE;
+    };
+    callbacks.complete = [&](int64_t job, int status) {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.completed.push_back(job);
+        trace.statuses.push_back(status);
+    };
+
+    // 1. A burst of jobs: in order, overlapped
+    {
+        TranscriptionQueue queue(jobs, 2, callbacks);
+        auto start = Clock::now();
+        for (int i = 0; i < jobs; i++) {
+            if (!queue.submit(i)) failures++;
+        }
+        if (queue.submit(jobs)) {
+            printf("submit beyond depth %d was accepted\n", jobs);
+            failures++;
+        }
+        while (queue.pending() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double elapsed = msSince(start);
+        double serial = (double)jobs * (frontMs + decodeMs);
+        double pipelined = frontMs + (double)jobs * std::max(frontMs, decodeMs);
+        printf("burst: %d jobs in %.0f ms (serial %.0f, pipelined ideal %.0f), %d overlapped front ends\n",
+               jobs, elapsed, serial, pipelined, trace.overlaps);
+        if (elapsed > (serial + pipelined) / 2 || trace.overlaps == 0) {
+            printf("stages did not overlap\n");
+            failures++;
+        }
+        for (int i = 0; i < (int)trace.completed.size(); i++) {
+            if (trace.completed[i] != i || trace.statuses[i] != JOB_DONE) {
+                printf("job %lld completed at %d with status %d\n", (long long)trace.completed[i], i, trace.statuses[i]);
+                failures++;
+            }
+        }
+        if ((int)trace.completed.size() != jobs || trace.slotConflicts != 0) {
+            printf("%zu completions, %d slot conflicts\n", trace.completed.size(), trace.slotConflicts);
+            failures++;
+        }
+    }
+
+    // 2. Cancel a queued job; shut down with jobs still queued
+    trace.completed.clear();
+    trace.statuses.clear();
+    trace.decoded.clear();
+    {
+        TranscriptionQueue queue(8, 2, callbacks);
+        for (int i = 100; i < 104; i++) queue.submit(i);
+        queue.cancel(102);
+        while (queue.pending() > 2) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        queue.submit(104);
+        queue.submit(105);
+        queue.shutdown();
+        if (queue.submit(106)) failures++;
+    }
+    int cancelled = 0;
+    std::set<int64_t> seen;
+    for (size_t i = 0; i < trace.completed.size(); i++) {
+        if (!seen.insert(trace.completed[i]).second) failures++;
+        if (trace.statuses[i] == JOB_CANCELLED) cancelled++;
+    }
+    bool skipped = trace.decoded.count(102) == 0;
+    printf("cancel: %zu jobs completed once each, %d cancelled, cancelled job %s\n",
+           trace.completed.size(), cancelled, skipped ? "skipped its decode" : "was decoded");
+    if (trace.completed.size() != 6 || !skipped || cancelled < 1) failures++;
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
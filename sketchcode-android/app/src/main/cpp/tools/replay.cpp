@@ -0,0 +1,134 @@
+// Replay a capture corpus (see capture_log.h) through the production mel engine.
+//
+//   whisper_mel_replay [-n iterations] [--npy OUT_DIR] CAPTURE_FILE...
+//
+// Every recorded utterance is featurized with the same options it was captured
+// with (noise suppression, the trimmed frame bucket, the int8/uint8 encoder input),
+// n times, and the best/median host mel time is printed next to the
+// stage timings measured on device. Use --npy to also dump the features for
+// offline encoder/decoder runs.
+
+#include "audio_file.h"
+#include "beamformer.h"
+#include "capture_log.h"
+#include "mel_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [-n iterations] [--npy OUT_DIR] CAPTURE_FILE...\n", argv0);
+}
+
+static double ms(uint32_t micros) {
+    return micros / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 5;
+    fs::path npyDir;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--npy") == 0 && i + 1 < argc) {
+            npyDir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            inputs.emplace_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!npyDir.empty()) {
+        fs::create_directories(npyDir);
+    }
+
+    std::vector<float> melSpec(N_MELS * N_FRAMES);
+    std::vector<uint8_t> quantized(N_MELS * N_FRAMES);
+    std::vector<float> mono;
+    std::vector<double> runs;
+    int failures = 0;
+
+    printf("%-24s %4s %7s %3s %6s %5s %9s %9s | %9s %9s %9s %9s %6s\n",
+           "record", "#", "audio_s", "ch", "frames", "quant", "mel_best", "mel_med",
+           "dev_mel", "dev_enc", "dev_dec", "dev_total", "tokens");
+
+    for (const auto& input : inputs) {
+        CaptureLogReader reader;
+        if (!reader.open(input)) {
+            fprintf(stderr, "%s: %s\n", input.c_str(), reader.error().c_str());
+            failures++;
+            continue;
+        }
+
+        std::string name = fs::path(input).stem().string();
+        const CaptureRecordHeader* header;
+        const float* samples;
+        for (int index = 0; reader.next(&header, &samples); index++) {
+            if (header->sampleRate != SAMPLE_RATE || header->channels < 1 || header->channels > 2) {
+                fprintf(stderr, "%s#%d: unsupported format %u Hz x%u, skipped\n",
+                        input.c_str(), index, header->sampleRate, header->channels);
+                continue;
+            }
+            int numFrames = (int)(header->numSamples / header->channels);
+            MelOptions options;
+            options.suppressNoise = (header->flags & CAPTURE_FLAG_DENOISE) != 0;
+            options.outputFrames = melFramesForAudio(numFrames, (int)header->melBucketFrames);
+            if (header->melQuantType == MEL_QUANT_INT8 || header->melQuantType == MEL_QUANT_UINT8) {
+                options.quantization.type = static_cast<MelQuantType>(header->melQuantType);
+                options.quantization.scale = header->melQuantScale;
+                options.quantization.zeroPoint = header->melQuantZeroPoint;
+                options.quantizedOut = quantized.data();
+            }
+            const char* quantName = options.quantizedOut == nullptr ? "fp32"
+                                  : options.quantization.type == MEL_QUANT_INT8 ? "int8" : "uint8";
+
+            runs.clear();
+            for (int it = 0; it < iterations; it++) {
+                auto start = std::chrono::steady_clock::now();
+                const float* audio = samples;
+                if (header->channels == 2) {
+                    beamformStereo(samples, numFrames, mono);
+                    audio = mono.data();
+                }
+                computeLogMelSpectrogram(audio, numFrames, options, melSpec.data());
+                runs.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count());
+            }
+            std::sort(runs.begin(), runs.end());
+
+            printf("%-24s %4d %7.2f %3u %6d %5s %9.2f %9.2f | %9.1f %9.1f %9.1f %9.1f %6u\n",
+                   name.c_str(), index, (double)numFrames / SAMPLE_RATE, header->channels,
+                   options.outputFrames, quantName, runs.front(), runs[runs.size() / 2],
+                   ms(header->stageMicros[CAPTURE_STAGE_MEL]), ms(header->stageMicros[CAPTURE_STAGE_ENCODER]),
+                   ms(header->stageMicros[CAPTURE_STAGE_DECODER]), ms(header->stageMicros[CAPTURE_STAGE_TOTAL]),
+                   header->decodedTokens);
+
+            if (!npyDir.empty()) {
+                fs::path out = npyDir / (name + "_" + std::to_string(index) + ".npy");
+                if (!writeNpy(out.string(), melSpec.data(), { (size_t)N_MELS, (size_t)options.outputFrames })) {
+                    fprintf(stderr, "failed to write %s\n", out.c_str());
+                    failures++;
+                }
+            }
+        }
+        if (reader.truncated()) {
+            fprintf(stderr, "%s: ignored truncated tail record\n", input.c_str());
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
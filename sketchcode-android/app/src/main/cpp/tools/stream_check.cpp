@@ -0,0 +1,124 @@
+// Checks the rolling log-mel window (mel_stream.cpp) against the batch pipeline.
+//
+//   whisper_stream_check [audio.wav|audio.pcm]
+//
+// A 16 kHz recording (channels averaged); without a file, a synthetic 45 s talker
+// that gets louder, so the window maximum moves as old frames drop out. Audio is
+// pushed in uneven chunks, as AudioRecord delivers it. Checks that:
+//  - up to 30 s, every snapshot equals computeLogMelSpectrogram() of the audio so far,
+//    bit for bit,
+//  - past 30 s, the snapshot equals the batch mel of the last 30 s (frame-aligned)
+//    except for the window's first two frames and its last one, which see real audio
+//    or zeros where the batch pipeline reflects,
+//  - frames are computed once: total frames == samples / hop, whatever the chunking,
+// and compares the cost of streaming plus a snapshot with recomputing the window.
+// Exits non-zero on any failure.
+
+#include "mel_engine.h"
+#include "mel_stream.h"
+#include "test_signals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Largest difference over frames [fromFrame, toFrame) of two [N_MELS x N_FRAMES] mels
+static float maxDiff(const float* a, const float* b, int fromFrame, int toFrame) {
+    float worst = 0.0f;
+    for (int m = 0; m < N_MELS; m++) {
+        for (int f = fromFrame; f < toFrame; f++) {
+            worst = fmaxf(worst, fabsf(a[m * N_FRAMES + f] - b[m * N_FRAMES + f]));
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    std::vector<float> audio;
+    if (argc > 1) {
+        std::string error;
+        if (!loadRecording(argv[1], audio, error)) {
+            fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+            return 1;
+        }
+    } else {
+        SyntheticSpeechOptions speech;
+        speech.level = 0.05f;
+        speech.levelSlope = 0.4f / 45.0f;
+        speech.noise = 0.01f;
+        speech.pitchHz = 150.0;
+        speech.glideHz = 80.0;
+        speech.glideRateHz = 0.2;
+        speech.seed = 99;
+        audio = syntheticSpeech(45 * SAMPLE_RATE, speech);
+    }
+
+    MelStream stream;
+    std::vector<float> snapshot(N_MELS * N_FRAMES), batch(N_MELS * N_FRAMES);
+    MelOptions options;
+    int failures = 0, snapshots = 0, exact = 0;
+    float worstPast30 = 0.0f;
+    double streamMs = 0.0, snapshotMs = 0.0, batchMs = 0.0;
+
+    // Uneven chunks around AudioRecord's 1024-sample reads
+    static const int CHUNKS[] = { 1024, 1024, 37, 2000, 1024, 160, 999, 4096 };
+    size_t pos = 0;
+    for (int c = 0; pos < audio.size(); c++) {
+        int count = (int)std::min<size_t>(CHUNKS[c % 8], audio.size() - pos);
+        auto start = Clock::now();
+        bool due = stream.push(audio.data() + pos, count);
+        streamMs += msSince(start);
+        pos += count;
+        if (!due && pos < audio.size()) continue;
+
+        start = Clock::now();
+        int frames = stream.snapshot(snapshot.data());
+        snapshotMs += msSince(start);
+        snapshots++;
+
+        // Batch reference over the same window
+        size_t first = pos > (size_t)N_SAMPLES ? (pos - N_SAMPLES + HOP_LENGTH - 1) / HOP_LENGTH * HOP_LENGTH : 0;
+        start = Clock::now();
+        computeLogMelSpectrogram(audio.data() + first, (int)(pos - first), options, batch.data());
+        batchMs += msSince(start);
+
+        if (first == 0) {
+            if (memcmp(snapshot.data(), batch.data(), batch.size() * sizeof(float)) == 0) {
+                exact++;
+            } else {
+                fprintf(stderr, "FAIL: snapshot at %.2f s differs from the batch mel by %g\n",
+                        (double)pos / SAMPLE_RATE, maxDiff(snapshot.data(), batch.data(), 0, N_FRAMES));
+                failures++;
+            }
+        } else {
+            worstPast30 = fmaxf(worstPast30, maxDiff(snapshot.data(), batch.data(), 2, N_FRAMES - 1));
+        }
+        if (frames <= 0 || frames > N_FRAMES) {
+            fprintf(stderr, "FAIL: snapshot reported %d audio frames\n", frames);
+            failures++;
+        }
+    }
+    if (worstPast30 > 1e-6f) {
+        fprintf(stderr, "FAIL: windows past 30 s differ from the batch mel by %g\n", worstPast30);
+        failures++;
+    }
+    int64_t expectedFrames = stream.samples() >= PAD + 1 ? (stream.samples() - PAD) / HOP_LENGTH + 1 : 0;
+    if (stream.frames() != expectedFrames) {
+        fprintf(stderr, "FAIL: %lld frames computed for %lld samples, expected %lld\n",
+                (long long)stream.frames(), (long long)stream.samples(), (long long)expectedFrames);
+        failures++;
+    }
+
+    printf("%.1f s of audio, %d snapshots (%d bit-exact up to 30 s, max diff past 30 s %g)\n",
+           (double)audio.size() / SAMPLE_RATE, snapshots, exact, worstPast30);
+    printf("streaming: %.1f ms for %lld frames (%.1f us/frame), snapshot %.2f ms, batch recompute %.1f ms\n",
+           streamMs, (long long)stream.frames(), 1000.0 * streamMs / std::max<int64_t>(1, stream.frames()),
+           snapshotMs / snapshots, batchMs / snapshots);
+
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "test_signals.h"
+#include "audio_file.h"
+#include "mel_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<float> syntheticSpeech(int samples, const SyntheticSpeechOptions& options) {
+    std::vector<float> audio(std::max(samples, 0));
+    uint32_t seed = options.seed;
+    double phase = 0.0;
+    for (size_t i = 0; i < audio.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float noise = ((seed >> 8) / 16777216.0f - 0.5f) * options.noise;
+        double t = (double)i / SAMPLE_RATE;
+        phase += 2.0 * M_PI * (options.pitchHz + options.glideHz * sin(2.0 * M_PI * options.glideRateHz * t)) / SAMPLE_RATE;
+        if (t < options.voicedFrom || t >= options.voicedTo) {
+            audio[i] = noise;
+            continue;
+        }
+        float envelope = options.syllableRateHz > 0.0
+            ? 0.5f + 0.5f * (float)sin(2.0 * M_PI * options.syllableRateHz * t) : 1.0f;
+        double voiced = 0.0, amplitude = 1.0;
+        for (int k = 1; k <= options.harmonics; k++, amplitude *= 0.5) voiced += amplitude * sin(k * phase);
+        float level = options.level + options.levelSlope * (float)t;
+        audio[i] = std::clamp(level * envelope * (float)voiced + noise, -1.0f, 1.0f);
+    }
+    return audio;
+}
+
+bool loadRecording(const std::string& path, std::vector<float>& mono, std::string& error) {
+    MappedAudioFile file;
+    if (!file.open(path)) {
+        error = file.error();
+        return false;
+    }
+    if (file.sampleRate() != SAMPLE_RATE) {
+        error = "sample rate " + std::to_string(file.sampleRate()) + ", expected " + std::to_string(SAMPLE_RATE);
+        return false;
+    }
+    // Block by block, so a long recording is never copied whole
+    int channels = file.channels();
+    mono.resize(file.numFrames());
+    std::vector<float> block(4096 * (size_t)channels);
+    for (size_t first = 0; first < mono.size(); first += 4096) {
+        size_t frames = std::min<size_t>(4096, mono.size() - first);
+        file.toFloat(first, frames, block.data());
+        for (size_t i = 0; i < frames; i++) {
+            float sum = 0.0f;
+            for (int c = 0; c < channels; c++) sum += block[i * channels + c];
+            mono[first + i] = sum / channels;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Test signals and timing shared by the host check tools.
+ *
+ * syntheticSpeech() stands in for a talker: a gliding voiced tone under a syllable-rate
+ * envelope, over a uniform noise floor from a fixed-seed LCG, so every run (and every
+ * platform) sees the same samples. loadRecording() reads a real 16 kHz recording for
+ * the checks whose subject is how real speech behaves.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+inline double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct SyntheticSpeechOptions {
+    float level = 0.3f;            // peak of the voiced part at full envelope
+    float levelSlope = 0.0f;       // level change per second (a talker getting louder)
+    float noise = 0.02f;           // peak-to-peak of the noise floor
+    double pitchHz = 160.0;        // centre of the pitch glide
+    double glideHz = 50.0;         // glide depth; 0 holds the pitch
+    double glideRateHz = 0.4;
+    double syllableRateHz = 3.0;   // envelope rate; 0 is a steady level
+    int harmonics = 1;             // harmonic k (from 1) at amplitude 2^(1-k)
+    double voicedFrom = 0.0;       // seconds; only noise outside [voicedFrom, voicedTo)
+    double voicedTo = 1e9;
+    uint32_t seed = 1;
+};
+
+/** samples of synthetic speech at SAMPLE_RATE, clipped to [-1, 1]. */
+std::vector<float> syntheticSpeech(int samples, const SyntheticSpeechOptions& options = {});
+
+/**
+ * Read a 16 kHz WAV or headerless .pcm recording (see MappedAudioFile) as mono: the
+ * channels are averaged. On failure returns false and sets error.
+ */
+bool loadRecording(const std::string& path, std::vector<float>& mono, std::string& error);
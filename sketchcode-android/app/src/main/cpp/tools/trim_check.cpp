@@ -0,0 +1,129 @@
+// Checks the trimmed log-mel output (MelOptions::outputFrames, melFramesForAudio) against
+// the full 30 s spectrogram.
+//
+//   whisper_trim_check [recording.wav|recording.pcm ...]
+//
+// For synthetic clips from 0.3 s to 45 s, and any 16 kHz recordings given (real
+// speech, whose pauses and onsets decide where speech detection lands), with and
+// without noise suppression, and several bucket sizes, checks that:
+//  - the frame count is what melFramesForAudio promises: a multiple of the bucket
+//    (or N_FRAMES), covering the audio plus one silent frame,
+//  - every emitted value equals the full spectrogram's, bit for bit,
+//  - repeating the last frame reproduces the dropped padding (how an encoder with a
+//    longer input is fed),
+//  - speech detection gives the same count on the trimmed mel,
+// and compares the cost of the trimmed and the full mel on short clips.
+// Exits non-zero on any failure.
+
+#include "mel_engine.h"
+#include "test_signals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Clip {
+    std::string name;
+    std::vector<float> audio;
+};
+
+int main(int argc, char** argv) {
+    static const float SECONDS[] = { 0.3f, 1.0f, 2.99f, 3.2f, 7.0f, 12.345f, 29.9f, 30.0f, 45.0f };
+    static const int BUCKETS[] = { 1, 100, 500, 1000 };
+
+    std::vector<Clip> clips;
+    for (float seconds : SECONDS) {
+        SyntheticSpeechOptions speech;
+        speech.pitchHz = 220.0;
+        speech.glideHz = 0.0;
+        speech.syllableRateHz = 2.0;
+        speech.seed = 7;
+        char name[32];
+        snprintf(name, sizeof(name), "%.2f s", seconds);
+        clips.push_back({ name, syntheticSpeech((int)(seconds * SAMPLE_RATE), speech) });
+    }
+    for (int i = 1; i < argc; i++) {
+        Clip clip{ argv[i], {} };
+        std::string error;
+        if (!loadRecording(argv[i], clip.audio, error)) {
+            fprintf(stderr, "%s: %s\n", argv[i], error.c_str());
+            return 1;
+        }
+        clips.push_back(std::move(clip));
+    }
+
+    std::vector<float> full(N_MELS * N_FRAMES), trimmed(N_MELS * N_FRAMES);
+    int failures = 0, cases = 0;
+    double fullMs = 0.0, trimmedMs = 0.0;
+    int timedClips = 0;
+
+    for (const Clip& clip : clips) {
+        const std::vector<float>& audio = clip.audio;
+        int audioLen = (int)audio.size();
+        float seconds = (float)audioLen / SAMPLE_RATE;
+        for (int denoise = 0; denoise < 2; denoise++) {
+            MelOptions options;
+            options.suppressNoise = denoise != 0;
+            auto start = Clock::now();
+            computeLogMelSpectrogram(audio.data(), audioLen, options, full.data());
+            double oneFull = msSince(start);
+            int fullSpeech = detectSpeechFrames(full.data(), N_FRAMES, N_FRAMES, nullptr);
+
+            for (int bucket : BUCKETS) {
+                cases++;
+                int frames = melFramesForAudio(audioLen, bucket);
+                int firstSilent = (audioLen + PAD + HOP_LENGTH - 1) / HOP_LENGTH;
+                if (frames != N_FRAMES && (frames % bucket != 0 || frames <= firstSilent)) {
+                    fprintf(stderr, "FAIL: %s, bucket %d: %d frames\n", clip.name.c_str(), bucket, frames);
+                    failures++;
+                    continue;
+                }
+
+                options.outputFrames = frames;
+                start = Clock::now();
+                computeLogMelSpectrogram(audio.data(), audioLen, options, trimmed.data());
+                double oneTrimmed = msSince(start);
+                options.outputFrames = N_FRAMES;
+                if (bucket == BUCKETS[2] && seconds < 10.0f && denoise == 0) {
+                    fullMs += oneFull;
+                    trimmedMs += oneTrimmed;
+                    timedClips++;
+                }
+
+                for (int m = 0; m < N_MELS; m++) {
+                    const float* row = trimmed.data() + (size_t)m * frames;
+                    const float* ref = full.data() + (size_t)m * N_FRAMES;
+                    if (memcmp(row, ref, frames * sizeof(float)) != 0) {
+                        fprintf(stderr, "FAIL: %s, bucket %d, denoise %d: mel row %d differs\n",
+                                clip.name.c_str(), bucket, denoise, m);
+                        failures++;
+                        break;
+                    }
+                    bool padded = true;
+                    for (int f = frames; f < N_FRAMES; f++) padded &= ref[f] == row[frames - 1];
+                    if (!padded) {
+                        fprintf(stderr, "FAIL: %s, bucket %d, denoise %d: padding of row %d is not its last frame\n",
+                                clip.name.c_str(), bucket, denoise, m);
+                        failures++;
+                        break;
+                    }
+                }
+                int speech = detectSpeechFrames(trimmed.data(), frames, frames, nullptr);
+                if (speech != fullSpeech) {
+                    fprintf(stderr, "FAIL: %s, bucket %d: %d speech frames, full mel has %d\n",
+                            clip.name.c_str(), bucket, speech, fullSpeech);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    printf("%d cases; clips under 10 s, bucket %d: trimmed %.2f ms vs full %.2f ms per mel\n",
+           cases, BUCKETS[2], trimmedMs / std::max(1, timedClips), fullMs / std::max(1, timedClips));
+    if (failures) return 1;
+    printf("OK\n");
+    return 0;
+}
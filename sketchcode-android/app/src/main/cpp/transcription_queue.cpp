@@ -0,0 +1,146 @@
+#include "transcription_queue.h"
+
+#include <algorithm>
+
+#define LOG_TAG "WhisperQueue"
+#include "native_log.h"
+
+TranscriptionQueue::TranscriptionQueue(int maxPending, int slots, TranscriptionQueueCallbacks callbacks)
+    : maxPending_(std::max(1, maxPending)), callbacks_(std::move(callbacks)) {
+    for (int slot = std::max(1, slots) - 1; slot >= 0; slot--) freeSlots_.push_back(slot);
+    frontWorker_ = std::thread(&TranscriptionQueue::frontLoop, this);
+    backWorker_ = std::thread(&TranscriptionQueue::backLoop, this);
+    LOGI("Transcription queue: %d pending max, %d encoder slots", maxPending_, (int)freeSlots_.size());
+}
+
+TranscriptionQueue::~TranscriptionQueue() {
+    shutdown();
+}
+
+bool TranscriptionQueue::submit(int64_t job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || (int)live_.size() >= maxPending_ || live_.count(job)) return false;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    live_[job] = cancelled;
+    frontQueue_.push_back({ job, -1, cancelled });
+    frontReady_.notify_one();
+    return true;
+}
+
+bool TranscriptionQueue::cancel(int64_t job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = live_.find(job);
+    if (it == live_.end()) return false;
+    it->second->store(true);
+    // A cancelled job no longer needs a slot to leave the front queue
+    frontReady_.notify_one();
+    return true;
+}
+
+void TranscriptionQueue::cancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : live_) entry.second->store(true);
+    frontReady_.notify_one();
+}
+
+bool TranscriptionQueue::isCancelled(int64_t job) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = live_.find(job);
+    return it == live_.end() || it->second->load();
+}
+
+int TranscriptionQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)live_.size();
+}
+
+void TranscriptionQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ && !frontWorker_.joinable()) return;
+        stopping_ = true;
+        for (auto& entry : live_) entry.second->store(true);
+    }
+    frontReady_.notify_all();
+    backReady_.notify_all();
+    if (frontWorker_.joinable()) frontWorker_.join();
+    if (backWorker_.joinable()) backWorker_.join();
+}
+
+void TranscriptionQueue::finish(const Job& job, int status) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        live_.erase(job.id);
+    }
+    if (callbacks_.complete) callbacks_.complete(job.id, status);
+}
+
+void TranscriptionQueue::frontLoop() {
+    if (callbacks_.threadStart) callbacks_.threadStart();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        frontReady_.wait(lock, [&] {
+            if (frontQueue_.empty()) return stopping_;
+            return !freeSlots_.empty() || frontQueue_.front().cancelled->load();
+        });
+        if (frontQueue_.empty()) {             // stopping and drained
+            frontDone_ = true;
+            break;
+        }
+        Job job = frontQueue_.front();
+        frontQueue_.pop_front();
+
+        if (job.cancelled->load()) {
+            lock.unlock();
+            finish(job, JOB_CANCELLED);
+            lock.lock();
+            continue;
+        }
+        job.slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        lock.unlock();
+
+        int status = callbacks_.frontEnd ? callbacks_.frontEnd(job.id, job.slot) : JOB_CONTINUE;
+        if (status == JOB_CONTINUE && job.cancelled->load()) status = JOB_CANCELLED;
+
+        lock.lock();
+        if (status == JOB_CONTINUE) {
+            backQueue_.push_back(job);
+            backReady_.notify_one();
+            continue;
+        }
+        freeSlots_.push_back(job.slot);
+        lock.unlock();
+        finish(job, status);
+        lock.lock();
+    }
+    lock.unlock();
+    // The decoder drains what is left, then stops too
+    backReady_.notify_all();
+    if (callbacks_.threadStop) callbacks_.threadStop();
+}
+
+void TranscriptionQueue::backLoop() {
+    if (callbacks_.threadStart) callbacks_.threadStart();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // Exit only once the front worker can no longer hand over a job
+        backReady_.wait(lock, [&] { return !backQueue_.empty() || frontDone_; });
+        if (backQueue_.empty()) break;
+        Job job = backQueue_.front();
+        backQueue_.pop_front();
+        lock.unlock();
+
+        int status = job.cancelled->load() ? JOB_CANCELLED
+                : callbacks_.decode ? callbacks_.decode(job.id, job.slot) : JOB_DONE;
+
+        lock.lock();
+        freeSlots_.push_back(job.slot);
+        frontReady_.notify_one();
+        lock.unlock();
+        finish(job, status);
+        lock.lock();
+    }
+    lock.unlock();
+    if (callbacks_.threadStop) callbacks_.threadStop();
+}
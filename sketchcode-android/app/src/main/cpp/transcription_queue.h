@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/** Stage results; anything but JOB_CONTINUE from the front end is final. */
+enum TranscriptionJobStatus {
+    JOB_CONTINUE = 0,     // front end done, decode next
+    JOB_DONE = 1,         // decoded
+    JOB_CANCELLED = 2,
+    JOB_FAILED = 3,
+    JOB_HANDLED = 4,      // finished by the front end (voice command, enrollment)
+};
+
+/**
+ * Stage callbacks. slot is the encoder-output buffer set the job owns from the start of
+ * its front end until its decode returns; a slot is never shared by two live jobs.
+ * threadStart/threadStop run once on each worker thread (e.g. to attach to a JVM).
+ */
+struct TranscriptionQueueCallbacks {
+    std::function<int(int64_t job, int slot)> frontEnd;   // mel + encoder
+    std::function<int(int64_t job, int slot)> decode;     // decoder loop
+    std::function<void(int64_t job, int status)> complete;
+    std::function<void()> threadStart;
+    std::function<void()> threadStop;
+};
+
+/**
+ * Two-stage transcription pipeline with one worker thread per stage.
+ *
+ * Utterances are decoded in submission order, one at a time, and encoded one at a
+ * time, but the two stages overlap: while utterance N is in its decoder loop, the mel
+ * and encoder of utterance N+1 run into the other encoder-output slot. With `slots`
+ * buffer sets the front end is at most slots - 1 jobs ahead of the decoder.
+ *
+ * At most maxPending jobs are live (queued or running); submit() refuses more.
+ * cancel() marks a job: a stage that has not started is skipped, and the job completes
+ * as JOB_CANCELLED. Every accepted job gets exactly one complete() call, on a worker
+ * thread, including the ones cancelled by shutdown.
+ */
+class TranscriptionQueue {
+public:
+    TranscriptionQueue(int maxPending, int slots, TranscriptionQueueCallbacks callbacks);
+    ~TranscriptionQueue();
+
+    TranscriptionQueue(const TranscriptionQueue&) = delete;
+    TranscriptionQueue& operator=(const TranscriptionQueue&) = delete;
+
+    /** Queue job (a caller-chosen, unique id); false if the queue is full or shut down. */
+    bool submit(int64_t job);
+
+    /** Mark a live job cancelled; false if it is unknown or already complete. */
+    bool cancel(int64_t job);
+    void cancelAll();
+    bool isCancelled(int64_t job) const;
+
+    /** Live jobs: queued, encoding or decoding. */
+    int pending() const;
+
+    /** Cancel everything, let both workers drain, join them. Idempotent. */
+    void shutdown();
+
+private:
+    struct Job {
+        int64_t id;
+        int slot;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    void frontLoop();
+    void backLoop();
+    void finish(const Job& job, int status);
+
+    const int maxPending_;
+    TranscriptionQueueCallbacks callbacks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable frontReady_;
+    std::condition_variable backReady_;
+    std::deque<Job> frontQueue_;
+    std::deque<Job> backQueue_;
+    std::vector<int> freeSlots_;
+    std::unordered_map<int64_t, std::shared_ptr<std::atomic<bool>>> live_;
+    bool stopping_ = false;
+    bool frontDone_ = false;       // front worker exited; nothing more reaches the decoder
+
+    std::thread frontWorker_;
+    std::thread backWorker_;
+};
@@ -0,0 +1,132 @@
+#include <jni.h>
+
+#include <memory>
+
+#include "transcription_queue.h"
+
+#define LOG_TAG "WhisperQueue"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin TranscriptionQueue owns the native pipeline through an opaque jlong
+// handle. Both worker threads attach to the JVM for their lifetime and call the
+// Kotlin TranscriptionQueue.Stages object (held as a global reference) for each stage
+// and completion. A stage that throws is logged and reported as JOB_FAILED.
+
+namespace {
+
+struct JniQueue {
+    JavaVM* vm = nullptr;
+    jobject stages = nullptr;          // global ref
+    jmethodID frontEnd = nullptr;      // (JI)I
+    jmethodID decode = nullptr;        // (JI)I
+    jmethodID complete = nullptr;      // (JI)V
+    std::unique_ptr<TranscriptionQueue> queue;
+};
+
+JNIEnv* threadEnv(JavaVM* vm) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) return nullptr;
+    return env;
+}
+
+int callStage(JniQueue* q, jmethodID method, int64_t job, int slot) {
+    JNIEnv* env = threadEnv(q->vm);
+    if (env == nullptr) return JOB_FAILED;
+    jint status = env->CallIntMethod(q->stages, method, (jlong)job, (jint)slot);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        LOGE("Stage of job %lld threw", (long long)job);
+        return JOB_FAILED;
+    }
+    return status;
+}
+
+} // namespace
+
+static inline JniQueue* fromHandle(jlong handle) {
+    return reinterpret_cast<JniQueue*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeCreate(
+        JNIEnv *env, jobject /* this */, jint maxPending, jint slots, jobject stages) {
+    auto* q = new JniQueue();
+    env->GetJavaVM(&q->vm);
+    jclass cls = env->GetObjectClass(stages);
+    q->frontEnd = env->GetMethodID(cls, "frontEnd", "(JI)I");
+    q->decode = env->GetMethodID(cls, "decode", "(JI)I");
+    q->complete = env->GetMethodID(cls, "onComplete", "(JI)V");
+    env->DeleteLocalRef(cls);
+    if (q->frontEnd == nullptr || q->decode == nullptr || q->complete == nullptr) {
+        env->ExceptionClear();
+        LOGE("TranscriptionQueue.Stages methods not found");
+        delete q;
+        return 0;
+    }
+    q->stages = env->NewGlobalRef(stages);
+
+    TranscriptionQueueCallbacks callbacks;
+    callbacks.threadStart = [q] {
+        JNIEnv* threadEnv = nullptr;
+        q->vm->AttachCurrentThread(&threadEnv, nullptr);
+    };
+    callbacks.threadStop = [q] { q->vm->DetachCurrentThread(); };
+    callbacks.frontEnd = [q](int64_t job, int slot) { return callStage(q, q->frontEnd, job, slot); };
+    callbacks.decode = [q](int64_t job, int slot) { return callStage(q, q->decode, job, slot); };
+    callbacks.complete = [q](int64_t job, int status) {
+        JNIEnv* env = threadEnv(q->vm);
+        if (env == nullptr) return;
+        env->CallVoidMethod(q->stages, q->complete, (jlong)job, (jint)status);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            LOGE("Completion of job %lld threw", (long long)job);
+        }
+    };
+    q->queue.reset(new TranscriptionQueue(maxPending, slots, std::move(callbacks)));
+    return reinterpret_cast<jlong>(q);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeDestroy(JNIEnv *env, jobject /* this */, jlong handle) {
+    JniQueue* q = fromHandle(handle);
+    // Drains and joins the workers; their last callbacks still use the global ref
+    q->queue.reset();
+    env->DeleteGlobalRef(q->stages);
+    delete q;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeSubmit(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jlong job) {
+    return fromHandle(handle)->queue->submit(job) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeCancel(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jlong job) {
+    return fromHandle(handle)->queue->cancel(job) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeCancelAll(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fromHandle(handle)->queue->cancelAll();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativeIsCancelled(
+        JNIEnv * /* env */, jobject /* this */, jlong handle, jlong job) {
+    return fromHandle(handle)->queue->isCancelled(job) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_TranscriptionQueue_nativePending(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->queue->pending();
+}
@@ -0,0 +1,121 @@
+#include "vocabulary.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "WhisperVocabulary"
+#include "native_log.h"
+
+Vocabulary* Vocabulary::open(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Cannot open %s", path);
+        return nullptr;
+    }
+    off_t length = lseek(fd, 0, SEEK_END);
+    Vocabulary* vocab = length > 0 ? openFd(fd, 0, length) : nullptr;
+    close(fd);
+    return vocab;
+}
+
+Vocabulary* Vocabulary::openFd(int fd, int64_t offset, int64_t length) {
+    // mmap offsets must be page-aligned; APK assets are only 4-byte aligned
+    int64_t page = sysconf(_SC_PAGESIZE);
+    int64_t aligned = offset - offset % page;
+    size_t mappedLength = (size_t)(length + (offset - aligned));
+    void* mapping = mmap(nullptr, mappedLength, PROT_READ, MAP_PRIVATE, fd, (off_t)aligned);
+    if (mapping == MAP_FAILED) {
+        LOGE("mmap of %lld vocabulary bytes failed", (long long)length);
+        return nullptr;
+    }
+    auto* vocab = new Vocabulary();
+    vocab->mapping_ = mapping;
+    vocab->mappingLength_ = mappedLength;
+    if (!vocab->bind(static_cast<const uint8_t*>(mapping) + (offset - aligned), (size_t)length)) {
+        delete vocab;
+        return nullptr;
+    }
+    return vocab;
+}
+
+Vocabulary* Vocabulary::fromMemory(const void* data, size_t length) {
+    auto* vocab = new Vocabulary();
+    if (!vocab->bind(data, length)) {
+        delete vocab;
+        return nullptr;
+    }
+    return vocab;
+}
+
+Vocabulary::~Vocabulary() {
+    if (mapping_ != nullptr) munmap(mapping_, mappingLength_);
+}
+
+bool Vocabulary::bind(const void* data, size_t length) {
+    auto* base = static_cast<const uint8_t*>(data);
+    if (length < sizeof(VocabHeader) || ((uintptr_t)base & 3) != 0) {
+        LOGE("Vocabulary too short or misaligned");
+        return false;
+    }
+    header_ = reinterpret_cast<const VocabHeader*>(base);
+    if (memcmp(header_->magic, VOCAB_MAGIC, sizeof(VOCAB_MAGIC)) != 0 || header_->version != VOCAB_VERSION) {
+        LOGE("Not a version %u vocabulary", VOCAB_VERSION);
+        return false;
+    }
+    uint32_t hashSize = header_->hashSize;
+    if (header_->count >= VOCAB_HASH_EMPTY || hashSize == 0 || (hashSize & (hashSize - 1)) != 0
+            || hashSize <= header_->count) {
+        LOGE("Bad vocabulary hash size %u", hashSize);
+        return false;
+    }
+    size_t needed = sizeof(VocabHeader) + ((size_t)header_->count + 1) * sizeof(uint32_t)
+            + (size_t)hashSize * sizeof(uint16_t) + header_->blobSize;
+    if (length < needed) {
+        LOGE("Vocabulary truncated: %zu of %zu bytes", length, needed);
+        return false;
+    }
+    offsets_ = reinterpret_cast<const uint32_t*>(base + sizeof(VocabHeader));
+    hash_ = reinterpret_cast<const uint16_t*>(offsets_ + header_->count + 1);
+    blob_ = reinterpret_cast<const uint8_t*>(hash_ + hashSize);
+    if (offsets_[header_->count] > header_->blobSize) {
+        LOGE("Vocabulary offsets exceed the blob");
+        return false;
+    }
+    LOGI("Vocabulary: %u tokens, %u blob bytes", header_->count, header_->blobSize);
+    return true;
+}
+
+const uint8_t* Vocabulary::tokenBytes(int token, size_t* length) const {
+    if (token < 0 || (uint32_t)token >= header_->count) {
+        *length = 0;
+        return nullptr;
+    }
+    *length = offsets_[token + 1] - offsets_[token];
+    return blob_ + offsets_[token];
+}
+
+int Vocabulary::lookup(const uint8_t* bytes, size_t length) const {
+    uint32_t mask = header_->hashSize - 1;
+    for (uint32_t slot = vocabHash(bytes, length) & mask;; slot = (slot + 1) & mask) {
+        uint16_t token = hash_[slot];
+        if (token == VOCAB_HASH_EMPTY) return -1;
+        if (token < header_->count && offsets_[token + 1] - offsets_[token] == length
+                && memcmp(blob_ + offsets_[token], bytes, length) == 0) {
+            return (int)token;
+        }
+    }
+}
+
+size_t Vocabulary::decode(const int32_t* tokens, int numTokens, uint8_t* out, size_t capacity) const {
+    size_t total = 0;
+    for (int i = 0; i < numTokens; i++) {
+        size_t length;
+        const uint8_t* bytes = tokenBytes(tokens[i], &length);
+        if (bytes == nullptr) continue;
+        if (total < capacity) memcpy(out + total, bytes, length < capacity - total ? length : capacity - total);
+        total += length;
+    }
+    return total;
+}
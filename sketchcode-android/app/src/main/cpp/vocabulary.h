@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Memory-mapped byte-level BPE vocabulary (vocab.bin), read in place.
+ *
+ * Layout (little-endian, packed at build time from vocab.json by the packVocab
+ * Gradle task; every section 4-byte aligned):
+ *
+ *   VocabHeader
+ *   uint32 offsets[count + 1]    token id → byte range in blob
+ *   uint16 hash[hashSize]        open-addressing table of token ids keyed by their
+ *                                bytes (FNV-1a, linear probing, VOCAB_HASH_EMPTY = free)
+ *   uint8  blob[blobSize]        token bytes, already mapped back through GPT-2's
+ *                                bytes_to_unicode(), i.e. raw UTF-8 fragments
+ *
+ * Token → bytes is two offset reads and bytes → token one probe sequence; nothing
+ * is allocated after the file is mapped. Special tokens (>= count) are not stored.
+ */
+
+static constexpr char VOCAB_MAGIC[4] = { 'W', 'V', 'O', 'C' };
+static constexpr uint32_t VOCAB_VERSION = 1;
+static constexpr uint16_t VOCAB_HASH_EMPTY = 0xFFFF;   // so count < 65535
+
+struct VocabHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;       // token ids [0, count)
+    uint32_t hashSize;    // power of two, at least twice count
+    uint32_t blobSize;
+};
+
+/** FNV-1a over the token bytes; the packer uses the same function. */
+static inline uint32_t vocabHash(const uint8_t* bytes, size_t length) {
+    uint32_t h = 0x811C9DC5u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= bytes[i];
+        h *= 0x01000193u;
+    }
+    return h;
+}
+
+class Vocabulary {
+public:
+    /** Map a vocab.bin file; nullptr (and a log line) if it is missing or malformed. */
+    static Vocabulary* open(const char* path);
+
+    /** Map length bytes at offset of an open descriptor (an uncompressed APK asset). */
+    static Vocabulary* openFd(int fd, int64_t offset, int64_t length);
+
+    /** Wrap bytes that stay valid for the vocabulary's lifetime; not unmapped. */
+    static Vocabulary* fromMemory(const void* data, size_t length);
+
+    ~Vocabulary();
+
+    Vocabulary(const Vocabulary&) = delete;
+    Vocabulary& operator=(const Vocabulary&) = delete;
+
+    int count() const { return (int)header_->count; }
+
+    /** Bytes of a token, or nullptr with length 0 for ids outside the table. */
+    const uint8_t* tokenBytes(int token, size_t* length) const;
+
+    /** Token whose bytes are exactly [bytes, bytes + length), or -1. */
+    int lookup(const uint8_t* bytes, size_t length) const;
+
+    /**
+     * Concatenate the bytes of the text tokens (< count) among tokens[0, numTokens);
+     * specials are skipped. Writes at most capacity bytes; returns the full length.
+     */
+    size_t decode(const int32_t* tokens, int numTokens, uint8_t* out, size_t capacity) const;
+
+private:
+    Vocabulary() = default;
+    bool bind(const void* data, size_t length);
+
+    void* mapping_ = nullptr;      // munmap() target, if we mapped it
+    size_t mappingLength_ = 0;
+    const VocabHeader* header_ = nullptr;
+    const uint32_t* offsets_ = nullptr;
+    const uint16_t* hash_ = nullptr;
+    const uint8_t* blob_ = nullptr;
+};
@@ -0,0 +1,95 @@
+#include <jni.h>
+#include <android/asset_manager_jni.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "vocabulary.h"
+
+#define LOG_TAG "WhisperVocabulary"
+#include "native_log.h"
+
+// ---- JNI Entry Points ----
+// The Kotlin Vocabulary owns a mapped vocab.bin through an opaque jlong handle. The
+// asset is stored uncompressed (noCompress "bin"), so it is mapped straight from the
+// APK file rather than read into the heap.
+
+static inline Vocabulary* fromHandle(jlong handle) {
+    return reinterpret_cast<Vocabulary*>(handle);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_sketchcode_app_whisper_Vocabulary_nativeOpenAsset(
+        JNIEnv *env, jobject /* this */, jobject assetManager, jstring name) {
+    AAssetManager* manager = AAssetManager_fromJava(env, assetManager);
+    const char* assetName = env->GetStringUTFChars(name, nullptr);
+    AAsset* asset = manager != nullptr ? AAssetManager_open(manager, assetName, AASSET_MODE_RANDOM) : nullptr;
+    Vocabulary* vocab = nullptr;
+    if (asset == nullptr) {
+        LOGE("Asset %s not found", assetName);
+    } else {
+        off64_t start = 0, length = 0;
+        int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+        if (fd >= 0) {
+            vocab = Vocabulary::openFd(fd, start, length);
+            close(fd);
+        } else {
+            LOGE("Asset %s is compressed; it must be packaged with noCompress to be mapped", assetName);
+        }
+        AAsset_close(asset);
+    }
+    env->ReleaseStringUTFChars(name, assetName);
+    return reinterpret_cast<jlong>(vocab);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_sketchcode_app_whisper_Vocabulary_nativeDestroy(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    delete fromHandle(handle);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_Vocabulary_nativeCount(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    return fromHandle(handle)->count();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_sketchcode_app_whisper_Vocabulary_nativeLookup(
+        JNIEnv *env, jobject /* this */, jlong handle, jbyteArray bytes) {
+    jsize length = env->GetArrayLength(bytes);
+    auto* data = static_cast<uint8_t*>(env->GetPrimitiveArrayCritical(bytes, nullptr));
+    if (data == nullptr) return -1;
+    int token = fromHandle(handle)->lookup(data, (size_t)length);
+    env->ReleasePrimitiveArrayCritical(bytes, data, JNI_ABORT);
+    return token;
+}
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_com_sketchcode_app_whisper_Vocabulary_nativeDecode(
+        JNIEnv *env, jobject /* this */, jlong handle, jintArray tokens, jint numTokens) {
+    Vocabulary* vocab = fromHandle(handle);
+    numTokens = std::min(numTokens, env->GetArrayLength(tokens));
+    auto* ids = static_cast<int32_t*>(env->GetPrimitiveArrayCritical(tokens, nullptr));
+    if (ids == nullptr) return nullptr;
+    // A transcript fits the stack buffer; the second pass only runs for longer ones
+    uint8_t stackBytes[2048];
+    size_t length = vocab->decode(ids, numTokens, stackBytes, sizeof(stackBytes));
+    std::vector<uint8_t> heapBytes;
+    if (length > sizeof(stackBytes)) {
+        heapBytes.resize(length);
+        vocab->decode(ids, numTokens, heapBytes.data(), length);
+    }
+    env->ReleasePrimitiveArrayCritical(tokens, ids, JNI_ABORT);
+
+    jbyteArray out = env->NewByteArray((jsize)length);
+    if (out != nullptr) {
+        const uint8_t* bytes = heapBytes.empty() ? stackBytes : heapBytes.data();
+        env->SetByteArrayRegion(out, 0, (jsize)length, reinterpret_cast<const jbyte*>(bytes));
+    }
+    return out;
+}
@@ -3,8 +3,15 @@ package com.sketchcode.app.service
 import android.content.Context
 import android.util.Log
 import com.sketchcode.app.whisper.AudioCapture
+import com.sketchcode.app.whisper.CancellationToken
+import com.sketchcode.app.whisper.CaptureRecorder
+import com.sketchcode.app.whisper.KeywordSpotter
+import com.sketchcode.app.whisper.MelQuantization
 import com.sketchcode.app.whisper.MelSpectrogram
+import com.sketchcode.app.whisper.MelStream
 import com.sketchcode.app.whisper.ModelManager
+import com.sketchcode.app.whisper.NativeArena
+import com.sketchcode.app.whisper.TranscriptionQueue
 import com.sketchcode.app.whisper.WhisperInference
 import com.sketchcode.app.whisper.WhisperTokenizer
 import kotlinx.coroutines.CoroutineScope
@@ -12,9 +19,39 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.SupervisorJob
 import kotlinx.coroutines.cancel
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.SharedFlow
 import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asSharedFlow
 import kotlinx.coroutines.flow.asStateFlow
+import java.io.File
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Voice pipeline options from the settings menu, persisted across launches. Each one
+ * applies from the next recording on.
+ */
+data class VoiceSettings(
+    /** Run native noise suppression on the spectrogram before inference. */
+    val noiseSuppression: Boolean = false,
+    /** Capture both microphones and beamform them natively (falls back to mono if unsupported). */
+    val stereoBeamforming: Boolean = false,
+    /**
+     * Re-transcribe the last 30 s every few seconds while recording and show it as
+     * interim text. Interim passes are greedy and skip noise suppression; the final
+     * transcription on stop() is unaffected.
+     */
+    val liveTranscription: Boolean = true,
+    /** Decoder beam width: 1 is greedy, 2–5 runs beam search (better identifiers, slower decode). */
+    val beamSize: Int = 1,
+    /**
+     * Opt-in: append every utterance and its stage timings to a replayable capture file
+     * ({externalFilesDir}/captures/utterances.wmcap) for offline latency reproduction.
+     */
+    val captureRecording: Boolean = false
+)
 
 data class VoiceState(
     val isRecording: Boolean = false,
@@ -36,19 +73,103 @@ data class VoiceState(
 class VoiceRecorderService(private val context: Context) {
     companion object {
         private const val TAG = "VoiceRecorder"
+        // Most frequent identifiers of the file on screen that get a logit boost
+        private const val MAX_BIAS_IDENTIFIERS = 256
+        // Stopped recordings that may wait for transcription before stop() refuses more,
+        // plus the one interim pass that may be in flight while recording
+        private const val MAX_PENDING_UTTERANCES = 4
+        // Audio between interim transcriptions of the live window
+        private const val INTERIM_INTERVAL_SECONDS = 2f
+        private const val N_MELS = 128
+        private const val N_FRAMES = 3000
+        const val MAX_BEAM_SIZE = 5
+
+        private const val PREFS_NAME = "voice_settings"
+        private const val PREF_NOISE_SUPPRESSION = "noise_suppression"
+        private const val PREF_STEREO_BEAMFORMING = "stereo_beamforming"
+        private const val PREF_LIVE_TRANSCRIPTION = "live_transcription"
+        private const val PREF_BEAM_SIZE = "beam_size"
+        private const val PREF_CAPTURE_RECORDING = "capture_recording"
     }
 
     private val _state = MutableStateFlow(VoiceState())
     val state: StateFlow<VoiceState> = _state.asStateFlow()
 
+    // Voice commands recognized by the keyword spotter (KeywordSpotter.CMD_*), bypassing Whisper
+    private val _commands = MutableSharedFlow<Int>(extraBufferCapacity = 4)
+    val commands: SharedFlow<Int> = _commands.asSharedFlow()
+
     private val scope = CoroutineScope(Dispatchers.Default + SupervisorJob())
     private val modelManager = ModelManager(context)
     private val audioCapture = AudioCapture()
     private var melSpectrogram: MelSpectrogram? = null
+    private var melStream: MelStream? = null
+    // Native scratch of the front-end thread, reset after each utterance's front end
+    private var frontEndArena: NativeArena? = null
+    private var keywordSpotter: KeywordSpotter? = null
     private var tokenizer: WhisperTokenizer? = null
     private var inference: WhisperInference? = null
+    private var queue: TranscriptionQueue? = null
     private var isInitialized = false
 
+    private val prefs = context.getSharedPreferences(PREFS_NAME, Context.MODE_PRIVATE)
+    private val _settings = MutableStateFlow(loadSettings())
+    val settings: StateFlow<VoiceSettings> = _settings.asStateFlow()
+
+    private val captureRecorder by lazy {
+        CaptureRecorder(File(File(context.getExternalFilesDir(null), "captures"), "utterances.wmcap"))
+    }
+
+    // Prompt tokens from the identifiers of the file on screen, rebuilt when it changes
+    @Volatile
+    private var codeContext: String? = null
+    @Volatile
+    private var contextTokens = IntArray(0)
+
+    // When set, the next recording is enrolled as a template for this command instead of transcribed
+    @Volatile
+    private var enrollingCommand: Int? = null
+
+    /**
+     * One stopped recording on its way through [queue]: the settings it was recorded
+     * under, plus the timings and text the stages fill in. [cancel] aborts its mel and
+     * decoder loops mid-run; it is released when the job completes.
+     *
+     * An interim pass carries a snapshot of the live mel window in [interimMel] instead
+     * of audio: it skips the front end's mel and voice commands and only updates the
+     * interim text.
+     */
+    private class Utterance(
+        val audio: FloatArray,
+        val channels: Int,
+        val suppressNoise: Boolean,
+        val beamSize: Int,
+        val contextTokens: IntArray,
+        val enrollCommand: Int?,
+        val interimMel: FloatArray? = null
+    ) {
+        val startTime = System.currentTimeMillis()
+        val cancel = CancellationToken()
+        @Volatile var melTime = 0L
+        @Volatile var encoderMs = 0L
+        // Mel front end as run, for the capture record
+        @Volatile var melBucketFrames = 0
+        @Volatile var melQuantization: MelQuantization? = null
+        @Volatile var text: String? = null
+    }
+
+    private val utterances = ConcurrentHashMap<Long, Utterance>()
+    private val nextJobId = AtomicLong()
+
+    // Live window snapshot, reused: at most one interim pass is in flight (interimJobId, 0 if none)
+    private val interimMel = FloatArray(N_MELS * N_FRAMES)
+    private var monoChunk = FloatArray(0)
+    @Volatile
+    private var interimJobId = 0L
+    // Cleared first thing in stop(): buffers the capture thread delivers after that queue no interim pass
+    @Volatile
+    private var interimOpen = false
+
     init {
         Log.i(TAG, "VoiceRecorderService init — checking models...")
         val modelsReady = modelManager.areModelsReady()
@@ -68,11 +189,21 @@ class VoiceRecorderService(private val context: Context) {
                 try {
                     Log.i(TAG, "Initializing MelSpectrogram...")
                     melSpectrogram = MelSpectrogram()
+                    melStream = MelStream(INTERIM_INTERVAL_SECONDS)
+                    frontEndArena = NativeArena()
+                    keywordSpotter = KeywordSpotter(File(context.filesDir, "keyword_templates.bin"))
                     Log.i(TAG, "Initializing WhisperTokenizer...")
                     tokenizer = WhisperTokenizer(context)
                     Log.i(TAG, "Initializing WhisperInference...")
                     inference = WhisperInference(modelManager, tokenizer!!)
                     inference!!.initialize()
+                    codeContext?.let { updateContextTokens(it) }
+                    queue = TranscriptionQueue(MAX_PENDING_UTTERANCES, WhisperInference.ENCODER_SLOTS,
+                        object : TranscriptionQueue.Stages {
+                            override fun frontEnd(jobId: Long, slot: Int) = this@VoiceRecorderService.frontEnd(jobId, slot)
+                            override fun decode(jobId: Long, slot: Int) = this@VoiceRecorderService.decode(jobId, slot)
+                            override fun onComplete(jobId: Long, status: Int) = this@VoiceRecorderService.onComplete(jobId, status)
+                        })
                     isInitialized = true
                     _state.value = _state.value.copy(interimText = "")
                     Log.i(TAG, "Whisper pipeline initialized successfully")
@@ -87,6 +218,38 @@ class VoiceRecorderService(private val context: Context) {
         }
     }
 
+    /**
+     * Condition transcription on the code on screen: its most frequent identifiers become
+     * Whisper's previous-text prompt, and a partially decoded identifier gets its
+     * continuation boosted, so names like getUserById come out spelled as in the file.
+     * Cheap to call on every code update; encoding runs natively off the UI thread.
+     */
+    fun setCodeContext(code: String?) {
+        if (code == codeContext) return
+        codeContext = code
+        if (code == null) {
+            contextTokens = IntArray(0)
+            inference?.setContextIdentifiers(emptyMap())
+            return
+        }
+        scope.launch { updateContextTokens(code) }
+    }
+
+    private fun updateContextTokens(code: String) {
+        val encoder = tokenizer ?: return
+        val whisper = inference ?: return
+        val start = System.nanoTime()
+        val identifiers = encoder.identifiers(code)
+        val tokens = encoder.identifierPrompt(identifiers, WhisperInference.MAX_CONTEXT_TOKENS)
+        val biased = identifiers.take(MAX_BIAS_IDENTIFIERS).associateWith { encoder.encode(" $it") }
+        // A newer update may have landed while this one was encoding
+        if (code != codeContext) return
+        contextTokens = tokens
+        whisper.setContextIdentifiers(biased)
+        Log.i(TAG, "Code context: ${tokens.size} prompt tokens, ${biased.size} biased identifiers " +
+                "in ${(System.nanoTime() - start) / 1000}us")
+    }
+
     fun toggle() {
         if (_state.value.isRecording) {
             stop()
@@ -113,8 +276,14 @@ class VoiceRecorderService(private val context: Context) {
             return
         }
 
+        // A new recording replaces the transcription, so earlier utterances still in
+        // flight would only be thrown away: stop them now instead of after 200 steps
+        cancelTranscription()
+
         try {
-            audioCapture.start()
+            melStream?.reset()
+            interimOpen = true
+            audioCapture.start(stereo = _settings.value.stereoBeamforming, onAudio = ::onAudio)
             _state.value = _state.value.copy(
                 transcription = "",
                 interimText = "Listening...",
@@ -130,91 +299,301 @@ class VoiceRecorderService(private val context: Context) {
         }
     }
 
+    /**
+     * Record one example of a voice command (KeywordSpotter.CMD_*). The next stop()
+     * enrolls the clip as a template instead of transcribing it.
+     */
+    fun startEnrollment(commandId: Int) {
+        enrollingCommand = commandId
+        start()
+        if (!_state.value.isRecording) {
+            enrollingCommand = null
+            return
+        }
+        _state.value = _state.value.copy(interimText = "Say the command once, then stop")
+    }
+
+    /**
+     * Feed each recorded chunk into the live mel window, on the recording thread. Every
+     * [INTERIM_INTERVAL_SECONDS] of audio, the window is queued for an interim pass
+     * unless the previous one is still running.
+     */
+    private fun onAudio(chunk: FloatArray, count: Int) {
+        val stream = melStream ?: return
+        var samples = chunk
+        var n = count
+        if (audioCapture.channelCount == 2) {
+            // Interim passes are mono: average the interleaved microphones
+            n = count / 2
+            if (monoChunk.size < n) monoChunk = FloatArray(n)
+            for (i in 0 until n) monoChunk[i] = 0.5f * (chunk[2 * i] + chunk[2 * i + 1])
+            samples = monoChunk
+        }
+        val due = stream.push(samples, n)
+        if (!due || !interimOpen || !_settings.value.liveTranscription || enrollingCommand != null || interimJobId != 0L) return
+        if (stream.snapshot(interimMel) <= 0) return
+
+        val utterance = Utterance(FloatArray(0), 1, false, 1, contextTokens, null, interimMel)
+        val jobId = nextJobId.incrementAndGet()
+        utterances[jobId] = utterance
+        interimJobId = jobId
+        if (queue?.submit(jobId) != true) {
+            utterances.remove(jobId)
+            utterance.cancel.release()
+            interimJobId = 0L
+            return
+        }
+        // stop() ran since the check above and may have missed this job: cancel it here
+        if (!interimOpen) cancelInterim(jobId)
+    }
+
+    private fun cancelInterim(jobId: Long) {
+        utterances[jobId]?.cancel?.cancel()
+        queue?.cancel(jobId)
+    }
+
     fun stop() {
         if (!_state.value.isRecording) return
 
+        // The final transcription supersedes the interim pass still in flight, and no
+        // later one may start from buffers still on their way from the capture thread
+        interimOpen = false
+        val interimJob = interimJobId
+        if (interimJob != 0L) cancelInterim(interimJob)
+
         _state.value = _state.value.copy(
             isRecording = false,
             interimText = "Processing..."
         )
 
-        // Move ENTIRE pipeline (including audioCapture.stop()) off the UI thread.
-        // audioCapture.stop() calls recordingThread.join(2000) which blocks,
-        // and the subsequent mel + inference are heavy compute.
+        // audioCapture.stop() calls recordingThread.join(2000), which blocks: stop the
+        // capture off the UI thread, then hand the utterance to the transcription queue.
         scope.launch {
+            // Step 0: Stop recording and get audio (blocks until recording thread finishes)
+            Log.i(TAG, "Stopping audio capture...")
+            val audio: FloatArray
             try {
-                // Step 0: Stop recording and get audio (blocks until recording thread finishes)
-                Log.i(TAG, "Stopping audio capture...")
-                val audio: FloatArray
-                try {
-                    audio = audioCapture.stop()
-                } catch (e: Exception) {
-                    Log.e(TAG, "audioCapture.stop() crashed: ${e.message}", e)
-                    _state.value = _state.value.copy(
-                        interimText = "",
-                        error = "Audio stop failed: ${e.message}"
-                    )
-                    return@launch
-                }
-                Log.i(TAG, "Recording stopped, ${audio.size} samples (${audio.size / 16000f}s)")
-
-                if (audio.isEmpty()) {
-                    _state.value = _state.value.copy(
-                        interimText = "",
-                        error = "No audio captured"
-                    )
-                    return@launch
-                }
+                audio = audioCapture.stop()
+            } catch (e: Exception) {
+                Log.e(TAG, "audioCapture.stop() crashed: ${e.message}", e)
+                _state.value = _state.value.copy(
+                    interimText = "",
+                    error = "Audio stop failed: ${e.message}"
+                )
+                return@launch
+            }
+            val channels = audioCapture.channelCount
+            Log.i(TAG, "Recording stopped, ${audio.size} samples (${audio.size / (16000f * channels)}s, $channels ch)")
 
-                val startTime = System.currentTimeMillis()
+            if (audio.isEmpty()) {
+                _state.value = _state.value.copy(
+                    interimText = "",
+                    error = "No audio captured"
+                )
+                return@launch
+            }
 
-                // Step 1: Compute mel spectrogram (C++ JNI)
-                Log.i(TAG, "Computing mel spectrogram for ${audio.size} samples...")
-                val mel: FloatArray
-                try {
-                    mel = melSpectrogram!!.compute(audio)
-                } catch (e: Exception) {
-                    Log.e(TAG, "Mel spectrogram crashed: ${e.message}", e)
-                    _state.value = _state.value.copy(
-                        interimText = "",
-                        error = "Mel spectrogram failed: ${e.message}"
-                    )
-                    return@launch
-                }
-                val melTime = System.currentTimeMillis() - startTime
-                Log.i(TAG, "Mel spectrogram: ${melTime}ms, output size=${mel.size}")
+            val enrollCommand = enrollingCommand
+            enrollingCommand = null
+            val settings = _settings.value
+            val utterance = Utterance(audio, channels, settings.noiseSuppression, settings.beamSize, contextTokens, enrollCommand)
+            val jobId = nextJobId.incrementAndGet()
+            utterances[jobId] = utterance
+            if (queue?.submit(jobId) != true) {
+                utterances.remove(jobId)
+                Log.w(TAG, "Transcription queue full, dropping utterance")
+                _state.value = _state.value.copy(
+                    interimText = if (utterances.isEmpty()) "" else _state.value.interimText,
+                    error = "Still transcribing earlier notes"
+                )
+            }
+        }
+    }
 
-                // Step 2: Run encoder + decoder (ONNX Runtime QNN)
-                Log.i(TAG, "Running Whisper inference...")
-                val text: String
-                try {
-                    text = inference!!.transcribe(mel)
-                } catch (e: Exception) {
-                    Log.e(TAG, "Whisper inference crashed: ${e.message}", e)
-                    _state.value = _state.value.copy(
-                        interimText = "",
-                        error = "Inference failed: ${e.message}"
-                    )
-                    return@launch
+    /**
+     * Front end of one utterance, on the queue's front-end thread: mel, voice commands
+     * and enrollment, then the encoder into [slot]. Runs while the previous utterance
+     * may still be decoding.
+     */
+    private fun frontEnd(jobId: Long, slot: Int): Int {
+        val u = utterances[jobId] ?: return TranscriptionQueue.CANCELLED
+        if (u.interimMel != null) {
+            return try {
+                u.encoderMs = inference!!.encode(u.interimMel, slot, u.cancel)
+                if (u.cancel.isCancelled) TranscriptionQueue.CANCELLED else TranscriptionQueue.CONTINUE
+            } catch (e: Exception) {
+                Log.e(TAG, "Interim encoder crashed: ${e.message}", e)
+                TranscriptionQueue.FAILED
+            }
+        }
+        try {
+            // Step 1: Compute mel spectrogram (C++ JNI), trimmed to what the encoders can take
+            Log.i(TAG, "Computing mel spectrogram for ${u.audio.size} samples...")
+            // A quantized encoder's input is written in the same pass
+            val bucketFrames = inference!!.melBucketFrames
+            val quantization = inference!!.melQuantization
+            val quantizedOut = inference!!.quantizedMelInput
+            val mel = try {
+                if (u.channels == 2) {
+                    melSpectrogram!!.computeStereo(u.audio, u.suppressNoise, u.cancel, bucketFrames, quantization,
+                        quantizedOut, frontEndArena)
+                } else {
+                    melSpectrogram!!.compute(u.audio, u.suppressNoise, u.cancel, bucketFrames, quantization,
+                        quantizedOut, frontEndArena)
                 }
-                val totalTime = System.currentTimeMillis() - startTime
-                Log.i(TAG, "Total transcription: ${totalTime}ms → \"$text\"")
+            } catch (e: Exception) {
+                Log.e(TAG, "Mel spectrogram crashed: ${e.message}", e)
+                _state.value = _state.value.copy(error = "Mel spectrogram failed: ${e.message}")
+                return TranscriptionQueue.FAILED
+            } ?: return TranscriptionQueue.CANCELLED
+            u.melTime = System.currentTimeMillis() - u.startTime
+            u.melBucketFrames = bucketFrames
+            u.melQuantization = if (quantizedOut != null) quantization else null
+            Log.i(TAG, "Mel spectrogram: ${u.melTime}ms, ${MelSpectrogram.frames(mel)} frames, " +
+                "native scratch high-water ${(frontEndArena?.stats?.highWater ?: 0L) / 1024} KB")
 
-                // Update state with result
-                val current = _state.value.transcription
-                val combined = if (current.isEmpty()) text else "$current $text"
+            val melFrames = KeywordSpotter.framesForSamples(u.audio.size / u.channels)
+            if (u.enrollCommand != null) {
+                val enrolled = keywordSpotter?.enroll(u.enrollCommand, mel, melFrames) == true
+                Log.i(TAG, "Enrollment for command ${u.enrollCommand}: ${if (enrolled) "ok" else "failed"}")
                 _state.value = _state.value.copy(
-                    transcription = combined.trim(),
-                    interimText = ""
+                    error = if (enrolled) null else "Enrollment failed: say the command clearly"
                 )
+                return TranscriptionQueue.HANDLED
+            }
+
+            // Step 1b: Short control phrases are matched natively and skip Whisper entirely
+            val spotter = keywordSpotter
+            if (spotter != null && spotter.hasTemplates) {
+                val command = spotter.match(mel, melFrames)
+                if (command != KeywordSpotter.NO_COMMAND) {
+                    val kwsTime = System.currentTimeMillis() - u.startTime
+                    Log.i(TAG, "Voice command $command recognized in ${kwsTime}ms, skipping Whisper")
+                    _commands.tryEmit(command)
+                    return TranscriptionQueue.HANDLED
+                }
+            }
+            if (u.cancel.isCancelled) return TranscriptionQueue.CANCELLED
+
+            // Step 2: Encoder (ONNX Runtime QNN) into this job's slot
+            u.encoderMs = inference!!.encode(mel, slot, u.cancel, melQuantized = quantizedOut != null)
+            return if (u.cancel.isCancelled) TranscriptionQueue.CANCELLED else TranscriptionQueue.CONTINUE
+        } catch (e: Exception) {
+            Log.e(TAG, "Whisper encoder crashed: ${e.message}", e)
+            _state.value = _state.value.copy(error = "Inference failed: ${e.message}")
+            return TranscriptionQueue.FAILED
+        } finally {
+            frontEndArena?.reset()
+        }
+    }
+
+    /** Decoder of one utterance, on the queue's decode thread. */
+    private fun decode(jobId: Long, slot: Int): Int {
+        val u = utterances[jobId] ?: return TranscriptionQueue.CANCELLED
+        val whisper = inference ?: return TranscriptionQueue.FAILED
+        if (u.interimMel != null) {
+            return try {
+                // One greedy attempt: a fallback re-decode would outlast the next snapshot
+                val text = whisper.decode(slot, 1, u.contextTokens, null, u.cancel, maxAttempts = 1)
+                if (u.cancel.isCancelled) return TranscriptionQueue.CANCELLED
+                if (text.isNotEmpty() && _state.value.isRecording) {
+                    _state.value = _state.value.copy(interimText = text)
+                }
+                TranscriptionQueue.HANDLED
             } catch (e: Exception) {
-                Log.e(TAG, "Transcription pipeline failed: ${e.message}", e)
-                _state.value = _state.value.copy(
-                    interimText = "",
-                    error = "Transcription failed: ${e.message}"
+                Log.e(TAG, "Interim decode crashed: ${e.message}", e)
+                TranscriptionQueue.FAILED
+            }
+        }
+        try {
+            // Step 3: Decoder, streaming the transcript into interimText as it is produced
+            Log.i(TAG, "Running Whisper decoder...")
+            val text = whisper.decode(slot, u.beamSize, u.contextTokens, { partial ->
+                if (partial.isNotEmpty()) _state.value = _state.value.copy(interimText = partial)
+            }, u.cancel)
+            if (u.cancel.isCancelled) return TranscriptionQueue.CANCELLED
+            val totalTime = System.currentTimeMillis() - u.startTime
+            Log.i(TAG, "Total transcription: ${totalTime}ms → \"$text\"")
+
+            if (_settings.value.captureRecording) {
+                captureRecorder.append(
+                    u.audio, u.channels, u.suppressNoise,
+                    u.melTime, u.encoderMs, whisper.lastDecoderMs, totalTime,
+                    whisper.lastTokenCount, u.melBucketFrames, u.melQuantization
                 )
             }
+            u.text = text
+            return TranscriptionQueue.DONE
+        } catch (e: Exception) {
+            Log.e(TAG, "Whisper inference crashed: ${e.message}", e)
+            _state.value = _state.value.copy(error = "Inference failed: ${e.message}")
+            return TranscriptionQueue.FAILED
+        }
+    }
+
+    /** Completion of one utterance, in submission order for decoded ones. */
+    private fun onComplete(jobId: Long, status: Int) {
+        val u = utterances.remove(jobId) ?: return
+        u.cancel.release()
+        if (u.interimMel != null) {
+            interimJobId = 0L
+            if (status == TranscriptionQueue.CANCELLED) Log.i(TAG, "Interim pass $jobId cancelled")
+            return
         }
+        val interim = when {
+            _state.value.isRecording -> _state.value.interimText
+            utterances.isEmpty() -> ""
+            else -> "Processing..."
+        }
+        val text = u.text
+        if (status == TranscriptionQueue.DONE && text != null) {
+            // Update state with result
+            val current = _state.value.transcription
+            val combined = if (current.isEmpty()) text else "$current $text"
+            _state.value = _state.value.copy(
+                transcription = combined.trim(),
+                interimText = interim
+            )
+        } else {
+            if (status == TranscriptionQueue.CANCELLED) Log.i(TAG, "Utterance $jobId cancelled")
+            _state.value = _state.value.copy(interimText = interim)
+        }
+    }
+
+    /**
+     * Abort every utterance still being transcribed: queued ones are skipped, and a
+     * running mel or decode stops within one frame or decoder step. Returns at once;
+     * the aborted jobs complete as cancelled on the queue's threads.
+     */
+    fun cancelTranscription() {
+        for ((jobId, u) in utterances) {
+            u.cancel.cancel()
+            queue?.cancel(jobId)
+        }
+    }
+
+    /** Apply and persist new settings; the beam width is clamped to 1..MAX_BEAM_SIZE. */
+    fun updateSettings(settings: VoiceSettings) {
+        val applied = settings.copy(beamSize = settings.beamSize.coerceIn(1, MAX_BEAM_SIZE))
+        _settings.value = applied
+        prefs.edit()
+            .putBoolean(PREF_NOISE_SUPPRESSION, applied.noiseSuppression)
+            .putBoolean(PREF_STEREO_BEAMFORMING, applied.stereoBeamforming)
+            .putBoolean(PREF_LIVE_TRANSCRIPTION, applied.liveTranscription)
+            .putInt(PREF_BEAM_SIZE, applied.beamSize)
+            .putBoolean(PREF_CAPTURE_RECORDING, applied.captureRecording)
+            .apply()
+    }
+
+    private fun loadSettings(): VoiceSettings {
+        val defaults = VoiceSettings()
+        return VoiceSettings(
+            noiseSuppression = prefs.getBoolean(PREF_NOISE_SUPPRESSION, defaults.noiseSuppression),
+            stereoBeamforming = prefs.getBoolean(PREF_STEREO_BEAMFORMING, defaults.stereoBeamforming),
+            liveTranscription = prefs.getBoolean(PREF_LIVE_TRANSCRIPTION, defaults.liveTranscription),
+            beamSize = prefs.getInt(PREF_BEAM_SIZE, defaults.beamSize).coerceIn(1, MAX_BEAM_SIZE),
+            captureRecording = prefs.getBoolean(PREF_CAPTURE_RECORDING, defaults.captureRecording)
+        )
     }
 
     fun clearTranscription() {
@@ -223,7 +602,14 @@ class VoiceRecorderService(private val context: Context) {
 
     fun destroy() {
         audioCapture.release()
+        // Abort the running stages, then wait for them before the models go
+        cancelTranscription()
+        queue?.release()
+        melStream?.release()
+        frontEndArena?.release()
         inference?.release()
+        tokenizer?.release()
+        keywordSpotter?.release()
         scope.cancel()
         Log.i(TAG, "VoiceRecorderService destroyed")
     }
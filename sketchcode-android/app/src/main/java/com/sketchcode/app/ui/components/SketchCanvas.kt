@@ -156,6 +156,19 @@ class SketchCanvasView @JvmOverloads constructor(
         onStrokesChanged?.invoke()
     }
 
+    /** Remove the last stroke of the current file */
+    fun undoStroke() {
+        if (strokes.isEmpty()) return
+        strokes.removeAt(strokes.size - 1)
+        currentStroke = null
+        // Keep the saved copy in step, or the stroke would come back on the next file switch
+        currentFile?.let {
+            if (strokes.isEmpty()) fileStrokes.remove(it) else fileStrokes[it] = strokes.toList()
+        }
+        invalidate()
+        onStrokesChanged?.invoke()
+    }
+
     /** Clear drawings for a specific file */
     fun clearFileStrokes(filename: String) {
         fileStrokes.remove(filename)
@@ -25,6 +25,7 @@ fun MainScreen(
     // Voice recorder (create once, tied to context)
     val voiceRecorder = remember { VoiceRecorderService(context) }
     val voiceState by voiceRecorder.state.collectAsStateWithLifecycle()
+    val voiceSettings by voiceRecorder.settings.collectAsStateWithLifecycle()
 
     // Request permissions
     val permissionLauncher = rememberLauncherForActivityResult(
@@ -40,6 +41,11 @@ fun MainScreen(
         )
     }
 
+    // Bias transcription towards the identifiers of the file on screen
+    LaunchedEffect(state.currentCode) {
+        voiceRecorder.setCodeContext(state.currentCode?.code)
+    }
+
     // Cleanup on dispose
     DisposableEffect(Unit) {
         onDispose { voiceRecorder.destroy() }
@@ -58,6 +64,10 @@ fun MainScreen(
             }
         }
         AppScreen.SKETCH -> {
+            // Leaving the sketch screen abandons the note being transcribed
+            DisposableEffect(Unit) {
+                onDispose { voiceRecorder.cancelTranscription() }
+            }
             SketchScreen(
                 codeUpdate = state.currentCode,
                 openFiles = state.openFiles,
@@ -74,6 +84,10 @@ fun MainScreen(
                 onVoiceToggle = { voiceRecorder.toggle() },
                 onClearTranscription = { voiceRecorder.clearTranscription() },
                 onDisconnect = { viewModel.disconnect() },
+                voiceCommands = voiceRecorder.commands,
+                onEnrollCommand = { command -> voiceRecorder.startEnrollment(command) },
+                voiceSettings = voiceSettings,
+                onVoiceSettingsChange = { settings -> voiceRecorder.updateSettings(settings) },
                 modifier = modifier
             )
         }
@@ -33,9 +33,13 @@ import androidx.compose.foundation.horizontalScroll
 import androidx.compose.foundation.rememberScrollState
 import com.sketchcode.app.network.CodeUpdate
 import com.sketchcode.app.network.OpenFileInfo
+import com.sketchcode.app.service.VoiceRecorderService
+import com.sketchcode.app.service.VoiceSettings
 import com.sketchcode.app.service.VoiceState
 import com.sketchcode.app.ui.components.DrawingTool
 import com.sketchcode.app.ui.components.SketchCanvasView
+import com.sketchcode.app.whisper.KeywordSpotter
+import kotlinx.coroutines.flow.Flow
 
 @Composable
 fun SketchScreen(
@@ -51,12 +55,18 @@ fun SketchScreen(
     onVoiceToggle: () -> Unit,
     onClearTranscription: () -> Unit,
     onDisconnect: () -> Unit,
+    voiceCommands: Flow<Int>,
+    onEnrollCommand: (Int) -> Unit,
+    voiceSettings: VoiceSettings,
+    onVoiceSettingsChange: (VoiceSettings) -> Unit,
     modifier: Modifier = Modifier
 ) {
     var currentTool by remember { mutableStateOf(DrawingTool.PEN) }
     var penColor by remember { mutableIntStateOf(AndroidColor.RED) }
     // Track whether current file has drawings (for enabling Send button reactively)
     var hasDrawings by remember { mutableStateOf(false) }
+    var enrollMenuOpen by remember { mutableStateOf(false) }
+    var settingsMenuOpen by remember { mutableStateOf(false) }
 
     // Native view references
     var sketchViewRef by remember { mutableStateOf<SketchCanvasView?>(null) }
@@ -76,6 +86,86 @@ fun SketchScreen(
         }
     }
 
+    val canSend = !isSending && codeUpdate != null && (hasDrawings || voiceState.transcription.isNotEmpty())
+
+    // Captures all annotated files (or the current one for a voice-only note) and sends them
+    fun sendAll() {
+        val sketch = sketchViewRef
+        val frame = innerFrameRef
+        val codeTextView = frame?.findViewWithTag<TextView>("codeText")
+        if (sketch != null && frame != null && codeTextView != null) {
+            val annotatedFiles = sketch.getAnnotatedFiles()
+            val captures = mutableListOf<Pair<Bitmap, String>>()
+
+            if (annotatedFiles.isNotEmpty()) {
+                // Save the original code text so we can restore it
+                val originalText = codeTextView.text.toString()
+                val originalFile = activeFile
+
+                for (filename in annotatedFiles) {
+                    // Switch canvas to this file's strokes
+                    sketch.switchToFile(filename)
+
+                    // Set the code text to this file's content
+                    val cached = codeCache[filename]
+                    if (cached != null) {
+                        val lines = cached.code.split("\n")
+                        val padWidth = lines.size.toString().length
+                        val numbered = lines.mapIndexed { i, line ->
+                            "${(i + 1).toString().padStart(padWidth)}  $line"
+                        }.joinToString("\n")
+                        codeTextView.text = numbered
+                    }
+
+                    // Force layout so the view dimensions are correct
+                    frame.measure(
+                        android.view.View.MeasureSpec.makeMeasureSpec(frame.width, android.view.View.MeasureSpec.EXACTLY),
+                        android.view.View.MeasureSpec.makeMeasureSpec(0, android.view.View.MeasureSpec.UNSPECIFIED)
+                    )
+                    frame.layout(frame.left, frame.top, frame.right, frame.top + frame.measuredHeight)
+
+                    val bitmap = captureFullContent(frame, sketch)
+                    if (bitmap != null) {
+                        captures.add(Pair(bitmap, filename))
+                    }
+
+                    // Clear this file's strokes after capture
+                    sketch.clearCanvas()
+                }
+
+                // Restore the original active file
+                sketch.switchToFile(originalFile)
+                codeTextView.text = originalText
+            } else if (voiceState.transcription.isNotEmpty()) {
+                // Voice-only: capture current file as-is
+                val bitmap = captureFullContent(frame, sketch)
+                if (bitmap != null) {
+                    captures.add(Pair(bitmap, activeFile))
+                }
+            }
+
+            if (captures.isNotEmpty()) {
+                onSendAll(captures, voiceState.transcription)
+            }
+        }
+    }
+
+    // Voice commands recognized by the keyword spotter do what their buttons do
+    val onVoiceCommand by rememberUpdatedState<(Int) -> Unit> { command ->
+        when (command) {
+            KeywordSpotter.CMD_SEND -> if (canSend) sendAll()
+            KeywordSpotter.CMD_CLEAR -> sketchViewRef?.clearCanvas()
+            KeywordSpotter.CMD_UNDO -> sketchViewRef?.undoStroke()
+            KeywordSpotter.CMD_NEXT_FILE -> if (openFiles.isNotEmpty()) {
+                val current = openFiles.indexOfFirst { it.filename == activeFile }
+                onFileSelect(openFiles[(current + 1) % openFiles.size])
+            }
+        }
+    }
+    LaunchedEffect(voiceCommands) {
+        voiceCommands.collect { onVoiceCommand(it) }
+    }
+
     Column(
         modifier = modifier
             .fillMaxSize()
@@ -107,6 +197,46 @@ fun SketchScreen(
                 )
             }
             Spacer(Modifier.width(8.dp))
+            // Voice pipeline settings, persisted by the recorder
+            Box {
+                TextButton(
+                    onClick = { settingsMenuOpen = true },
+                    contentPadding = PaddingValues(horizontal = 8.dp, vertical = 0.dp),
+                    modifier = Modifier.height(28.dp)
+                ) {
+                    Text("⚙", fontSize = 13.sp, color = Color(0xFFCCCCCC))
+                }
+                DropdownMenu(
+                    expanded = settingsMenuOpen,
+                    onDismissRequest = { settingsMenuOpen = false }
+                ) {
+                    SettingItem("Live transcription", voiceSettings.liveTranscription) {
+                        onVoiceSettingsChange(voiceSettings.copy(liveTranscription = it))
+                    }
+                    SettingItem("Noise suppression", voiceSettings.noiseSuppression) {
+                        onVoiceSettingsChange(voiceSettings.copy(noiseSuppression = it))
+                    }
+                    SettingItem("Stereo beamforming", voiceSettings.stereoBeamforming) {
+                        onVoiceSettingsChange(voiceSettings.copy(stereoBeamforming = it))
+                    }
+                    SettingItem("Record captures", voiceSettings.captureRecording) {
+                        onVoiceSettingsChange(voiceSettings.copy(captureRecording = it))
+                    }
+                    // Cycles greedy -> beam 2 -> ... -> MAX_BEAM_SIZE -> greedy
+                    DropdownMenuItem(
+                        text = {
+                            Text(
+                                if (voiceSettings.beamSize <= 1) "Decoding: greedy"
+                                else "Decoding: beam ${voiceSettings.beamSize}"
+                            )
+                        },
+                        onClick = {
+                            val next = voiceSettings.beamSize % VoiceRecorderService.MAX_BEAM_SIZE + 1
+                            onVoiceSettingsChange(voiceSettings.copy(beamSize = next))
+                        }
+                    )
+                }
+            }
             TextButton(
                 onClick = onDisconnect,
                 contentPadding = PaddingValues(horizontal = 8.dp, vertical = 0.dp),
@@ -345,6 +475,27 @@ fun SketchScreen(
                     activeColor = Color(0xFFB91C1C)
                 ) { onVoiceToggle() }
 
+                // Teach a voice command: the next recording becomes its template
+                if (!voiceState.isRecording) {
+                    Box {
+                        ToolChip("🗣", false) { enrollMenuOpen = true }
+                        DropdownMenu(
+                            expanded = enrollMenuOpen,
+                            onDismissRequest = { enrollMenuOpen = false }
+                        ) {
+                            VOICE_COMMANDS.forEach { (command, phrase) ->
+                                DropdownMenuItem(
+                                    text = { Text("Teach \"$phrase\"") },
+                                    onClick = {
+                                        enrollMenuOpen = false
+                                        onEnrollCommand(command)
+                                    }
+                                )
+                            }
+                        }
+                    }
+                }
+
                 // Clear transcription
                 if (voiceState.transcription.isNotEmpty()) {
                     ToolChip("✕", false) {
@@ -354,67 +505,8 @@ fun SketchScreen(
 
                 // SEND button — captures all annotated files
                 Button(
-                    onClick = {
-                        val sketch = sketchViewRef
-                        val frame = innerFrameRef
-                        val codeTextView = frame?.findViewWithTag<TextView>("codeText")
-                        if (sketch != null && frame != null && codeTextView != null) {
-                            val annotatedFiles = sketch.getAnnotatedFiles()
-                            val captures = mutableListOf<Pair<Bitmap, String>>()
-
-                            if (annotatedFiles.isNotEmpty()) {
-                                // Save the original code text so we can restore it
-                                val originalText = codeTextView.text.toString()
-                                val originalFile = activeFile
-
-                                for (filename in annotatedFiles) {
-                                    // Switch canvas to this file's strokes
-                                    sketch.switchToFile(filename)
-
-                                    // Set the code text to this file's content
-                                    val cached = codeCache[filename]
-                                    if (cached != null) {
-                                        val lines = cached.code.split("\n")
-                                        val padWidth = lines.size.toString().length
-                                        val numbered = lines.mapIndexed { i, line ->
-                                            "${(i + 1).toString().padStart(padWidth)}  $line"
-                                        }.joinToString("\n")
-                                        codeTextView.text = numbered
-                                    }
-
-                                    // Force layout so the view dimensions are correct
-                                    frame.measure(
-                                        android.view.View.MeasureSpec.makeMeasureSpec(frame.width, android.view.View.MeasureSpec.EXACTLY),
-                                        android.view.View.MeasureSpec.makeMeasureSpec(0, android.view.View.MeasureSpec.UNSPECIFIED)
-                                    )
-                                    frame.layout(frame.left, frame.top, frame.right, frame.top + frame.measuredHeight)
-
-                                    val bitmap = captureFullContent(frame, sketch)
-                                    if (bitmap != null) {
-                                        captures.add(Pair(bitmap, filename))
-                                    }
-
-                                    // Clear this file's strokes after capture
-                                    sketch.clearCanvas()
-                                }
-
-                                // Restore the original active file
-                                sketch.switchToFile(originalFile)
-                                codeTextView.text = originalText
-                            } else if (voiceState.transcription.isNotEmpty()) {
-                                // Voice-only: capture current file as-is
-                                val bitmap = captureFullContent(frame, sketch)
-                                if (bitmap != null) {
-                                    captures.add(Pair(bitmap, activeFile))
-                                }
-                            }
-
-                            if (captures.isNotEmpty()) {
-                                onSendAll(captures, voiceState.transcription)
-                            }
-                        }
-                    },
-                    enabled = !isSending && codeUpdate != null && (hasDrawings || voiceState.transcription.isNotEmpty()),
+                    onClick = { sendAll() },
+                    enabled = canSend,
                     colors = ButtonDefaults.buttonColors(
                         containerColor = when {
                             annotationSent -> Color(0xFF22C55E)
@@ -439,6 +531,23 @@ fun SketchScreen(
     }
 }
 
+/** Voice commands the keyword spotter can be taught, with the phrase to say. */
+private val VOICE_COMMANDS = listOf(
+    KeywordSpotter.CMD_SEND to "send",
+    KeywordSpotter.CMD_CLEAR to "clear",
+    KeywordSpotter.CMD_UNDO to "undo",
+    KeywordSpotter.CMD_NEXT_FILE to "next file"
+)
+
+@Composable
+private fun SettingItem(label: String, checked: Boolean, onChange: (Boolean) -> Unit) {
+    DropdownMenuItem(
+        text = { Text(label) },
+        onClick = { onChange(!checked) },
+        trailingIcon = { Checkbox(checked = checked, onCheckedChange = onChange) }
+    )
+}
+
 @Composable
 private fun ToolChip(
     text: String,
@@ -7,9 +7,13 @@ import android.util.Log
 import java.util.concurrent.atomic.AtomicBoolean
 
 /**
- * Records 16kHz mono PCM audio using Android's AudioRecord API.
+ * Records 16kHz PCM audio using Android's AudioRecord API.
  * Accumulates samples in a buffer until stop() is called, then returns
  * the complete recording as a FloatArray.
+ *
+ * Mono by default. With start(stereo = true) both microphones are captured and
+ * stop() returns interleaved [L, R] samples for the native beamformer; devices
+ * that cannot open a stereo stream fall back to mono (see channelCount).
  */
 class AudioCapture {
     companion object {
@@ -24,57 +28,94 @@ class AudioCapture {
     private val isRecording = AtomicBoolean(false)
     private val buffer = ArrayList<Float>(MAX_SAMPLES)
 
+    /** Channels of the current/last recording: 1 = mono, 2 = interleaved stereo. */
+    @Volatile
+    var channelCount = 1
+        private set
+
     /**
      * Start recording audio. Non-blocking — recording happens on a background thread.
+     * @param onAudio called on the recording thread with each chunk as it is read
+     *        (interleaved like the recording, valid only during the call)
      */
-    fun start() {
+    fun start(stereo: Boolean = false, onAudio: ((FloatArray, Int) -> Unit)? = null) {
         if (isRecording.get()) return
 
         buffer.clear()
 
-        val bufferSize = AudioRecord.getMinBufferSize(
-            SAMPLE_RATE,
-            AudioFormat.CHANNEL_IN_MONO,
-            AudioFormat.ENCODING_PCM_FLOAT
-        ).coerceAtLeast(SAMPLE_RATE) // at least 1 second buffer
-
-        audioRecord = AudioRecord(
-            MediaRecorder.AudioSource.MIC,
-            SAMPLE_RATE,
-            AudioFormat.CHANNEL_IN_MONO,
-            AudioFormat.ENCODING_PCM_FLOAT,
-            bufferSize * 4 // float = 4 bytes
-        )
+        audioRecord = if (stereo) createAudioRecord(AudioFormat.CHANNEL_IN_STEREO) else null
+        if (audioRecord != null) {
+            channelCount = 2
+        } else {
+            if (stereo) Log.w(TAG, "Stereo capture unavailable, falling back to mono")
+            audioRecord = createAudioRecord(AudioFormat.CHANNEL_IN_MONO)
+            channelCount = 1
+        }
 
-        if (audioRecord?.state != AudioRecord.STATE_INITIALIZED) {
+        if (audioRecord == null) {
             Log.e(TAG, "AudioRecord failed to initialize")
-            audioRecord?.release()
-            audioRecord = null
             return
         }
 
         isRecording.set(true)
         audioRecord?.startRecording()
 
+        val maxSamples = MAX_SAMPLES * channelCount
         recordingThread = Thread({
-            val chunk = FloatArray(1024)
-            while (isRecording.get() && buffer.size < MAX_SAMPLES) {
+            val chunk = FloatArray(1024 * channelCount)
+            while (isRecording.get() && buffer.size < maxSamples) {
                 val read = audioRecord?.read(chunk, 0, chunk.size, AudioRecord.READ_BLOCKING) ?: 0
                 if (read > 0) {
+                    val toAdd: Int
                     synchronized(buffer) {
-                        val remaining = MAX_SAMPLES - buffer.size
-                        val toAdd = minOf(read, remaining)
+                        val remaining = maxSamples - buffer.size
+                        toAdd = minOf(read, remaining)
                         for (i in 0 until toAdd) {
                             buffer.add(chunk[i])
                         }
                     }
+                    try {
+                        onAudio?.invoke(chunk, toAdd)
+                    } catch (e: Exception) {
+                        Log.w(TAG, "Audio listener failed: ${e.message}")
+                    }
                 }
             }
             Log.i(TAG, "Recording thread finished, ${buffer.size} samples captured")
         }, "AudioCapture")
         recordingThread?.start()
 
-        Log.i(TAG, "Recording started (16kHz, mono, float)")
+        Log.i(TAG, "Recording started (16kHz, ${if (channelCount == 2) "stereo" else "mono"}, float)")
+    }
+
+    /**
+     * Open an AudioRecord with the given channel mask, or null if the device rejects it.
+     */
+    private fun createAudioRecord(channelMask: Int): AudioRecord? {
+        val bufferSize = AudioRecord.getMinBufferSize(
+            SAMPLE_RATE,
+            channelMask,
+            AudioFormat.ENCODING_PCM_FLOAT
+        ).coerceAtLeast(SAMPLE_RATE) // at least 1 second buffer
+
+        val record = try {
+            AudioRecord(
+                MediaRecorder.AudioSource.MIC,
+                SAMPLE_RATE,
+                channelMask,
+                AudioFormat.ENCODING_PCM_FLOAT,
+                bufferSize * 4 // float = 4 bytes
+            )
+        } catch (e: IllegalArgumentException) {
+            Log.w(TAG, "AudioRecord rejected channel mask $channelMask: ${e.message}")
+            return null
+        }
+
+        if (record.state != AudioRecord.STATE_INITIALIZED) {
+            record.release()
+            return null
+        }
+        return record
     }
 
     /**
@@ -126,7 +167,8 @@ class AudioCapture {
             buffer.clear()
         }
 
-        Log.i(TAG, "Recording stopped, returning ${result.size} samples (${result.size / SAMPLE_RATE.toFloat()}s)")
+        Log.i(TAG, "Recording stopped, returning ${result.size} samples " +
+                "(${result.size / (SAMPLE_RATE.toFloat() * channelCount)}s, $channelCount ch)")
         return result
     }
 
@@ -0,0 +1,90 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin JNI wrapper for the native beam-search controller (beam_search.cpp).
+ *
+ * Keeps the hypotheses, cumulative log-probs and Whisper's length-penalized
+ * ranking natively; the caller drives the decoder one beam at a time and keeps
+ * the self-attention KV tensors in numbered slots. Beams forked from the same
+ * parent share its slot, so a shared prefix is never copied: [advance] reports
+ * the slots no beam reads any more, and only those are closed.
+ */
+class BeamSearch(
+    vocabSize: Int,
+    val beamSize: Int,
+    maxTokens: Int,
+    lengthPenalty: Float = 0f,
+    patience: Float = 1f
+) {
+    companion object {
+        /** KV-cache slots in use at most: each beam's input plus each beam's output. */
+        const val MAX_SLOTS = 16
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    private var handle: Long = nativeCreate(
+        beamSize, WhisperTokenizer.EOT, vocabSize, maxTokens, lengthPenalty, patience
+    )
+
+    /** Begin an utterance; returns the slot for the caches after the prompt prefix. */
+    fun start(lastPromptToken: Int, maxTokens: Int): Int = nativeStart(handle, lastPromptToken, maxTokens)
+
+    val beamCount: Int
+        get() = nativeBeamCount(handle)
+
+    val done: Boolean
+        get() = nativeDone(handle)
+
+    /** KV-cache slot the beam's next decoder step reads. */
+    fun beamSlot(beam: Int): Int = nativeBeamSlot(handle, beam)
+
+    fun lastToken(beam: Int): Int = nativeLastToken(handle, beam)
+
+    /** Copies the beam's sampled tokens into [out]; returns the count. */
+    fun tokens(beam: Int, out: IntArray): Int = nativeTokens(handle, beam, out)
+
+    /** Scores one beam's filtered logits; returns the slot for this step's output caches. */
+    fun score(beam: Int, logits: ByteBuffer, fp16: Boolean): Int = nativeScore(handle, beam, logits, fp16)
+
+    /** Selects the next beams; the first n entries of [freedSlots] can be released. */
+    fun advance(freedSlots: IntArray): Int = nativeAdvance(handle, freedSlots)
+
+    /** Best finished sequence (EOT excluded) into [out]; returns the count. */
+    fun best(out: IntArray): Int = nativeBest(handle, out)
+
+    /** Cumulative log-probability of the [best] sequence. */
+    val bestLogProb: Float
+        get() = nativeBestLogProb(handle)
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(
+        beamSize: Int,
+        eot: Int,
+        vocabSize: Int,
+        maxTokens: Int,
+        lengthPenalty: Float,
+        patience: Float
+    ): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeStart(handle: Long, lastPromptToken: Int, maxTokens: Int): Int
+    private external fun nativeBeamCount(handle: Long): Int
+    private external fun nativeBeamSlot(handle: Long, beam: Int): Int
+    private external fun nativeLastToken(handle: Long, beam: Int): Int
+    private external fun nativeTokens(handle: Long, beam: Int, outTokens: IntArray): Int
+    private external fun nativeScore(handle: Long, beam: Int, logits: ByteBuffer, fp16: Boolean): Int
+    private external fun nativeAdvance(handle: Long, outFreedSlots: IntArray): Int
+    private external fun nativeDone(handle: Long): Boolean
+    private external fun nativeBest(handle: Long, outTokens: IntArray): Int
+    private external fun nativeBestLogProb(handle: Long): Float
+}
@@ -0,0 +1,46 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for the native byte-level BPE encoder (bpe_encoder.cpp).
+ *
+ * Turns text into Whisper token IDs for prompt conditioning. Merge ranks come from
+ * the mapped [vocabulary] itself (in Whisper's tiktoken vocabulary a token's id is its
+ * merge rank), and each pre-tokenized word is cached, so re-encoding the identifiers
+ * of the open file costs a few hash lookups. The vocabulary must outlive the encoder.
+ * Not thread-safe: calls are serialized.
+ */
+class BpeEncoder(vocabulary: Vocabulary, cacheCapacity: Int = 4096) {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    private var handle: Long = nativeCreate(vocabulary.handle, cacheCapacity)
+
+    init {
+        if (handle == 0L) throw IllegalStateException("Vocabulary is not open")
+    }
+
+    /** Token IDs of [text] (no special tokens). */
+    @Synchronized
+    fun encode(text: String): IntArray =
+        if (handle != 0L) nativeEncode(handle, text.toByteArray(Charsets.UTF_8)) ?: IntArray(0) else IntArray(0)
+
+    /** Words currently cached. */
+    val cacheSize: Int
+        get() = if (handle != 0L) nativeCacheSize(handle) else 0
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(vocabHandle: Long, cacheCapacity: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeEncode(handle: Long, text: ByteArray): IntArray?
+    private external fun nativeCacheSize(handle: Long): Int
+}
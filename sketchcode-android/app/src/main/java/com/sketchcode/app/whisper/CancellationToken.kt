@@ -0,0 +1,50 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for a native cancellation token (cancellation.h).
+ *
+ * One token per transcription: [cancel] from any thread makes the mel frame loop and
+ * the decoder step loops (native and Kotlin) return within one frame or step. The
+ * work's result is then incomplete, so callers check [isCancelled] before using it.
+ * Release the token only once no call that was given it is still running.
+ */
+class CancellationToken {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [MelSpectrogram] and [NativeDecoder]. */
+    internal var handle: Long = nativeCreate()
+        private set
+
+    @Synchronized
+    fun cancel() {
+        if (handle != 0L) nativeCancel(handle)
+    }
+
+    /** Make the token usable for another transcription. */
+    @Synchronized
+    fun reset() {
+        if (handle != 0L) nativeReset(handle)
+    }
+
+    /** True once cancelled; a released token counts as cancelled. */
+    val isCancelled: Boolean
+        @Synchronized get() = handle == 0L || nativeIsCancelled(handle)
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeCancel(handle: Long)
+    private external fun nativeReset(handle: Long)
+    private external fun nativeIsCancelled(handle: Long): Boolean
+}
@@ -0,0 +1,91 @@
+package com.sketchcode.app.whisper
+
+import android.util.Log
+import java.io.File
+
+/**
+ * Opt-in recorder for the capture-and-replay corpus.
+ *
+ * Appends each transcribed utterance (the exact PCM fed to the mel engine) together
+ * with its per-stage timings to an append-only native file. Pull it with
+ * `adb pull` and replay it on a workstation with the host `whisper_mel_replay` tool
+ * to reproduce field latency reports deterministically.
+ */
+class CaptureRecorder(
+    val file: File,
+    private val maxFileBytes: Long = DEFAULT_MAX_FILE_BYTES
+) {
+    companion object {
+        private const val TAG = "CaptureRecorder"
+        private const val SAMPLE_RATE = 16000
+        private const val DEFAULT_MAX_FILE_BYTES = 256L * 1024 * 1024
+
+        // Stage slots, must match CaptureStage in capture_log.h
+        private const val STAGE_MEL = 0
+        private const val STAGE_ENCODER = 1
+        private const val STAGE_DECODER = 2
+        private const val STAGE_TOTAL = 3
+        private const val STAGE_COUNT = 4
+
+        // Must match CaptureFlags in capture_log.h
+        private const val FLAG_DENOISE = 1
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    init {
+        file.parentFile?.mkdirs()
+    }
+
+    /**
+     * Append one utterance. Timings are wall-clock milliseconds, 0 if not measured.
+     * @param melBucketFrames the bucket the mel was trimmed to (0: full 30 s mel)
+     * @param melQuantization the int8/uint8 encoder input written with the mel, if any
+     * @return false if the write failed or the file reached its size cap
+     */
+    fun append(
+        audio: FloatArray,
+        channels: Int,
+        denoise: Boolean,
+        melMs: Long,
+        encoderMs: Long,
+        decoderMs: Long,
+        totalMs: Long,
+        decodedTokens: Int,
+        melBucketFrames: Int = 0,
+        melQuantization: MelQuantization? = null
+    ): Boolean {
+        val stageMicros = IntArray(STAGE_COUNT)
+        stageMicros[STAGE_MEL] = (melMs * 1000).toInt()
+        stageMicros[STAGE_ENCODER] = (encoderMs * 1000).toInt()
+        stageMicros[STAGE_DECODER] = (decoderMs * 1000).toInt()
+        stageMicros[STAGE_TOTAL] = (totalMs * 1000).toInt()
+        val flags = if (denoise) FLAG_DENOISE else 0
+
+        val ok = nativeAppend(
+            file.absolutePath, audio, SAMPLE_RATE, channels, flags,
+            stageMicros, decodedTokens, System.currentTimeMillis(), maxFileBytes,
+            melBucketFrames, melQuantization?.type ?: 0, melQuantization?.scale ?: 0f, melQuantization?.zeroPoint ?: 0
+        )
+        if (!ok) Log.w(TAG, "Capture not recorded (${file.absolutePath})")
+        return ok
+    }
+
+    private external fun nativeAppend(
+        path: String,
+        audio: FloatArray,
+        sampleRate: Int,
+        channels: Int,
+        flags: Int,
+        stageMicros: IntArray,
+        decodedTokens: Int,
+        timestampMs: Long,
+        maxFileBytes: Long,
+        melBucketFrames: Int,
+        melQuantType: Int,
+        melQuantScale: Float,
+        melQuantZeroPoint: Int
+    ): Boolean
+}
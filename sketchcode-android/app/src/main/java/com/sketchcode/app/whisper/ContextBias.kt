@@ -0,0 +1,74 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for identifier-aware contextual biasing (context_bias.cpp).
+ *
+ * Holds a token trie of the identifiers in the file on screen. Attached to the
+ * [LogitProcessor], it boosts every token that continues a partially decoded
+ * identifier, on the Kotlin, native and beam-search decode paths alike. [update]
+ * diffs against the current words, so a new code snapshot only adds and removes
+ * what changed; it may run while a decode is in progress.
+ *
+ * @param boost logit added to continuations of a matched identifier prefix
+ * @param startBoost logit added to tokens that start an identifier (0 = off)
+ */
+class ContextBias(boost: Float = 2.0f, startBoost: Float = 0.0f) {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [LogitProcessor]. */
+    internal var handle: Long = nativeCreate(boost, startBoost)
+        private set
+
+    // Identifier → its tokens, as currently in the trie
+    private val words = HashMap<String, IntArray>()
+
+    /** Make the trie hold exactly [next] (identifier → tokens, leading space included). */
+    @Synchronized
+    fun update(next: Map<String, IntArray>) {
+        if (handle == 0L) return
+        val iterator = words.entries.iterator()
+        while (iterator.hasNext()) {
+            val (word, tokens) = iterator.next()
+            if (word !in next) {
+                nativeRemove(handle, tokens)
+                iterator.remove()
+            }
+        }
+        for ((word, tokens) in next) {
+            if (word !in words && tokens.isNotEmpty()) {
+                nativeAdd(handle, tokens)
+                words[word] = tokens
+            }
+        }
+    }
+
+    /** Identifiers currently boosted. */
+    val wordCount: Int
+        get() = if (handle != 0L) nativeWordCount(handle) else 0
+
+    @Synchronized
+    fun clear() {
+        if (handle != 0L) nativeClear(handle)
+        words.clear()
+    }
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+        words.clear()
+    }
+
+    private external fun nativeCreate(boost: Float, startBoost: Float): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeAdd(handle: Long, tokens: IntArray)
+    private external fun nativeRemove(handle: Long, tokens: IntArray)
+    private external fun nativeClear(handle: Long)
+    private external fun nativeWordCount(handle: Long): Int
+}
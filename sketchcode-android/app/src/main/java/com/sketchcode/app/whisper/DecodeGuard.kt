@@ -0,0 +1,52 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for the native decode guard (decode_guard.cpp).
+ *
+ * Stops greedy decoding early when the output falls into a repetition loop
+ * (a short token pattern repeated back to back) or exceeds a token budget
+ * estimated from the clip's speech duration. Call [reset] with the mel
+ * spectrogram before each utterance and [accept] for every text token.
+ */
+class DecodeGuard(maxTokens: Int) {
+    companion object {
+        const val CONTINUE = 0
+        const val STOP_REPETITION = 1
+        const val STOP_TOKEN_BUDGET = 2
+        // Reported by the decoder loops when their CancellationToken fires
+        const val STOP_CANCELLED = 3
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [NativeDecoder]. */
+    internal var handle: Long = nativeCreate(maxTokens)
+        private set
+
+    /** Start a new utterance; returns the token budget derived from [mel]. */
+    fun reset(mel: FloatArray): Int =
+        if (handle != 0L) nativeReset(handle, mel) else 0
+
+    /** Feed the next text token; returns [CONTINUE] or a stop reason. */
+    fun accept(token: Int): Int =
+        if (handle != 0L) nativeAccept(handle, token) else CONTINUE
+
+    /** Tokens to keep after a stop: a repetition loop is trimmed to its first occurrence. */
+    val keepTokens: Int
+        get() = if (handle != 0L) nativeKeepTokens(handle) else 0
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(maxTokens: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeReset(handle: Long, mel: FloatArray): Int
+    private external fun nativeAccept(handle: Long, token: Int): Int
+    private external fun nativeKeepTokens(handle: Long): Int
+}
@@ -0,0 +1,79 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin JNI wrapper for the native decode scorer (decode_scorer.cpp).
+ *
+ * Drives Whisper's temperature fallback: picks tokens (argmax or a temperature
+ * draw) from the pinned logits, accumulates their log-probabilities, and judges
+ * each finished attempt by average log-probability, zlib compression ratio and
+ * no-speech probability. Call [reset] before each attempt.
+ */
+class DecodeScorer(vocabSize: Int, seed: Long = System.nanoTime()) {
+    companion object {
+        const val ACCEPT = 0
+        const val FALLBACK = 1
+        const val NO_SPEECH = 2
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [NativeDecoder]. */
+    internal var handle: Long = nativeCreate(vocabSize, WhisperTokenizer.NO_SPEECH, seed)
+        private set
+
+    fun reset() {
+        if (handle != 0L) nativeReset(handle)
+    }
+
+    /** Record P(no-speech) from the unfiltered logits of the first decoder step. */
+    fun noSpeech(logits: ByteBuffer, fp16: Boolean) {
+        if (handle != 0L) nativeNoSpeech(handle, logits, fp16)
+    }
+
+    /** Next token: argmax at [temperature] 0, otherwise a draw from softmax(logits / T). */
+    fun sample(logits: ByteBuffer, fp16: Boolean, temperature: Float): Int =
+        nativeSample(handle, logits, fp16, temperature)
+
+    /** Add log P([token]) under the filtered logits. */
+    fun accept(logits: ByteBuffer, fp16: Boolean, token: Int) {
+        if (handle != 0L) nativeAccept(handle, logits, fp16, token)
+    }
+
+    fun addLogProb(logProb: Float) {
+        if (handle != 0L) nativeAddLogProb(handle, logProb)
+    }
+
+    /** [ACCEPT], [FALLBACK] (re-decode hotter) or [NO_SPEECH] for the finished attempt. */
+    fun verdict(text: String, numTokens: Int): Int =
+        if (handle != 0L) nativeVerdict(handle, text.toByteArray(Charsets.UTF_8), numTokens) else ACCEPT
+
+    val avgLogProb: Float
+        get() = nativeAvgLogProb(handle)
+    val compressionRatio: Float
+        get() = nativeCompressionRatio(handle)
+    val noSpeechProb: Float
+        get() = nativeNoSpeechProb(handle)
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(vocabSize: Int, noSpeechToken: Int, seed: Long): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeReset(handle: Long)
+    private external fun nativeNoSpeech(handle: Long, logits: ByteBuffer, fp16: Boolean)
+    private external fun nativeSample(handle: Long, logits: ByteBuffer, fp16: Boolean, temperature: Float): Int
+    private external fun nativeAccept(handle: Long, logits: ByteBuffer, fp16: Boolean, token: Int)
+    private external fun nativeAddLogProb(handle: Long, logProb: Float)
+    private external fun nativeVerdict(handle: Long, textUtf8: ByteArray, numTokens: Int): Int
+    private external fun nativeAvgLogProb(handle: Long): Float
+    private external fun nativeCompressionRatio(handle: Long): Float
+    private external fun nativeNoSpeechProb(handle: Long): Float
+}
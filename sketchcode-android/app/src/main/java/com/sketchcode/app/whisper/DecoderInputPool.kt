@@ -0,0 +1,97 @@
+package com.sketchcode.app.whisper
+
+import ai.onnxruntime.OnnxJavaType
+import ai.onnxruntime.OnnxTensor
+import ai.onnxruntime.OrtEnvironment
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.IntBuffer
+
+/**
+ * Pinned, preallocated decoder inputs (decoder_inputs.cpp), created once per session.
+ *
+ * The Qualcomm model uses a sliding window cache, so its attention mask unmasks from
+ * the RIGHT: step n attends to positions (maskSize - 1 - n)..(maskSize - 1). All
+ * [numMasks] masks are filled natively into one slab and each gets an ORT tensor
+ * over its slice. input_ids / position_ids are single int32 tensors rewritten in place
+ * with [setStep], and the initial self-attention caches are one shared zero block.
+ * Nothing here allocates after construction, and every tensor is closed by [release].
+ */
+class DecoderInputPool(
+    env: OrtEnvironment,
+    maskSize: Int,
+    numMasks: Int,
+    maskValue: Short,
+    private val numLayers: Int,
+    kCacheShape: LongArray,
+    vCacheShape: LongArray
+) {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    private var handle: Long = nativeCreate(maskSize, numMasks, maskValue, kCacheShape.fold(1L) { a, b -> a * b }.toInt())
+
+    init {
+        if (handle == 0L) throw IllegalStateException("Decoder input pool allocation failed")
+    }
+
+    private val inputIdsBuffer: IntBuffer = pinned(nativeInputIds(handle)).asIntBuffer()
+    private val positionIdsBuffer: IntBuffer = pinned(nativePositionIds(handle)).asIntBuffer()
+
+    /** input_ids: int32 [1, 1] */
+    val inputIds: OnnxTensor = OnnxTensor.createTensor(env, inputIdsBuffer, longArrayOf(1, 1))
+
+    /** position_ids: int32 [1] */
+    val positionIds: OnnxTensor = OnnxTensor.createTensor(env, positionIdsBuffer, longArrayOf(1))
+
+    private val masks: Array<OnnxTensor> = run {
+        val slab = pinned(nativeMasks(handle))
+        val maskShape = longArrayOf(1, 1, 1, maskSize.toLong())
+        Array(numMasks) { n ->
+            slab.limit((n + 1) * maskSize * 2).position(n * maskSize * 2)
+            val slice = slab.slice().order(ByteOrder.nativeOrder()).asShortBuffer()
+            OnnxTensor.createTensor(env, slice, maskShape, OnnxJavaType.FLOAT16)
+        }
+    }
+
+    private val zeroBuffer = pinned(nativeZeroCache(handle))
+    private val zeroK = OnnxTensor.createTensor(env, zeroBuffer.asShortBuffer(), kCacheShape, OnnxJavaType.FLOAT16)
+    private val zeroV = OnnxTensor.createTensor(env, zeroBuffer.asShortBuffer(), vCacheShape, OnnxJavaType.FLOAT16)
+
+    /** Initial self-attention caches; every layer reads the same zero tensors. */
+    val zeroKCaches: Array<OnnxTensor> = Array(numLayers) { zeroK }
+    val zeroVCaches: Array<OnnxTensor> = Array(numLayers) { zeroV }
+
+    /** Attention mask for a decoder position; past the last mask every position attends. */
+    fun mask(position: Int): OnnxTensor = masks[position.coerceAtMost(masks.size - 1)]
+
+    /** Write this step's token and position into the pinned scalar inputs. */
+    fun setStep(token: Int, position: Int) {
+        inputIdsBuffer.put(0, token)
+        positionIdsBuffer.put(0, position)
+    }
+
+    fun release() {
+        if (handle == 0L) return
+        inputIds.close()
+        positionIds.close()
+        masks.forEach { it.close() }
+        zeroK.close()
+        zeroV.close()
+        nativeDestroy(handle)
+        handle = 0L
+    }
+
+    private fun pinned(buffer: ByteBuffer?): ByteBuffer =
+        (buffer ?: throw IllegalStateException("Decoder input pool buffer unavailable")).order(ByteOrder.nativeOrder())
+
+    private external fun nativeCreate(maskSize: Int, numMasks: Int, maskValue: Short, zeroCacheElements: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeMasks(handle: Long): ByteBuffer?
+    private external fun nativeInputIds(handle: Long): ByteBuffer?
+    private external fun nativePositionIds(handle: Long): ByteBuffer?
+    private external fun nativeZeroCache(handle: Long): ByteBuffer?
+}
@@ -0,0 +1,99 @@
+package com.sketchcode.app.whisper
+
+import android.util.Log
+import java.io.File
+
+/**
+ * Kotlin JNI wrapper for the native voice-command keyword spotter.
+ *
+ * Short control phrases are matched against user-enrolled templates using MFCCs
+ * derived from the log-mel spectrogram MelSpectrogram already produced, so a
+ * recognized command costs a few milliseconds instead of a full encoder and
+ * decoder pass. Templates persist in [templateFile].
+ */
+class KeywordSpotter(private val templateFile: File) {
+    companion object {
+        private const val TAG = "KeywordSpotter"
+        private const val HOP_LENGTH = 160
+        private const val N_FRAMES = 3000
+
+        // Command IDs
+        const val NO_COMMAND = -1
+        const val CMD_SEND = 0
+        const val CMD_CLEAR = 1
+        const val CMD_UNDO = 2
+        const val CMD_NEXT_FILE = 3
+
+        // Match thresholds (normalized DTW distance / runner-up ratio)
+        private const val MAX_DISTANCE = 1.2f
+        private const val MIN_MARGIN = 1.15f
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+
+        /** Mel frames that contain audio for a clip of the given length. */
+        fun framesForSamples(samples: Int): Int = minOf((samples + HOP_LENGTH - 1) / HOP_LENGTH, N_FRAMES)
+    }
+
+    private var handle: Long = nativeCreate()
+
+    init {
+        if (templateFile.exists() && nativeLoad(handle, templateFile.absolutePath)) {
+            Log.i(TAG, "Loaded ${nativeTemplateCount(handle)} templates")
+        }
+    }
+
+    val hasTemplates: Boolean
+        @Synchronized get() = handle != 0L && nativeTemplateCount(handle) > 0
+
+    /**
+     * Enroll one example of a command from its mel spectrogram and persist the templates.
+     * @param mel full or trimmed (see [MelSpectrogram.compute]) spectrogram
+     * @param numFrames mel frames covering the recording (see framesForSamples)
+     */
+    @Synchronized
+    fun enroll(commandId: Int, mel: FloatArray, numFrames: Int): Boolean {
+        if (handle == 0L) return false
+        val ok = nativeEnroll(handle, commandId, mel, numFrames)
+        if (ok) {
+            templateFile.parentFile?.mkdirs()
+            nativeSave(handle, templateFile.absolutePath)
+        }
+        return ok
+    }
+
+    /**
+     * Match a short utterance. Returns the command ID, or NO_COMMAND if no
+     * enrolled command matched confidently (the clip should go to Whisper).
+     */
+    @Synchronized
+    fun match(mel: FloatArray, numFrames: Int): Int {
+        if (handle == 0L) return NO_COMMAND
+        return nativeMatch(handle, mel, numFrames, MAX_DISTANCE, MIN_MARGIN)
+    }
+
+    @Synchronized
+    fun removeCommand(commandId: Int) {
+        if (handle == 0L) return
+        nativeRemoveCommand(handle, commandId)
+        nativeSave(handle, templateFile.absolutePath)
+    }
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeEnroll(handle: Long, commandId: Int, mel: FloatArray, numFrames: Int): Boolean
+    private external fun nativeMatch(handle: Long, mel: FloatArray, numFrames: Int, maxDistance: Float, minMargin: Float): Int
+    private external fun nativeRemoveCommand(handle: Long, commandId: Int)
+    private external fun nativeTemplateCount(handle: Long): Int
+    private external fun nativeSave(handle: Long, path: String): Boolean
+    private external fun nativeLoad(handle: Long, path: String): Boolean
+}
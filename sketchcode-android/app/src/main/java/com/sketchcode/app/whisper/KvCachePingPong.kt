@@ -0,0 +1,60 @@
+package com.sketchcode.app.whisper
+
+import ai.onnxruntime.OnnxJavaType
+import ai.onnxruntime.OnnxTensor
+import ai.onnxruntime.OrtEnvironment
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Two preallocated sets of self-attention caches that alternate as decoder input and
+ * pinned decoder output, so the greedy loop stops adopting (and closing) eight fresh
+ * runtime-allocated cache tensors every token.
+ *
+ * Step n reads set n % 2 and writes set (n + 1) % 2; step 0 reads the pool's zero
+ * caches instead. The Java API has no IoBinding, so the output side goes through
+ * OrtSession.run's pinned outputs: [bindOutputs] points the k/v_cache_self_*_out
+ * entries of a reused output map at the set being written.
+ */
+class KvCachePingPong(
+    env: OrtEnvironment,
+    private val numLayers: Int,
+    kCacheShape: LongArray,
+    vCacheShape: LongArray,
+    private val kOutNames: Array<String>,
+    private val vOutNames: Array<String>
+) {
+    private val buffers = ArrayList<ByteBuffer>()
+    private val kSets: Array<Array<OnnxTensor>> = Array(2) { Array(numLayers) { tensor(env, kCacheShape) } }
+    private val vSets: Array<Array<OnnxTensor>> = Array(2) { Array(numLayers) { tensor(env, vCacheShape) } }
+
+    /** Bytes held by both sets. */
+    val bytes: Long
+        get() = buffers.sumOf { it.capacity().toLong() }
+
+    /** Self-attention inputs of [step] (> 0); step 0 reads the zero caches. */
+    fun kInputs(step: Int): Array<OnnxTensor> = kSets[step and 1]
+    fun vInputs(step: Int): Array<OnnxTensor> = vSets[step and 1]
+
+    /** Point the cache outputs of [outputs] at the set [step] writes. */
+    fun bindOutputs(step: Int, outputs: MutableMap<String, OnnxTensor>) {
+        val set = (step + 1) and 1
+        for (layer in 0 until numLayers) {
+            outputs[kOutNames[layer]] = kSets[set][layer]
+            outputs[vOutNames[layer]] = vSets[set][layer]
+        }
+    }
+
+    fun release() {
+        kSets.forEach { set -> set.forEach { it.close() } }
+        vSets.forEach { set -> set.forEach { it.close() } }
+        buffers.clear()
+    }
+
+    private fun tensor(env: OrtEnvironment, shape: LongArray): OnnxTensor {
+        val elements = shape.fold(1L) { n, d -> n * d }
+        val buf = ByteBuffer.allocateDirect((elements * 2).toInt()).order(ByteOrder.nativeOrder())
+        buffers.add(buf)
+        return OnnxTensor.createTensor(env, buf.asShortBuffer(), shape, OnnxJavaType.FLOAT16)
+    }
+}
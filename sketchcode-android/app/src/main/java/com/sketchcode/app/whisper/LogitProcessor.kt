@@ -0,0 +1,69 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin JNI wrapper for the native logit-processor chain (logit_processor.cpp).
+ *
+ * Implements Whisper's reference decoding filters — suppressed tokens, blank
+ * suppression on the first sampled step, timestamp rules and an optional
+ * repetition penalty — in place on the decoder's pinned logits buffer.
+ * Create once per session and call [apply] once per decoder step.
+ */
+class LogitProcessor(
+    vocabSize: Int,
+    suppressTokens: IntArray,
+    blankToken: Int,
+    timestamps: Boolean = false,
+    repetitionPenalty: Float = 1.0f
+) {
+    companion object {
+        private const val MAX_INITIAL_TIMESTAMP_INDEX = 50 // 1.0 s
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [NativeDecoder]. */
+    internal var handle: Long = nativeCreate(
+        vocabSize, WhisperTokenizer.EOT, WhisperTokenizer.NO_TIMESTAMPS, WhisperTokenizer.FIRST_TIMESTAMP,
+        blankToken, suppressTokens, timestamps, MAX_INITIAL_TIMESTAMP_INDEX, repetitionPenalty
+    )
+        private set
+
+    /**
+     * Filter one step's logits in place.
+     * @param sampledTokens tokens generated after the prompt; the first [numSampled] are used
+     */
+    fun apply(logits: ByteBuffer, fp16: Boolean, sampledTokens: IntArray, numSampled: Int) {
+        if (handle != 0L) nativeApply(handle, logits, fp16, sampledTokens, numSampled)
+    }
+
+    /** Boost continuations of [bias]'s identifiers from the next [apply] on; null to stop. */
+    fun setContextBias(bias: ContextBias?) {
+        if (handle != 0L) nativeSetContextBias(handle, bias?.handle ?: 0L)
+    }
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(
+        vocabSize: Int,
+        eot: Int,
+        noTimestamps: Int,
+        timestampBegin: Int,
+        blankToken: Int,
+        suppressTokens: IntArray,
+        timestamps: Boolean,
+        maxInitialTimestampIndex: Int,
+        repetitionPenalty: Float
+    ): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeSetContextBias(handle: Long, biasHandle: Long)
+    private external fun nativeApply(handle: Long, logits: ByteBuffer, fp16: Boolean, tokens: IntArray, numTokens: Int)
+}
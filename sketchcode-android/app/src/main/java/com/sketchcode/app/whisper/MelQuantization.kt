@@ -0,0 +1,49 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+import kotlin.math.ceil
+
+/**
+ * Affine int8/uint8 quantization of the normalized mel for quantized encoder inputs
+ * (MelQuantization in mel_engine.h), as ONNX QuantizeLinear:
+ * q = saturate(round(x / scale) + zeroPoint).
+ *
+ * [MelSpectrogram.compute] writes it in the same pass that normalizes the fp32 mel;
+ * [quantize] covers mels that come from elsewhere (live-window snapshots, padded
+ * trimmed mels).
+ */
+class MelQuantization(val type: Int, val scale: Float, val zeroPoint: Int) {
+    companion object {
+        const val INT8 = 1
+        const val UINT8 = 2
+        // Range of the default quantization (MEL_QUANT_MIN / MEL_QUANT_MAX in mel_engine.h)
+        private const val DEFAULT_MIN = -1.5f
+        private const val DEFAULT_MAX = 2.0f
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+
+        /** Silence to full-scale speech over the 256 levels of [type], for models that carry no parameters. */
+        fun default(type: Int): MelQuantization {
+            val scale = (DEFAULT_MAX - DEFAULT_MIN) / 255f
+            val lowest = if (type == INT8) -128 else 0
+            return MelQuantization(type, scale, lowest + ceil(-DEFAULT_MIN / scale).toInt())
+        }
+    }
+
+    /** Quantize [count] values of an already normalized [mel] into the direct buffer [dst]. */
+    fun quantize(mel: FloatArray, dst: ByteBuffer, count: Int = mel.size): Boolean =
+        nativeQuantize(mel, count, dst, type, scale, zeroPoint)
+
+    override fun toString(): String = "${if (type == INT8) "int8" else "uint8"} (scale $scale, zero point $zeroPoint)"
+
+    private external fun nativeQuantize(
+        mel: FloatArray,
+        count: Int,
+        dst: ByteBuffer,
+        type: Int,
+        scale: Float,
+        zeroPoint: Int
+    ): Boolean
+}
@@ -1,5 +1,7 @@
 package com.sketchcode.app.whisper
 
+import java.nio.ByteBuffer
+
 /**
  * Kotlin JNI wrapper for the C++ mel spectrogram computation.
  * Computes a 128x3000 log-mel spectrogram from 16kHz PCM audio,
@@ -7,19 +9,100 @@ package com.sketchcode.app.whisper
  */
 class MelSpectrogram {
     companion object {
+        const val N_MELS = 128
+        const val N_FRAMES = 3000
+
         init {
             System.loadLibrary("whisper_mel")
         }
+
+        /** Frames of a [compute] result: [N_FRAMES], or fewer for a trimmed one. */
+        fun frames(mel: FloatArray): Int = mel.size / N_MELS
     }
 
     /**
      * Compute mel spectrogram from raw PCM audio samples.
      * @param audio Float array of 16kHz mono PCM samples (will be padded/truncated to 30s)
-     * @return Float array of shape [128 * 3000] (flattened row-major mel spectrogram)
+     * @param suppressNoise Attenuate the stationary noise floor on the STFT power spectra
+     *   before the mel filterbank (no extra FFTs). Helps on clips recorded in noisy rooms.
+     * @param cancel polled once per STFT frame
+     * @param bucketFrames 0 for the full 30 s input; otherwise only the frames that cover
+     *   the audio plus one frame of silence are computed, rounded up to a multiple of
+     *   this (for encoders that take shorter inputs). The values are those of the full
+     *   spectrogram; only the trailing padding is dropped.
+     * @param quantization with [quantizedOut], also write the mel int8/uint8-quantized
+     *   into [quantizedOut] (a direct buffer of at least 128 * 3000 bytes, same layout),
+     *   in the pass that normalizes it
+     * @param arena native scratch for the call (padded audio, spectra), instead of the heap
+     * @return Float array of shape [128 * frames] (flattened row-major mel spectrogram,
+     *   frames = [frames] of it), or null if [cancel] fired
+     */
+    fun compute(
+        audio: FloatArray,
+        suppressNoise: Boolean = false,
+        cancel: CancellationToken? = null,
+        bucketFrames: Int = 0,
+        quantization: MelQuantization? = null,
+        quantizedOut: ByteBuffer? = null,
+        arena: NativeArena? = null
+    ): FloatArray? {
+        checkQuantizedOut(quantizedOut)
+        return nativeComputeMelSpectrogram(
+            audio, suppressNoise, cancel?.handle ?: 0L, bucketFrames,
+            quantization?.type ?: 0, quantization?.scale ?: 1f, quantization?.zeroPoint ?: 0, quantizedOut,
+            arena?.handle ?: 0L
+        )
+    }
+
+    /**
+     * Compute mel spectrogram from two-microphone capture.
+     * The channels are aligned with a GCC-PHAT delay estimate and summed into one
+     * beamformed mono stream before the regular mel pipeline.
+     * @param interleaved 16kHz stereo PCM as [L0, R0, L1, R1, ...]
      */
-    fun compute(audio: FloatArray): FloatArray {
-        return nativeComputeMelSpectrogram(audio)
+    fun computeStereo(
+        interleaved: FloatArray,
+        suppressNoise: Boolean = false,
+        cancel: CancellationToken? = null,
+        bucketFrames: Int = 0,
+        quantization: MelQuantization? = null,
+        quantizedOut: ByteBuffer? = null,
+        arena: NativeArena? = null
+    ): FloatArray? {
+        checkQuantizedOut(quantizedOut)
+        return nativeComputeMelSpectrogramStereo(
+            interleaved, suppressNoise, cancel?.handle ?: 0L, bucketFrames,
+            quantization?.type ?: 0, quantization?.scale ?: 1f, quantization?.zeroPoint ?: 0, quantizedOut,
+            arena?.handle ?: 0L
+        )
+    }
+
+    private fun checkQuantizedOut(quantizedOut: ByteBuffer?) {
+        if (quantizedOut != null && (!quantizedOut.isDirect || quantizedOut.capacity() < N_MELS * N_FRAMES)) {
+            throw IllegalArgumentException("Quantized mel output must be a direct buffer of ${N_MELS * N_FRAMES} bytes")
+        }
     }
 
-    private external fun nativeComputeMelSpectrogram(audio: FloatArray): FloatArray
+    private external fun nativeComputeMelSpectrogram(
+        audio: FloatArray,
+        suppressNoise: Boolean,
+        cancelHandle: Long,
+        bucketFrames: Int,
+        quantType: Int,
+        scale: Float,
+        zeroPoint: Int,
+        quantizedOut: ByteBuffer?,
+        arenaHandle: Long
+    ): FloatArray?
+    private external fun nativeComputeMelSpectrogramStereo(
+        interleaved: FloatArray,
+        suppressNoise: Boolean,
+        cancelHandle: Long,
+        bucketFrames: Int,
+        quantType: Int,
+        scale: Float,
+        zeroPoint: Int,
+        quantizedOut: ByteBuffer?,
+        arenaHandle: Long
+    ): FloatArray?
 }
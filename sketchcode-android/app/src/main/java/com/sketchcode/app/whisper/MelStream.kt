@@ -0,0 +1,61 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for the rolling 30 s log-mel window (mel_stream.cpp).
+ *
+ * Feed it audio while recording with [push]; each chunk only computes the frames it
+ * completes. When [push] returns true, [snapshot] gives an encoder-ready mel of the
+ * last 30 s for an interim transcription, without recomputing older frames. Mono
+ * only and without noise suppression: interim text is a preview, the final
+ * transcription still runs the full pipeline on the whole recording.
+ *
+ * @param snapshotIntervalSeconds how much new audio makes a snapshot due
+ */
+class MelStream(snapshotIntervalSeconds: Float = 2f) {
+    companion object {
+        private const val FRAMES_PER_SECOND = 100   // 16 kHz / hop 160
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    private var handle: Long = nativeCreate((snapshotIntervalSeconds * FRAMES_PER_SECOND).toInt())
+
+    /** Start a new recording. */
+    @Synchronized
+    fun reset() {
+        if (handle != 0L) nativeReset(handle)
+    }
+
+    /** Append [count] 16 kHz mono samples of [samples]; true if a snapshot is due. */
+    @Synchronized
+    fun push(samples: FloatArray, count: Int = samples.size): Boolean =
+        handle != 0L && nativePush(handle, samples, count)
+
+    /**
+     * Write the normalized [128 * 3000] mel of the last 30 s into [out].
+     * @return frames of the window that hold audio, or -1 if [out] is too small
+     */
+    @Synchronized
+    fun snapshot(out: FloatArray): Int = if (handle != 0L) nativeSnapshot(handle, out) else -1
+
+    /** Samples pushed since the last [reset]. */
+    val samples: Long
+        @Synchronized get() = if (handle != 0L) nativeSamples(handle) else 0L
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(snapshotIntervalFrames: Int): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeReset(handle: Long)
+    private external fun nativePush(handle: Long, samples: FloatArray, count: Int): Boolean
+    private external fun nativeSnapshot(handle: Long, out: FloatArray): Int
+    private external fun nativeSamples(handle: Long): Long
+}
@@ -15,11 +15,17 @@ import java.io.File
  * Layout:
  *   {externalFilesDir}/models/encoder/model.onnx + model.bin
  *   {externalFilesDir}/models/decoder/model.onnx + model.bin
+ *   {externalFilesDir}/models/encoder_10s/model.onnx + model.bin   (optional, any encoder_<N>s)
+ *
+ * The optional encoders take shorter mel inputs for short clips; WhisperInference
+ * reads their input length from the model and only uses those whose cross-attention
+ * outputs the decoder accepts.
  */
 class ModelManager(context: Context) {
     companion object {
         private const val TAG = "ModelManager"
         private const val MODELS_DIR = "models"
+        private val ENCODER_VARIANT_DIR = Regex("encoder_\\d+s")
     }
 
     private val modelsDir: File = File(context.getExternalFilesDir(null), MODELS_DIR)
@@ -29,6 +35,14 @@ class ModelManager(context: Context) {
     val encoderOnnxPath: String get() = File(encoderDir, "model.onnx").absolutePath
     val decoderOnnxPath: String get() = File(decoderDir, "model.onnx").absolutePath
 
+    /** model.onnx of every complete encoder_<N>s directory. */
+    val encoderVariantPaths: List<String>
+        get() = modelsDir.listFiles { f -> f.isDirectory && ENCODER_VARIANT_DIR.matches(f.name) }
+            .orEmpty()
+            .filter { dir -> listOf("model.onnx", "model.bin").all { File(dir, it).length() > 0 } }
+            .sortedBy { it.name }
+            .map { File(it, "model.onnx").absolutePath }
+
     init {
         // Create directories so they're owned by the app (not shell)
         // adb push can then write files into app-owned directories
@@ -0,0 +1,62 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for a native bump-pointer arena (arena.h).
+ *
+ * One arena per worker thread: native stages that are given it ([MelSpectrogram])
+ * take their per-utterance scratch from it instead of the heap, and release it when
+ * they return. [reset] at the end of each transcription folds the blocks a long
+ * utterance grew into one, so once warmed up a transcription allocates nothing
+ * natively. Calls on one arena must not overlap.
+ *
+ * @param initialBytes capacity to reserve up front (0: grow on the first utterance)
+ */
+class NativeArena(initialBytes: Long = 0L) {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Memory use of the arena, in bytes. */
+    data class Stats(
+        val used: Long,
+        /** Largest [used] since creation: what one transcription needs. */
+        val highWater: Long,
+        val capacity: Long,
+        val blocks: Int,
+        /** Blocks ever taken from the heap; stops growing after warm-up. */
+        val heapBlocks: Long,
+        val resets: Long
+    )
+
+    /** Native handle, passed to the stages that allocate from the arena. */
+    internal var handle: Long = nativeCreate(initialBytes)
+        private set
+
+    /** Release everything allocated; keeps the memory for the next transcription. */
+    @Synchronized
+    fun reset() {
+        if (handle != 0L) nativeReset(handle)
+    }
+
+    val stats: Stats
+        @Synchronized get() {
+            val values = if (handle != 0L) nativeStats(handle) else null
+            if (values == null || values.size < 6) return Stats(0, 0, 0, 0, 0, 0)
+            return Stats(values[0], values[1], values[2], values[3].toInt(), values[4], values[5])
+        }
+
+    @Synchronized
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(initialBytes: Long): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeReset(handle: Long)
+    private external fun nativeStats(handle: Long): LongArray?
+}
@@ -0,0 +1,140 @@
+package com.sketchcode.app.whisper
+
+import android.util.Log
+import java.nio.ByteBuffer
+
+/**
+ * Kotlin JNI wrapper for the native decoder loop (native_decoder.cpp).
+ *
+ * Owns a second decoder session on the ONNX Runtime C API and runs a whole decode
+ * attempt in one call: the encoder's cross-attention buffers go in, token IDs come
+ * out. Inputs, logits and the ping-pong self-attention caches are bound once through
+ * an IoBinding, so the per-step input map, JNI crossings and output tensors of the
+ * Kotlin loop disappear. Token choice, suppression rules and the stop guard are the
+ * same native objects the Kotlin loop uses, passed by handle.
+ *
+ * [isLoaded] is false when the library was built without ONNX Runtime headers or the
+ * model failed to load; callers then keep the Kotlin loop.
+ */
+class NativeDecoder(
+    modelPath: String,
+    qnnOptions: Map<String, String>,
+    configEntries: Map<String, String> = emptyMap()
+) {
+    companion object {
+        private const val TAG = "NativeDecoder"
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    private var handle: Long = nativeCreate(
+        modelPath, qnnOptions.isNotEmpty(),
+        qnnOptions.keys.toTypedArray(), qnnOptions.values.toTypedArray(),
+        configEntries.keys.toTypedArray(), configEntries.values.toTypedArray()
+    )
+
+    val isLoaded: Boolean
+        get() = handle != 0L
+
+    // Partial-text target of the decode in progress
+    private var stream: StreamingDetokenizer? = null
+    private var onPartial: ((String) -> Unit)? = null
+
+    /**
+     * Decode one attempt.
+     * @param crossK,crossV per-layer direct fp16 encoder outputs (k_cache_cross_N / v_cache_cross_N)
+     * @param sotIndex position of SOT in [prompt], where the no-speech probability is read
+     * @param guard reset by the caller for this utterance
+     * @param stream if set, reset and fed every kept token; [onPartial] then gets the
+     *        text so far, on the calling thread, whenever it grows
+     * @param outTokens receives the text tokens (no EOT, no timestamps); its size is the token limit
+     * @param cancel polled before every decoder run; a cancelled attempt stops with
+     *        [DecodeGuard.STOP_CANCELLED]
+     * @return number of tokens written
+     */
+    fun decode(
+        crossK: Array<ByteBuffer>,
+        crossV: Array<ByteBuffer>,
+        prompt: IntArray,
+        sotIndex: Int,
+        processor: LogitProcessor,
+        guard: DecodeGuard,
+        scorer: DecodeScorer,
+        temperature: Float,
+        outTokens: IntArray,
+        stream: StreamingDetokenizer? = null,
+        onPartial: ((String) -> Unit)? = null,
+        cancel: CancellationToken? = null
+    ): Int {
+        if (handle == 0L) return 0
+        stream?.reset()
+        this.stream = stream
+        this.onPartial = onPartial
+        try {
+            return nativeDecode(
+                handle, crossK, crossV, prompt, sotIndex, processor.handle, guard.handle, scorer.handle,
+                if (onPartial != null) stream?.handle ?: 0L else 0L, cancel?.handle ?: 0L, temperature,
+                WhisperTokenizer.EOT, WhisperTokenizer.FIRST_TIMESTAMP, outTokens
+            )
+        } finally {
+            this.stream = null
+            this.onPartial = null
+        }
+    }
+
+    // Called from nativeDecode each time the stream completes more characters
+    @Suppress("unused")
+    private fun onStreamedText() {
+        val text = stream?.text ?: return
+        try {
+            onPartial?.invoke(text)
+        } catch (e: Exception) {
+            Log.w(TAG, "Partial text listener failed: ${e.message}")
+        }
+    }
+
+    /** DecodeGuard stop reason of the last [decode], or [DecodeGuard.CONTINUE]. */
+    val lastStopReason: Int
+        get() = if (handle != 0L) nativeLastStopReason(handle) else DecodeGuard.CONTINUE
+
+    /** Decoder runs of the last [decode], prompt included. */
+    val lastSteps: Int
+        get() = if (handle != 0L) nativeLastSteps(handle) else 0
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(
+        modelPath: String,
+        qnn: Boolean,
+        qnnKeys: Array<String>,
+        qnnValues: Array<String>,
+        configKeys: Array<String>,
+        configValues: Array<String>
+    ): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeDecode(
+        handle: Long,
+        crossK: Array<ByteBuffer>,
+        crossV: Array<ByteBuffer>,
+        prompt: IntArray,
+        sotIndex: Int,
+        processorHandle: Long,
+        guardHandle: Long,
+        scorerHandle: Long,
+        streamHandle: Long,
+        cancelHandle: Long,
+        temperature: Float,
+        eot: Int,
+        timestampBegin: Int,
+        outTokens: IntArray
+    ): Int
+    private external fun nativeLastStopReason(handle: Long): Int
+    private external fun nativeLastSteps(handle: Long): Int
+}
@@ -0,0 +1,40 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+
+/**
+ * JNI bindings for the bulk fp16 conversions (fp16_convert.cpp): NEON fcvtl/fcvtn on
+ * device, F16C or a scalar fallback on hosts, round-to-nearest-even on every path.
+ *
+ * fp16 data lives in direct ByteBuffers in native byte order (the pinned tensor
+ * memory ORT reads and writes); the fp32 side is a FloatArray or another direct
+ * buffer. Each call returns false if a buffer is not direct or is too small.
+ */
+object NativeFp16 {
+    init {
+        System.loadLibrary("whisper_mel")
+    }
+
+    /** "neon", "f16c" or "scalar". */
+    val backend: String by lazy { nativeBackend() }
+
+    /** Narrow [count] floats of [src] starting at [offset] into the fp16 buffer [dst]. */
+    fun toFp16(src: FloatArray, dst: ByteBuffer, offset: Int = 0, count: Int = src.size - offset): Boolean =
+        nativeFloatsToFp16(src, offset, dst, count)
+
+    /** Widen [count] fp16 values of [src] into [dst] starting at [offset]. */
+    fun toFloat(src: ByteBuffer, dst: FloatArray, offset: Int = 0, count: Int = dst.size - offset): Boolean =
+        nativeFp16ToFloats(src, dst, offset, count)
+
+    /** Narrow [count] fp32 values from a direct buffer into a direct fp16 buffer. */
+    fun toFp16(src: ByteBuffer, dst: ByteBuffer, count: Int): Boolean = nativeBufferToFp16(src, dst, count)
+
+    /** Widen [count] fp16 values from a direct buffer into a direct fp32 buffer. */
+    fun toFloat(src: ByteBuffer, dst: ByteBuffer, count: Int): Boolean = nativeBufferToFloat(src, dst, count)
+
+    private external fun nativeFloatsToFp16(src: FloatArray, offset: Int, dst: ByteBuffer, count: Int): Boolean
+    private external fun nativeFp16ToFloats(src: ByteBuffer, dst: FloatArray, offset: Int, count: Int): Boolean
+    private external fun nativeBufferToFp16(src: ByteBuffer, dst: ByteBuffer, count: Int): Boolean
+    private external fun nativeBufferToFloat(src: ByteBuffer, dst: ByteBuffer, count: Int): Boolean
+    private external fun nativeBackend(): String
+}
@@ -0,0 +1,37 @@
+package com.sketchcode.app.whisper
+
+import java.nio.ByteBuffer
+
+/**
+ * JNI bindings for the native logits kernels (logits.cpp).
+ *
+ * All functions read the decoder's logits straight from a direct ByteBuffer in
+ * native byte order, so no per-step FloatArray or fp16 conversion is needed.
+ */
+object NativeLogits {
+    init {
+        System.loadLibrary("whisper_mel")
+    }
+
+    /** Index of the largest of [count] fp16 logits. */
+    fun argmaxFp16(logits: ByteBuffer, count: Int): Int = nativeArgmaxFp16(logits, count)
+
+    /** Index of the largest of [count] fp32 logits. */
+    fun argmaxFp32(logits: ByteBuffer, count: Int): Int = nativeArgmaxFp32(logits, count)
+
+    /**
+     * Partial top-k of [count] fp16 logits, best first, into preallocated arrays.
+     * At most 64 entries; returns the number written.
+     */
+    fun topKFp16(logits: ByteBuffer, count: Int, k: Int, outIndices: IntArray, outValues: FloatArray): Int =
+        nativeTopKFp16(logits, count, k, outIndices, outValues)
+
+    /** fp32 variant of [topKFp16]. */
+    fun topKFp32(logits: ByteBuffer, count: Int, k: Int, outIndices: IntArray, outValues: FloatArray): Int =
+        nativeTopKFp32(logits, count, k, outIndices, outValues)
+
+    private external fun nativeArgmaxFp16(logits: ByteBuffer, count: Int): Int
+    private external fun nativeArgmaxFp32(logits: ByteBuffer, count: Int): Int
+    private external fun nativeTopKFp16(logits: ByteBuffer, count: Int, k: Int, outIndices: IntArray, outValues: FloatArray): Int
+    private external fun nativeTopKFp32(logits: ByteBuffer, count: Int, k: Int, outIndices: IntArray, outValues: FloatArray): Int
+}
@@ -0,0 +1,50 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for the incremental detokenizer (stream_detokenizer.cpp).
+ *
+ * Tokens are pushed one at a time as the decoder picks them; [text] is the transcript
+ * so far with any character still split across tokens held back, so partial results
+ * can go to the UI without garbled UTF-8. The native decoder pushes into the same
+ * object by handle. The vocabulary must outlive the detokenizer.
+ */
+class StreamingDetokenizer(vocabulary: Vocabulary) {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to [NativeDecoder]. */
+    internal var handle: Long = nativeCreate(vocabulary.handle)
+        private set
+
+    init {
+        if (handle == 0L) throw IllegalStateException("Vocabulary is not open")
+    }
+
+    /** Start a new transcript. */
+    fun reset() {
+        if (handle != 0L) nativeReset(handle)
+    }
+
+    /** Append one token; true if [text] grew. Special tokens add nothing. */
+    fun push(token: Int): Boolean = handle != 0L && nativePush(handle, token)
+
+    /** Complete characters so far. */
+    val text: String
+        get() = if (handle != 0L) String(nativeText(handle) ?: ByteArray(0), Charsets.UTF_8) else ""
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(vocabHandle: Long): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeReset(handle: Long)
+    private external fun nativePush(handle: Long, token: Int): Boolean
+    private external fun nativeText(handle: Long): ByteArray?
+}
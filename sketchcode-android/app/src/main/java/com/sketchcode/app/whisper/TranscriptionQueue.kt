@@ -0,0 +1,79 @@
+package com.sketchcode.app.whisper
+
+/**
+ * Kotlin JNI wrapper for the native two-stage transcription pipeline (transcription_queue.cpp).
+ *
+ * Two native worker threads run the [Stages] callbacks: one the front end (mel and
+ * encoder) and one the decoder. Utterances decode one at a time in submission order,
+ * while the next utterance's front end already runs into the other encoder-output
+ * slot. Every accepted job gets exactly one [Stages.onComplete], on a worker thread.
+ *
+ * @param maxPending jobs that may be queued or running at once; [submit] refuses more
+ * @param slots encoder-output buffer sets the stages rotate through (2 = one job ahead)
+ */
+class TranscriptionQueue(maxPending: Int, slots: Int, stages: Stages) {
+    companion object {
+        // Stage results (TranscriptionJobStatus)
+        const val CONTINUE = 0
+        const val DONE = 1
+        const val CANCELLED = 2
+        const val FAILED = 3
+        const val HANDLED = 4
+
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Called on the native worker threads. [slot] is owned by the job until its decode returns. */
+    interface Stages {
+        /** Mel + encoder into [slot]; [CONTINUE] to decode, or a final status. */
+        fun frontEnd(jobId: Long, slot: Int): Int
+        /** Decoder loop over [slot]; the final status. */
+        fun decode(jobId: Long, slot: Int): Int
+        fun onComplete(jobId: Long, status: Int)
+    }
+
+    private var handle: Long = nativeCreate(maxPending, slots, stages)
+
+    init {
+        if (handle == 0L) throw IllegalStateException("Cannot create transcription queue")
+    }
+
+    /** Queue [jobId] (unique per job); false if the queue is full or released. */
+    fun submit(jobId: Long): Boolean = handle != 0L && nativeSubmit(handle, jobId)
+
+    /** Skip the stages [jobId] has not started; it completes as [CANCELLED]. */
+    fun cancel(jobId: Long): Boolean = handle != 0L && nativeCancel(handle, jobId)
+
+    fun cancelAll() {
+        if (handle != 0L) nativeCancelAll(handle)
+    }
+
+    /** True once [jobId] is cancelled (or no longer live); stages can poll it. */
+    fun isCancelled(jobId: Long): Boolean = handle == 0L || nativeIsCancelled(handle, jobId)
+
+    /** Jobs queued or running. */
+    val pending: Int
+        get() = if (handle != 0L) nativePending(handle) else 0
+
+    /**
+     * Cancel all jobs and join the workers. Blocks until running stages return, so
+     * it must not be called from a stage, nor while holding a lock a stage takes.
+     */
+    fun release() {
+        if (handle != 0L) {
+            val h = handle
+            handle = 0L
+            nativeDestroy(h)
+        }
+    }
+
+    private external fun nativeCreate(maxPending: Int, slots: Int, stages: Stages): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeSubmit(handle: Long, jobId: Long): Boolean
+    private external fun nativeCancel(handle: Long, jobId: Long): Boolean
+    private external fun nativeCancelAll(handle: Long)
+    private external fun nativeIsCancelled(handle: Long, jobId: Long): Boolean
+    private external fun nativePending(handle: Long): Int
+}
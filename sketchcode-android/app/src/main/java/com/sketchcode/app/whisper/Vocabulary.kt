@@ -0,0 +1,55 @@
+package com.sketchcode.app.whisper
+
+import android.content.res.AssetManager
+
+/**
+ * Kotlin JNI wrapper for the memory-mapped vocabulary (vocabulary.cpp).
+ *
+ * vocab.bin is packed from vocab.json at build time (the packVocab Gradle task) and
+ * mapped straight out of the APK, so loading costs a few page faults instead of a
+ * JSON parse, and lookups create no per-token objects: token bytes are already
+ * UTF-8 fragments, and a hash table keyed by those bytes maps text back to ids.
+ */
+class Vocabulary(assets: AssetManager, name: String = "vocab.bin") {
+    companion object {
+        init {
+            System.loadLibrary("whisper_mel")
+        }
+    }
+
+    /** Native handle, also passed to the native tokenizer code. */
+    internal var handle: Long = nativeOpenAsset(assets, name)
+        private set
+
+    init {
+        if (handle == 0L) throw IllegalStateException("Cannot map vocabulary asset $name")
+    }
+
+    /** Number of text tokens (ids below this have bytes; specials do not). */
+    val count: Int
+        get() = if (handle != 0L) nativeCount(handle) else 0
+
+    /** Token whose bytes are exactly the UTF-8 of [text], or null. */
+    fun lookup(text: String): Int? {
+        if (handle == 0L) return null
+        val token = nativeLookup(handle, text.toByteArray(Charsets.UTF_8))
+        return if (token >= 0) token else null
+    }
+
+    /** Concatenated UTF-8 bytes of the first [count] tokens; specials contribute nothing. */
+    fun decodeBytes(tokens: IntArray, count: Int = tokens.size): ByteArray =
+        if (handle != 0L) nativeDecode(handle, tokens, count) ?: ByteArray(0) else ByteArray(0)
+
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeOpenAsset(assets: AssetManager, name: String): Long
+    private external fun nativeDestroy(handle: Long)
+    private external fun nativeCount(handle: Long): Int
+    private external fun nativeLookup(handle: Long, bytes: ByteArray): Int
+    private external fun nativeDecode(handle: Long, tokens: IntArray, numTokens: Int): ByteArray?
+}
@@ -6,12 +6,10 @@ import ai.onnxruntime.OrtEnvironment
 import ai.onnxruntime.OrtLoggingLevel
 import ai.onnxruntime.OrtProvider
 import ai.onnxruntime.OrtSession
-import ai.onnxruntime.platform.Fp16Conversions
+import ai.onnxruntime.TensorInfo
 import android.util.Log
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
-import java.nio.FloatBuffer
-import java.nio.IntBuffer
 import java.nio.ShortBuffer
 
 /**
@@ -49,17 +47,171 @@ class WhisperInference(
         private const val ENCODER_SEQ = 1500
         private const val CACHE_LEN = 199        // MEAN_DECODE_LEN - 1
         private const val ATTN_MASK_SIZE = 200    // MEAN_DECODE_LEN
+        private const val DEBUG_TOP_K = 5
+        // Context tokens before SOT: each costs a decoder step and a self-attention slot
+        const val MAX_CONTEXT_TOKENS = 32
+        // Encoder-output sets: one utterance can encode while the previous one decodes
+        const val ENCODER_SLOTS = 2
+        // Mel trimming granularity (5 s) when an encoder takes shorter inputs
+        const val DEFAULT_BUCKET_FRAMES = 500
+        // Self-attention cache shapes
+        private val K_CACHE_SELF_SHAPE = longArrayOf(N_HEADS.toLong(), 1, HEAD_DIM.toLong(), CACHE_LEN.toLong())
+        private val V_CACHE_SELF_SHAPE = longArrayOf(N_HEADS.toLong(), 1, CACHE_LEN.toLong(), HEAD_DIM.toLong())
+        // Whisper's fallback schedule: re-decode at rising temperature until the scores pass
+        private val FALLBACK_TEMPERATURES = floatArrayOf(0.0f, 0.2f, 0.4f, 0.6f, 0.8f, 1.0f)
         // Mask value for "don't attend": Qualcomm uses -100.0, but -inf also works
         // In fp16: -100.0 = 0xD640, -inf = 0xFC00
         private const val MASK_NEG_FP16: Short = 0xD640.toShort()  // fp16 for -100.0
-        private const val MASK_ZERO_FP16: Short = 0x0000           // fp16 for 0.0
+        // Decoder input names, built once instead of per step
+        private val K_CACHE_SELF_IN = Array(N_LAYERS) { "k_cache_self_${it}_in" }
+        private val V_CACHE_SELF_IN = Array(N_LAYERS) { "v_cache_self_${it}_in" }
+        private val K_CACHE_SELF_OUT = Array(N_LAYERS) { "k_cache_self_${it}_out" }
+        private val V_CACHE_SELF_OUT = Array(N_LAYERS) { "v_cache_self_${it}_out" }
+        private val K_CACHE_CROSS = Array(N_LAYERS) { "k_cache_cross_$it" }
+        private val V_CACHE_CROSS = Array(N_LAYERS) { "v_cache_cross_$it" }
     }
 
     private var env: OrtEnvironment? = null
     private var encoderSession: OrtSession? = null
     private var decoderSession: OrtSession? = null
 
-    fun initialize() {
+    // Pinned decoder output: ORT writes the logits of every step into this one direct
+    // buffer, and the native argmax reads it in place (no per-step FloatArray).
+    private var logitsBuffer: ByteBuffer? = null
+    private var logitsTensor: OnnxTensor? = null
+    private var logitsFp16 = true
+    private val topKIndices = IntArray(DEBUG_TOP_K)
+    private val topKValues = FloatArray(DEBUG_TOP_K)
+
+    // Attention masks, input scalars and zero caches, preallocated natively once
+    private var inputPool: DecoderInputPool? = null
+    private val stepInputs = HashMap<String, OnnxTensor>()
+
+    // Greedy self-attention caches alternate between two preallocated sets, written as
+    // pinned outputs; stepOutputs is the reused logits + cache output map
+    private var kvPingPong: KvCachePingPong? = null
+    private val stepOutputs = HashMap<String, OnnxTensor>()
+    private var decoderSteps = 0
+    private var runtimeAllocations = 0
+
+    // Whisper's suppression / timestamp rules, applied natively to the pinned logits
+    private var logitProcessor: LogitProcessor? = null
+    // Identifier trie of the file on screen, attached to the logit processor
+    private var contextBias: ContextBias? = null
+    private val sampledTokens = IntArray(MAX_TOKENS + 1)
+
+    // Stops on repetition loops or once the duration-derived token budget is spent
+    private var decodeGuard: DecodeGuard? = null
+
+    // Confidence / compression scoring and sampling for the temperature fallback
+    private var decodeScorer: DecodeScorer? = null
+
+    // Encoder input pinned once: each call narrows (fp16) or quantizes (int8/uint8) the mel into it natively
+    private var melBuffer: ByteBuffer? = null
+    private var melTensor: OnnxTensor? = null
+
+    // Encoder outputs pinned to direct buffers, one set per slot: the cross-attention caches
+    // are written in place, so both decoder loops read them without a copy
+    private var crossBuffers: Array<Map<String, ByteBuffer>> = Array(ENCODER_SLOTS) { emptyMap() }
+    private var crossTensors: Array<Map<String, OnnxTensor>> = Array(ENCODER_SLOTS) { emptyMap() }
+    // What each slot's decode reads, and the encoder results that back it when not pinned
+    private val slotCaches = arrayOfNulls<Map<String, OnnxTensor>>(ENCODER_SLOTS)
+    private val slotResults = arrayOfNulls<OrtSession.Result>(ENCODER_SLOTS)
+    // Mel of each slot's utterance; the decode guard derives its token budget from it
+    private val slotMels = arrayOfNulls<FloatArray>(ENCODER_SLOTS)
+    // Slots encoded from a trimmed input: their caches are not the full-length pinned set
+    // the native decoder binds, so they decode in Kotlin
+    private val slotTrimmed = BooleanArray(ENCODER_SLOTS)
+
+    /**
+     * A shorter fixed-input encoder build (ModelManager.encoderVariantPaths). Its mel
+     * input and cross-attention outputs are views over the same pinned buffers as the
+     * 30 s encoder's, in its own shapes.
+     */
+    private class EncoderVariant(
+        val session: OrtSession,
+        val frames: Int,
+        val melTensor: OnnxTensor,
+        val crossTensors: Array<Map<String, OnnxTensor>>
+    ) {
+        fun close() {
+            melTensor.close()
+            crossTensors.forEach { tensors -> tensors.values.forEach { it.close() } }
+            session.close()
+        }
+    }
+    // By input frames, ascending
+    private val encoderVariants = ArrayList<EncoderVariant>()
+    // The 30 s encoder was exported with a dynamic frame count (and the decoder takes the
+    // matching cross-attention lengths): mel views per trimmed length, made on first use
+    private var dynamicEncoder = false
+    private val dynamicMelTensors = HashMap<Int, OnnxTensor>()
+    // Trimmed mel padded out to a longer encoder input, reused
+    private var paddedMel: FloatArray? = null
+
+    // Whole-attempt native decoder loop (C API + IoBinding); null when unavailable
+    private var nativeDecoder: NativeDecoder? = null
+    private val nativeTokens = IntArray(MAX_TOKENS)
+
+    // Partial transcript of the attempt in progress, for decode()'s onPartial
+    private var partialText: StreamingDetokenizer? = null
+
+    // Beam search (width > 1): created on first use, recreated when the width changes
+    private var beamSearch: BeamSearch? = null
+    private val beamTokens = IntArray(MAX_TOKENS)
+    private val freedSlots = IntArray(BeamSearch.MAX_SLOTS)
+
+    /** Stage timings of the most recent encode() / decode() calls, for latency capture. */
+    var lastEncoderMs = 0L
+        private set
+    var lastDecoderMs = 0L
+        private set
+    var lastTokenCount = 0
+        private set
+    /** Why the most recent decode stopped early: a DecodeGuard stop reason, or CONTINUE. */
+    var lastStopReason = DecodeGuard.CONTINUE
+        private set
+    /** Decode attempts of the most recent decode() call (1 = no temperature fallback). */
+    var lastAttempts = 0
+        private set
+    /** Decoder outputs the runtime allocated per step in the most recent call (0 when fully pinned). */
+    var lastAllocationsPerStep = 0f
+        private set
+    /** Mel frames the encoder of the most recent encode() call took. */
+    var lastEncoderFrames = N_FRAMES
+        private set
+
+    /**
+     * bucketFrames to pass to [MelSpectrogram.compute]: 0 (full 30 s mel) unless a
+     * shorter-input encoder is loaded, in which case [encode] runs the smallest one that
+     * fits the trimmed mel.
+     */
+    var melBucketFrames = 0
+        private set
+
+    /**
+     * Quantization of the encoder's mel input when it is int8/uint8 (from the model's
+     * mel_scale / mel_zero_point metadata, else [MelQuantization.default]); null for a
+     * float encoder.
+     */
+    var melQuantization: MelQuantization? = null
+        private set
+
+    /**
+     * The pinned int8/uint8 encoder input, for MelSpectrogram.compute(quantizedOut = ...)
+     * to write into directly; pass melQuantized = true to the [encode] that follows, on
+     * the same thread. Null for a float encoder.
+     */
+    val quantizedMelInput: ByteBuffer?
+        get() = if (melQuantization != null) melBuffer else null
+
+    /**
+     * @param nativeDecoding decode greedy/sampled attempts with [NativeDecoder] when the
+     *   library was built with ONNX Runtime; beam search stays on the Kotlin loop
+     * @param bucketFrames mel trimming granularity ([melBucketFrames]) when an encoder
+     *   takes shorter inputs: a dynamic-length export runs every multiple of it
+     */
+    fun initialize(nativeDecoding: Boolean = true, bucketFrames: Int = DEFAULT_BUCKET_FRAMES) {
         env = OrtEnvironment.getEnvironment(OrtLoggingLevel.ORT_LOGGING_LEVEL_VERBOSE)
         Log.i(TAG, "OrtEnvironment created")
 
@@ -90,102 +242,479 @@ class WhisperInference(
         val decoderOpts = OrtSession.SessionOptions()
         decoderOpts.addQnn(qnnOpts)
         decoderOpts.addConfigEntry("ep.context_file_path", decoderPath)
+        // The native decoder loads the same context; let the two sessions share it
+        decoderOpts.addConfigEntry("ep.share_ep_contexts", "1")
         decoderSession = env!!.createSession(decoderPath, decoderOpts)
         Log.i(TAG, "Decoder session created!")
         logSessionInfo("Decoder", decoderSession!!)
+
+        createPinnedLogits(env!!, decoderSession!!)
+        createPinnedMel(env!!, encoderSession!!)
+        createPinnedCrossCaches(env!!, encoderSession!!)
+        dynamicEncoder = inputFrames(encoderSession!!) <= 0 && acceptsCrossCaches(encoderSession!!, decoderSession!!)
+        loadEncoderVariants(env!!, qnnOpts, decoderSession!!)
+        melBucketFrames = if (dynamicEncoder || encoderVariants.isNotEmpty()) bucketFrames.coerceIn(1, N_FRAMES) else 0
+        Log.i(TAG, "Encoder inputs: ${encoderVariants.map { it.frames } + N_FRAMES} frames" +
+                (if (dynamicEncoder) ", dynamic" else "") + ", mel bucket $melBucketFrames")
+        kvPingPong = KvCachePingPong(
+            env!!, N_LAYERS, K_CACHE_SELF_SHAPE, V_CACHE_SELF_SHAPE, K_CACHE_SELF_OUT, V_CACHE_SELF_OUT
+        ).also { Log.i(TAG, "Ping-pong self-attention caches: ${it.bytes / 1024} KB") }
+        inputPool = DecoderInputPool(
+            env!!, ATTN_MASK_SIZE, ATTN_MASK_SIZE, MASK_NEG_FP16, N_LAYERS, K_CACHE_SELF_SHAPE, V_CACHE_SELF_SHAPE
+        )
+        logitProcessor = LogitProcessor(VOCAB_SIZE, tokenizer.suppressTokens, tokenizer.blankToken)
+        contextBias = ContextBias().also { logitProcessor!!.setContextBias(it) }
+        decodeGuard = DecodeGuard(MAX_TOKENS)
+        decodeScorer = DecodeScorer(VOCAB_SIZE)
+        partialText = tokenizer.streamingDetokenizer()
+
+        if (nativeDecoding && crossBuffers[0].size == 2 * N_LAYERS) {
+            val native = NativeDecoder(
+                decoderPath, qnnOpts,
+                mapOf("ep.context_file_path" to decoderPath, "ep.share_ep_contexts" to "1")
+            )
+            if (native.isLoaded) {
+                nativeDecoder = native
+                Log.i(TAG, "Native decoder loop enabled")
+            } else {
+                native.release()
+                Log.w(TAG, "Native decoder unavailable, decoding in Kotlin")
+            }
+        }
+    }
+
+    /** Allocate the encoder's mel input once: fp16, or int8/uint8 for a quantized encoder. */
+    private fun createPinnedMel(env: OrtEnvironment, encoder: OrtSession) {
+        melQuantization = when (inputType(encoder)) {
+            OnnxJavaType.INT8 -> quantizationOf(encoder, MelQuantization.INT8)
+            OnnxJavaType.UINT8 -> quantizationOf(encoder, MelQuantization.UINT8)
+            else -> null
+        }
+        val bytesPerValue = if (melQuantization != null) 1 else 2
+        melBuffer = ByteBuffer.allocateDirect(N_MELS * N_FRAMES * bytesPerValue).order(ByteOrder.nativeOrder())
+        melTensor = melInputView(env, N_FRAMES)
+        Log.i(TAG, "Pinned mel input (" + (melQuantization?.toString() ?: "fp16 conversion: ${NativeFp16.backend}") + ")")
+    }
+
+    /** The quantized encoder's own input parameters if its metadata has them. */
+    private fun quantizationOf(encoder: OrtSession, type: Int): MelQuantization {
+        val custom = try {
+            encoder.metadata.customMetadata
+        } catch (e: Exception) {
+            emptyMap<String, String>()
+        }
+        val scale = custom["mel_scale"]?.toFloatOrNull()
+        val zeroPoint = custom["mel_zero_point"]?.toIntOrNull()
+        return if (scale != null && scale > 0f && zeroPoint != null) {
+            MelQuantization(type, scale, zeroPoint)
+        } else {
+            MelQuantization.default(type)
+        }
+    }
+
+    /** The first [frames] frames of the pinned mel buffer as an encoder input. */
+    private fun melInputView(env: OrtEnvironment, frames: Int): OnnxTensor {
+        val shape = longArrayOf(1, N_MELS.toLong(), frames.toLong())
+        val quant = melQuantization
+            ?: return OnnxTensor.createTensor(env, fp16View(melBuffer!!, N_MELS * frames), shape, OnnxJavaType.FLOAT16)
+        val bytes = melBuffer!!.duplicate().apply { limit(N_MELS * frames) }
+        val type = if (quant.type == MelQuantization.INT8) OnnxJavaType.INT8 else OnnxJavaType.UINT8
+        return OnnxTensor.createTensor(env, bytes, shape, type)
+    }
+
+    /**
+     * Allocate the encoder's cross-attention outputs once as direct fp16 buffers. Left
+     * empty (encoder outputs come back as fresh tensors) if any output is not fp16.
+     */
+    private fun createPinnedCrossCaches(env: OrtEnvironment, encoder: OrtSession) {
+        for (slot in 0 until ENCODER_SLOTS) {
+            val buffers = HashMap<String, ByteBuffer>()
+            val tensors = HashMap<String, OnnxTensor>()
+            for ((name, nodeInfo) in encoder.outputInfo) {
+                val info = nodeInfo.info as? TensorInfo
+                if (info == null || info.type != OnnxJavaType.FLOAT16 || info.shape.any { it <= 0 }) {
+                    tensors.values.forEach { it.close() }
+                    Log.w(TAG, "Encoder output $name is not fixed-shape fp16; cross caches not pinned")
+                    return
+                }
+                val elements = info.shape.fold(1L) { n, d -> n * d }
+                val buf = ByteBuffer.allocateDirect((elements * 2).toInt()).order(ByteOrder.nativeOrder())
+                buffers[name] = buf
+                tensors[name] = OnnxTensor.createTensor(env, buf.asShortBuffer(), info.shape, OnnxJavaType.FLOAT16)
+            }
+            crossBuffers[slot] = buffers
+            crossTensors[slot] = tensors
+        }
+        Log.i(TAG, "Pinned ${crossTensors[0].size} encoder outputs x $ENCODER_SLOTS slots")
+    }
+
+    /**
+     * Load the shorter-input encoders. A variant is skipped if its cross-attention outputs
+     * do not fit the decoder's inputs (a fixed 1500-position decoder only takes 30 s
+     * encoders), or if it fails to load.
+     */
+    private fun loadEncoderVariants(env: OrtEnvironment, qnnOpts: Map<String, String>, decoder: OrtSession) {
+        for (path in modelManager.encoderVariantPaths) {
+            val session = try {
+                val opts = OrtSession.SessionOptions()
+                opts.addQnn(qnnOpts)
+                opts.addConfigEntry("ep.context_file_path", path)
+                env.createSession(path, opts)
+            } catch (e: Exception) {
+                Log.w(TAG, "Encoder variant $path failed to load: ${e.message}")
+                continue
+            }
+            val frames = inputFrames(session)
+            if (frames <= 0 || frames >= N_FRAMES || inputType(session) != inputType(encoderSession!!) ||
+                !acceptsCrossCaches(session, decoder)) {
+                Log.w(TAG, "Encoder variant $path skipped: $frames ${inputType(session)} input frames, " +
+                        "outputs ${session.outputInfo.values.map { it.info }}")
+                session.close()
+                continue
+            }
+            val mel = melInputView(env, frames)
+            val cross = Array(ENCODER_SLOTS) { slot -> crossViews(env, session, crossBuffers[slot]) }
+            encoderVariants.add(EncoderVariant(session, frames, mel, cross))
+            Log.i(TAG, "Encoder variant: $frames frames from $path")
+        }
+        encoderVariants.sortBy { it.frames }
     }
 
+    private fun inputType(encoder: OrtSession): OnnxJavaType? =
+        (encoder.inputInfo[encoder.inputNames.first()]?.info as? TensorInfo)?.type
+
+    /** Frame count of an encoder's mel input; -1 if dynamic. */
+    private fun inputFrames(encoder: OrtSession): Int {
+        val shape = (encoder.inputInfo[encoder.inputNames.first()]?.info as? TensorInfo)?.shape
+        return shape?.getOrNull(2)?.toInt() ?: -1
+    }
+
+    /** Whether every cross-attention output of [encoder] fits the decoder input of the same name. */
+    private fun acceptsCrossCaches(encoder: OrtSession, decoder: OrtSession): Boolean =
+        encoder.outputInfo.all { (name, nodeInfo) ->
+            val out = (nodeInfo.info as? TensorInfo)?.shape
+            val input = (decoder.inputInfo[name]?.info as? TensorInfo)?.shape
+            out != null && input != null && out.size == input.size &&
+                    out.indices.all { out[it] == input[it] || input[it] < 0 }
+        }
+
     /**
-     * Run full Whisper transcription pipeline.
-     * @param mel Float array of shape [128 * 3000] (flattened mel spectrogram, float32)
-     * @return Transcribed text
+     * [encoder]'s outputs as tensors over the slot's pinned cross buffers (which are
+     * sized for the 30 s encoder). Empty, so outputs come back from ORT, if any output
+     * is not fixed-shape fp16 or does not fit.
      */
-    fun transcribe(mel: FloatArray): String {
-        val env = this.env ?: throw IllegalStateException("Not initialized")
+    private fun crossViews(env: OrtEnvironment, encoder: OrtSession, buffers: Map<String, ByteBuffer>): Map<String, OnnxTensor> {
+        val views = HashMap<String, OnnxTensor>()
+        for ((name, nodeInfo) in encoder.outputInfo) {
+            val info = nodeInfo.info as? TensorInfo
+            val buf = buffers[name]
+            val elements = info?.shape?.fold(1L) { n, d -> n * d } ?: 0L
+            if (info == null || info.type != OnnxJavaType.FLOAT16 || buf == null || elements <= 0 ||
+                elements * 2 > buf.capacity()) {
+                views.values.forEach { it.close() }
+                return emptyMap()
+            }
+            views[name] = OnnxTensor.createTensor(env, fp16View(buf, elements.toInt()), info.shape, OnnxJavaType.FLOAT16)
+        }
+        return views
+    }
+
+    /** The first [count] fp16 values of a pinned buffer, as an input/output view. */
+    private fun fp16View(buf: ByteBuffer, count: Int): ShortBuffer =
+        buf.duplicate().order(ByteOrder.nativeOrder()).asShortBuffer().apply { limit(count) }
+
+    /**
+     * Allocate the logits output once, in the decoder's declared dtype and shape.
+     */
+    private fun createPinnedLogits(env: OrtEnvironment, decoder: OrtSession) {
+        val info = decoder.outputInfo["logits"]?.info as? TensorInfo
+        logitsFp16 = info?.type != OnnxJavaType.FLOAT
+        val shape = info?.shape ?: longArrayOf(1, VOCAB_SIZE.toLong(), 1, 1)
+
+        val bytesPerValue = if (logitsFp16) 2 else 4
+        val buf = ByteBuffer.allocateDirect(VOCAB_SIZE * bytesPerValue).order(ByteOrder.nativeOrder())
+        logitsBuffer = buf
+        logitsTensor = if (logitsFp16) {
+            OnnxTensor.createTensor(env, buf.asShortBuffer(), shape, OnnxJavaType.FLOAT16)
+        } else {
+            OnnxTensor.createTensor(env, buf.asFloatBuffer(), shape)
+        }
+        Log.i(TAG, "Pinned logits output: ${if (logitsFp16) "fp16" else "fp32"} ${shape.contentToString()}")
+    }
+
+    /**
+     * Run full Whisper transcription pipeline: [encode] into slot 0, then [decode] it.
+     * @param mel Float array of shape [128 * frames] (flattened mel spectrogram, float32): the
+     *   full 3000 frames, or trimmed per [melBucketFrames]
+     * @param beamSize 1 for greedy decoding, 2..5 for beam search
+     * @param contextTokens previous-text tokens (e.g. identifiers of the open file) that
+     *        condition the decoder; only the last [MAX_CONTEXT_TOKENS] are used
+     * @param onPartial called on this thread with the text so far as greedy/sampled
+     *        attempts decode it (restarting on a temperature fallback); beam search
+     *        reports only the final text
+     * @param cancel checked before the encoder and between decoder steps
+     * @return Transcribed text, empty if [cancel] fired
+     */
+    fun transcribe(
+        mel: FloatArray,
+        beamSize: Int = 1,
+        contextTokens: IntArray = IntArray(0),
+        onPartial: ((String) -> Unit)? = null,
+        cancel: CancellationToken? = null
+    ): String {
+        encode(mel, 0, cancel)
+        if (cancel?.isCancelled == true) return ""
+        return decode(0, beamSize, contextTokens, onPartial, cancel)
+    }
+
+    /**
+     * Run the encoder on [mel] into encoder-output [slot]. A trimmed mel (see
+     * [melBucketFrames]) runs the smallest encoder whose input fits it, padded with its
+     * trailing silence frame; a dynamic-length encoder runs it as is. Calls for different slots may
+     * overlap a [decode] of another slot (the two use separate sessions and buffers), but
+     * encode calls must not overlap each other: they share the pinned mel input.
+     *
+     * [cancel] is only checked before the run: on QNN the encoder is one context-binary
+     * node, which ORT's per-node terminate flag cannot interrupt.
+     * @param melQuantized [mel] was also written quantized into [quantizedMelInput], so
+     *   only a padded input needs quantizing here
+     * @return encoder time in ms; 0 and an empty slot if [cancel] already fired
+     */
+    fun encode(mel: FloatArray, slot: Int, cancel: CancellationToken? = null, melQuantized: Boolean = false): Long {
+        if (this.env == null) throw IllegalStateException("Not initialized")
         val encoder = this.encoderSession ?: throw IllegalStateException("Encoder not loaded")
-        val decoder = this.decoderSession ?: throw IllegalStateException("Decoder not loaded")
+        if (cancel?.isCancelled == true) return 0
 
         // === Step 1: Encoder ===
         val startEnc = System.currentTimeMillis()
 
-        val melFp16 = Fp16Conversions.convertFloatBufferToFp16Buffer(FloatBuffer.wrap(mel))
-        val melTensor = OnnxTensor.createTensor(
-            env, melFp16, longArrayOf(1, N_MELS.toLong(), N_FRAMES.toLong()),
-            OnnxJavaType.FLOAT16
-        )
+        val frames = mel.size / N_MELS
+        if (frames <= 0 || frames > N_FRAMES || frames * N_MELS != mel.size) {
+            throw IllegalArgumentException("Mel has ${mel.size} values, expected $N_MELS x up to $N_FRAMES")
+        }
+        val variant = if (frames < N_FRAMES) encoderVariants.firstOrNull { it.frames >= frames } else null
+        val inputFrames = variant?.frames ?: if (dynamicEncoder) frames else N_FRAMES
+        val session = variant?.session ?: encoder
+        val input = variant?.melTensor
+            ?: if (inputFrames < N_FRAMES) dynamicMelTensor(inputFrames)
+            else this.melTensor ?: throw IllegalStateException("Mel input not allocated")
+        if (!melQuantized || melQuantization == null || inputFrames != frames) {
+            val src = if (inputFrames == frames) mel else padMel(mel, frames, inputFrames)
+            val quant = melQuantization
+            val written = quant?.quantize(src, melBuffer!!, N_MELS * inputFrames)
+                ?: NativeFp16.toFp16(src, melBuffer!!, count = N_MELS * inputFrames)
+            if (!written) throw IllegalStateException("Mel input not allocated")
+        }
 
-        val encoderInputName = encoder.inputNames.first()
-        Log.i(TAG, "Running encoder (input: $encoderInputName)...")
-        val encoderResults = encoder.run(mapOf(encoderInputName to melTensor))
+        // The slot's previous decode is over; drop the results that backed it
+        slotResults[slot]?.close()
+        slotResults[slot] = null
+        // A dynamic-length encoder's trimmed outputs come back from ORT
+        val pinned = variant?.crossTensors?.get(slot) ?: if (inputFrames < N_FRAMES) emptyMap() else crossTensors[slot]
+        val encoderInputName = session.inputNames.first()
+        Log.i(TAG, "Running encoder (input: $encoderInputName, $inputFrames frames, slot $slot)...")
+        val encoderResults = session.run(mapOf(encoderInputName to input), pinned)
         val encTime = System.currentTimeMillis() - startEnc
         Log.i(TAG, "Encoder inference: ${encTime}ms")
 
         // Collect cross-attention KV caches (constant across all decoder steps)
         val crossCaches = mutableMapOf<String, OnnxTensor>()
-        for (name in encoder.outputNames) {
-            crossCaches[name] = encoderResults.get(name).get() as OnnxTensor
+        for (name in session.outputNames) {
+            crossCaches[name] = pinned[name] ?: encoderResults.get(name).get() as OnnxTensor
         }
         Log.i(TAG, "Encoder outputs: ${crossCaches.keys}")
+        slotCaches[slot] = crossCaches
+        slotResults[slot] = encoderResults
+        slotMels[slot] = mel
+        slotTrimmed[slot] = inputFrames < N_FRAMES
+        lastEncoderMs = encTime
+        lastEncoderFrames = inputFrames
+        return encTime
+    }
+
+    /** Mel input view of a dynamic-length encoder for [frames] frames. */
+    private fun dynamicMelTensor(frames: Int): OnnxTensor = dynamicMelTensors.getOrPut(frames) {
+        melInputView(env!!, frames)
+    }
+
+    /**
+     * Widen a trimmed [N_MELS x frames] mel to [inputFrames] frames. A trimmed mel ends in
+     * a silence frame (melFramesForAudio), which is what the full spectrogram holds there.
+     */
+    private fun padMel(mel: FloatArray, frames: Int, inputFrames: Int): FloatArray {
+        val out = paddedMel ?: FloatArray(N_MELS * N_FRAMES).also { paddedMel = it }
+        for (m in 0 until N_MELS) {
+            System.arraycopy(mel, m * frames, out, m * inputFrames, frames)
+            out.fill(mel[m * frames + frames - 1], m * inputFrames + frames, (m + 1) * inputFrames)
+        }
+        return out
+    }
+
+    /**
+     * Decode the encoder outputs in [slot] (written by [encode]), then free the slot.
+     * Decode calls must not overlap each other: they share the decoder session, caches
+     * and logits. The other parameters are as for [transcribe]; a cancelled decode stops
+     * within one decoder step, frees the slot and reports [DecodeGuard.STOP_CANCELLED].
+     * @param maxAttempts cap on the temperature fallback; interim passes use 1 and keep
+     *        whatever the T = 0 attempt produced
+     * @return Transcribed text, empty if [cancel] fired
+     */
+    fun decode(
+        slot: Int,
+        beamSize: Int = 1,
+        contextTokens: IntArray = IntArray(0),
+        onPartial: ((String) -> Unit)? = null,
+        cancel: CancellationToken? = null,
+        maxAttempts: Int = FALLBACK_TEMPERATURES.size
+    ): String {
+        if (this.env == null) throw IllegalStateException("Not initialized")
+        val decoder = this.decoderSession ?: throw IllegalStateException("Decoder not loaded")
+        val logitsBuf = this.logitsBuffer ?: throw IllegalStateException("Logits output not allocated")
+        val pinnedOutputs = mapOf("logits" to logitsTensor!!)
+        val processor = this.logitProcessor ?: throw IllegalStateException("Logit processor not created")
+        val guard = this.decodeGuard ?: throw IllegalStateException("Decode guard not created")
+        val scorer = this.decodeScorer ?: throw IllegalStateException("Decode scorer not created")
+        val pool = this.inputPool ?: throw IllegalStateException("Decoder inputs not allocated")
+        val pingPong = this.kvPingPong ?: throw IllegalStateException("Self-attention caches not allocated")
+        val crossCaches = slotCaches[slot] ?: throw IllegalStateException("Encoder slot $slot is empty")
+        val mel = slotMels[slot]!!
 
         // === Step 2: Autoregressive decoder with sliding window KV cache ===
         val startDec = System.currentTimeMillis()
 
-        // Self-attention cache shapes
-        val kCacheSelfShape = longArrayOf(N_HEADS.toLong(), 1, HEAD_DIM.toLong(), CACHE_LEN.toLong())
-        val vCacheSelfShape = longArrayOf(N_HEADS.toLong(), 1, CACHE_LEN.toLong(), HEAD_DIM.toLong())
-        val kCacheSelfSize = N_HEADS * HEAD_DIM * CACHE_LEN
-        val vCacheSelfSize = N_HEADS * CACHE_LEN * HEAD_DIM
+        // Prompt: [SOT_PREV, context...,] SOT, EN, TRANSCRIBE, NO_TIMESTAMPS
+        val promptTokens = buildPrompt(contextTokens)
+        val sotIndex = promptTokens.size - 4
+
+        // Whisper's temperature fallback: every attempt reuses the encoder's cross-attention
+        // caches, only the decoder re-runs. Beam search (if enabled) is the T = 0 attempt.
+        var generatedTokens: List<Int> = emptyList()
+        var verdict = DecodeScorer.ACCEPT
+        var attempts = 0
+        lastStopReason = DecodeGuard.CONTINUE
+        decoderSteps = 0
+        runtimeAllocations = 0
+        for (temperature in FALLBACK_TEMPERATURES) {
+            attempts++
+            scorer.reset()
+            val search = if (temperature == 0f) beamSearchFor(beamSize) else null
+            val native = if (slotTrimmed[slot]) null else nativeDecoder
+            generatedTokens = if (search != null) {
+                decodeBeam(
+                    decoder, pool, search, promptTokens, sotIndex, crossCaches, pinnedOutputs, logitsBuf, processor,
+                    scorer, guard.reset(mel), cancel
+                )
+            } else if (native != null) {
+                decodeNative(native, slot, promptTokens, sotIndex, processor, guard, scorer, mel, temperature, onPartial, cancel)
+            } else {
+                decodeGreedy(
+                    decoder, pool, pingPong, promptTokens, sotIndex, crossCaches, logitsBuf, processor, guard, scorer,
+                    mel, temperature, onPartial, cancel
+                )
+            }
+
+            if (lastStopReason == DecodeGuard.STOP_CANCELLED) {
+                Log.i(TAG, "Decode cancelled after $decoderSteps steps")
+                generatedTokens = emptyList()
+                break
+            }
+            verdict = scorer.verdict(tokenizer.decode(generatedTokens), generatedTokens.size)
+            if (verdict != DecodeScorer.FALLBACK || attempts >= maxAttempts) break
+            Log.w(TAG, "Attempt at T=$temperature rejected (avg logprob ${scorer.avgLogProb}, " +
+                    "compression ratio ${scorer.compressionRatio})")
+        }
+        if (verdict == DecodeScorer.NO_SPEECH) {
+            Log.i(TAG, "No speech (p=${scorer.noSpeechProb}), dropping ${generatedTokens.size} tokens")
+            generatedTokens = emptyList()
+        }
+        lastAttempts = attempts
+
+        val decTime = System.currentTimeMillis() - startDec
+        lastAllocationsPerStep = if (decoderSteps > 0) runtimeAllocations.toFloat() / decoderSteps else 0f
+        Log.i(TAG, "Decoder: ${decTime}ms for ${generatedTokens.size} tokens, $decoderSteps steps, " +
+                "${"%.1f".format(lastAllocationsPerStep)} runtime-allocated outputs/step")
+        lastDecoderMs = decTime
+        lastTokenCount = generatedTokens.size
 
-        // Initialize caches to zeros
-        var selfKCaches = Array(N_LAYERS) { createZeroFp16Tensor(env, kCacheSelfShape, kCacheSelfSize) }
-        var selfVCaches = Array(N_LAYERS) { createZeroFp16Tensor(env, vCacheSelfShape, vCacheSelfSize) }
+        // Cleanup (the pinned mel and cross-cache tensors are reused)
+        slotResults[slot]?.close()
+        slotResults[slot] = null
+        slotCaches[slot] = null
+        slotMels[slot] = null
 
-        // Prompt: SOT, EN, TRANSCRIBE, NO_TIMESTAMPS
-        val promptTokens = intArrayOf(
+        val text = tokenizer.decode(generatedTokens)
+        Log.i(TAG, "Transcription: \"$text\"")
+        return text
+    }
+
+    /**
+     * Bias decoding towards [identifiers] (identifier → tokens with a leading space):
+     * once an identifier's first tokens are decoded, its continuation is boosted.
+     * Only the difference to the previous set is applied. Safe during a transcription.
+     */
+    fun setContextIdentifiers(identifiers: Map<String, IntArray>) {
+        contextBias?.update(identifiers)
+    }
+
+    /** Whisper's previous-text prompt layout; without context it is the plain four-token prompt. */
+    private fun buildPrompt(contextTokens: IntArray): IntArray {
+        val context = if (contextTokens.size > MAX_CONTEXT_TOKENS) {
+            contextTokens.copyOfRange(contextTokens.size - MAX_CONTEXT_TOKENS, contextTokens.size)
+        } else contextTokens
+        val task = intArrayOf(
             WhisperTokenizer.SOT,
             WhisperTokenizer.EN,
             WhisperTokenizer.TRANSCRIBE,
             WhisperTokenizer.NO_TIMESTAMPS
         )
+        return if (context.isEmpty()) task else intArrayOf(WhisperTokenizer.SOT_PREV) + context + task
+    }
+
+    /**
+     * Greedy (T = 0) or sampled (T > 0) decode of one attempt. Every sampled token is
+     * scored by [scorer]; the decode guard may stop early and trim a repetition loop.
+     */
+    private fun decodeGreedy(
+        decoder: OrtSession,
+        pool: DecoderInputPool,
+        pingPong: KvCachePingPong,
+        promptTokens: IntArray,
+        sotIndex: Int,
+        crossCaches: Map<String, OnnxTensor>,
+        logitsBuf: ByteBuffer,
+        processor: LogitProcessor,
+        guard: DecodeGuard,
+        scorer: DecodeScorer,
+        mel: FloatArray,
+        temperature: Float,
+        onPartial: ((String) -> Unit)?,
+        cancel: CancellationToken?
+    ): List<Int> {
+        stepOutputs["logits"] = logitsTensor!!
+        val stream = if (onPartial != null) partialText else null
+        stream?.reset()
 
         val generatedTokens = mutableListOf<Int>()
+        var numSampled = 0
+        var stopReason = DecodeGuard.CONTINUE
+        val tokenBudget = guard.reset(mel)
+        Log.i(TAG, "Token budget: $tokenBudget, temperature $temperature")
         var position = 0
         val allTokens = promptTokens.toMutableList()
 
         for (step in 0 until MAX_TOKENS + promptTokens.size) {
             if (step >= allTokens.size) break
-            val currentToken = allTokens[step]
-
-            val inputs = mutableMapOf<String, OnnxTensor>()
-
-            // input_ids: int32 [1, 1]
-            inputs["input_ids"] = OnnxTensor.createTensor(
-                env, IntBuffer.wrap(intArrayOf(currentToken)), longArrayOf(1, 1)
-            )
-
-            // position_ids: int32 [1]
-            inputs["position_ids"] = OnnxTensor.createTensor(
-                env, IntBuffer.wrap(intArrayOf(position)), longArrayOf(1)
-            )
-
-            // attention_mask: fp16 [1, 1, 1, 200]
-            // Sliding window: unmask from the RIGHT side.
-            // Step 0: unmask position 199 only
-            // Step 1: unmask positions 198-199
-            // Step n: unmask positions (199-n)..199
-            inputs["attention_mask"] = createAttentionMask(env, step)
-
-            // Self-attention KV caches
-            for (layer in 0 until N_LAYERS) {
-                inputs["k_cache_self_${layer}_in"] = selfKCaches[layer]
-                inputs["v_cache_self_${layer}_in"] = selfVCaches[layer]
+            if (cancel?.isCancelled == true) {
+                stopReason = DecodeGuard.STOP_CANCELLED
+                break
             }
+            val currentToken = allTokens[step]
 
-            // Cross-attention KV caches (from encoder, constant)
-            for (layer in 0 until N_LAYERS) {
-                inputs["k_cache_cross_$layer"] = crossCaches["k_cache_cross_$layer"]!!
-                inputs["v_cache_cross_$layer"] = crossCaches["v_cache_cross_$layer"]!!
-            }
+            // Ping-pong: read the set the previous step wrote (zeros at step 0), write the other
+            val selfKCaches = if (step == 0) pool.zeroKCaches else pingPong.kInputs(step)
+            val selfVCaches = if (step == 0) pool.zeroVCaches else pingPong.vInputs(step)
+            val inputs = decoderStepInputs(pool, currentToken, position, selfKCaches, selfVCaches, crossCaches)
+            pingPong.bindOutputs(step, stepOutputs)
 
             if (step == 0) {
                 val missing = decoder.inputNames.filter { it !in inputs }
@@ -197,57 +726,39 @@ class WhisperInference(
             }
 
             try {
-                val decoderResults = decoder.run(inputs)
+                decoder.run(inputs, stepOutputs).use { countStep(it, stepOutputs) }
 
-                // Extract logits: fp16 [1, 51866, 1, 1] (NCHW from Conv2D)
+                // Logits: fp16 [1, 51866, 1, 1] (NCHW from Conv2D), written into logitsBuf.
                 // Vocab is on dimension 1 (channel dim). Flattened buffer = 51866 values.
-                val logitsTensor = decoderResults.get("logits").get() as OnnxTensor
-                val logits: FloatArray
-
-                val logitsFloat = logitsTensor.floatBuffer
-                if (logitsFloat != null) {
-                    logits = FloatArray(VOCAB_SIZE)
-                    logitsFloat.rewind()
-                    logitsFloat.get(logits)
-                } else {
-                    val fp16Buf = logitsTensor.shortBuffer
-                    logits = fp16ShortBufferToFloatArray(fp16Buf, VOCAB_SIZE)
+                // The no-speech probability is read from the raw logits after SOT.
+                if (step == sotIndex) scorer.noSpeech(logitsBuf, logitsFp16)
+
+                // Once the prompt is consumed, apply suppression rules before picking
+                val sampling = step >= promptTokens.size - 1
+                if (sampling) {
+                    processor.apply(logitsBuf, logitsFp16, sampledTokens, numSampled)
                 }
 
-                // Greedy argmax over vocab dimension
-                val nextToken = argmax(logits)
+                // Argmax at T = 0, a softmax(logits / T) draw above; natively and in place
+                val nextToken = scorer.sample(logitsBuf, logitsFp16, temperature)
+                if (sampling) scorer.accept(logitsBuf, logitsFp16, nextToken)
 
                 // Log top-k for debugging on first few steps
                 if (step < 6) {
-                    val topK = logits.indices.sortedByDescending { logits[it] }.take(5)
-                    val topStr = topK.joinToString { "[$it]=${String.format("%.2f", logits[it])}" }
+                    val n = if (logitsFp16) {
+                        NativeLogits.topKFp16(logitsBuf, VOCAB_SIZE, DEBUG_TOP_K, topKIndices, topKValues)
+                    } else {
+                        NativeLogits.topKFp32(logitsBuf, VOCAB_SIZE, DEBUG_TOP_K, topKIndices, topKValues)
+                    }
+                    val topStr = (0 until n).joinToString { "[${topKIndices[it]}]=${String.format("%.2f", topKValues[it])}" }
                     Log.i(TAG, "Step $step (pos=$position): input=$currentToken → next=$nextToken " +
                             "(${if (nextToken < WhisperTokenizer.FIRST_SPECIAL) tokenizer.decode(listOf(nextToken)) else "<special:$nextToken>"}) " +
                             "top5: $topStr")
                 }
 
-                // Clean up per-step tensors
-                inputs["input_ids"]?.close()
-                inputs["position_ids"]?.close()
-                inputs["attention_mask"]?.close()
-
-                // Extract updated self-attention KV caches (sliding window: oldest dropped)
-                val newKCaches = Array(N_LAYERS) { layer ->
-                    decoderResults.get("k_cache_self_${layer}_out").get() as OnnxTensor
-                }
-                val newVCaches = Array(N_LAYERS) { layer ->
-                    decoderResults.get("v_cache_self_${layer}_out").get() as OnnxTensor
-                }
-
-                // Close old caches
-                selfKCaches.forEach { it.close() }
-                selfVCaches.forEach { it.close() }
-                selfKCaches = newKCaches
-                selfVCaches = newVCaches
-
                 position++
 
-                // During prompt phase (steps 0..2), just advance — don't collect output
+                // During the prompt phase, just advance — don't collect output
                 if (step < promptTokens.size - 1) continue
 
                 // From step (promptTokens.size - 1) onward, collect generated tokens
@@ -257,100 +768,206 @@ class WhisperInference(
                 } else if (nextToken >= WhisperTokenizer.FIRST_TIMESTAMP) {
                     // Timestamp token — add to sequence but don't collect as text
                     allTokens.add(nextToken)
+                    sampledTokens[numSampled++] = nextToken
                 } else {
                     generatedTokens.add(nextToken)
                     allTokens.add(nextToken)
+                    sampledTokens[numSampled++] = nextToken
+
+                    stopReason = guard.accept(nextToken)
+                    if (stopReason != DecodeGuard.CONTINUE) {
+                        val keep = guard.keepTokens
+                        Log.w(TAG, "Decode stopped at step $step (reason $stopReason), keeping $keep of ${generatedTokens.size} tokens")
+                        while (generatedTokens.size > keep) generatedTokens.removeAt(generatedTokens.size - 1)
+                        break
+                    }
+                    if (stream != null && stream.push(nextToken)) onPartial?.invoke(stream.text.trim())
                 }
 
             } catch (e: Exception) {
                 Log.e(TAG, "Decoder step $step failed: ${e.message}", e)
-                inputs["input_ids"]?.close()
-                inputs["position_ids"]?.close()
-                inputs["attention_mask"]?.close()
                 break
             }
         }
 
-        val decTime = System.currentTimeMillis() - startDec
-        Log.i(TAG, "Decoder: ${decTime}ms for ${generatedTokens.size} tokens")
+        lastStopReason = stopReason
+        return generatedTokens
+    }
 
-        // Cleanup
-        selfKCaches.forEach { it.close() }
-        selfVCaches.forEach { it.close() }
-        melTensor.close()
-        encoderResults.close()
+    /**
+     * One attempt on the native decoder loop: a single JNI call from the pinned encoder
+     * outputs to token IDs, with the same processor, guard and scorer as [decodeGreedy].
+     */
+    private fun decodeNative(
+        native: NativeDecoder,
+        slot: Int,
+        promptTokens: IntArray,
+        sotIndex: Int,
+        processor: LogitProcessor,
+        guard: DecodeGuard,
+        scorer: DecodeScorer,
+        mel: FloatArray,
+        temperature: Float,
+        onPartial: ((String) -> Unit)?,
+        cancel: CancellationToken?
+    ): List<Int> {
+        val tokenBudget = guard.reset(mel)
+        Log.i(TAG, "Token budget: $tokenBudget, temperature $temperature (native)")
+        val crossK = Array(N_LAYERS) { crossBuffers[slot].getValue(K_CACHE_CROSS[it]) }
+        val crossV = Array(N_LAYERS) { crossBuffers[slot].getValue(V_CACHE_CROSS[it]) }
+        val count = native.decode(
+            crossK, crossV, promptTokens, sotIndex, processor, guard, scorer, temperature, nativeTokens,
+            partialText, onPartial?.let { listener -> { text: String -> listener(text.trim()) } }, cancel
+        )
+        lastStopReason = native.lastStopReason
+        decoderSteps += native.lastSteps   // every output is bound, nothing allocated per step
+        return List(count) { nativeTokens[it] }
+    }
 
-        val text = tokenizer.decode(generatedTokens)
-        Log.i(TAG, "Transcription: \"$text\"")
-        return text
+    /** Self-attention KV tensors of one decoder step, held in a beam-search cache slot. */
+    private class KvSlot(val k: Array<OnnxTensor>, val v: Array<OnnxTensor>, val pooled: Boolean = false) {
+        fun close() {
+            if (pooled) return
+            k.forEach { it.close() }
+            v.forEach { it.close() }
+        }
+    }
+
+    private fun beamSearchFor(beamSize: Int): BeamSearch? {
+        if (beamSize <= 1) return null
+        beamSearch?.let { if (it.beamSize == beamSize) return it }
+        beamSearch?.release()
+        return BeamSearch(VOCAB_SIZE, beamSize, MAX_TOKENS).also { beamSearch = it }
     }
 
     /**
-     * Create attention mask: fp16 [1, 1, 1, 200]
-     *
-     * The Qualcomm model uses a sliding window cache. The mask unmasks from the RIGHT:
-     *   Step 0: all masked except position 199 → [mask, mask, ..., mask, 0.0]
-     *   Step 1: positions 198-199 unmasked     → [mask, mask, ..., 0.0, 0.0]
-     *   Step n: positions (199-n)..199 unmasked
-     *
-     * Mask value: -100.0 (fp16 = 0xD640), matching Qualcomm's reference implementation.
-     * Attend value: 0.0 (fp16 = 0x0000).
+     * Beam-search decode. The prompt prefix runs once as a single hypothesis; after that
+     * every live beam runs one decoder step per token position, reading the KV slot the
+     * native controller assigns it. Forked beams share their parent's slot, and a slot's
+     * tensors are closed as soon as no beam reads them. [cancel] is checked before every
+     * decoder run; a cancelled search returns no tokens.
      */
-    private fun createAttentionMask(env: OrtEnvironment, step: Int): OnnxTensor {
-        val buf = ByteBuffer.allocateDirect(ATTN_MASK_SIZE * 2).order(ByteOrder.nativeOrder())
-        val shorts = buf.asShortBuffer()
+    private fun decodeBeam(
+        decoder: OrtSession,
+        pool: DecoderInputPool,
+        search: BeamSearch,
+        promptTokens: IntArray,
+        sotIndex: Int,
+        crossCaches: Map<String, OnnxTensor>,
+        pinnedOutputs: Map<String, OnnxTensor>,
+        logitsBuf: ByteBuffer,
+        processor: LogitProcessor,
+        scorer: DecodeScorer,
+        tokenBudget: Int,
+        cancel: CancellationToken?
+    ): List<Int> {
+        val slots = arrayOfNulls<KvSlot>(BeamSearch.MAX_SLOTS)
+        var prefix: KvSlot? = KvSlot(pool.zeroKCaches, pool.zeroVCaches, pooled = true)
+        var position = 0
+        try {
+            while (position < promptTokens.size - 1) {
+                if (cancel?.isCancelled == true) return beamCancelled()
+                val cache = prefix!!
+                val inputs = decoderStepInputs(pool, promptTokens[position], position, cache.k, cache.v, crossCaches)
+                val results = decoder.run(inputs, pinnedOutputs)
+                if (position == sotIndex) scorer.noSpeech(logitsBuf, logitsFp16)
+                cache.close()
+                prefix = selfCachesOf(results, pinnedOutputs)
+                position++
+            }
+            slots[search.start(promptTokens.last(), tokenBudget)] = prefix
+            prefix = null
 
-        // Start fully masked, then unmask (n+1) positions from the right
-        val numUnmasked = step + 1  // step 0 → 1 unmasked, step 1 → 2, etc.
-        val firstUnmasked = ATTN_MASK_SIZE - numUnmasked  // unmask from this index to end
+            while (!search.done) {
+                for (beam in 0 until search.beamCount) {
+                    if (cancel?.isCancelled == true) return beamCancelled()
+                    val cache = slots[search.beamSlot(beam)]
+                        ?: throw IllegalStateException("Beam $beam reads an empty KV slot")
+                    val inputs = decoderStepInputs(pool, search.lastToken(beam), position, cache.k, cache.v, crossCaches)
+                    val output = selfCachesOf(decoder.run(inputs, pinnedOutputs), pinnedOutputs)
+                    val numSampled = search.tokens(beam, sampledTokens)
+                    processor.apply(logitsBuf, logitsFp16, sampledTokens, numSampled)
+                    val slot = search.score(beam, logitsBuf, logitsFp16)
+                    if (slot < 0) {
+                        output.close()
+                        throw IllegalStateException("No KV slot for beam $beam")
+                    }
+                    slots[slot] = output
+                }
 
-        for (i in 0 until ATTN_MASK_SIZE) {
-            shorts.put(if (i >= firstUnmasked) MASK_ZERO_FP16 else MASK_NEG_FP16)
+                val numFreed = search.advance(freedSlots)
+                for (i in 0 until numFreed) {
+                    slots[freedSlots[i]]?.close()
+                    slots[freedSlots[i]] = null
+                }
+                position++
+            }
+        } catch (e: Exception) {
+            Log.e(TAG, "Beam search failed at position $position: ${e.message}", e)
+        } finally {
+            // Normally every slot has been freed by now; this covers a failed step
+            prefix?.close()
+            slots.forEach { it?.close() }
         }
-        shorts.rewind()
 
-        return OnnxTensor.createTensor(
-            env, shorts, longArrayOf(1, 1, 1, ATTN_MASK_SIZE.toLong()),
-            OnnxJavaType.FLOAT16
+        val n = search.best(beamTokens)
+        scorer.addLogProb(search.bestLogProb)
+        Log.i(TAG, "Beam search (width ${search.beamSize}): $n tokens")
+        return (0 until n).map { beamTokens[it] }.filter { it < WhisperTokenizer.EOT }
+    }
+
+    private fun beamCancelled(): List<Int> {
+        lastStopReason = DecodeGuard.STOP_CANCELLED
+        return emptyList()
+    }
+
+    private fun selfCachesOf(results: OrtSession.Result, pinned: Map<String, OnnxTensor>): KvSlot {
+        countStep(results, pinned)
+        return KvSlot(
+            Array(N_LAYERS) { layer -> results.get(K_CACHE_SELF_OUT[layer]).get() as OnnxTensor },
+            Array(N_LAYERS) { layer -> results.get(V_CACHE_SELF_OUT[layer]).get() as OnnxTensor }
         )
     }
 
-    /**
-     * Create a zero-filled fp16 tensor.
-     */
-    private fun createZeroFp16Tensor(
-        env: OrtEnvironment,
-        shape: LongArray,
-        numElements: Int
-    ): OnnxTensor {
-        val buf = ByteBuffer.allocateDirect(numElements * 2).order(ByteOrder.nativeOrder())
-        val shorts = buf.asShortBuffer()
-        shorts.rewind()
-        return OnnxTensor.createTensor(env, shorts, shape, OnnxJavaType.FLOAT16)
+    /** Count one decoder run and the outputs the runtime allocated for it (anything not pinned). */
+    private fun countStep(results: OrtSession.Result, pinned: Map<String, OnnxTensor>) {
+        decoderSteps++
+        for ((name, value) in results) {
+            if (pinned[name] !== value) runtimeAllocations++
+        }
     }
 
     /**
-     * Fallback: manually convert fp16 ShortBuffer to float32 array.
+     * Inputs of one decoder step, all pooled: the token and position are written into
+     * the pinned scalars, the mask is the precomputed one for [position], and the caches
+     * are borrowed. The same map is reused for every step.
      */
-    private fun fp16ShortBufferToFloatArray(fp16: ShortBuffer, count: Int): FloatArray {
-        val result = FloatArray(count)
-        fp16.rewind()
-        for (i in 0 until count) {
-            result[i] = Fp16Conversions.fp16ToFloat(fp16.get())
+    private fun decoderStepInputs(
+        pool: DecoderInputPool,
+        token: Int,
+        position: Int,
+        kCaches: Array<OnnxTensor>,
+        vCaches: Array<OnnxTensor>,
+        crossCaches: Map<String, OnnxTensor>
+    ): Map<String, OnnxTensor> {
+        val inputs = stepInputs
+        pool.setStep(token, position)
+        inputs["input_ids"] = pool.inputIds           // int32 [1, 1]
+        inputs["position_ids"] = pool.positionIds     // int32 [1]
+        inputs["attention_mask"] = pool.mask(position) // fp16 [1, 1, 1, 200], unmasked right-to-left
+
+        // Self-attention KV caches
+        for (layer in 0 until N_LAYERS) {
+            inputs[K_CACHE_SELF_IN[layer]] = kCaches[layer]
+            inputs[V_CACHE_SELF_IN[layer]] = vCaches[layer]
         }
-        return result
-    }
 
-    private fun argmax(arr: FloatArray): Int {
-        var maxIdx = 0
-        var maxVal = arr[0]
-        for (i in 1 until arr.size) {
-            if (arr[i] > maxVal) {
-                maxVal = arr[i]
-                maxIdx = i
-            }
+        // Cross-attention KV caches (from encoder, constant)
+        for (layer in 0 until N_LAYERS) {
+            inputs[K_CACHE_CROSS[layer]] = crossCaches[K_CACHE_CROSS[layer]]!!
+            inputs[V_CACHE_CROSS[layer]] = crossCaches[V_CACHE_CROSS[layer]]!!
         }
-        return maxIdx
+        return inputs
     }
 
     private fun logSessionInfo(name: String, session: OrtSession) {
@@ -368,6 +985,46 @@ class WhisperInference(
     }
 
     fun release() {
+        nativeDecoder?.release()
+        nativeDecoder = null
+        logitProcessor?.release()
+        contextBias?.release()
+        contextBias = null
+        logitProcessor = null
+        decodeGuard?.release()
+        decodeGuard = null
+        beamSearch?.release()
+        beamSearch = null
+        decodeScorer?.release()
+        decodeScorer = null
+        partialText?.release()
+        partialText = null
+        stepInputs.clear()
+        inputPool?.release()
+        inputPool = null
+        logitsTensor?.close()
+        logitsTensor = null
+        logitsBuffer = null
+        stepOutputs.clear()
+        kvPingPong?.release()
+        kvPingPong = null
+        encoderVariants.forEach { it.close() }
+        encoderVariants.clear()
+        dynamicMelTensors.values.forEach { it.close() }
+        dynamicMelTensors.clear()
+        melTensor?.close()
+        melTensor = null
+        melBuffer = null
+        melQuantization = null
+        for (slot in 0 until ENCODER_SLOTS) {
+            slotResults[slot]?.close()
+            slotResults[slot] = null
+            slotCaches[slot] = null
+            slotMels[slot] = null
+            crossTensors[slot].values.forEach { it.close() }
+            crossTensors[slot] = emptyMap()
+            crossBuffers[slot] = emptyMap()
+        }
         encoderSession?.close()
         decoderSession?.close()
         encoderSession = null
@@ -2,13 +2,12 @@ package com.sketchcode.app.whisper
 
 import android.content.Context
 import android.util.Log
-import com.google.gson.Gson
-import com.google.gson.reflect.TypeToken
 
 /**
- * Decodes Whisper token IDs back to text using the BPE vocabulary.
- * Loads vocab.json from assets and implements the bytes_to_unicode reverse mapping
- * used by GPT-2 / Whisper tokenizers.
+ * Decodes Whisper token IDs back to text using the BPE vocabulary, and encodes prompt
+ * text (identifiers of the open file) into tokens with the native BPE encoder.
+ * The vocabulary is vocab.bin, packed from vocab.json at build time with the
+ * bytes_to_unicode mapping of GPT-2 / Whisper already undone, and mapped in place.
  */
 class WhisperTokenizer(context: Context) {
     companion object {
@@ -20,86 +19,119 @@ class WhisperTokenizer(context: Context) {
         const val EN = 50259           // <|en|>
         const val TRANSCRIBE = 50360   // <|transcribe|>
         const val TRANSLATE = 50359    // <|translate|>
+        const val SOT_LM = 50361       // <|startoflm|>
+        const val SOT_PREV = 50362     // <|startofprev|>
+        const val NO_SPEECH = 50363    // <|nospeech|>
         const val NO_TIMESTAMPS = 50364 // <|notimestamps|>
         const val FIRST_TIMESTAMP = 50365
 
         // First real text token
         const val FIRST_SPECIAL = 50257
+
+        // Symbols Whisper never wants in a transcript (decoding.py non_speech_tokens)
+        private const val NON_SPEECH_SYMBOLS = "\"#()*+/:;<=>@[\\]^_`{|}~「」『』"
+        private val NON_SPEECH_MULTI = listOf(
+            "<<", ">>", "<<<", ">>>", "--", "---", "-(", "-[", "('", "(\"", "((", "))", "(((", ")))",
+            "[[", "]]", "{{", "}}", "♪♪", "♪♪♪"
+        )
+        private const val MISC_SYMBOLS = "♩♪♫♬♭♮♯"
+
+        // Identifiers worth biasing towards: three or more characters, not keywords
+        private val IDENTIFIER = Regex("[A-Za-z_][A-Za-z0-9_]{2,}")
+        private val KEYWORDS = setOf(
+            "and", "break", "case", "catch", "class", "const", "continue", "def", "default", "del",
+            "else", "elif", "enum", "export", "extends", "false", "final", "finally", "for", "from",
+            "fun", "function", "if", "implements", "import", "interface", "let", "new", "not", "null",
+            "object", "override", "package", "pass", "private", "protected", "public", "return", "self",
+            "static", "struct", "super", "switch", "this", "throw", "true", "try", "val", "var", "void",
+            "when", "while", "with", "yield", "None", "True", "False", "int", "float", "string", "bool"
+        )
     }
 
-    // Maps token ID → BPE string
-    private val idToToken: Map<Int, String>
+    // Memory-mapped vocab.bin: token bytes by id, and ids by bytes
+    private val vocab = Vocabulary(context.assets)
+    // Native BPE over the same mapping, for prompt text
+    private val encoder = BpeEncoder(vocab)
+
+    /** Token ID of a lone space, suppressed as the first sampled token. */
+    val blankToken: Int
 
-    // Reverse of bytes_to_unicode(): maps unicode char → byte value
-    private val byteDecoder: Map<Char, Int>
+    /**
+     * Tokens suppressed at every decoder step: non-speech symbols plus the task
+     * and SOT specials, matching Whisper's default suppress_tokens="-1".
+     * Symbols that do not map to a single vocabulary entry are skipped.
+     */
+    val suppressTokens: IntArray
 
     init {
-        // Load vocab.json: { "token_string": token_id, ... }
-        val vocabJson = context.assets.open("vocab.json").bufferedReader().readText()
-        val type = object : TypeToken<Map<String, Int>>() {}.type
-        val tokenToId: Map<String, Int> = Gson().fromJson(vocabJson, type)
-        idToToken = tokenToId.entries.associate { (k, v) -> v to k }
-        Log.i(TAG, "Loaded ${idToToken.size} tokens from vocab.json")
-
-        // Build bytes_to_unicode reverse mapping
-        byteDecoder = buildByteDecoder()
+        Log.i(TAG, "Mapped ${vocab.count} tokens from vocab.bin")
+
+        blankToken = vocab.lookup(" ") ?: 220
+        val suppress = sortedSetOf(TRANSLATE, TRANSCRIBE, SOT, SOT_PREV, SOT_LM, NO_SPEECH)
+        val symbols = NON_SPEECH_SYMBOLS.map { it.toString() } + NON_SPEECH_MULTI + MISC_SYMBOLS.map { it.toString() }
+        for (symbol in symbols) {
+            vocab.lookup(symbol)?.let { suppress.add(it) }
+            vocab.lookup(" $symbol")?.let { suppress.add(it) }
+        }
+        // Whisper also suppresses the space-prefixed hyphen and apostrophe
+        vocab.lookup(" -")?.let { suppress.add(it) }
+        vocab.lookup(" '")?.let { suppress.add(it) }
+        suppressTokens = suppress.toIntArray()
+        Log.i(TAG, "Suppressing ${suppressTokens.size} non-speech/special tokens")
     }
 
     /**
      * Decode a list of token IDs into a text string.
-     * Filters out special tokens and applies BPE byte decoding.
+     * Special tokens are skipped; the mapped token bytes are concatenated and read as UTF-8.
      */
     fun decode(tokenIds: List<Int>): String {
-        // Filter out special tokens
-        val textTokens = tokenIds.filter { it < FIRST_SPECIAL }
-
-        // Map token IDs to BPE strings and concatenate
-        val bpeString = textTokens.mapNotNull { idToToken[it] }.joinToString("")
-
-        // Decode BPE bytes to UTF-8 string
-        val bytes = ByteArray(bpeString.length)
-        var validLen = 0
-        for (ch in bpeString) {
-            val b = byteDecoder[ch]
-            if (b != null) {
-                bytes[validLen++] = b.toByte()
-            }
-        }
+        val bytes = vocab.decodeBytes(tokenIds.toIntArray())
+        return String(bytes, Charsets.UTF_8).trim()
+    }
 
-        return String(bytes, 0, validLen, Charsets.UTF_8).trim()
+    /** A new incremental detokenizer over this vocabulary; the caller releases it. */
+    fun streamingDetokenizer(): StreamingDetokenizer = StreamingDetokenizer(vocab)
+
+    /** Encode text into token IDs (no special tokens). */
+    fun encode(text: String): IntArray = encoder.encode(text)
+
+    /** Distinct identifiers of [code] (keywords and short names left out), most frequent first. */
+    fun identifiers(code: String): List<String> {
+        val counts = HashMap<String, Int>()
+        for (match in IDENTIFIER.findAll(code)) {
+            val word = match.value
+            if (word !in KEYWORDS) counts[word] = (counts[word] ?: 0) + 1
+        }
+        return counts.entries.sortedByDescending { it.value }.map { it.key }
     }
 
     /**
-     * Build the reverse of OpenAI's bytes_to_unicode() mapping.
-     * This is the standard GPT-2 byte-level BPE encoding table.
+     * Prompt tokens for [identifiers] (most frequent first), joined with spaces as
+     * Whisper expects previous text, at most [maxTokens] tokens. Whisper keeps the tail
+     * of a prompt, so the most frequent identifiers go last; an identifier that does
+     * not fit whole is left out rather than cut.
      */
-    private fun buildByteDecoder(): Map<Char, Int> {
-        // bytes_to_unicode() maps byte values 0-255 to unicode code points.
-        // Printable ASCII chars map to themselves. Other bytes map to
-        // code points starting at 256 to avoid control characters.
-        val bs = mutableListOf<Int>()
-        val cs = mutableListOf<Int>()
-
-        // Ranges that map to themselves: '!' to '~', non-break space to Latin-1 supplement
-        for (b in '!'.code..'~'.code) { bs.add(b); cs.add(b) }
-        for (b in '\u00A1'.code..'\u00AC'.code) { bs.add(b); cs.add(b) }
-        for (b in '\u00AE'.code..'\u00FF'.code) { bs.add(b); cs.add(b) }
-
-        // Remaining bytes map to 256+
-        var n = 0
-        for (b in 0..255) {
-            if (b !in bs) {
-                bs.add(b)
-                cs.add(256 + n)
-                n++
-            }
+    fun identifierPrompt(identifiers: List<String>, maxTokens: Int): IntArray {
+        val chosen = ArrayList<IntArray>()
+        var total = 0
+        for (word in identifiers) {
+            val tokens = encoder.encode(" $word")
+            if (total + tokens.size > maxTokens) continue
+            chosen.add(tokens)
+            total += tokens.size
+            if (total == maxTokens) break
         }
-
-        // Reverse: unicode char → byte value
-        val decoder = mutableMapOf<Char, Int>()
-        for (i in bs.indices) {
-            decoder[cs[i].toChar()] = bs[i]
+        val prompt = IntArray(total)
+        var offset = 0
+        for (tokens in chosen.asReversed()) {
+            tokens.copyInto(prompt, offset)
+            offset += tokens.size
         }
-        return decoder
+        return prompt
+    }
+
+    fun release() {
+        encoder.release()
+        vocab.release()
     }
 }